@@ -502,6 +502,30 @@ enum aome_enc_control_id {
    * Experiment: LOOPFILTERING_ACROSS_TILES
    */
   AV1E_SET_TILE_LOOPFILTER,
+
+  /*!\brief Codec control function to enable row based multi-threading.
+   *
+   * When enabled, the superblock rows of each tile are encoded in parallel,
+   * each row staying behind the top-right superblock of the row above. This
+   * allows using more threads than there are tile columns. The encoded
+   * stream does not depend on the number of threads. The parameter for this
+   * control has a valid range [0, 1]:
+   *            0 = disable row based multi-threading
+   *            1 = enable row based multi-threading
+   *
+   * By default, the value is 0.
+   */
+  AV1E_SET_ROW_MT,
+
+  /*!\brief Codec control function to lend the input images to the encoder.
+   *
+   * When a release callback is set, the encoder reads the images passed to
+   * aom_codec_encode() in place instead of copying them, and returns each of
+   * them through the callback once it no longer reads it, see
+   * #aom_zero_copy_input_t. A NULL callback restores the default copy of the
+   * input images.
+   */
+  AV1E_SET_ZERO_COPY_INPUT,
 };
 
 /*!\brief aom 1-D scaling mode
@@ -539,6 +563,9 @@ typedef struct aom_roi_map {
  *
  * These defines the data structures for active region map
  *
+ * The encoder skips the inactive regions. It may also skip reading them from
+ * the images passed to aom_codec_encode(), taking them as unchanged from the
+ * previous image.
  */
 
 typedef struct aom_active_map {
@@ -548,6 +575,40 @@ typedef struct aom_active_map {
   unsigned int cols; /**< number of cols */
 } aom_active_map_t;
 
+/*!\brief Smallest border of the images lent to the encoder
+ *
+ * Lent images whose border is smaller than this are copied.
+ */
+#define AOM_ENC_MIN_INPUT_BORDER 64
+
+/*!\brief Returns an input image lent to the encoder to the application.
+ *
+ * \param[in] cb_priv  The private data given with the callback
+ * \param[in] img      The image passed to aom_codec_encode()
+ */
+typedef void (*aom_release_input_cb_fn_t)(void *cb_priv, aom_image_t *img);
+
+/*!\brief  aom zero-copy input
+ *
+ * These define how the input images are lent to the encoder. A lent image,
+ * including the pixel buffers of its planes, must stay valid and unmodified
+ * until it is returned through the release callback. The encoder holds up to
+ * g_lag_in_frames + 2 images at a time, and returns the remaining ones when it
+ * is destroyed.
+ *
+ * The encoder extends the edges of a lent image into its border, so each
+ * plane must be surrounded by a writable border of border pixels on each side,
+ * subsampled like the plane. Images that do not meet this, because border is
+ * below #AOM_ENC_MIN_INPUT_BORDER or the strides are too small to hold the
+ * border, are copied as usual and returned during the aom_codec_encode() call
+ * that received them.
+ */
+typedef struct aom_zero_copy_input {
+  aom_release_input_cb_fn_t release_cb; /**< Returns a lent image */
+  void *cb_priv;                        /**< Private data for release_cb */
+  unsigned int border;                  /**< Border of the images, in pixels */
+} aom_zero_copy_input_t;
+
 /*!\brief  aom image scaling mode
  *
  * This defines the data structure for image scaling mode
@@ -622,6 +683,12 @@ AOM_CTRL_USE_TYPE(AV1E_SET_TILE_DEPENDENT_ROWS, int)
 AOM_CTRL_USE_TYPE(AV1E_SET_TILE_LOOPFILTER, int)
 #define AOM_CTRL_AV1E_SET_TILE_LOOPFILTER
 
+AOM_CTRL_USE_TYPE(AV1E_SET_ROW_MT, unsigned int)
+#define AOM_CTRL_AV1E_SET_ROW_MT
+
+AOM_CTRL_USE_TYPE(AV1E_SET_ZERO_COPY_INPUT, aom_zero_copy_input_t *)
+#define AOM_CTRL_AV1E_SET_ZERO_COPY_INPUT
+
 AOM_CTRL_USE_TYPE(AOME_GET_LAST_QUANTIZER, int *)
 #define AOM_CTRL_AOME_GET_LAST_QUANTIZER
 AOM_CTRL_USE_TYPE(AOME_GET_LAST_QUANTIZER_64, int *)
@@ -14,6 +14,7 @@
 
 void aom_daala_start_encode(daala_writer *br, uint8_t *source) {
   br->buffer = source;
+  br->buffer_end = NULL;
   br->pos = 0;
   od_ec_enc_init(&br->ec, 62025);
 }
@@ -22,6 +23,13 @@ void aom_daala_stop_encode(daala_writer *br) {
   uint32_t daala_bytes;
   unsigned char *daala_data;
   daala_data = od_ec_enc_done(&br->ec, &daala_bytes);
+  // The data is followed by a zero byte.
+  if (br->buffer_end != NULL &&
+      daala_bytes >= (uint32_t)(br->buffer_end - br->buffer)) {
+    br->pos = 0;
+    od_ec_enc_clear(&br->ec);
+    return;
+  }
   memcpy(br->buffer, daala_data, daala_bytes);
   br->pos = daala_bytes;
   /* Prevent ec bitstream from being detected as a superframe marker.
@@ -27,6 +27,10 @@ extern "C" {
 struct daala_writer {
   unsigned int pos;
   uint8_t *buffer;
+  // End of buffer if it may be too small for the data, NULL otherwise. If the
+  // data does not fit, aom_daala_stop_encode() writes nothing and sets pos to
+  // 0.
+  uint8_t *buffer_end;
   od_ec_enc ec;
 };
 
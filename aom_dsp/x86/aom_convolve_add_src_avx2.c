@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+
+#include "./aom_config.h"
+#include "./aom_dsp_rtcd.h"
+#include "aom_dsp/aom_filter.h"
+#include "aom_ports/mem.h"
+
+// convolve_add_src is only used by the Wiener filter, whose taps are
+// symmetric (filter[k] == filter[6 - k]) with filter[7] == 0. Pixels at the
+// same distance from the centre are added first, so that each output needs
+// only two multiply-adds of 16-bit pairs:
+//   sum = (s0 + s6, s1 + s5) . (f0, f1) + (s2 + s4, s3) . (f2, f3)
+// The pair sums fit in 16 bits up to 12-bit pixels, and so does the result
+// of ROUND_POWER_OF_TWO(sum, FILTER_BITS) + s3, so the same kernel serves
+// both bit depths.
+//
+// The two passes are fused: each 16 pixel wide column is filtered
+// horizontally one row at a time into a window of 7 rows, which is then
+// filtered vertically. The horizontal output is clipped exactly as it is
+// stored in the intermediate buffer of the C version.
+
+static INLINE void check_wiener_filter(const int16_t *filter) {
+  assert(filter[0] == filter[6]);
+  assert(filter[1] == filter[5]);
+  assert(filter[2] == filter[4]);
+  assert(filter[7] == 0);
+  (void)filter;
+}
+
+static INLINE void init_wiener_coeffs(const int16_t *filter, __m256i *coeffs) {
+  coeffs[0] = _mm256_set1_epi32((int)((uint16_t)filter[0] |
+                                      ((uint32_t)(uint16_t)filter[1] << 16)));
+  coeffs[1] = _mm256_set1_epi32((int)((uint16_t)filter[2] |
+                                      ((uint32_t)(uint16_t)filter[3] << 16)));
+}
+
+// Filters 16 pixels given the 7 vectors s[k] of the pixels k - 3 away from
+// them. Returns ROUND_POWER_OF_TWO(sum, FILTER_BITS) + s[3], not clipped.
+static INLINE __m256i wiener_filter_16(const __m256i *s,
+                                       const __m256i *coeffs) {
+  const __m256i round = _mm256_set1_epi32(1 << (FILTER_BITS - 1));
+  const __m256i p06 = _mm256_add_epi16(s[0], s[6]);
+  const __m256i p15 = _mm256_add_epi16(s[1], s[5]);
+  const __m256i p24 = _mm256_add_epi16(s[2], s[4]);
+  // Each 128-bit lane is unpacked and packed back separately, so the pixels
+  // come out in their original order.
+  __m256i lo = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(p06, p15), coeffs[0]),
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(p24, s[3]), coeffs[1]));
+  __m256i hi = _mm256_add_epi32(
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(p06, p15), coeffs[0]),
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(p24, s[3]), coeffs[1]));
+  lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), FILTER_BITS);
+  hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), FILTER_BITS);
+  return _mm256_adds_epi16(_mm256_packs_epi32(lo, hi), s[3]);
+}
+
+static INLINE __m256i clip_16(__m256i v, const __m256i max) {
+  return _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), max);
+}
+
+static INLINE __m256i hfilter_row_16(const uint8_t *src,
+                                     const __m256i *coeffs) {
+  __m256i s[7];
+  int k;
+  for (k = 0; k < 7; ++k)
+    s[k] = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(src - 3 + k)));
+  return clip_16(wiener_filter_16(s, coeffs), _mm256_set1_epi16(255));
+}
+
+void aom_convolve8_add_src_avx2(const uint8_t *src, ptrdiff_t src_stride,
+                                uint8_t *dst, ptrdiff_t dst_stride,
+                                const int16_t *filter_x, int x_step_q4,
+                                const int16_t *filter_y, int y_step_q4, int w,
+                                int h) {
+  __m256i hcoeffs[2], vcoeffs[2];
+  int x, y, k;
+
+  assert(x_step_q4 == 16);
+  assert(y_step_q4 == 16);
+  check_wiener_filter(filter_x);
+  check_wiener_filter(filter_y);
+  init_wiener_coeffs(filter_x, hcoeffs);
+  init_wiener_coeffs(filter_y, vcoeffs);
+
+  for (x = 0; x + 16 <= w; x += 16) {
+    const uint8_t *s = src - 3 * src_stride + x;
+    uint8_t *d = dst + x;
+    __m256i rows[7];
+    for (k = 0; k < 6; ++k)
+      rows[k] = hfilter_row_16(s + k * src_stride, hcoeffs);
+    for (y = 0; y < h; ++y) {
+      __m256i v;
+      rows[6] = hfilter_row_16(s + (y + 6) * src_stride, hcoeffs);
+      v = wiener_filter_16(rows, vcoeffs);
+      _mm_storeu_si128((__m128i *)(d + y * dst_stride),
+                       _mm_packus_epi16(_mm256_castsi256_si128(v),
+                                        _mm256_extracti128_si256(v, 1)));
+      for (k = 0; k < 6; ++k) rows[k] = rows[k + 1];
+    }
+  }
+  if (x < w)
+    aom_convolve8_add_src_c(src + x, src_stride, dst + x, dst_stride, filter_x,
+                            x_step_q4, filter_y, y_step_q4, w - x, h);
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+static INLINE __m256i highbd_hfilter_row_16(const uint16_t *src,
+                                            const __m256i *coeffs,
+                                            const __m256i max) {
+  __m256i s[7];
+  int k;
+  for (k = 0; k < 7; ++k)
+    s[k] = _mm256_loadu_si256((const __m256i *)(src - 3 + k));
+  return clip_16(wiener_filter_16(s, coeffs), max);
+}
+
+void aom_highbd_convolve8_add_src_avx2(const uint8_t *src8,
+                                       ptrdiff_t src_stride, uint8_t *dst8,
+                                       ptrdiff_t dst_stride,
+                                       const int16_t *filter_x, int x_step_q4,
+                                       const int16_t *filter_y, int y_step_q4,
+                                       int w, int h, int bd) {
+  const uint16_t *const src = CONVERT_TO_SHORTPTR(src8);
+  uint16_t *const dst = CONVERT_TO_SHORTPTR(dst8);
+  const __m256i max = _mm256_set1_epi16((1 << bd) - 1);
+  __m256i hcoeffs[2], vcoeffs[2];
+  int x, y, k;
+
+  assert(x_step_q4 == 16);
+  assert(y_step_q4 == 16);
+  assert(bd <= 12);
+  check_wiener_filter(filter_x);
+  check_wiener_filter(filter_y);
+  init_wiener_coeffs(filter_x, hcoeffs);
+  init_wiener_coeffs(filter_y, vcoeffs);
+
+  for (x = 0; x + 16 <= w; x += 16) {
+    const uint16_t *s = src - 3 * src_stride + x;
+    uint16_t *d = dst + x;
+    __m256i rows[7];
+    for (k = 0; k < 6; ++k)
+      rows[k] = highbd_hfilter_row_16(s + k * src_stride, hcoeffs, max);
+    for (y = 0; y < h; ++y) {
+      rows[6] = highbd_hfilter_row_16(s + (y + 6) * src_stride, hcoeffs, max);
+      _mm256_storeu_si256((__m256i *)(d + y * dst_stride),
+                          clip_16(wiener_filter_16(rows, vcoeffs), max));
+      for (k = 0; k < 6; ++k) rows[k] = rows[k + 1];
+    }
+  }
+  if (x < w)
+    aom_highbd_convolve8_add_src_c(
+        CONVERT_TO_BYTEPTR(src + x), src_stride, CONVERT_TO_BYTEPTR(dst + x),
+        dst_stride, filter_x, x_step_q4, filter_y, y_step_q4, w - x, h, bd);
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
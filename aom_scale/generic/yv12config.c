@@ -28,15 +28,27 @@
 #if CONFIG_AV1
 // TODO(jkoleszar): Maybe replace this with struct aom_image
 
+void aom_invalidate_frame_buffer_cache(YV12_BUFFER_CONFIG *ybf) {
+#if CONFIG_GLOBAL_MOTION
+#if CONFIG_AOM_HIGHBITDEPTH
+  free(ybf->y_buffer_8bit);
+  ybf->y_buffer_8bit = NULL;
+#endif
+  free(ybf->corners);
+  ybf->corners = NULL;
+  ybf->num_corners = 0;
+#else
+  (void)ybf;
+#endif
+}
+
 int aom_free_frame_buffer(YV12_BUFFER_CONFIG *ybf) {
   if (ybf) {
     if (ybf->buffer_alloc_sz > 0) {
       aom_free(ybf->buffer_alloc);
     }
 
-#if CONFIG_AOM_HIGHBITDEPTH && CONFIG_GLOBAL_MOTION
-    if (ybf->y_buffer_8bit) free(ybf->y_buffer_8bit);
-#endif
+    aom_invalidate_frame_buffer_cache(ybf);
 
     /* buffer_alloc isn't accessed by most functions.  Rather y_buffer,
       u_buffer and v_buffer point to buffer_alloc and are used.  Clear out
@@ -167,12 +179,7 @@ int aom_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
                                        (uv_border_h * uv_stride) + uv_border_w,
                                    aom_byte_align);
 
-#if CONFIG_AOM_HIGHBITDEPTH && CONFIG_GLOBAL_MOTION
-    if (ybf->y_buffer_8bit) {
-      free(ybf->y_buffer_8bit);
-      ybf->y_buffer_8bit = NULL;
-    }
-#endif
+    aom_invalidate_frame_buffer_cache(ybf);
 
     ybf->corrupted = 0; /* assume not corrupted by errors */
     return 0;
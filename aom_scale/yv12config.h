@@ -60,6 +60,13 @@ typedef struct yv12_buffer_config {
   // for use in global motion detection. It is allocated on-demand.
   uint8_t *y_buffer_8bit;
 #endif
+#if CONFIG_GLOBAL_MOTION
+  // FAST corners of the luma plane, as (x, y) pairs, for use in global motion
+  // detection. They are allocated and found on-demand, so corners is NULL
+  // until then.
+  int *corners;
+  int num_corners;
+#endif
 
   uint8_t *buffer_alloc;
   size_t buffer_alloc_sz;
@@ -103,6 +110,11 @@ int aom_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height,
                              aom_get_frame_buffer_cb_fn_t cb, void *cb_priv);
 int aom_free_frame_buffer(YV12_BUFFER_CONFIG *ybf);
 
+// Frees the data derived from the frame contents and cached with the buffer,
+// such as the global motion features. This must be called when the contents
+// of the frame are replaced without reallocating the buffer.
+void aom_invalidate_frame_buffer_cache(YV12_BUFFER_CONFIG *ybf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,7 @@
 #include "aom/aom_decoder.h"
 #include "aom_ports/mem_ops.h"
 #include "aom_ports/aom_timer.h"
+#include "aom_util/aom_thread.h"
 
 #if CONFIG_AV1_DECODER
 #include "aom/aomdx.h"
@@ -56,6 +57,18 @@ struct AvxDecInputContext {
   struct WebmInputContext *webm_ctx;
 };
 
+struct KeyFrame {
+  int frame;   // Number of the input frame.
+  size_t pos;  // Offset of the IVF frame header in the mapped input.
+};
+
+// The key frames of the input, from which decoding can start.
+struct KeyFrameIndex {
+  struct KeyFrame *key_frames;
+  int count;
+  int allocated;
+};
+
 static const arg_def_t looparg =
     ARG_DEF(NULL, "loops", 1, "Number of times to decode the file");
 static const arg_def_t codecarg = ARG_DEF(NULL, "codec", 1, "Codec to use");
@@ -75,6 +88,12 @@ static const arg_def_t limitarg =
     ARG_DEF(NULL, "limit", 1, "Stop decoding after n frames");
 static const arg_def_t skiparg =
     ARG_DEF(NULL, "skip", 1, "Skip the first n input frames");
+static const arg_def_t seekarg =
+    ARG_DEF(NULL, "seek", 1,
+            "Start output at frame n, decoding from the key frame before it");
+static const arg_def_t framesarg =
+    ARG_DEF(NULL, "frames", 1,
+            "Output frames a to b-1 (a:b), like --seek=a --limit=b-a");
 static const arg_def_t postprocarg =
     ARG_DEF(NULL, "postproc", 0, "Postprocess decoded frames");
 static const arg_def_t summaryarg =
@@ -121,6 +140,8 @@ static const arg_def_t *all_args[] = { &codecarg,
                                        &progressarg,
                                        &limitarg,
                                        &skiparg,
+                                       &seekarg,
+                                       &framesarg,
                                        &postprocarg,
                                        &summaryarg,
                                        &outputfile,
@@ -259,12 +280,116 @@ static int read_frame(struct AvxDecInputContext *input, uint8_t **buf,
       return raw_read_frame(input->aom_input_ctx->file, buf, bytes_in_buffer,
                             buffer_size);
     case FILE_TYPE_IVF:
+      if (input->aom_input_ctx->map) {
+        // The frame is used in place, in the mapping of the file.
+        const uint8_t *frame = NULL;
+        const int ret = ivf_read_mapped_frame(input->aom_input_ctx, &frame,
+                                              bytes_in_buffer);
+        *buf = (uint8_t *)frame;
+        return ret;
+      }
       return ivf_read_frame(input->aom_input_ctx->file, buf, bytes_in_buffer,
                             buffer_size);
     default: return 1;
   }
 }
 
+static void add_key_frame(struct KeyFrameIndex *index, int frame, size_t pos) {
+  if (index->count == index->allocated) {
+    const int allocated = index->allocated ? 2 * index->allocated : 64;
+    struct KeyFrame *const key_frames = (struct KeyFrame *)realloc(
+        index->key_frames, allocated * sizeof(*key_frames));
+    if (!key_frames) fatal("Failed to allocate the key frame index");
+    index->key_frames = key_frames;
+    index->allocated = allocated;
+  }
+  index->key_frames[index->count].frame = frame;
+  index->key_frames[index->count].pos = pos;
+  ++index->count;
+}
+
+// Finds the key frames of the input by a scan of the frame headers, which
+// leaves the input at its current position. Returns 0 if the input can not
+// be repositioned.
+static int build_key_frame_index(struct AvxDecInputContext *input,
+                                 aom_codec_iface_t *iface,
+                                 struct KeyFrameIndex *index) {
+  struct AvxInputContext *const aom_ctx = input->aom_input_ctx;
+  int frame = 0;
+
+  switch (aom_ctx->file_type) {
+#if CONFIG_WEBM_IO
+    case FILE_TYPE_WEBM:
+      while (!webm_skip_frame(input->webm_ctx)) {
+        if (input->webm_ctx->is_key_frame) add_key_frame(index, frame, 0);
+        ++frame;
+      }
+      webm_rewind(input->webm_ctx);
+      return 1;
+#endif
+    case FILE_TYPE_IVF: {
+      const size_t start = aom_ctx->map_pos;
+      size_t pos = start;
+      const uint8_t *buf;
+      size_t bytes_in_buffer;
+
+      // Only the first bytes of each frame are read from the mapping.
+      if (!aom_ctx->map) return 0;
+      while (!ivf_read_mapped_frame(aom_ctx, &buf, &bytes_in_buffer)) {
+        aom_codec_stream_info_t si;
+        si.sz = sizeof(si);
+        if (bytes_in_buffer &&
+            !aom_codec_peek_stream_info(iface, buf,
+                                        (unsigned int)bytes_in_buffer, &si) &&
+            si.is_kf)
+          add_key_frame(index, frame, pos);
+        pos = aom_ctx->map_pos;
+        ++frame;
+      }
+      aom_ctx->map_pos = start;
+      return 1;
+    }
+    default: return 0;
+  }
+}
+
+// Moves the input to the last key frame at or before |frame|, and returns its
+// number. Returns 0 and leaves the input at the first frame if there is none.
+static int seek_key_frame(struct AvxDecInputContext *input,
+                          const struct KeyFrameIndex *index, int frame) {
+  const struct KeyFrame *key_frame = NULL;
+  int i;
+
+  for (i = 0; i < index->count && index->key_frames[i].frame <= frame; ++i)
+    key_frame = &index->key_frames[i];
+  if (!key_frame) return 0;
+
+  switch (input->aom_input_ctx->file_type) {
+#if CONFIG_WEBM_IO
+    case FILE_TYPE_WEBM:
+      for (i = 0; i < key_frame->frame; ++i) webm_skip_frame(input->webm_ctx);
+      break;
+#endif
+    case FILE_TYPE_IVF: input->aom_input_ctx->map_pos = key_frame->pos; break;
+    default: assert(0); return 0;
+  }
+  return key_frame->frame;
+}
+
+// Parses the a:b argument of --frames.
+static void parse_frame_range(const struct arg *arg, int *first, int *last) {
+  char *end;
+  const long a = strtol(arg->val, &end, 10);
+  long b = -1;
+
+  if (end != arg->val && *end == ':') b = strtol(end + 1, &end, 10);
+  if (*end || a < 0 || b <= a || b > INT_MAX)
+    die("Option %s: invalid frame range '%s', expected a:b with a < b\n",
+        arg->name, arg->val);
+  *first = (int)a;
+  *last = (int)b;
+}
+
 static void update_image_md5(const aom_image_t *img, const int planes[3],
                              MD5Context *md5) {
   int i, y;
@@ -348,14 +473,40 @@ static void show_progress(int frame_in, int frame_out, uint64_t dx_time) {
 struct ExternalFrameBuffer {
   uint8_t *data;
   size_t size;
-  int in_use;
+  int in_use;  // Held by the decoder and, until it is output, by aomdec.
 };
 
 struct ExternalFrameBufferList {
   int num_external_frame_buffers;
   struct ExternalFrameBuffer *ext_fb;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+#endif
 };
 
+static void lock_frame_buffers(struct ExternalFrameBufferList *ext_fb_list) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&ext_fb_list->mutex);
+#else
+  (void)ext_fb_list;
+#endif
+}
+
+static void unlock_frame_buffers(struct ExternalFrameBufferList *ext_fb_list) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&ext_fb_list->mutex);
+#else
+  (void)ext_fb_list;
+#endif
+}
+
+static void release_frame_buffer(struct ExternalFrameBufferList *ext_fb_list,
+                                 struct ExternalFrameBuffer *ext_fb) {
+  lock_frame_buffers(ext_fb_list);
+  --ext_fb->in_use;
+  unlock_frame_buffers(ext_fb_list);
+}
+
 // Callback used by libaom to request an external frame buffer. |cb_priv|
 // Application private data passed into the set function. |min_size| is the
 // minimum size in bytes needed to decode the next frame. |fb| pointer to the
@@ -368,23 +519,29 @@ static int get_av1_frame_buffer(void *cb_priv, size_t min_size,
   if (ext_fb_list == NULL) return -1;
 
   // Find a free frame buffer.
+  lock_frame_buffers(ext_fb_list);
   for (i = 0; i < ext_fb_list->num_external_frame_buffers; ++i) {
     if (!ext_fb_list->ext_fb[i].in_use) break;
   }
+  if (i < ext_fb_list->num_external_frame_buffers)
+    ext_fb_list->ext_fb[i].in_use = 1;
+  unlock_frame_buffers(ext_fb_list);
 
   if (i == ext_fb_list->num_external_frame_buffers) return -1;
 
   if (ext_fb_list->ext_fb[i].size < min_size) {
     free(ext_fb_list->ext_fb[i].data);
     ext_fb_list->ext_fb[i].data = (uint8_t *)calloc(min_size, sizeof(uint8_t));
-    if (!ext_fb_list->ext_fb[i].data) return -1;
+    if (!ext_fb_list->ext_fb[i].data) {
+      release_frame_buffer(ext_fb_list, &ext_fb_list->ext_fb[i]);
+      return -1;
+    }
 
     ext_fb_list->ext_fb[i].size = min_size;
   }
 
   fb->data = ext_fb_list->ext_fb[i].data;
   fb->size = ext_fb_list->ext_fb[i].size;
-  ext_fb_list->ext_fb[i].in_use = 1;
 
   // Set the frame buffer's private data to point at the external frame buffer.
   fb->priv = &ext_fb_list->ext_fb[i];
@@ -398,11 +555,158 @@ static int release_av1_frame_buffer(void *cb_priv,
                                     aom_codec_frame_buffer_t *fb) {
   struct ExternalFrameBuffer *const ext_fb =
       (struct ExternalFrameBuffer *)fb->priv;
-  (void)cb_priv;
-  ext_fb->in_use = 0;
+  release_frame_buffer((struct ExternalFrameBufferList *)cb_priv, ext_fb);
   return 0;
 }
 
+// Writes a frame of a single output file, or adds it to the MD5 sum if |md5|
+// is not NULL. The file and frame headers of Y4M output are in |header|.
+static void write_frame(FILE *file, MD5Context *md5, const char *header,
+                        size_t header_len, const aom_image_t *img,
+                        const int planes[3]) {
+  if (md5) {
+    MD5Update(md5, (const md5byte *)header, (unsigned int)header_len);
+    update_image_md5(img, planes, md5);
+  } else {
+    fwrite(header, 1, header_len, file);
+    write_image_file(img, planes, file);
+  }
+}
+
+#if CONFIG_MULTITHREAD
+#define OUTPUT_QUEUE_SIZE 4
+
+struct output_frame {
+  aom_image_t img;
+  int planes[3];
+  char header[2 * Y4M_BUFFER_SIZE];
+  size_t header_len;
+};
+
+/* Decoded frames waiting to be written or hashed by a thread, so that the
+ * decoder is not held up by the output. The frames are not copied: the
+ * decoder's frame buffers are held until the frames are output.
+ */
+struct output_queue {
+  struct output_frame frames[OUTPUT_QUEUE_SIZE];
+  FILE *file;
+  MD5Context *md5;
+  struct ExternalFrameBufferList *ext_fb_list;
+  int head;
+  int count;
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+static THREADFN output_queue_thread(void *arg) {
+  struct output_queue *const q = (struct output_queue *)arg;
+
+  pthread_mutex_lock(&q->mutex);
+  while (q->count || !q->stop) {
+    const struct output_frame *f = &q->frames[q->head];
+    struct ExternalFrameBuffer *const ext_fb =
+        (struct ExternalFrameBuffer *)f->img.fb_priv;
+
+    if (!q->count) {
+      pthread_cond_wait(&q->cond, &q->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    write_frame(q->file, q->md5, f->header, f->header_len, &f->img,
+                f->planes);
+    if (ext_fb) release_frame_buffer(q->ext_fb_list, ext_fb);
+
+    pthread_mutex_lock(&q->mutex);
+    q->head = (q->head + 1) % OUTPUT_QUEUE_SIZE;
+    q->count--;
+    pthread_cond_signal(&q->cond);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return THREAD_RETURN(NULL);
+}
+
+static struct output_queue *output_queue_create(
+    FILE *file, MD5Context *md5, struct ExternalFrameBufferList *ext_fb_list) {
+  struct output_queue *const q =
+      (struct output_queue *)calloc(1, sizeof(*q));
+  if (!q) fatal("Failed to allocate the output queue");
+  q->file = file;
+  q->md5 = md5;
+  q->ext_fb_list = ext_fb_list;
+  if (pthread_mutex_init(&q->mutex, NULL) ||
+      pthread_cond_init(&q->cond, NULL) ||
+      pthread_create(&q->thread, NULL, output_queue_thread, q))
+    fatal("Failed to create the output thread");
+  return q;
+}
+
+/* Queues a frame for output. A frame in one of the external frame buffers is
+ * held until it is output, others are output before returning, as their
+ * memory is reused for the next frame.
+ */
+static void output_queue_push(struct output_queue *q, const char *header,
+                              size_t header_len, const aom_image_t *img,
+                              const int planes[3]) {
+  struct ExternalFrameBuffer *const ext_fb =
+      (struct ExternalFrameBuffer *)img->fb_priv;
+  struct output_frame *f;
+
+  pthread_mutex_lock(&q->mutex);
+  while (q->count == OUTPUT_QUEUE_SIZE) pthread_cond_wait(&q->cond, &q->mutex);
+  f = &q->frames[(q->head + q->count) % OUTPUT_QUEUE_SIZE];
+  pthread_mutex_unlock(&q->mutex);
+
+  // The slot is not visible to the output thread until the count is updated.
+  memcpy(f->header, header, header_len);
+  f->header_len = header_len;
+  f->img = *img;
+  memcpy(f->planes, planes, sizeof(f->planes));
+  if (ext_fb) {
+    lock_frame_buffers(q->ext_fb_list);
+    ++ext_fb->in_use;
+    unlock_frame_buffers(q->ext_fb_list);
+  }
+
+  pthread_mutex_lock(&q->mutex);
+  q->count++;
+  pthread_cond_signal(&q->cond);
+  while (!ext_fb && q->count) pthread_cond_wait(&q->cond, &q->mutex);
+  pthread_mutex_unlock(&q->mutex);
+}
+
+/* Outputs the remaining frames and stops the output thread. */
+static void output_queue_stop(struct output_queue *q) {
+  pthread_mutex_lock(&q->mutex);
+  q->stop = 1;
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->mutex);
+  pthread_join(q->thread, NULL);
+  pthread_cond_destroy(&q->cond);
+  pthread_mutex_destroy(&q->mutex);
+  free(q);
+}
+#else
+struct output_queue;
+#endif
+
+static void write_or_queue_frame(struct output_queue *q, FILE *file,
+                                 MD5Context *md5, const char *header,
+                                 size_t header_len, const aom_image_t *img,
+                                 const int planes[3]) {
+#if CONFIG_MULTITHREAD
+  if (q) {
+    output_queue_push(q, header, header_len, img, planes);
+    return;
+  }
+#else
+  (void)q;
+#endif
+  write_frame(file, md5, header, header_len, img, planes);
+}
+
 static void generate_filename(const char *pattern, char *out, size_t q_len,
                               unsigned int d_w, unsigned int d_h,
                               unsigned int frame_in) {
@@ -509,6 +813,8 @@ static int main_loop(int argc, const char **argv_) {
   int do_md5 = 0, progress = 0, frame_parallel = 0;
   int stop_after = 0, postproc = 0, summary = 0, quiet = 1;
   int arg_skip = 0;
+  int seek_to = 0, seek_discard = 0;
+  struct KeyFrameIndex key_frame_index = { NULL, 0, 0 };
   int ec_enabled = 0;
   int keep_going = 0;
   const AvxInterface *interface = NULL;
@@ -538,7 +844,8 @@ static int main_loop(int argc, const char **argv_) {
 #endif
   int frame_avail, got_data, flush_decoder = 0;
   int num_external_frame_buffers = 0;
-  struct ExternalFrameBufferList ext_fb_list = { 0, NULL };
+  struct ExternalFrameBufferList ext_fb_list;
+  struct output_queue *output_queue = NULL;
 
   const char *outfile_pattern = NULL;
   char outfile_name[PATH_MAX] = { 0 };
@@ -556,7 +863,9 @@ static int main_loop(int argc, const char **argv_) {
   memset(&(webm_ctx), 0, sizeof(webm_ctx));
   input.webm_ctx = &webm_ctx;
 #endif
+  memset(&aom_input_ctx, 0, sizeof(aom_input_ctx));
   input.aom_input_ctx = &aom_input_ctx;
+  memset(&ext_fb_list, 0, sizeof(ext_fb_list));
 
   /* Parse command line */
   exec_name = argv_[0];
@@ -594,6 +903,12 @@ static int main_loop(int argc, const char **argv_) {
       stop_after = arg_parse_uint(&arg);
     } else if (arg_match(&arg, &skiparg, argi)) {
       arg_skip = arg_parse_uint(&arg);
+    } else if (arg_match(&arg, &seekarg, argi)) {
+      seek_to = arg_parse_uint(&arg);
+    } else if (arg_match(&arg, &framesarg, argi)) {
+      int last;
+      parse_frame_range(&arg, &seek_to, &last);
+      stop_after = last - seek_to;
     } else if (arg_match(&arg, &postprocarg, argi)) {
       postproc = 1;
     } else if (arg_match(&arg, &md5arg, argi)) {
@@ -648,6 +963,7 @@ static int main_loop(int argc, const char **argv_) {
     free(argv);
     usage_exit();
   }
+  if (seek_to && arg_skip) die("Error: --seek can not be used with --skip\n");
   /* Open file */
   infile = strcmp(fn, "-") ? fopen(fn, "rb") : set_binary_mode(stdin);
 
@@ -680,6 +996,10 @@ static int main_loop(int argc, const char **argv_) {
     return EXIT_FAILURE;
   }
 
+  // Frames are read in place from the mapping of the file when possible.
+  if (input.aom_input_ctx->file_type == FILE_TYPE_IVF)
+    aom_map_input_file(input.aom_input_ctx);
+
   outfile_pattern = outfile_pattern ? outfile_pattern : "-";
   single_file = is_single_file(outfile_pattern);
 
@@ -752,10 +1072,41 @@ static int main_loop(int argc, const char **argv_) {
     arg_skip--;
   }
 
+  if (seek_to) {
+    int key_frame = 0;
+    if (build_key_frame_index(&input, interface->codec_interface(),
+                              &key_frame_index))
+      key_frame = seek_key_frame(&input, &key_frame_index, seek_to);
+    else
+      warn("Input can not be indexed, decoding from the first frame.");
+    if (!quiet)
+      fprintf(stderr, "Seeking to frame %d from key frame %d.\n", seek_to,
+              key_frame);
+    // The frames before the sought one are decoded only as references.
+    frame_in = key_frame;
+    seek_discard = seek_to - key_frame;
+    if (stop_after) stop_after += seek_to;
+  }
+
+#if CONFIG_MULTITHREAD
+  // The frames are output by a thread straight from the decoder's frame
+  // buffers, so there must be enough of them to hold the queued frames.
+  if (!noblit && single_file && !num_external_frame_buffers) {
+    num_external_frame_buffers = AOM_MAXIMUM_WORK_BUFFERS +
+                                 AOM_MAXIMUM_REF_BUFFERS + OUTPUT_QUEUE_SIZE;
+    output_queue = output_queue_create(outfile, do_md5 ? &md5_ctx : NULL,
+                                       &ext_fb_list);
+  }
+#endif
+
   if (num_external_frame_buffers > 0) {
     ext_fb_list.num_external_frame_buffers = num_external_frame_buffers;
     ext_fb_list.ext_fb = (struct ExternalFrameBuffer *)calloc(
         num_external_frame_buffers, sizeof(*ext_fb_list.ext_fb));
+#if CONFIG_MULTITHREAD
+    if (pthread_mutex_init(&ext_fb_list.mutex, NULL))
+      fatal("Failed to initialize the frame buffer lock");
+#endif
     if (aom_codec_set_frame_buffer_functions(&decoder, get_av1_frame_buffer,
                                              release_av1_frame_buffer,
                                              &ext_fb_list)) {
@@ -825,8 +1176,13 @@ static int main_loop(int argc, const char **argv_) {
 
     got_data = 0;
     if ((img = aom_codec_get_frame(&decoder, &iter))) {
-      ++frame_out;
       got_data = 1;
+      if (seek_discard) {
+        --seek_discard;
+        img = NULL;
+      } else {
+        ++frame_out;
+      }
     }
 
     aom_usec_timer_mark(&timer);
@@ -923,9 +1279,9 @@ static int main_loop(int argc, const char **argv_) {
 #endif  // CONFIG_EXT_TILE
 
       if (single_file) {
+        char y4m_buf[2 * Y4M_BUFFER_SIZE];
+        size_t len = 0;
         if (use_y4m) {
-          char y4m_buf[Y4M_BUFFER_SIZE] = { 0 };
-          size_t len = 0;
           if (img->fmt == AOM_IMG_FMT_I440 || img->fmt == AOM_IMG_FMT_I44016) {
             fprintf(stderr, "Cannot produce y4m output for 440 sampling.\n");
             goto fail;
@@ -933,23 +1289,13 @@ static int main_loop(int argc, const char **argv_) {
           if (frame_out == 1) {
             // Y4M file header
             len = y4m_write_file_header(
-                y4m_buf, sizeof(y4m_buf), aom_input_ctx.width,
+                y4m_buf, Y4M_BUFFER_SIZE, aom_input_ctx.width,
                 aom_input_ctx.height, &aom_input_ctx.framerate, img->fmt,
                 img->bit_depth);
-            if (do_md5) {
-              MD5Update(&md5_ctx, (md5byte *)y4m_buf, (unsigned int)len);
-            } else {
-              fputs(y4m_buf, outfile);
-            }
           }
 
           // Y4M frame header
-          len = y4m_write_frame_header(y4m_buf, sizeof(y4m_buf));
-          if (do_md5) {
-            MD5Update(&md5_ctx, (md5byte *)y4m_buf, (unsigned int)len);
-          } else {
-            fputs(y4m_buf, outfile);
-          }
+          len += y4m_write_frame_header(y4m_buf + len, Y4M_BUFFER_SIZE);
         } else {
           if (frame_out == 1) {
             // Check if --yv12 or --i420 options are consistent with the
@@ -972,11 +1318,8 @@ static int main_loop(int argc, const char **argv_) {
           }
         }
 
-        if (do_md5) {
-          update_image_md5(img, planes, &md5_ctx);
-        } else {
-          write_image_file(img, planes, outfile);
-        }
+        write_or_queue_frame(output_queue, outfile, do_md5 ? &md5_ctx : NULL,
+                             y4m_buf, len, img, planes);
       } else {
         generate_filename(outfile_pattern, outfile_name, PATH_MAX, img->d_w,
                           img->d_h, frame_in);
@@ -1014,6 +1357,10 @@ fail:
 
 fail2:
 
+#if CONFIG_MULTITHREAD
+  if (output_queue) output_queue_stop(output_queue);
+#endif
+
   if (!noblit && single_file) {
     if (do_md5) {
       MD5Final(md5_digest, &md5_ctx);
@@ -1028,7 +1375,11 @@ fail2:
     webm_free(input.webm_ctx);
 #endif
 
-  if (input.aom_input_ctx->file_type != FILE_TYPE_WEBM) free(buf);
+  if (input.aom_input_ctx->file_type != FILE_TYPE_WEBM &&
+      !input.aom_input_ctx->map)
+    free(buf);
+  aom_unmap_input_file(input.aom_input_ctx);
+  free(key_frame_index.key_frames);
 
   if (scaled_img) aom_img_free(scaled_img);
 #if CONFIG_AOM_HIGHBITDEPTH
@@ -1038,6 +1389,9 @@ fail2:
   for (i = 0; i < ext_fb_list.num_external_frame_buffers; ++i) {
     free(ext_fb_list.ext_fb[i].data);
   }
+#if CONFIG_MULTITHREAD
+  if (ext_fb_list.ext_fb) pthread_mutex_destroy(&ext_fb_list.mutex);
+#endif
   free(ext_fb_list.ext_fb);
 
   fclose(infile);
@@ -46,6 +46,7 @@
 #include "aom/aom_integer.h"
 #include "aom_ports/aom_timer.h"
 #include "aom_ports/mem_ops.h"
+#include "aom_util/aom_thread.h"
 #if CONFIG_WEBM_IO
 #include "./webmenc.h"
 #endif
@@ -102,7 +103,14 @@ static int read_frame(struct AvxInputContext *input_ctx, aom_image_t *img) {
   int shortread = 0;
 
   if (input_ctx->file_type == FILE_TYPE_Y4M) {
-    if (y4m_input_fetch_frame(y4m, f, img) < 1) return 0;
+    if (input_ctx->map) {
+      if (y4m_input_fetch_frame_mapped(y4m, input_ctx->map,
+                                       input_ctx->map_size,
+                                       &input_ctx->map_pos, img) < 1)
+        return 0;
+    } else if (y4m_input_fetch_frame(y4m, f, img) < 1) {
+      return 0;
+    }
   } else {
     shortread = read_yuv_frame(input_ctx, img);
   }
@@ -408,6 +416,9 @@ static const arg_def_t frame_parallel_decoding =
     ARG_DEF(NULL, "frame-parallel", 1,
             "Enable frame parallel decodability features "
             "(0: false (default), 1: true)");
+static const arg_def_t row_mt =
+    ARG_DEF(NULL, "row-mt", 1,
+            "Enable row based multi-threading (0: off (default), 1: on)");
 #if CONFIG_DELTA_Q
 static const arg_def_t aq_mode = ARG_DEF(
     NULL, "aq-mode", 1,
@@ -497,6 +508,7 @@ static const arg_def_t *av1_args[] = { &cpu_used_av1,
                                        &qm_max,
 #endif
                                        &frame_parallel_decoding,
+                                       &row_mt,
                                        &aq_mode,
                                        &frame_periodic_boost,
                                        &noise_sens,
@@ -545,6 +557,7 @@ static const int av1_arg_ctrl_map[] = { AOME_SET_CPUUSED,
                                         AV1E_SET_QM_MAX,
 #endif
                                         AV1E_SET_FRAME_PARALLEL_DECODING,
+                                        AV1E_SET_ROW_MT,
                                         AV1E_SET_AQ_MODE,
                                         AV1E_SET_FRAME_PERIODIC_BOOST,
                                         AV1E_SET_NOISE_SENSITIVITY,
@@ -883,6 +896,9 @@ struct stream_state {
   struct aom_image *img;
   aom_codec_ctx_t decoder;
   int mismatch_seen;
+#if CONFIG_MULTITHREAD
+  struct output_queue *output_queue;
+#endif
 };
 
 static void validate_positive_rational(const char *msg,
@@ -1045,6 +1061,7 @@ static void open_input_file(struct AvxInputContext *input) {
       input->framerate.denominator = input->y4m.fps_d;
       input->fmt = input->y4m.aom_fmt;
       input->bit_depth = input->y4m.bit_depth;
+      aom_map_input_file(input);
     } else
       fatal("Unsupported Y4M stream.");
   } else if (input->detect.buf_read == 4 && fourcc_is_ivf(input->detect.buf)) {
@@ -1055,6 +1072,7 @@ static void open_input_file(struct AvxInputContext *input) {
 }
 
 static void close_input_file(struct AvxInputContext *input) {
+  aom_unmap_input_file(input);
   fclose(input->file);
   if (input->file_type == FILE_TYPE_Y4M) y4m_input_close(&input->y4m);
 }
@@ -1680,6 +1698,150 @@ static void update_quantizer_histogram(struct stream_state *stream) {
   }
 }
 
+static void write_packet(struct stream_state *stream,
+                         const aom_codec_cx_pkt_t *pkt) {
+  static size_t fsize = 0;
+  static FileOffset ivf_header_pos = 0;
+
+#if CONFIG_WEBM_IO
+  if (stream->config.write_webm) {
+    write_webm_block(&stream->webm_ctx, &stream->config.cfg, pkt);
+  }
+#endif
+  if (!stream->config.write_webm) {
+    if (pkt->data.frame.partition_id <= 0) {
+      ivf_header_pos = ftello(stream->file);
+      fsize = pkt->data.frame.sz;
+
+      ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
+    } else {
+      fsize += pkt->data.frame.sz;
+
+      if (!(pkt->data.frame.flags & AOM_FRAME_IS_FRAGMENT)) {
+        const FileOffset currpos = ftello(stream->file);
+        fseeko(stream->file, ivf_header_pos, SEEK_SET);
+        ivf_write_frame_size(stream->file, fsize);
+        fseeko(stream->file, currpos, SEEK_SET);
+      }
+    }
+
+    (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz, stream->file);
+  }
+}
+
+#if CONFIG_MULTITHREAD
+/* Number of packets the output thread may lag behind the encoder. */
+#define OUTPUT_QUEUE_SIZE 16
+
+struct output_packet {
+  struct stream_state *stream;
+  aom_codec_cx_pkt_t pkt;
+  void *buf;
+  size_t buf_sz;
+};
+
+/* Compressed frames waiting to be written to the output files by a thread,
+ * so that the encoder is not held up by the writes.
+ */
+struct output_queue {
+  struct output_packet packets[OUTPUT_QUEUE_SIZE];
+  int head;
+  int count;
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+static THREADFN output_queue_thread(void *arg) {
+  struct output_queue *const q = (struct output_queue *)arg;
+
+  pthread_mutex_lock(&q->mutex);
+  while (q->count || !q->stop) {
+    const struct output_packet *p = &q->packets[q->head];
+
+    if (!q->count) {
+      pthread_cond_wait(&q->cond, &q->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    write_packet(p->stream, &p->pkt);
+
+    pthread_mutex_lock(&q->mutex);
+    q->head = (q->head + 1) % OUTPUT_QUEUE_SIZE;
+    q->count--;
+    pthread_cond_signal(&q->cond);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return THREAD_RETURN(NULL);
+}
+
+static void output_queue_start(struct output_queue *q) {
+  memset(q, 0, sizeof(*q));
+  if (pthread_mutex_init(&q->mutex, NULL) ||
+      pthread_cond_init(&q->cond, NULL) ||
+      pthread_create(&q->thread, NULL, output_queue_thread, q))
+    fatal("Failed to create the output thread");
+}
+
+/* Copies the packet, as its data is only valid until the next call to the
+ * encoder, and queues it for writing.
+ */
+static void output_queue_push(struct output_queue *q,
+                              struct stream_state *stream,
+                              const aom_codec_cx_pkt_t *pkt) {
+  struct output_packet *p;
+
+  pthread_mutex_lock(&q->mutex);
+  while (q->count == OUTPUT_QUEUE_SIZE) pthread_cond_wait(&q->cond, &q->mutex);
+  p = &q->packets[(q->head + q->count) % OUTPUT_QUEUE_SIZE];
+  pthread_mutex_unlock(&q->mutex);
+
+  // The slot is not visible to the output thread until the count is updated.
+  if (p->buf_sz < pkt->data.frame.sz) {
+    free(p->buf);
+    p->buf = malloc(pkt->data.frame.sz);
+    if (!p->buf) fatal("Failed to allocate compressed data buffer");
+    p->buf_sz = pkt->data.frame.sz;
+  }
+  memcpy(p->buf, pkt->data.frame.buf, pkt->data.frame.sz);
+  p->stream = stream;
+  p->pkt = *pkt;
+  p->pkt.data.frame.buf = p->buf;
+
+  pthread_mutex_lock(&q->mutex);
+  q->count++;
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->mutex);
+}
+
+/* Writes the remaining packets and stops the output thread. */
+static void output_queue_stop(struct output_queue *q) {
+  int i;
+
+  pthread_mutex_lock(&q->mutex);
+  q->stop = 1;
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->mutex);
+  pthread_join(q->thread, NULL);
+  pthread_cond_destroy(&q->cond);
+  pthread_mutex_destroy(&q->mutex);
+  for (i = 0; i < OUTPUT_QUEUE_SIZE; ++i) free(q->packets[i].buf);
+}
+#endif
+
+static void write_or_queue_packet(struct stream_state *stream,
+                                  const aom_codec_cx_pkt_t *pkt) {
+#if CONFIG_MULTITHREAD
+  if (stream->output_queue) {
+    output_queue_push(stream->output_queue, stream, pkt);
+    return;
+  }
+#endif
+  write_packet(stream, pkt);
+}
+
 static void get_cx_data(struct stream_state *stream,
                         struct AvxEncoderConfig *global, int *got_data) {
   const aom_codec_cx_pkt_t *pkt;
@@ -1688,9 +1850,6 @@ static void get_cx_data(struct stream_state *stream,
 
   *got_data = 0;
   while ((pkt = aom_codec_get_cx_data(&stream->encoder, &iter))) {
-    static size_t fsize = 0;
-    static FileOffset ivf_header_pos = 0;
-
     switch (pkt->kind) {
       case AOM_CODEC_CX_FRAME_PKT:
         if (!(pkt->data.frame.flags & AOM_FRAME_IS_FRAGMENT)) {
@@ -1700,31 +1859,7 @@ static void get_cx_data(struct stream_state *stream,
           fprintf(stderr, " %6luF", (unsigned long)pkt->data.frame.sz);
 
         update_rate_histogram(stream->rate_hist, cfg, pkt);
-#if CONFIG_WEBM_IO
-        if (stream->config.write_webm) {
-          write_webm_block(&stream->webm_ctx, cfg, pkt);
-        }
-#endif
-        if (!stream->config.write_webm) {
-          if (pkt->data.frame.partition_id <= 0) {
-            ivf_header_pos = ftello(stream->file);
-            fsize = pkt->data.frame.sz;
-
-            ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
-          } else {
-            fsize += pkt->data.frame.sz;
-
-            if (!(pkt->data.frame.flags & AOM_FRAME_IS_FRAGMENT)) {
-              const FileOffset currpos = ftello(stream->file);
-              fseeko(stream->file, ivf_header_pos, SEEK_SET);
-              ivf_write_frame_size(stream->file, fsize);
-              fseeko(stream->file, currpos, SEEK_SET);
-            }
-          }
-
-          (void)fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
-                       stream->file);
-        }
+        write_or_queue_packet(stream, pkt);
         stream->nbytes += pkt->data.raw.sz;
 
         *got_data = 1;
@@ -1890,18 +2025,207 @@ static void print_time(const char *label, int64_t etl) {
   }
 }
 
+/* Number of frames the input thread may read ahead of the encoder. */
+#define INPUT_QUEUE_SIZE 4
+
+/* Frames read and converted to the format of the encoder, in decoding order.
+ * With CONFIG_MULTITHREAD, a thread reads ahead of the encoder into a ring of
+ * INPUT_QUEUE_SIZE images; otherwise each frame is read when it is needed.
+ */
+struct input_queue {
+  struct AvxInputContext *input;
+  /* Image the input is read into when it needs a conversion. */
+  aom_image_t *raw;
+  int limit;
+  int upshift;
+  int input_shift;
+  aom_image_t frames[INPUT_QUEUE_SIZE];
+  int64_t input_pos[INPUT_QUEUE_SIZE];
+#if CONFIG_MULTITHREAD
+  int head;
+  int count;
+  int popped;
+  int frames_read;
+  int eof;
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+};
+
+static int64_t input_position(const struct AvxInputContext *input) {
+  return input->map ? (int64_t)input->map_pos : (int64_t)ftello(input->file);
+}
+
+static void copy_image(aom_image_t *dst, const aom_image_t *src) {
+  const int bytes_per_sample = (src->fmt & AOM_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  int plane;
+
+  for (plane = 0; plane < 3; ++plane) {
+    const int w = aom_img_plane_width(src, plane) * bytes_per_sample;
+    const int h = aom_img_plane_height(src, plane);
+    const unsigned char *src_buf = src->planes[plane];
+    unsigned char *dst_buf = dst->planes[plane];
+    int y;
+
+    for (y = 0; y < h; ++y) {
+      memcpy(dst_buf, src_buf, w);
+      src_buf += src->stride[plane];
+      dst_buf += dst->stride[plane];
+    }
+  }
+}
+
+/* Reads the next frame and converts it for the encoder. If |own| is set the
+ * returned image is |dst| and stays valid until |dst| is reused, otherwise it
+ * may be the buffer of the reader, valid until the next read. Returns NULL at
+ * the end of the input.
+ */
+static aom_image_t *fetch_frame(struct input_queue *q, aom_image_t *dst,
+                                int own) {
+  struct AvxInputContext *const input = q->input;
+  const int y4m = input->file_type == FILE_TYPE_Y4M;
+  // Mapped Y4M frames that need no conversion live as long as the mapping.
+  const int in_place =
+      !y4m || (input->map && y4m_input_frames_are_mapped(&input->y4m));
+  const int direct = own && !q->upshift && in_place;
+  aom_image_t *const src = direct ? dst : q->raw;
+
+  if (direct && !y4m && !dst->img_data)
+    aom_img_alloc(dst, input->fmt, input->width, input->height, 32);
+  if (!read_frame(input, src)) return NULL;
+  if (direct || (!own && !q->upshift)) return src;
+
+  if (!dst->img_data)
+    aom_img_alloc(dst,
+                  q->upshift ? src->fmt | AOM_IMG_FMT_HIGHBITDEPTH : src->fmt,
+                  input->width, input->height, 32);
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (q->upshift) {
+    // Input bit depth and stream bit depth do not match, so up shift frame to
+    // stream bit depth
+    aom_img_upshift(dst, src, q->input_shift);
+    return dst;
+  }
+#endif
+  copy_image(dst, src);
+  return dst;
+}
+
+#if CONFIG_MULTITHREAD
+static THREADFN input_queue_thread(void *arg) {
+  struct input_queue *const q = (struct input_queue *)arg;
+
+  pthread_mutex_lock(&q->mutex);
+  while (!q->stop && !q->eof) {
+    const int slot = (q->head + q->count) % INPUT_QUEUE_SIZE;
+    aom_image_t *img;
+    int64_t input_pos;
+
+    if (q->count == INPUT_QUEUE_SIZE) {
+      pthread_cond_wait(&q->cond, &q->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    // The slot is not visible to the encoder until the count is updated.
+    img = (!q->limit || q->frames_read < q->limit)
+              ? fetch_frame(q, &q->frames[slot], 1)
+              : NULL;
+    input_pos = img ? input_position(q->input) : 0;
+    if (img) q->frames_read++;
+
+    pthread_mutex_lock(&q->mutex);
+    if (img) {
+      q->input_pos[slot] = input_pos;
+      q->count++;
+    } else {
+      q->eof = 1;
+    }
+    pthread_cond_signal(&q->cond);
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return THREAD_RETURN(NULL);
+}
+#endif
+
+static void input_queue_start(struct input_queue *q,
+                              struct AvxInputContext *input, aom_image_t *raw,
+                              int frame_limit, int upshift, int input_shift) {
+  memset(q, 0, sizeof(*q));
+  q->input = input;
+  q->raw = raw;
+  q->limit = frame_limit;
+  q->upshift = upshift;
+  q->input_shift = input_shift;
+#if CONFIG_MULTITHREAD
+  if (pthread_mutex_init(&q->mutex, NULL) ||
+      pthread_cond_init(&q->cond, NULL) ||
+      pthread_create(&q->thread, NULL, input_queue_thread, q))
+    fatal("Failed to create the input thread");
+#endif
+}
+
+/* Returns the next frame, and the position of the input file after it, or
+ * NULL at the end of the input. The frame is valid until the next call.
+ */
+static aom_image_t *input_queue_next(struct input_queue *q,
+                                     int64_t *input_pos) {
+#if CONFIG_MULTITHREAD
+  aom_image_t *img = NULL;
+
+  pthread_mutex_lock(&q->mutex);
+  if (q->popped) {
+    q->head = (q->head + 1) % INPUT_QUEUE_SIZE;
+    q->count--;
+    q->popped = 0;
+    pthread_cond_signal(&q->cond);
+  }
+  while (!q->count && !q->eof) pthread_cond_wait(&q->cond, &q->mutex);
+  if (q->count) {
+    img = &q->frames[q->head];
+    *input_pos = q->input_pos[q->head];
+    q->popped = 1;
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return img;
+#else
+  aom_image_t *const img = fetch_frame(q, &q->frames[0], 0);
+  if (img) *input_pos = input_position(q->input);
+  return img;
+#endif
+}
+
+static void input_queue_stop(struct input_queue *q) {
+  int i;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&q->mutex);
+  q->stop = 1;
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->mutex);
+  pthread_join(q->thread, NULL);
+  pthread_cond_destroy(&q->cond);
+  pthread_mutex_destroy(&q->mutex);
+#endif
+  for (i = 0; i < INPUT_QUEUE_SIZE; ++i) aom_img_free(&q->frames[i]);
+}
+
 int main(int argc, const char **argv_) {
   int pass;
   aom_image_t raw;
 #if CONFIG_AOM_HIGHBITDEPTH
-  aom_image_t raw_shift;
-  int allocated_raw_shift = 0;
   int use_16bit_internal = 0;
   int input_shift = 0;
 #endif
   int frame_avail, got_data;
 
   struct AvxInputContext input;
+  struct input_queue input_queue;
+#if CONFIG_MULTITHREAD
+  struct output_queue output_queue;
+#endif
   struct AvxEncoderConfig global;
   struct stream_state *streams = NULL;
   char **argv, **argi;
@@ -1971,6 +2295,7 @@ int main(int argc, const char **argv_) {
     int64_t estimated_time_left = -1;
     int64_t average_rate = -1;
     int64_t lagged_count = 0;
+    int64_t input_pos = 0;
 
     open_input_file(&input);
 
@@ -2161,14 +2486,29 @@ int main(int argc, const char **argv_) {
     }
 #endif
 
+#if CONFIG_AOM_HIGHBITDEPTH
+    input_queue_start(&input_queue, &input, &raw, global.limit,
+                      input_shift ||
+                          (use_16bit_internal && input.bit_depth == 8),
+                      input_shift);
+#else
+    input_queue_start(&input_queue, &input, &raw, global.limit, 0, 0);
+#endif
+#if CONFIG_MULTITHREAD
+    output_queue_start(&output_queue);
+    FOREACH_STREAM(stream->output_queue = &output_queue);
+#endif
+
     frame_avail = 1;
     got_data = 0;
 
     while (frame_avail || got_data) {
       struct aom_usec_timer timer;
+      aom_image_t *frame_to_encode = NULL;
 
       if (!global.limit || frames_in < global.limit) {
-        frame_avail = read_frame(&input, &raw);
+        frame_to_encode = input_queue_next(&input_queue, &input_pos);
+        frame_avail = frame_to_encode != NULL;
 
         if (frame_avail) frames_in++;
         seen_frames =
@@ -2197,41 +2537,26 @@ int main(int argc, const char **argv_) {
 
       if (frames_in > global.skip_frames) {
 #if CONFIG_AOM_HIGHBITDEPTH
-        aom_image_t *frame_to_encode;
-        if (input_shift || (use_16bit_internal && input.bit_depth == 8)) {
-          assert(use_16bit_internal);
-          // Input bit depth and stream bit depth do not match, so up
-          // shift frame to stream bit depth
-          if (!allocated_raw_shift) {
-            aom_img_alloc(&raw_shift, raw.fmt | AOM_IMG_FMT_HIGHBITDEPTH,
-                          input.width, input.height, 32);
-            allocated_raw_shift = 1;
-          }
-          aom_img_upshift(&raw_shift, &raw, input_shift);
-          frame_to_encode = &raw_shift;
-        } else {
-          frame_to_encode = &raw;
-        }
         aom_usec_timer_start(&timer);
         if (use_16bit_internal) {
-          assert(frame_to_encode->fmt & AOM_IMG_FMT_HIGHBITDEPTH);
+          assert(!frame_to_encode ||
+                 (frame_to_encode->fmt & AOM_IMG_FMT_HIGHBITDEPTH));
           FOREACH_STREAM({
             if (stream->config.use_16bit_internal)
-              encode_frame(stream, &global,
-                           frame_avail ? frame_to_encode : NULL, frames_in);
+              encode_frame(stream, &global, frame_to_encode, frames_in);
             else
               assert(0);
           });
         } else {
-          assert((frame_to_encode->fmt & AOM_IMG_FMT_HIGHBITDEPTH) == 0);
-          FOREACH_STREAM(encode_frame(stream, &global,
-                                      frame_avail ? frame_to_encode : NULL,
-                                      frames_in));
+          assert(!frame_to_encode ||
+                 (frame_to_encode->fmt & AOM_IMG_FMT_HIGHBITDEPTH) == 0);
+          FOREACH_STREAM(
+              encode_frame(stream, &global, frame_to_encode, frames_in));
         }
 #else
         aom_usec_timer_start(&timer);
-        FOREACH_STREAM(encode_frame(stream, &global, frame_avail ? &raw : NULL,
-                                    frames_in));
+        FOREACH_STREAM(
+            encode_frame(stream, &global, frame_to_encode, frames_in));
 #endif
         aom_usec_timer_mark(&timer);
         cx_time += aom_usec_timer_elapsed(&timer);
@@ -2243,7 +2568,7 @@ int main(int argc, const char **argv_) {
 
         if (!got_data && input.length && streams != NULL &&
             !streams->frames_out) {
-          lagged_count = global.limit ? seen_frames : ftello(input.file);
+          lagged_count = global.limit ? seen_frames : input_pos;
         } else if (input.length) {
           int64_t remaining;
           int64_t rate;
@@ -2255,7 +2580,6 @@ int main(int argc, const char **argv_) {
             remaining = 1000 * (global.limit - global.skip_frames -
                                 seen_frames + lagged_count);
           } else {
-            const int64_t input_pos = ftello(input.file);
             const int64_t input_pos_lagged = input_pos - lagged_count;
             const int64_t input_limit = input.length;
 
@@ -2276,6 +2600,12 @@ int main(int argc, const char **argv_) {
       if (!global.quiet) fprintf(stderr, "\033[K");
     }
 
+    input_queue_stop(&input_queue);
+#if CONFIG_MULTITHREAD
+    output_queue_stop(&output_queue);
+    FOREACH_STREAM(stream->output_queue = NULL);
+#endif
+
     if (stream_cnt > 1) fprintf(stderr, "\n");
 
     if (!global.quiet) {
@@ -2352,9 +2682,6 @@ int main(int argc, const char **argv_) {
     });
 #endif
 
-#if CONFIG_AOM_HIGHBITDEPTH
-  if (allocated_raw_shift) aom_img_free(&raw_shift);
-#endif
   aom_img_free(&raw);
   free(argv);
   free(streams);
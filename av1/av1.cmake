@@ -183,7 +183,8 @@ set(AOM_AV1_ENCODER_SSSE3_INTRIN
 
 set(AOM_AV1_ENCODER_AVX2_INTRIN
     "${AOM_ROOT}/av1/encoder/x86/error_intrin_avx2.c"
-    "${AOM_ROOT}/av1/encoder/x86/hybrid_fwd_txfm_avx2.c")
+    "${AOM_ROOT}/av1/encoder/x86/hybrid_fwd_txfm_avx2.c"
+    "${AOM_ROOT}/av1/encoder/x86/temporal_filter_apply_avx2.c")
 
 set(AOM_AV1_ENCODER_NEON_INTRIN
     "${AOM_ROOT}/av1/encoder/arm/neon/quantize_neon.c")
@@ -236,7 +237,25 @@ if (CONFIG_CDEF)
 
   set(AOM_AV1_ENCODER_SOURCES
       ${AOM_AV1_ENCODER_SOURCES}
-      "${AOM_ROOT}/av1/encoder/pickcdef.c")
+      "${AOM_ROOT}/av1/encoder/pickcdef.c"
+      "${AOM_ROOT}/av1/encoder/pickcdef.h"
+      "${AOM_ROOT}/av1/encoder/pickcdef_simd.h")
+
+  set(AOM_AV1_ENCODER_SSE2_INTRIN
+      ${AOM_AV1_ENCODER_SSE2_INTRIN}
+      "${AOM_ROOT}/av1/encoder/pickcdef_sse2.c")
+
+  set(AOM_AV1_ENCODER_SSSE3_INTRIN
+      ${AOM_AV1_ENCODER_SSSE3_INTRIN}
+      "${AOM_ROOT}/av1/encoder/pickcdef_ssse3.c")
+
+  set(AOM_AV1_ENCODER_SSE4_1_INTRIN
+      ${AOM_AV1_ENCODER_SSE4_1_INTRIN}
+      "${AOM_ROOT}/av1/encoder/pickcdef_sse4.c")
+
+  set(AOM_AV1_ENCODER_NEON_INTRIN
+      ${AOM_AV1_ENCODER_NEON_INTRIN}
+      "${AOM_ROOT}/av1/encoder/pickcdef_neon.c")
 
   set(AOM_AV1_COMMON_SSE2_INTRIN
       ${AOM_AV1_COMMON_SSE2_INTRIN}
@@ -366,6 +385,10 @@ if (CONFIG_WARPED_MOTION)
   set(AOM_AV1_COMMON_SSE2_INTRIN
       ${AOM_AV1_COMMON_SSE2_INTRIN}
       "${AOM_ROOT}/av1/common/x86/warp_plane_sse2.c")
+
+  set(AOM_AV1_COMMON_AVX2_INTRIN
+      ${AOM_AV1_COMMON_AVX2_INTRIN}
+      "${AOM_ROOT}/av1/common/x86/frame_error_avx2.c")
 endif ()
 
 # Setup AV1 common/decoder/encoder targets. The libaom target must exist before
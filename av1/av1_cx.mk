@@ -110,6 +110,12 @@ AV1_CX_SRCS-yes += encoder/mbgraph.c
 AV1_CX_SRCS-yes += encoder/mbgraph.h
 ifeq ($(CONFIG_CDEF),yes)
 AV1_CX_SRCS-yes += encoder/pickcdef.c
+AV1_CX_SRCS-yes += encoder/pickcdef.h
+AV1_CX_SRCS-yes += encoder/pickcdef_simd.h
+AV1_CX_SRCS-$(HAVE_SSE2) += encoder/pickcdef_sse2.c
+AV1_CX_SRCS-$(HAVE_SSSE3) += encoder/pickcdef_ssse3.c
+AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/pickcdef_sse4.c
+AV1_CX_SRCS-$(HAVE_NEON) += encoder/pickcdef_neon.c
 endif
 ifeq ($(CONFIG_PVQ),yes)
 # PVQ from daala
@@ -125,6 +131,7 @@ endif
 
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/av1_quantize_sse2.c
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/temporal_filter_apply_sse2.asm
+AV1_CX_SRCS-$(HAVE_AVX2) += encoder/x86/temporal_filter_apply_avx2.c
 ifeq ($(CONFIG_AOM_HIGHBITDEPTH),yes)
 AV1_CX_SRCS-$(HAVE_SSE2) += encoder/x86/highbd_block_error_intrin_sse2.c
 endif
@@ -151,6 +158,15 @@ endif
 
 AV1_CX_SRCS-$(HAVE_AVX2) += encoder/x86/error_intrin_avx2.c
 
+ifeq ($(CONFIG_LOOP_RESTORATION),yes)
+AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/pickrst_sse4.c
+endif
+
+ifeq ($(CONFIG_GLOBAL_MOTION),yes)
+AV1_CX_SRCS-$(HAVE_SSE4_1) += encoder/x86/corner_match_sse4.c
+AV1_CX_SRCS-$(HAVE_AVX2) += encoder/x86/corner_match_avx2.c
+endif
+
 ifneq ($(CONFIG_AOM_HIGHBITDEPTH),yes)
 AV1_CX_SRCS-$(HAVE_NEON) += encoder/arm/neon/dct_neon.c
 AV1_CX_SRCS-$(HAVE_NEON) += encoder/arm/neon/error_neon.c
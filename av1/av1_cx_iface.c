@@ -63,6 +63,7 @@ struct av1_extracfg {
   unsigned int disable_tempmv;
 #endif
   unsigned int frame_parallel_decoding_mode;
+  unsigned int row_mt;
   AQ_MODE aq_mode;
   unsigned int frame_periodic_boost;
   aom_bit_depth_t bit_depth;
@@ -122,6 +123,7 @@ static struct av1_extracfg default_extra_cfg = {
   0,  // disable temporal mv prediction
 #endif
   1,                            // frame_parallel_decoding_mode
+  0,                            // row_mt
   NO_AQ,                        // aq_mode
   CONFIG_XIPHRC,                // frame_periodic_delta_q
   AOM_BITS_8,                   // Bit depth
@@ -280,6 +282,7 @@ static aom_codec_err_t validate_config(aom_codec_alg_priv_t *ctx,
 #if CONFIG_LOOPFILTERING_ACROSS_TILES
   RANGE_CHECK_HI(extra_cfg, loop_filter_across_tiles_enabled, 1);
 #endif  // CONFIG_LOOPFILTERING_ACROSS_TILES
+  RANGE_CHECK_HI(extra_cfg, row_mt, 1);
   RANGE_CHECK_HI(extra_cfg, sharpness, 7);
   RANGE_CHECK_HI(extra_cfg, arnr_max_frames, 15);
   RANGE_CHECK_HI(extra_cfg, arnr_strength, 6);
@@ -534,6 +537,7 @@ static aom_codec_err_t set_encoder_config(
 #endif  // CONFIG_LOOPFILTERING_ACROSS_TILES
   oxcf->error_resilient_mode = cfg->g_error_resilient;
   oxcf->frame_parallel_decoding_mode = extra_cfg->frame_parallel_decoding_mode;
+  oxcf->row_mt = extra_cfg->row_mt;
 
   oxcf->aq_mode = extra_cfg->aq_mode;
 
@@ -711,6 +715,13 @@ static aom_codec_err_t ctrl_set_tile_loopfilter(aom_codec_alg_priv_t *ctx,
 }
 #endif  // CONFIG_LOOPFILTERING_ACROSS_TILES
 
+static aom_codec_err_t ctrl_set_row_mt(aom_codec_alg_priv_t *ctx,
+                                       va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.row_mt = CAST(AV1E_SET_ROW_MT, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+
 static aom_codec_err_t ctrl_set_arnr_max_frames(aom_codec_alg_priv_t *ctx,
                                                 va_list args) {
   struct av1_extracfg extra_cfg = ctx->extra_cfg;
@@ -1112,7 +1123,8 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
       // Store the original flags in to the frame buffer. Will extract the
       // key frame flag when we actually encode this frame.
       if (av1_receive_raw_frame(cpi, flags | ctx->next_frame_flags, &sd,
-                                dst_time_stamp, dst_end_time_stamp)) {
+                                dst_time_stamp, dst_end_time_stamp,
+                                (aom_image_t *)img)) {
         res = update_error_state(ctx, &cpi->common.error);
       }
       ctx->next_frame_flags = 0;
@@ -1331,6 +1343,19 @@ static aom_codec_err_t ctrl_get_active_map(aom_codec_alg_priv_t *ctx,
   }
 }
 
+static aom_codec_err_t ctrl_set_zero_copy_input(aom_codec_alg_priv_t *ctx,
+                                                va_list args) {
+  aom_zero_copy_input_t *const zero_copy =
+      va_arg(args, aom_zero_copy_input_t *);
+
+  if (zero_copy) {
+    ctx->cpi->zero_copy_input = *zero_copy;
+    return AOM_CODEC_OK;
+  } else {
+    return AOM_CODEC_INVALID_PARAM;
+  }
+}
+
 static aom_codec_err_t ctrl_set_scale_mode(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   aom_scaling_mode_t *const mode = va_arg(args, aom_scaling_mode_t *);
@@ -1401,6 +1426,7 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AOME_SET_ROI_MAP, ctrl_set_roi_map },
   { AOME_SET_ACTIVEMAP, ctrl_set_active_map },
   { AOME_SET_SCALEMODE, ctrl_set_scale_mode },
+  { AV1E_SET_ZERO_COPY_INPUT, ctrl_set_zero_copy_input },
   { AOME_SET_CPUUSED, ctrl_set_cpuused },
   { AOME_SET_ENABLEAUTOALTREF, ctrl_set_enable_auto_alt_ref },
 #if CONFIG_EXT_REFS
@@ -1416,6 +1442,7 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
 #if CONFIG_LOOPFILTERING_ACROSS_TILES
   { AV1E_SET_TILE_LOOPFILTER, ctrl_set_tile_loopfilter },
 #endif  // CONFIG_LOOPFILTERING_ACROSS_TILES
+  { AV1E_SET_ROW_MT, ctrl_set_row_mt },
   { AOME_SET_ARNR_MAXFRAMES, ctrl_set_arnr_max_frames },
   { AOME_SET_ARNR_STRENGTH, ctrl_set_arnr_strength },
   { AOME_SET_TUNING, ctrl_set_tuning },
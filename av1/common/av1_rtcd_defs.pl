@@ -12,6 +12,7 @@ print <<EOF
 #include "av1/common/convolve.h"
 #include "av1/common/av1_txfm.h"
 #include "av1/common/odintrin.h"
+#include "av1/common/od_dering.h"
 
 struct macroblockd;
 
@@ -486,7 +487,7 @@ add_proto qw/int av1_diamond_search_sad/, "struct macroblock *x, const struct se
 add_proto qw/int av1_full_range_search/, "const struct macroblock *x, const struct search_site_config *cfg, struct mv *ref_mv, struct mv *best_mv, int search_param, int sad_per_bit, int *num00, const struct aom_variance_vtable *fn_ptr, const struct mv *center_mv";
 
 add_proto qw/void av1_temporal_filter_apply/, "uint8_t *frame1, unsigned int stride, uint8_t *frame2, unsigned int block_width, unsigned int block_height, int strength, int filter_weight, unsigned int *accumulator, uint16_t *count";
-specialize qw/av1_temporal_filter_apply sse2 msa/;
+specialize qw/av1_temporal_filter_apply avx2/;
 
 if (aom_config("CONFIG_AOM_QM") eq "yes") {
   add_proto qw/void av1_quantize_b/, "const tran_low_t *coeff_ptr, intptr_t n_coeffs, int skip_block, const int16_t *zbin_ptr, const int16_t *round_ptr, const int16_t *quant_ptr, const int16_t *quant_shift_ptr, tran_low_t *qcoeff_ptr, tran_low_t *dqcoeff_ptr, const int16_t *dequant_ptr, uint16_t *eob_ptr, const int16_t *scan, const int16_t *iscan, const qm_val_t * qm_ptr, const qm_val_t * iqm_ptr, int log_scale";
@@ -583,6 +584,11 @@ if (aom_config("CONFIG_EXT_INTER") eq "yes") {
   specialize qw/av1_wedge_compute_delta_squares sse2/;
 }
 
+if (aom_config("CONFIG_GLOBAL_MOTION") eq "yes") {
+  add_proto qw/double compute_cross_correlation/, "unsigned char *im1, int stride1, int x1, int y1, unsigned char *im2, int stride2, int x2, int y2";
+  specialize qw/compute_cross_correlation sse4_1 avx2/;
+}
+
 }
 # end encoder functions
 
@@ -636,6 +642,12 @@ if (aom_config("CONFIG_CDEF") eq "yes") {
   add_proto qw/void copy_rect8_8bit_to_16bit/, "uint16_t *dst, int dstride, const uint8_t *src, int sstride, int v, int h";
   add_proto qw/void copy_rect8_16bit_to_16bit/, "uint16_t *dst, int dstride, const uint16_t *src, int sstride, int v, int h";
 
+  if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
+    add_proto qw/uint64_t dist_8x8_16bit/, "uint16_t *dst, int dstride, uint16_t *src, int sstride, int coeff_shift";
+    add_proto qw/uint64_t mse_8x8_16bit/, "uint16_t *dst, int dstride, uint16_t *src, int sstride";
+    add_proto qw/uint64_t compute_dering_dist/, "uint16_t *dst, int dstride, uint16_t *src, dering_list *dlist, int dering_count, BLOCK_SIZE bsize, int coeff_shift, int pli";
+  }
+
 # VS compiling for 32 bit targets does not support vector types in
   # structs as arguments, which makes the v256 type of the intrinsics
   # hard to support, so optimizations for this target are disabled.
@@ -654,6 +666,12 @@ if (aom_config("CONFIG_CDEF") eq "yes") {
     specialize qw/copy_4x4_16bit_to_16bit sse2 ssse3 sse4_1 neon/;
     specialize qw/copy_rect8_8bit_to_16bit sse2 ssse3 sse4_1 neon/;
     specialize qw/copy_rect8_16bit_to_16bit sse2 ssse3 sse4_1 neon/;
+
+    if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
+      specialize qw/dist_8x8_16bit sse2 ssse3 sse4_1 neon/;
+      specialize qw/mse_8x8_16bit sse2 ssse3 sse4_1 neon/;
+      specialize qw/compute_dering_dist sse2 ssse3 sse4_1 neon/;
+    }
   }
 }
 
@@ -675,6 +693,9 @@ if ((aom_config("CONFIG_WARPED_MOTION") eq "yes") ||
     add_proto qw/void av1_highbd_warp_affine/, "int32_t *mat, uint16_t *ref, int width, int height, int stride, uint16_t *pred, int p_col, int p_row, int p_width, int p_height, int p_stride, int subsampling_x, int subsampling_y, int bd, int ref_frm, int32_t alpha, int32_t beta, int32_t gamma, int32_t delta";
     specialize qw/av1_highbd_warp_affine ssse3/;
   }
+
+  add_proto qw/int64_t av1_calc_frame_error/, "const uint8_t *const ref, int stride, const uint8_t *const dst, int p_width, int p_height, int p_stride";
+  specialize qw/av1_calc_frame_error avx2/;
 }
 
 # LOOP_RESTORATION functions
@@ -699,6 +720,16 @@ if (aom_config("CONFIG_LOOP_RESTORATION") eq "yes") {
     add_proto qw/void av1_highpass_filter_highbd/, "uint16_t *dgd, int width, int height, int stride, int32_t *dst, int dst_stride, int r, int eps";
     specialize qw/av1_highpass_filter_highbd sse4_1/;
   }
+
+  if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
+    add_proto qw/void av1_compute_wiener_sums/, "const uint8_t *dgd, const uint8_t *src, int width, int height, int dgd_stride, int src_stride, int64_t *sum_x, int64_t *sum_y, int64_t *sum_xy, int64_t *sum_yy";
+    specialize qw/av1_compute_wiener_sums sse4_1/;
+
+    if (aom_config("CONFIG_AOM_HIGHBITDEPTH") eq "yes") {
+      add_proto qw/void av1_compute_wiener_sums_highbd/, "const uint16_t *dgd, const uint16_t *src, int width, int height, int dgd_stride, int src_stride, int64_t *sum_x, int64_t *sum_y, int64_t *sum_xy, int64_t *sum_yy";
+      specialize qw/av1_compute_wiener_sums_highbd sse4_1/;
+    }
+  }
 }
 
 1;
@@ -19,6 +19,7 @@
 #include "av1/common/od_dering.h"
 #include "av1/common/onyxc_int.h"
 #include "av1/common/reconinter.h"
+#include "av1/common/thread_common.h"
 
 int sb_all_skip(const AV1_COMMON *const cm, int mi_row, int mi_col) {
   int r, c;
@@ -170,274 +171,380 @@ static INLINE void copy_rect(uint16_t *dst, int dstride, const uint16_t *src,
   }
 }
 
-void av1_cdef_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
-                    MACROBLOCKD *xd) {
-  int sbr, sbc;
-  int nhsb, nvsb;
-  uint16_t src[OD_DERING_INBUF_SIZE];
-  uint16_t *linebuf[3];
-  uint16_t colbuf[3][(MAX_SB_SIZE + 2 * OD_FILT_VBORDER) * OD_FILT_HBORDER];
-  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
-  unsigned char *row_dering, *prev_row_dering, *curr_row_dering;
-  int dering_count;
-  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
-  int var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
-  int stride;
-  int mi_wide_l2[3];
-  int mi_high_l2[3];
-  int xdec[3];
-  int ydec[3];
+void av1_cdef_frame_init(CdefFrameData *fd, YV12_BUFFER_CONFIG *frame,
+                         AV1_COMMON *cm, MACROBLOCKD *xd) {
+  const int nplanes = 3;
   int pli;
-  int dering_left;
-  int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
-  int nplanes = 3;
-  int chroma_dering =
+
+  fd->cm = cm;
+  fd->planes = xd->plane;
+  fd->nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  fd->nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+  fd->chroma_dering =
       xd->plane[1].subsampling_x == xd->plane[1].subsampling_y &&
       xd->plane[2].subsampling_x == xd->plane[2].subsampling_y;
-  nvsb = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
-  nhsb = (cm->mi_cols + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
   av1_setup_dst_planes(xd->plane, frame, 0, 0);
-  row_dering = aom_malloc(sizeof(*row_dering) * (nhsb + 2) * 2);
-  memset(row_dering, 1, sizeof(*row_dering) * (nhsb + 2) * 2);
-  prev_row_dering = row_dering + 1;
-  curr_row_dering = prev_row_dering + nhsb + 2;
+  fd->row_dering = aom_malloc(sizeof(*fd->row_dering) * (fd->nvsb + 2) *
+                              (fd->nhsb + 2));
+  memset(fd->row_dering, 1,
+         sizeof(*fd->row_dering) * (fd->nvsb + 2) * (fd->nhsb + 2));
+  fd->row_dirs = aom_malloc(sizeof(*fd->row_dirs) * fd->nvsb);
+  fd->linebuf_stride = (cm->mi_cols << MI_SIZE_LOG2) + 2 * OD_FILT_HBORDER;
   for (pli = 0; pli < nplanes; pli++) {
-    xdec[pli] = xd->plane[pli].subsampling_x;
-    ydec[pli] = xd->plane[pli].subsampling_y;
-    mi_wide_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_x;
-    mi_high_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_y;
+    fd->linebuf[0][pli] = aom_malloc(sizeof(*fd->linebuf[0][pli]) *
+                                     OD_FILT_VBORDER * fd->linebuf_stride);
+    fd->linebuf[1][pli] = aom_malloc(sizeof(*fd->linebuf[1][pli]) *
+                                     OD_FILT_VBORDER * fd->linebuf_stride);
   }
-  stride = (cm->mi_cols << MI_SIZE_LOG2) + 2 * OD_FILT_HBORDER;
+}
+
+void av1_cdef_frame_free(CdefFrameData *fd) {
+  const int nplanes = 3;
+  int pli;
+
+  aom_free(fd->row_dering);
+  fd->row_dering = NULL;
+  aom_free(fd->row_dirs);
+  fd->row_dirs = NULL;
   for (pli = 0; pli < nplanes; pli++) {
-    linebuf[pli] = aom_malloc(sizeof(*linebuf) * OD_FILT_VBORDER * stride);
+    aom_free(fd->linebuf[0][pli]);
+    aom_free(fd->linebuf[1][pli]);
+    fd->linebuf[0][pli] = NULL;
+    fd->linebuf[1][pli] = NULL;
   }
-  for (sbr = 0; sbr < nvsb; sbr++) {
-    for (pli = 0; pli < nplanes; pli++) {
-      const int block_height =
-          (MAX_MIB_SIZE << mi_high_l2[pli]) + 2 * OD_FILT_VBORDER;
-      fill_rect(colbuf[pli], OD_FILT_HBORDER, block_height, OD_FILT_HBORDER,
-                OD_DERING_VERY_LARGE);
+}
+
+// The chroma deringing of a superblock uses the luma directions left by the
+// last superblock before it, in raster order, whose luma was filtered. A
+// superblock row keeps track of the directions it sets, and only merges in
+// those left by the rows above when a superblock needs them.
+typedef struct {
+  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  unsigned char set[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  int merged;
+} CdefRowDirs;
+
+static void merge_row_above_dirs(const CdefFrameData *const fd, int sbr,
+                                 CdefRowDirs *const dirs,
+                                 struct AV1CdefSyncData *cdef_sync) {
+  int by, bx;
+  if (dirs->merged) return;
+  // Wait until the row above, and so all the rows above, have been filtered.
+  if (sbr > 0) av1_cdef_sync_read(cdef_sync, sbr, fd->nhsb - 1);
+  for (by = 0; by < OD_DERING_NBLOCKS; by++) {
+    for (bx = 0; bx < OD_DERING_NBLOCKS; bx++) {
+      if (!dirs->set[by][bx])
+        dirs->dir[by][bx] = sbr > 0 ? fd->row_dirs[sbr - 1][by][bx] : 0;
     }
-    dering_left = 1;
-    for (sbc = 0; sbc < nhsb; sbc++) {
-      int level, clpf_strength;
-      int uv_level, uv_clpf_strength;
-      int nhb, nvb;
-      int cstart = 0;
-      if (cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
-                              MAX_MIB_SIZE * sbc] == NULL) {
-        dering_left = 0;
-        continue;
-      }
-      if (!dering_left) cstart = -OD_FILT_HBORDER;
-      nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
-      nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
-      int tile_top, tile_left, tile_bottom, tile_right;
-      int mi_idx = MAX_MIB_SIZE * sbr * cm->mi_stride + MAX_MIB_SIZE * sbc;
-      BOUNDARY_TYPE boundary_tl =
-          cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
-                              MAX_MIB_SIZE * sbc]
-              ->mbmi.boundary_info;
-      tile_top = boundary_tl & TILE_ABOVE_BOUNDARY;
-      tile_left = boundary_tl & TILE_LEFT_BOUNDARY;
-      /* Right and bottom information appear unreliable, so we use the top
-         and left flags for the next superblocks. */
-      if (sbr != nvsb - 1 &&
-          cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE * cm->mi_stride])
-        tile_bottom = cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE * cm->mi_stride]
-                          ->mbmi.boundary_info &
-                      TILE_ABOVE_BOUNDARY;
-      else
-        tile_bottom = 1;
-      if (sbc != nhsb - 1 && cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE])
-        tile_right =
-            cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE]->mbmi.boundary_info &
-            TILE_LEFT_BOUNDARY;
+  }
+  dirs->merged = 1;
+}
+
+// Filter one superblock, returning 1 if it was filtered and its bottom lines
+// were saved to linebuf.
+static int cdef_filter_sb(const CdefFrameData *const fd, int sbr, int sbc,
+                          CdefRowDirs *const dirs,
+                          struct AV1CdefSyncData *cdef_sync,
+                          int dering_left, uint16_t *src,
+                          uint16_t colbuf[3][(MAX_SB_SIZE +
+                                              2 * OD_FILT_VBORDER) *
+                                             OD_FILT_HBORDER],
+                          uint16_t *const linebuf[3],
+                          uint16_t *const prev_linebuf[3],
+                          const unsigned char *prev_row_dering,
+                          unsigned char *curr_row_dering) {
+  AV1_COMMON *const cm = fd->cm;
+  const struct macroblockd_plane *const planes = fd->planes;
+  const int nvsb = fd->nvsb;
+  const int nhsb = fd->nhsb;
+  const int stride = fd->linebuf_stride;
+  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
+  int dering_count;
+  int var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
+  int level, clpf_strength;
+  int uv_level, uv_clpf_strength;
+  int nhb, nvb;
+  int cstart = 0;
+  int pli;
+  const int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
+  const int nplanes = 3;
+  const int mi_idx = MAX_MIB_SIZE * sbr * cm->mi_stride + MAX_MIB_SIZE * sbc;
+
+  if (!dering_left) cstart = -OD_FILT_HBORDER;
+  nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
+  nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
+  int tile_top, tile_left, tile_bottom, tile_right;
+  BOUNDARY_TYPE boundary_tl = cm->mi_grid_visible[mi_idx]->mbmi.boundary_info;
+  tile_top = boundary_tl & TILE_ABOVE_BOUNDARY;
+  tile_left = boundary_tl & TILE_LEFT_BOUNDARY;
+  /* Right and bottom information appear unreliable, so we use the top
+     and left flags for the next superblocks. */
+  if (sbr != nvsb - 1 &&
+      cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE * cm->mi_stride])
+    tile_bottom = cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE * cm->mi_stride]
+                      ->mbmi.boundary_info &
+                  TILE_ABOVE_BOUNDARY;
+  else
+    tile_bottom = 1;
+  if (sbc != nhsb - 1 && cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE])
+    tile_right =
+        cm->mi_grid_visible[mi_idx + MAX_MIB_SIZE]->mbmi.boundary_info &
+        TILE_LEFT_BOUNDARY;
+  else
+    tile_right = 1;
+  const int mbmi_cdef_strength =
+      cm->mi_grid_visible[mi_idx]->mbmi.cdef_strength;
+  level = cm->cdef_strengths[mbmi_cdef_strength] / CLPF_STRENGTHS;
+  clpf_strength = cm->cdef_strengths[mbmi_cdef_strength] % CLPF_STRENGTHS;
+  clpf_strength += clpf_strength == 3;
+  uv_level = cm->cdef_uv_strengths[mbmi_cdef_strength] / CLPF_STRENGTHS;
+  uv_clpf_strength = cm->cdef_uv_strengths[mbmi_cdef_strength] % CLPF_STRENGTHS;
+  uv_clpf_strength += uv_clpf_strength == 3;
+  curr_row_dering[sbc] = 0;
+  if ((level == 0 && clpf_strength == 0 && uv_level == 0 &&
+       uv_clpf_strength == 0) ||
+      (dering_count = sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE,
+                                             sbc * MAX_MIB_SIZE, dlist)) == 0) {
+    return 0;
+  }
+
+  curr_row_dering[sbc] = 1;
+  if (level == 0 && clpf_strength == 0 && fd->chroma_dering && uv_level != 0)
+    merge_row_above_dirs(fd, sbr, dirs, cdef_sync);
+  for (pli = 0; pli < nplanes; pli++) {
+    uint16_t dst[MAX_SB_SIZE * MAX_SB_SIZE];
+    const int xdec = planes[pli].subsampling_x;
+    const int ydec = planes[pli].subsampling_y;
+    const int mi_wide_l2 = MI_SIZE_LOG2 - xdec;
+    const int mi_high_l2 = MI_SIZE_LOG2 - ydec;
+    int coffset;
+    int rend, cend;
+    int clpf_damping = 3 - (pli != AOM_PLANE_Y) + (cm->base_qindex >> 6);
+    int hsize = nhb << mi_wide_l2;
+    int vsize = nvb << mi_high_l2;
+
+    if (pli) {
+      if (fd->chroma_dering)
+        level = uv_level;
       else
-        tile_right = 1;
-      const int mbmi_cdef_strength =
-          cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
-                              MAX_MIB_SIZE * sbc]
-              ->mbmi.cdef_strength;
-      level = cm->cdef_strengths[mbmi_cdef_strength] / CLPF_STRENGTHS;
-      clpf_strength = cm->cdef_strengths[mbmi_cdef_strength] % CLPF_STRENGTHS;
-      clpf_strength += clpf_strength == 3;
-      uv_level = cm->cdef_uv_strengths[mbmi_cdef_strength] / CLPF_STRENGTHS;
-      uv_clpf_strength =
-          cm->cdef_uv_strengths[mbmi_cdef_strength] % CLPF_STRENGTHS;
-      uv_clpf_strength += uv_clpf_strength == 3;
-      curr_row_dering[sbc] = 0;
-      if ((level == 0 && clpf_strength == 0 && uv_level == 0 &&
-           uv_clpf_strength == 0) ||
-          (dering_count = sb_compute_dering_list(
-               cm, sbr * MAX_MIB_SIZE, sbc * MAX_MIB_SIZE, dlist)) == 0) {
-        dering_left = 0;
-        continue;
-      }
+        level = 0;
+      clpf_strength = uv_clpf_strength;
+    }
 
-      curr_row_dering[sbc] = 1;
-      for (pli = 0; pli < nplanes; pli++) {
-        uint16_t dst[MAX_SB_SIZE * MAX_SB_SIZE];
-        int coffset;
-        int rend, cend;
-        int clpf_damping = 3 - (pli != AOM_PLANE_Y) + (cm->base_qindex >> 6);
-        int hsize = nhb << mi_wide_l2[pli];
-        int vsize = nvb << mi_high_l2[pli];
-
-        if (pli) {
-          if (chroma_dering)
-            level = uv_level;
-          else
-            level = 0;
-          clpf_strength = uv_clpf_strength;
-        }
+    if (sbc == nhsb - 1)
+      cend = hsize;
+    else
+      cend = hsize + OD_FILT_HBORDER;
 
-        if (sbc == nhsb - 1)
-          cend = hsize;
-        else
-          cend = hsize + OD_FILT_HBORDER;
-
-        if (sbr == nvsb - 1)
-          rend = vsize;
-        else
-          rend = vsize + OD_FILT_VBORDER;
-
-        coffset = sbc * MAX_MIB_SIZE << mi_wide_l2[pli];
-        if (sbc == nhsb - 1) {
-          /* On the last superblock column, fill in the right border with
-             OD_DERING_VERY_LARGE to avoid filtering with the outside. */
-          fill_rect(&src[cend + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                    rend + OD_FILT_VBORDER, hsize + OD_FILT_HBORDER - cend,
-                    OD_DERING_VERY_LARGE);
-        }
-        if (sbr == nvsb - 1) {
-          /* On the last superblock row, fill in the bottom border with
-             OD_DERING_VERY_LARGE to avoid filtering with the outside. */
-          fill_rect(&src[(rend + OD_FILT_VBORDER) * OD_FILT_BSTRIDE],
-                    OD_FILT_BSTRIDE, OD_FILT_VBORDER,
-                    hsize + 2 * OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
-        }
-        /* Copy in the pixels we need from the current superblock for
-           deringing.*/
-        copy_sb8_16(
-            cm,
-            &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER + cstart],
-            OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-            (MAX_MIB_SIZE << mi_high_l2[pli]) * sbr, coffset + cstart,
-            xd->plane[pli].dst.stride, rend, cend - cstart);
-        if (!prev_row_dering[sbc]) {
-          copy_sb8_16(cm, &src[OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                      xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << mi_high_l2[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset, xd->plane[pli].dst.stride, OD_FILT_VBORDER,
-                      hsize);
-        } else if (sbr > 0) {
-          copy_rect(&src[OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                    &linebuf[pli][coffset], stride, OD_FILT_VBORDER, hsize);
-        } else {
-          fill_rect(&src[OD_FILT_HBORDER], OD_FILT_BSTRIDE, OD_FILT_VBORDER,
-                    hsize, OD_DERING_VERY_LARGE);
-        }
-        if (!prev_row_dering[sbc - 1]) {
-          copy_sb8_16(cm, src, OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << mi_high_l2[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset - OD_FILT_HBORDER, xd->plane[pli].dst.stride,
-                      OD_FILT_VBORDER, OD_FILT_HBORDER);
-        } else if (sbr > 0 && sbc > 0) {
-          copy_rect(src, OD_FILT_BSTRIDE,
-                    &linebuf[pli][coffset - OD_FILT_HBORDER], stride,
-                    OD_FILT_VBORDER, OD_FILT_HBORDER);
-        } else {
-          fill_rect(src, OD_FILT_BSTRIDE, OD_FILT_VBORDER, OD_FILT_HBORDER,
-                    OD_DERING_VERY_LARGE);
-        }
-        if (!prev_row_dering[sbc + 1]) {
-          copy_sb8_16(cm, &src[OD_FILT_HBORDER + (nhb << mi_wide_l2[pli])],
-                      OD_FILT_BSTRIDE, xd->plane[pli].dst.buf,
-                      (MAX_MIB_SIZE << mi_high_l2[pli]) * sbr - OD_FILT_VBORDER,
-                      coffset + hsize, xd->plane[pli].dst.stride,
-                      OD_FILT_VBORDER, OD_FILT_HBORDER);
-        } else if (sbr > 0 && sbc < nhsb - 1) {
-          copy_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                    &linebuf[pli][coffset + hsize], stride, OD_FILT_VBORDER,
-                    OD_FILT_HBORDER);
-        } else {
-          fill_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                    OD_FILT_VBORDER, OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
-        }
-        if (dering_left) {
-          /* If we deringed the superblock on the left then we need to copy in
-             saved pixels. */
-          copy_rect(src, OD_FILT_BSTRIDE, colbuf[pli], OD_FILT_HBORDER,
-                    rend + OD_FILT_VBORDER, OD_FILT_HBORDER);
-        }
-        /* Saving pixels in case we need to dering the superblock on the
-            right. */
-        copy_rect(colbuf[pli], OD_FILT_HBORDER, src + hsize, OD_FILT_BSTRIDE,
-                  rend + OD_FILT_VBORDER, OD_FILT_HBORDER);
-        copy_sb8_16(
-            cm, &linebuf[pli][coffset], stride, xd->plane[pli].dst.buf,
-            (MAX_MIB_SIZE << mi_high_l2[pli]) * (sbr + 1) - OD_FILT_VBORDER,
-            coffset, xd->plane[pli].dst.stride, OD_FILT_VBORDER, hsize);
-
-        if (level == 0 && clpf_strength == 0) continue;
-        if (tile_top) {
-          fill_rect(src, OD_FILT_BSTRIDE, OD_FILT_VBORDER,
-                    hsize + 2 * OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
-        }
-        if (tile_left) {
-          fill_rect(src, OD_FILT_BSTRIDE, vsize + 2 * OD_FILT_VBORDER,
-                    OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
-        }
-        if (tile_bottom) {
-          fill_rect(&src[(vsize + OD_FILT_VBORDER) * OD_FILT_BSTRIDE],
-                    OD_FILT_BSTRIDE, OD_FILT_VBORDER,
-                    hsize + 2 * OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
-        }
-        if (tile_right) {
-          fill_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
-                    vsize + 2 * OD_FILT_VBORDER, OD_FILT_HBORDER,
-                    OD_DERING_VERY_LARGE);
-        }
+    if (sbr == nvsb - 1)
+      rend = vsize;
+    else
+      rend = vsize + OD_FILT_VBORDER;
+
+    coffset = sbc * MAX_MIB_SIZE << mi_wide_l2;
+    if (sbc == nhsb - 1) {
+      /* On the last superblock column, fill in the right border with
+         OD_DERING_VERY_LARGE to avoid filtering with the outside. */
+      fill_rect(&src[cend + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
+                rend + OD_FILT_VBORDER, hsize + OD_FILT_HBORDER - cend,
+                OD_DERING_VERY_LARGE);
+    }
+    if (sbr == nvsb - 1) {
+      /* On the last superblock row, fill in the bottom border with
+         OD_DERING_VERY_LARGE to avoid filtering with the outside. */
+      fill_rect(&src[(rend + OD_FILT_VBORDER) * OD_FILT_BSTRIDE],
+                OD_FILT_BSTRIDE, OD_FILT_VBORDER, hsize + 2 * OD_FILT_HBORDER,
+                OD_DERING_VERY_LARGE);
+    }
+    /* Copy in the pixels we need from the current superblock for
+       deringing.*/
+    copy_sb8_16(
+        cm, &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER + cstart],
+        OD_FILT_BSTRIDE, planes[pli].dst.buf, (MAX_MIB_SIZE << mi_high_l2) * sbr,
+        coffset + cstart, planes[pli].dst.stride, rend, cend - cstart);
+    if (!prev_row_dering[sbc]) {
+      copy_sb8_16(cm, &src[OD_FILT_HBORDER], OD_FILT_BSTRIDE,
+                  planes[pli].dst.buf,
+                  (MAX_MIB_SIZE << mi_high_l2) * sbr - OD_FILT_VBORDER, coffset,
+                  planes[pli].dst.stride, OD_FILT_VBORDER, hsize);
+    } else if (sbr > 0) {
+      copy_rect(&src[OD_FILT_HBORDER], OD_FILT_BSTRIDE,
+                &prev_linebuf[pli][coffset], stride, OD_FILT_VBORDER, hsize);
+    } else {
+      fill_rect(&src[OD_FILT_HBORDER], OD_FILT_BSTRIDE, OD_FILT_VBORDER, hsize,
+                OD_DERING_VERY_LARGE);
+    }
+    if (!prev_row_dering[sbc - 1]) {
+      copy_sb8_16(cm, src, OD_FILT_BSTRIDE, planes[pli].dst.buf,
+                  (MAX_MIB_SIZE << mi_high_l2) * sbr - OD_FILT_VBORDER,
+                  coffset - OD_FILT_HBORDER, planes[pli].dst.stride,
+                  OD_FILT_VBORDER, OD_FILT_HBORDER);
+    } else if (sbr > 0 && sbc > 0) {
+      // The lines of the superblock on the left have already been replaced
+      // by the ones of the current row.
+      copy_rect(src, OD_FILT_BSTRIDE, &linebuf[pli][coffset - OD_FILT_HBORDER],
+                stride, OD_FILT_VBORDER, OD_FILT_HBORDER);
+    } else {
+      fill_rect(src, OD_FILT_BSTRIDE, OD_FILT_VBORDER, OD_FILT_HBORDER,
+                OD_DERING_VERY_LARGE);
+    }
+    if (!prev_row_dering[sbc + 1]) {
+      copy_sb8_16(cm, &src[OD_FILT_HBORDER + (nhb << mi_wide_l2)],
+                  OD_FILT_BSTRIDE, planes[pli].dst.buf,
+                  (MAX_MIB_SIZE << mi_high_l2) * sbr - OD_FILT_VBORDER,
+                  coffset + hsize, planes[pli].dst.stride, OD_FILT_VBORDER,
+                  OD_FILT_HBORDER);
+    } else if (sbr > 0 && sbc < nhsb - 1) {
+      copy_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
+                &prev_linebuf[pli][coffset + hsize], stride, OD_FILT_VBORDER,
+                OD_FILT_HBORDER);
+    } else {
+      fill_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE, OD_FILT_VBORDER,
+                OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
+    }
+    if (dering_left) {
+      /* If we deringed the superblock on the left then we need to copy in
+         saved pixels. */
+      copy_rect(src, OD_FILT_BSTRIDE, colbuf[pli], OD_FILT_HBORDER,
+                rend + OD_FILT_VBORDER, OD_FILT_HBORDER);
+    }
+    /* Saving pixels in case we need to dering the superblock on the
+        right. */
+    copy_rect(colbuf[pli], OD_FILT_HBORDER, src + hsize, OD_FILT_BSTRIDE,
+              rend + OD_FILT_VBORDER, OD_FILT_HBORDER);
+    copy_sb8_16(cm, &linebuf[pli][coffset], stride, planes[pli].dst.buf,
+                (MAX_MIB_SIZE << mi_high_l2) * (sbr + 1) - OD_FILT_VBORDER,
+                coffset, planes[pli].dst.stride, OD_FILT_VBORDER, hsize);
+
+    if (level == 0 && clpf_strength == 0) continue;
+    if (tile_top) {
+      fill_rect(src, OD_FILT_BSTRIDE, OD_FILT_VBORDER,
+                hsize + 2 * OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
+    }
+    if (tile_left) {
+      fill_rect(src, OD_FILT_BSTRIDE, vsize + 2 * OD_FILT_VBORDER,
+                OD_FILT_HBORDER, OD_DERING_VERY_LARGE);
+    }
+    if (tile_bottom) {
+      fill_rect(&src[(vsize + OD_FILT_VBORDER) * OD_FILT_BSTRIDE],
+                OD_FILT_BSTRIDE, OD_FILT_VBORDER, hsize + 2 * OD_FILT_HBORDER,
+                OD_DERING_VERY_LARGE);
+    }
+    if (tile_right) {
+      fill_rect(&src[hsize + OD_FILT_HBORDER], OD_FILT_BSTRIDE,
+                vsize + 2 * OD_FILT_VBORDER, OD_FILT_HBORDER,
+                OD_DERING_VERY_LARGE);
+    }
 #if CONFIG_AOM_HIGHBITDEPTH
-        if (cm->use_highbitdepth) {
-          od_dering(
-              (uint8_t *)&CONVERT_TO_SHORTPTR(
-                  xd->plane[pli]
-                      .dst.buf)[xd->plane[pli].dst.stride *
-                                    (MAX_MIB_SIZE * sbr << mi_high_l2[pli]) +
-                                (sbc * MAX_MIB_SIZE << mi_wide_l2[pli])],
-              xd->plane[pli].dst.stride, dst,
-              &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER],
-              xdec[pli], ydec[pli], dir, NULL, var, pli, dlist, dering_count,
-              level, clpf_strength, clpf_damping, coeff_shift, 0, 1);
-        } else {
+    if (cm->use_highbitdepth) {
+      od_dering(
+          (uint8_t *)&CONVERT_TO_SHORTPTR(
+              planes[pli].dst.buf)[planes[pli].dst.stride *
+                                       (MAX_MIB_SIZE * sbr << mi_high_l2) +
+                                   (sbc * MAX_MIB_SIZE << mi_wide_l2)],
+          planes[pli].dst.stride, dst,
+          &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER], xdec, ydec,
+          dirs->dir, NULL, var, pli, dlist, dering_count, level,
+          clpf_strength, clpf_damping, coeff_shift, 0, 1);
+    } else {
 #endif
-          od_dering(&xd->plane[pli]
-                         .dst.buf[xd->plane[pli].dst.stride *
-                                      (MAX_MIB_SIZE * sbr << mi_high_l2[pli]) +
-                                  (sbc * MAX_MIB_SIZE << mi_wide_l2[pli])],
-                    xd->plane[pli].dst.stride, dst,
-                    &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER],
-                    xdec[pli], ydec[pli], dir, NULL, var, pli, dlist,
-                    dering_count, level, clpf_strength, clpf_damping,
-                    coeff_shift, 0, 0);
+      od_dering(&planes[pli].dst.buf[planes[pli].dst.stride *
+                                         (MAX_MIB_SIZE * sbr << mi_high_l2) +
+                                     (sbc * MAX_MIB_SIZE << mi_wide_l2)],
+                planes[pli].dst.stride, dst,
+                &src[OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER], xdec,
+                ydec, dirs->dir, NULL, var, pli, dlist, dering_count, level,
+                clpf_strength, clpf_damping, coeff_shift, 0, 0);
 
 #if CONFIG_AOM_HIGHBITDEPTH
-        }
-#endif
-      }
-      dering_left = 1;
     }
-    {
-      unsigned char *tmp;
-      tmp = prev_row_dering;
-      prev_row_dering = curr_row_dering;
-      curr_row_dering = tmp;
+#endif
+    if (pli == AOM_PLANE_Y && !dirs->merged) {
+      int bi;
+      for (bi = 0; bi < dering_count; bi++)
+        dirs->set[dlist[bi].by][dlist[bi].bx] = 1;
     }
   }
-  aom_free(row_dering);
+  return 1;
+}
+
+void av1_cdef_sb_row(const CdefFrameData *fd, int sbr,
+                     struct AV1CdefSyncData *cdef_sync) {
+  const AV1_COMMON *const cm = fd->cm;
+  const int nhsb = fd->nhsb;
+  const int nplanes = 3;
+  uint16_t src[OD_DERING_INBUF_SIZE];
+  uint16_t colbuf[3][(MAX_SB_SIZE + 2 * OD_FILT_VBORDER) * OD_FILT_HBORDER];
+  uint16_t *const *const linebuf = fd->linebuf[sbr & 1];
+  uint16_t *const *const prev_linebuf = fd->linebuf[(sbr + 1) & 1];
+  unsigned char *const curr_row_dering =
+      fd->row_dering + (sbr + 2) * (nhsb + 2) + 1;
+  const unsigned char *const prev_row_dering = curr_row_dering - (nhsb + 2);
+  const unsigned char *const prev2_row_dering = prev_row_dering - (nhsb + 2);
+  CdefRowDirs dirs;
+  int sbc, pli;
+  int dering_left;
+
+  memset(dirs.set, 0, sizeof(dirs.set));
+  dirs.merged = 0;
   for (pli = 0; pli < nplanes; pli++) {
-    aom_free(linebuf[pli]);
+    const int block_height =
+        (MAX_MIB_SIZE << (MI_SIZE_LOG2 - fd->planes[pli].subsampling_y)) +
+        2 * OD_FILT_VBORDER;
+    fill_rect(colbuf[pli], OD_FILT_HBORDER, block_height, OD_FILT_HBORDER,
+              OD_DERING_VERY_LARGE);
+  }
+  dering_left = 1;
+  for (sbc = 0; sbc < nhsb; sbc++) {
+    av1_cdef_sync_read(cdef_sync, sbr, sbc);
+
+    if (cm->mi_grid_visible[MAX_MIB_SIZE * sbr * cm->mi_stride +
+                            MAX_MIB_SIZE * sbc] == NULL) {
+      // The flag of a missing superblock is left from two rows above, as
+      // the frame filter only keeps two rows of flags.
+      curr_row_dering[sbc] = prev2_row_dering[sbc];
+      dering_left = 0;
+    } else {
+      dering_left =
+          cdef_filter_sb(fd, sbr, sbc, &dirs, cdef_sync, dering_left, src,
+                         colbuf, linebuf, prev_linebuf, prev_row_dering,
+                         curr_row_dering);
+    }
+
+    if (!dering_left && sbr > 0) {
+      // Keep the lines saved by the rows above, which are the ones the frame
+      // filter would read from its single line buffer.
+      for (pli = 0; pli < nplanes; pli++) {
+        const int mi_wide_l2 = MI_SIZE_LOG2 - fd->planes[pli].subsampling_x;
+        const int coffset = sbc * MAX_MIB_SIZE << mi_wide_l2;
+        const int hsize =
+            AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc)
+            << mi_wide_l2;
+        int r;
+        for (r = 0; r < OD_FILT_VBORDER; r++) {
+          memcpy(&linebuf[pli][r * fd->linebuf_stride + coffset],
+                 &prev_linebuf[pli][r * fd->linebuf_stride + coffset],
+                 hsize * sizeof(*linebuf[pli]));
+        }
+      }
+    }
+
+    if (sbc == nhsb - 1) {
+      // The row above has been filtered, as the last superblock waited for
+      // it. Leave the directions for the rows below.
+      merge_row_above_dirs(fd, sbr, &dirs, cdef_sync);
+      memcpy(fd->row_dirs[sbr], dirs.dir, sizeof(dirs.dir));
+    }
+    av1_cdef_sync_write(cdef_sync, sbr, sbc, nhsb);
   }
 }
+
+void av1_cdef_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                    MACROBLOCKD *xd) {
+  CdefFrameData fd;
+  int sbr;
+
+  av1_cdef_frame_init(&fd, frame, cm, xd);
+  for (sbr = 0; sbr < fd.nvsb; sbr++) av1_cdef_sb_row(&fd, sbr, NULL);
+  av1_cdef_frame_free(&fd);
+}
@@ -39,13 +39,49 @@ static INLINE int constrain(int diff, int threshold, unsigned int damping) {
 extern "C" {
 #endif
 
+struct AV1CdefSyncData;
+
+// Frame level state shared by the superblock rows filtered by CDEF.
+typedef struct {
+  AV1_COMMON *cm;
+  // Planes of the frame being filtered.
+  struct macroblockd_plane *planes;
+  int nvsb;
+  int nhsb;
+  int chroma_dering;
+  int linebuf_stride;
+  // Unfiltered bottom lines of the last two superblock rows, indexed by the
+  // parity of the row. A superblock row reads the lines of the row above
+  // while it saves its own.
+  uint16_t *linebuf[2][3];
+  // Whether each superblock was filtered, with two rows of padding above and
+  // one column of padding on each side.
+  unsigned char *row_dering;
+  // Luma directions left at the end of each superblock row.
+  int (*row_dirs)[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+} CdefFrameData;
+
 int sb_all_skip(const AV1_COMMON *const cm, int mi_row, int mi_col);
 int sb_compute_dering_list(const AV1_COMMON *const cm, int mi_row, int mi_col,
                            dering_list *dlist);
 void av1_cdef_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm, MACROBLOCKD *xd);
 
+// Set up the frame level state of CDEF, and the planes of xd on the frame.
+void av1_cdef_frame_init(CdefFrameData *fd, YV12_BUFFER_CONFIG *frame,
+                         AV1_COMMON *cm, MACROBLOCKD *xd);
+void av1_cdef_frame_free(CdefFrameData *fd);
+
+// Filter one superblock row. The rows of a frame may be filtered concurrently
+// in wavefront order if cdef_sync is not NULL.
+void av1_cdef_sb_row(const CdefFrameData *fd, int sbr,
+                     struct AV1CdefSyncData *cdef_sync);
+
+// Pick the CDEF strengths of the frame. The superblocks are searched on
+// num_workers threads. With prune_strengths, the strong luma dering levels are
+// only tried on superblocks with strongly directional blocks.
 void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                     AV1_COMMON *cm, MACROBLOCKD *xd);
+                     AV1_COMMON *cm, MACROBLOCKD *xd, int prune_strengths,
+                     AVxWorker *workers, int num_workers);
 
 #ifdef __cplusplus
 }  // extern "C"
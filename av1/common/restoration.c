@@ -10,6 +10,8 @@
  *
  */
 
+#include <assert.h>
+#include <limits.h>
 #include <math.h>
 
 #include "./aom_config.h"
@@ -37,13 +39,16 @@ const sgr_params_type sgr_params[SGRPROJ_PARAMS] = {
 #endif
 };
 
-typedef void (*restore_func_type)(uint8_t *data8, int width, int height,
-                                  int stride, RestorationInternal *rst,
-                                  uint8_t *dst8, int dst_stride);
+// Restore one tile, writing its top-left pixel to dst.
+typedef void (*restore_func_type)(uint8_t *data, int tile_idx, int width,
+                                  int height, int stride,
+                                  RestorationInternal *rst, uint8_t *dst,
+                                  int dst_stride);
 #if CONFIG_AOM_HIGHBITDEPTH
-typedef void (*restore_func_highbd_type)(uint8_t *data8, int width, int height,
-                                         int stride, RestorationInternal *rst,
-                                         int bit_depth, uint8_t *dst8,
+typedef void (*restore_func_highbd_type)(uint16_t *data, int tile_idx,
+                                         int width, int height, int stride,
+                                         RestorationInternal *rst,
+                                         int bit_depth, uint16_t *dst,
                                          int dst_stride);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
@@ -102,24 +107,35 @@ static void loop_restoration_init(RestorationInternal *rst, int kf) {
   rst->keyframe = kf;
 }
 
-void extend_frame(uint8_t *data, int width, int height, int stride) {
+// Extend the borders of rows start to end - 1, and the rows above or below
+// the frame if the first or last row is included.
+static void extend_frame_rows(uint8_t *data, int width, int height, int stride,
+                              int start, int end) {
   uint8_t *data_p;
   int i;
-  for (i = 0; i < height; ++i) {
+  for (i = start; i < end; ++i) {
     data_p = data + i * stride;
     memset(data_p - WIENER_HALFWIN, data_p[0], WIENER_HALFWIN);
     memset(data_p + width, data_p[width - 1], WIENER_HALFWIN);
   }
   data_p = data - WIENER_HALFWIN;
-  for (i = -WIENER_HALFWIN; i < 0; ++i) {
-    memcpy(data_p + i * stride, data_p, width + 2 * WIENER_HALFWIN);
+  if (start == 0) {
+    for (i = -WIENER_HALFWIN; i < 0; ++i) {
+      memcpy(data_p + i * stride, data_p, width + 2 * WIENER_HALFWIN);
+    }
   }
-  for (i = height; i < height + WIENER_HALFWIN; ++i) {
-    memcpy(data_p + i * stride, data_p + (height - 1) * stride,
-           width + 2 * WIENER_HALFWIN);
+  if (end == height) {
+    for (i = height; i < height + WIENER_HALFWIN; ++i) {
+      memcpy(data_p + i * stride, data_p + (height - 1) * stride,
+             width + 2 * WIENER_HALFWIN);
+    }
   }
 }
 
+void extend_frame(uint8_t *data, int width, int height, int stride) {
+  extend_frame_rows(data, width, height, stride, 0, height);
+}
+
 static void loop_copy_tile(uint8_t *data, int tile_idx, int subtile_idx,
                            int subtile_bits, int width, int height, int stride,
                            RestorationInternal *rst, uint8_t *dst,
@@ -132,7 +148,7 @@ static void loop_copy_tile(uint8_t *data, int tile_idx, int subtile_idx,
                            rst->nvtiles, tile_width, tile_height, width, height,
                            0, 0, &h_start, &h_end, &v_start, &v_end);
   for (i = v_start; i < v_end; ++i)
-    memcpy(dst + i * dst_stride + h_start, data + i * stride + h_start,
+    memcpy(dst + (i - v_start) * dst_stride, data + i * stride + h_start,
            h_end - h_start);
 }
 
@@ -159,24 +175,13 @@ static void loop_wiener_filter_tile(uint8_t *data, int tile_idx, int width,
       int w = AOMMIN(MAX_SB_SIZE, (h_end - j + 15) & ~15);
       int h = AOMMIN(MAX_SB_SIZE, (v_end - i + 15) & ~15);
       const uint8_t *data_p = data + i * stride + j;
-      uint8_t *dst_p = dst + i * dst_stride + j;
+      uint8_t *dst_p = dst + (i - v_start) * dst_stride + j - h_start;
       aom_convolve8_add_src(data_p, stride, dst_p, dst_stride,
                             rst->rsi->wiener_info[tile_idx].hfilter, 16,
                             rst->rsi->wiener_info[tile_idx].vfilter, 16, w, h);
     }
 }
 
-static void loop_wiener_filter(uint8_t *data, int width, int height, int stride,
-                               RestorationInternal *rst, uint8_t *dst,
-                               int dst_stride) {
-  int tile_idx;
-  extend_frame(data, width, height, stride);
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_wiener_filter_tile(data, tile_idx, width, height, stride, rst, dst,
-                            dst_stride);
-  }
-}
-
 /* Calculate windowed sums (if sqr=0) or sums of squares (if sqr=1)
    over the input. The window is of size (2r + 1)x(2r + 1), and we
    specialize to r = 1, 2, 3. A default function is used for r > 3.
@@ -882,7 +887,7 @@ static void loop_sgrproj_filter_tile(uint8_t *data, int tile_idx, int width,
   const int tile_width = rst->tile_width;
   const int tile_height = rst->tile_height;
   int h_start, h_end, v_start, v_end;
-  uint8_t *data_p, *dst_p;
+  uint8_t *data_p;
 
   if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
     loop_copy_tile(data, tile_idx, 0, 0, width, height, stride, rst, dst,
@@ -893,63 +898,58 @@ static void loop_sgrproj_filter_tile(uint8_t *data, int tile_idx, int width,
                            tile_width, tile_height, width, height, 0, 0,
                            &h_start, &h_end, &v_start, &v_end);
   data_p = data + h_start + v_start * stride;
-  dst_p = dst + h_start + v_start * dst_stride;
   apply_selfguided_restoration(data_p, h_end - h_start, v_end - v_start, stride,
                                rst->rsi->sgrproj_info[tile_idx].ep,
-                               rst->rsi->sgrproj_info[tile_idx].xqd, dst_p,
+                               rst->rsi->sgrproj_info[tile_idx].xqd, dst,
                                dst_stride, rst->tmpbuf);
 }
 
-static void loop_sgrproj_filter(uint8_t *data, int width, int height,
-                                int stride, RestorationInternal *rst,
-                                uint8_t *dst, int dst_stride) {
-  int tile_idx;
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
+static void loop_switchable_filter_tile(uint8_t *data, int tile_idx, int width,
+                                        int height, int stride,
+                                        RestorationInternal *rst, uint8_t *dst,
+                                        int dst_stride) {
+  if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
+    loop_copy_tile(data, tile_idx, 0, 0, width, height, stride, rst, dst,
+                   dst_stride);
+  } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
+    loop_wiener_filter_tile(data, tile_idx, width, height, stride, rst, dst,
+                            dst_stride);
+  } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
     loop_sgrproj_filter_tile(data, tile_idx, width, height, stride, rst, dst,
                              dst_stride);
   }
 }
 
-static void loop_switchable_filter(uint8_t *data, int width, int height,
-                                   int stride, RestorationInternal *rst,
-                                   uint8_t *dst, int dst_stride) {
-  int tile_idx;
-  extend_frame(data, width, height, stride);
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
-      loop_copy_tile(data, tile_idx, 0, 0, width, height, stride, rst, dst,
-                     dst_stride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
-      loop_wiener_filter_tile(data, tile_idx, width, height, stride, rst, dst,
-                              dst_stride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
-      loop_sgrproj_filter_tile(data, tile_idx, width, height, stride, rst, dst,
-                               dst_stride);
-    }
-  }
-}
-
 #if CONFIG_AOM_HIGHBITDEPTH
-void extend_frame_highbd(uint16_t *data, int width, int height, int stride) {
+static void extend_frame_rows_highbd(uint16_t *data, int width, int height,
+                                     int stride, int start, int end) {
   uint16_t *data_p;
   int i, j;
-  for (i = 0; i < height; ++i) {
+  for (i = start; i < end; ++i) {
     data_p = data + i * stride;
     for (j = -WIENER_HALFWIN; j < 0; ++j) data_p[j] = data_p[0];
     for (j = width; j < width + WIENER_HALFWIN; ++j)
       data_p[j] = data_p[width - 1];
   }
   data_p = data - WIENER_HALFWIN;
-  for (i = -WIENER_HALFWIN; i < 0; ++i) {
-    memcpy(data_p + i * stride, data_p,
-           (width + 2 * WIENER_HALFWIN) * sizeof(uint16_t));
+  if (start == 0) {
+    for (i = -WIENER_HALFWIN; i < 0; ++i) {
+      memcpy(data_p + i * stride, data_p,
+             (width + 2 * WIENER_HALFWIN) * sizeof(uint16_t));
+    }
   }
-  for (i = height; i < height + WIENER_HALFWIN; ++i) {
-    memcpy(data_p + i * stride, data_p + (height - 1) * stride,
-           (width + 2 * WIENER_HALFWIN) * sizeof(uint16_t));
+  if (end == height) {
+    for (i = height; i < height + WIENER_HALFWIN; ++i) {
+      memcpy(data_p + i * stride, data_p + (height - 1) * stride,
+             (width + 2 * WIENER_HALFWIN) * sizeof(uint16_t));
+    }
   }
 }
 
+void extend_frame_highbd(uint16_t *data, int width, int height, int stride) {
+  extend_frame_rows_highbd(data, width, height, stride, 0, height);
+}
+
 static void loop_copy_tile_highbd(uint16_t *data, int tile_idx, int subtile_idx,
                                   int subtile_bits, int width, int height,
                                   int stride, RestorationInternal *rst,
@@ -962,7 +962,7 @@ static void loop_copy_tile_highbd(uint16_t *data, int tile_idx, int subtile_idx,
                            rst->nvtiles, tile_width, tile_height, width, height,
                            0, 0, &h_start, &h_end, &v_start, &v_end);
   for (i = v_start; i < v_end; ++i)
-    memcpy(dst + i * dst_stride + h_start, data + i * stride + h_start,
+    memcpy(dst + (i - v_start) * dst_stride, data + i * stride + h_start,
            (h_end - h_start) * sizeof(*dst));
 }
 
@@ -991,7 +991,7 @@ static void loop_wiener_filter_tile_highbd(uint16_t *data, int tile_idx,
       int w = AOMMIN(MAX_SB_SIZE, (h_end - j + 15) & ~15);
       int h = AOMMIN(MAX_SB_SIZE, (v_end - i + 15) & ~15);
       const uint16_t *data_p = data + i * stride + j;
-      uint16_t *dst_p = dst + i * dst_stride + j;
+      uint16_t *dst_p = dst + (i - v_start) * dst_stride + j - h_start;
       aom_highbd_convolve8_add_src(
           CONVERT_TO_BYTEPTR(data_p), stride, CONVERT_TO_BYTEPTR(dst_p),
           dst_stride, rst->rsi->wiener_info[tile_idx].hfilter, 16,
@@ -999,20 +999,6 @@ static void loop_wiener_filter_tile_highbd(uint16_t *data, int tile_idx,
     }
 }
 
-static void loop_wiener_filter_highbd(uint8_t *data8, int width, int height,
-                                      int stride, RestorationInternal *rst,
-                                      int bit_depth, uint8_t *dst8,
-                                      int dst_stride) {
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
-  int tile_idx;
-  extend_frame_highbd(data, width, height, stride);
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    loop_wiener_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
-                                   bit_depth, dst, dst_stride);
-  }
-}
-
 void av1_selfguided_restoration_highbd_c(uint16_t *dgd, int width, int height,
                                          int stride, int32_t *dst,
                                          int dst_stride, int bit_depth, int r,
@@ -1164,7 +1150,7 @@ static void loop_sgrproj_filter_tile_highbd(uint16_t *data, int tile_idx,
   const int tile_width = rst->tile_width;
   const int tile_height = rst->tile_height;
   int h_start, h_end, v_start, v_end;
-  uint16_t *data_p, *dst_p;
+  uint16_t *data_p;
 
   if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
     loop_copy_tile_highbd(data, tile_idx, 0, 0, width, height, stride, rst, dst,
@@ -1175,227 +1161,538 @@ static void loop_sgrproj_filter_tile_highbd(uint16_t *data, int tile_idx,
                            tile_width, tile_height, width, height, 0, 0,
                            &h_start, &h_end, &v_start, &v_end);
   data_p = data + h_start + v_start * stride;
-  dst_p = dst + h_start + v_start * dst_stride;
   apply_selfguided_restoration_highbd(
       data_p, h_end - h_start, v_end - v_start, stride, bit_depth,
       rst->rsi->sgrproj_info[tile_idx].ep, rst->rsi->sgrproj_info[tile_idx].xqd,
-      dst_p, dst_stride, rst->tmpbuf);
+      dst, dst_stride, rst->tmpbuf);
 }
 
-static void loop_sgrproj_filter_highbd(uint8_t *data8, int width, int height,
-                                       int stride, RestorationInternal *rst,
-                                       int bit_depth, uint8_t *dst8,
-                                       int dst_stride) {
-  int tile_idx;
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
+static void loop_switchable_filter_tile_highbd(uint16_t *data, int tile_idx,
+                                               int width, int height,
+                                               int stride,
+                                               RestorationInternal *rst,
+                                               int bit_depth, uint16_t *dst,
+                                               int dst_stride) {
+  if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
+    loop_copy_tile_highbd(data, tile_idx, 0, 0, width, height, stride, rst, dst,
+                          dst_stride);
+  } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
+    loop_wiener_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
+                                   bit_depth, dst, dst_stride);
+  } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
     loop_sgrproj_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
                                     bit_depth, dst, dst_stride);
   }
 }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
 
-static void loop_switchable_filter_highbd(uint8_t *data8, int width, int height,
-                                          int stride, RestorationInternal *rst,
-                                          int bit_depth, uint8_t *dst8,
-                                          int dst_stride) {
-  uint16_t *data = CONVERT_TO_SHORTPTR(data8);
-  uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
-  int tile_idx;
-  extend_frame_highbd(data, width, height, stride);
-  for (tile_idx = 0; tile_idx < rst->ntiles; ++tile_idx) {
-    if (rst->rsi->restoration_type[tile_idx] == RESTORE_NONE) {
-      loop_copy_tile_highbd(data, tile_idx, 0, 0, width, height, stride, rst,
-                            dst, dst_stride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_WIENER) {
-      loop_wiener_filter_tile_highbd(data, tile_idx, width, height, stride, rst,
-                                     bit_depth, dst, dst_stride);
-    } else if (rst->rsi->restoration_type[tile_idx] == RESTORE_SGRPROJ) {
-      loop_sgrproj_filter_tile_highbd(data, tile_idx, width, height, stride,
-                                      rst, bit_depth, dst, dst_stride);
-    }
-  }
+static const restore_func_type restore_funcs[RESTORE_TYPES] = {
+  NULL, loop_wiener_filter_tile, loop_sgrproj_filter_tile,
+  loop_switchable_filter_tile
+};
+#if CONFIG_AOM_HIGHBITDEPTH
+static const restore_func_highbd_type restore_funcs_highbd[RESTORE_TYPES] = {
+  NULL, loop_wiener_filter_tile_highbd, loop_sgrproj_filter_tile_highbd,
+  loop_switchable_filter_tile_highbd
+};
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+// The Wiener filter of a tile may write up to 15 pixels past its right and
+// bottom edges, so each tile in a stripe buffer is followed by this many
+// columns, and the buffer has this many extra rows. The filter also reads
+// that many rows below the tile, whose output is discarded.
+#define STRIPE_TILE_BORDER 16
+
+#if CONFIG_MULTITHREAD
+static INLINE void lr_sync_lock(AV1LrSync *const lr_sync) {
+  if (lr_sync->mutex_ != NULL) pthread_mutex_lock(lr_sync->mutex_);
+}
+
+static INLINE void lr_sync_unlock(AV1LrSync *const lr_sync) {
+  if (lr_sync->mutex_ != NULL) pthread_mutex_unlock(lr_sync->mutex_);
+}
+
+static INLINE void lr_sync_signal(AV1LrSync *const lr_sync) {
+  if (lr_sync->cond_ != NULL) pthread_cond_broadcast(lr_sync->cond_);
+}
+#else
+static INLINE void lr_sync_lock(AV1LrSync *const lr_sync) { (void)lr_sync; }
+static INLINE void lr_sync_unlock(AV1LrSync *const lr_sync) { (void)lr_sync; }
+static INLINE void lr_sync_signal(AV1LrSync *const lr_sync) { (void)lr_sync; }
+#endif  // CONFIG_MULTITHREAD
+
+// Number of rows of the plane read by a step, including the rows the Wiener
+// filter reads below the stripe.
+static int step_rows_read(const LRPlaneData *const pd, int step) {
+  const RestorationInternal *const rst = &pd->rst;
+  int h_start, h_end, v_start, v_end;
+  if (step >= rst->nvtiles) return 0;
+  av1_get_rest_tile_limits(step * rst->nhtiles, 0, 0, rst->nhtiles,
+                           rst->nvtiles, rst->tile_width, rst->tile_height,
+                           pd->width, pd->height, 0, 0, &h_start, &h_end,
+                           &v_start, &v_end);
+  return AOMMIN(v_end + WIENER_HALFWIN + STRIPE_TILE_BORDER, pd->height);
 }
+
+// Write back tile column c of the stripe two rows above the step, and filter
+// the one of the stripe of the step.
+static void restore_tile_col(const AV1LrSync *const lr_sync,
+                             const LRPlaneData *const pd, int step, int c,
+                             int32_t *tmpbuf) {
+  RestorationInternal rst = pd->rst;
+  const int pixel_size = lr_sync->highbd ? 2 : 1;
+  const int write_stripe = pd->stripe_stride ? step - 2 : -1;
+  int h_start, h_end, v_start, v_end;
+
+  rst.tmpbuf = tmpbuf;
+
+  if (write_stripe >= 0) {
+    const int tile_idx = write_stripe * rst.nhtiles + c;
+    const uint8_t *src;
+    int i;
+    av1_get_rest_tile_limits(tile_idx, 0, 0, rst.nhtiles, rst.nvtiles,
+                             rst.tile_width, rst.tile_height, pd->width,
+                             pd->height, 0, 0, &h_start, &h_end, &v_start,
+                             &v_end);
+    src = pd->stripe_buf[write_stripe & 1] +
+          (h_start + c * STRIPE_TILE_BORDER) * pixel_size;
+    for (i = v_start; i < v_end; ++i) {
+#if CONFIG_AOM_HIGHBITDEPTH
+      if (lr_sync->highbd)
+        memcpy(CONVERT_TO_SHORTPTR(pd->dst8) + i * pd->dst_stride + h_start,
+               src, (h_end - h_start) * sizeof(uint16_t));
+      else
 #endif  // CONFIG_AOM_HIGHBITDEPTH
+        memcpy(pd->dst8 + i * pd->dst_stride + h_start, src, h_end - h_start);
+      src += pd->stripe_stride * pixel_size;
+    }
+  }
 
-static void loop_restoration_rows(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
-                                  int start_mi_row, int end_mi_row,
-                                  int components_pattern, RestorationInfo *rsi,
-                                  YV12_BUFFER_CONFIG *dst) {
-  const int ywidth = frame->y_crop_width;
-  const int ystride = frame->y_stride;
-  const int uvwidth = frame->uv_crop_width;
-  const int uvstride = frame->uv_stride;
-  const int ystart = start_mi_row << MI_SIZE_LOG2;
-  const int uvstart = ystart >> cm->subsampling_y;
-  int yend = end_mi_row << MI_SIZE_LOG2;
-  int uvend = yend >> cm->subsampling_y;
-  restore_func_type restore_funcs[RESTORE_TYPES] = {
-    NULL, loop_wiener_filter, loop_sgrproj_filter, loop_switchable_filter
-  };
+  if (step < rst.nvtiles) {
+    const int tile_idx = step * rst.nhtiles + c;
+    uint8_t *dst;
+    int dst_stride;
+    av1_get_rest_tile_limits(tile_idx, 0, 0, rst.nhtiles, rst.nvtiles,
+                             rst.tile_width, rst.tile_height, pd->width,
+                             pd->height, 0, 0, &h_start, &h_end, &v_start,
+                             &v_end);
+    if (pd->stripe_stride) {
+      dst = pd->stripe_buf[step & 1] +
+            (h_start + c * STRIPE_TILE_BORDER) * pixel_size;
+      dst_stride = pd->stripe_stride;
+    } else {
 #if CONFIG_AOM_HIGHBITDEPTH
-  restore_func_highbd_type restore_funcs_highbd[RESTORE_TYPES] = {
-    NULL, loop_wiener_filter_highbd, loop_sgrproj_filter_highbd,
-    loop_switchable_filter_highbd
-  };
+      if (lr_sync->highbd)
+        dst = (uint8_t *)(CONVERT_TO_SHORTPTR(pd->dst8) +
+                          v_start * pd->dst_stride + h_start);
+      else
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  restore_func_type restore_func;
+        dst = pd->dst8 + v_start * pd->dst_stride + h_start;
+      dst_stride = pd->dst_stride;
+    }
 #if CONFIG_AOM_HIGHBITDEPTH
-  restore_func_highbd_type restore_func_highbd;
+    if (lr_sync->highbd)
+      restore_funcs_highbd[rst.rsi->frame_restoration_type](
+          CONVERT_TO_SHORTPTR(pd->data8), tile_idx, pd->width, pd->height,
+          pd->stride, &rst, lr_sync->bit_depth, (uint16_t *)dst, dst_stride);
+    else
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  YV12_BUFFER_CONFIG dst_;
+      restore_funcs[rst.rsi->frame_restoration_type](
+          pd->data8, tile_idx, pd->width, pd->height, pd->stride, &rst, dst,
+          dst_stride);
+  }
+}
 
-  yend = AOMMIN(yend, cm->height);
-  uvend = AOMMIN(uvend, cm->subsampling_y ? (cm->height + 1) >> 1 : cm->height);
+// Pick the next tile column to restore, if any. Must be called with the
+// mutex held. The rows read by a step are extended when the step starts.
+static int get_restoration_job(AV1LrSync *const lr_sync, int *plane,
+                               int *step, int *col) {
+  int p;
+  for (p = 0; p < MAX_MB_PLANE; ++p) {
+    LRPlaneData *const pd = &lr_sync->planes[p];
+    if (pd->step >= pd->nsteps || pd->next_col == pd->rst.nhtiles) continue;
+    if (pd->next_col == 0) {
+      const int rows = step_rows_read(pd, pd->step);
+      if ((rows << pd->subsampling_y) > lr_sync->rows_ready) continue;
+      if (pd->extend && rows > pd->rows_extended) {
+#if CONFIG_AOM_HIGHBITDEPTH
+        if (lr_sync->highbd)
+          extend_frame_rows_highbd(CONVERT_TO_SHORTPTR(pd->data8), pd->width,
+                                   pd->height, pd->stride, pd->rows_extended,
+                                   rows);
+        else
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+          extend_frame_rows(pd->data8, pd->width, pd->height, pd->stride,
+                            pd->rows_extended, rows);
+        pd->rows_extended = rows;
+      }
+    }
+    *plane = p;
+    *step = pd->step;
+    *col = pd->next_col++;
+    return 1;
+  }
+  return 0;
+}
 
-  if (components_pattern == (1 << AOM_PLANE_Y)) {
-    // Only y
-    if (rsi[0].frame_restoration_type == RESTORE_NONE) {
-      if (dst) aom_yv12_copy_y(frame, dst);
-      return;
+static void restore_tiles(AV1LrSync *const lr_sync, int32_t *tmpbuf,
+                          int wait) {
+  int plane, step, col;
+
+  lr_sync_lock(lr_sync);
+  while (lr_sync->planes_left > 0) {
+    if (get_restoration_job(lr_sync, &plane, &step, &col)) {
+      LRPlaneData *const pd = &lr_sync->planes[plane];
+      lr_sync_unlock(lr_sync);
+      restore_tile_col(lr_sync, pd, step, col, tmpbuf);
+      lr_sync_lock(lr_sync);
+      if (++pd->cols_done == pd->rst.nhtiles) {
+        pd->next_col = 0;
+        pd->cols_done = 0;
+        if (++pd->step == pd->nsteps) --lr_sync->planes_left;
+        lr_sync_signal(lr_sync);
+      }
+    } else {
+#if CONFIG_MULTITHREAD
+      if (wait && lr_sync->cond_ != NULL) {
+        pthread_cond_wait(lr_sync->cond_, lr_sync->mutex_);
+        continue;
+      }
+#else
+      (void)wait;
+#endif  // CONFIG_MULTITHREAD
+      break;
     }
-  } else if (components_pattern == (1 << AOM_PLANE_U)) {
-    // Only U
-    if (rsi[1].frame_restoration_type == RESTORE_NONE) {
-      if (dst) aom_yv12_copy_u(frame, dst);
-      return;
+  }
+  lr_sync_unlock(lr_sync);
+}
+
+void av1_loop_restoration_tiles(AV1LrSync *lr_sync, int worker, int wait) {
+  restore_tiles(lr_sync, lr_sync->lrworkerdata[worker].tmpbuf, wait);
+}
+
+void av1_loop_restoration_rows_ready(AV1LrSync *lr_sync, int rows) {
+  lr_sync_lock(lr_sync);
+  if (rows > lr_sync->rows_ready) {
+    lr_sync->rows_ready = rows;
+    lr_sync_signal(lr_sync);
+  }
+  lr_sync_unlock(lr_sync);
+}
+
+// Set up the restoration of one plane. The result is written to dst8 if it is
+// not NULL, or back to data8 otherwise.
+static void loop_restoration_plane_start(AV1_COMMON *cm, LRPlaneData *pd,
+                                         uint8_t *data8, int width, int height,
+                                         int stride, uint8_t *dst8,
+                                         int dst_stride, int num_workers) {
+  RestorationInternal *const rst = &cm->rst_internal;
+  // With a single thread per stripe the tiles can be filtered to dst
+  // directly, as no other thread writes the pixels past their edges.
+  const int use_stripe_buf =
+      dst8 == NULL || AOMMIN(num_workers, rst->nhtiles) > 1;
+
+  pd->rst = *rst;
+  pd->data8 = data8;
+  pd->width = width;
+  pd->height = height;
+  pd->stride = stride;
+  pd->dst8 = dst8 ? dst8 : data8;
+  pd->dst_stride = dst8 ? dst_stride : stride;
+  pd->extend = rst->rsi->frame_restoration_type == RESTORE_WIENER ||
+               rst->rsi->frame_restoration_type == RESTORE_SWITCHABLE;
+  pd->rows_extended = 0;
+  pd->stripe_stride = 0;
+  pd->nsteps = rst->nvtiles + (use_stripe_buf ? 2 : 0);
+  pd->step = 0;
+  pd->next_col = 0;
+  pd->cols_done = 0;
+
+  if (use_stripe_buf) {
+#if CONFIG_AOM_HIGHBITDEPTH
+    const int pixel_size = cm->use_highbitdepth ? 2 : 1;
+#else
+    const int pixel_size = 1;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    int stripe_rows = 0;
+    size_t buf_size;
+    int s, i;
+    for (s = 0; s < rst->nvtiles; ++s) {
+      int h_start, h_end, v_start, v_end;
+      av1_get_rest_tile_limits(s * rst->nhtiles, 0, 0, rst->nhtiles,
+                               rst->nvtiles, rst->tile_width, rst->tile_height,
+                               width, height, 0, 0, &h_start, &h_end, &v_start,
+                               &v_end);
+      stripe_rows = AOMMAX(stripe_rows, v_end - v_start);
     }
-  } else if (components_pattern == (1 << AOM_PLANE_V)) {
-    // Only V
-    if (rsi[2].frame_restoration_type == RESTORE_NONE) {
-      if (dst) aom_yv12_copy_v(frame, dst);
-      return;
+    pd->stripe_stride = (width + rst->nhtiles * STRIPE_TILE_BORDER + 15) & ~15;
+    buf_size = (size_t)pd->stripe_stride * (stripe_rows + STRIPE_TILE_BORDER) *
+               pixel_size;
+    if (buf_size > pd->stripe_buf_size) {
+      for (i = 0; i < 2; ++i) {
+        aom_free(pd->stripe_buf[i]);
+        CHECK_MEM_ERROR(cm, pd->stripe_buf[i],
+                        (uint8_t *)aom_memalign(32, buf_size));
+      }
+      pd->stripe_buf_size = buf_size;
     }
-  } else if (components_pattern ==
-             ((1 << AOM_PLANE_Y) | (1 << AOM_PLANE_U) | (1 << AOM_PLANE_V))) {
-    // All components
-    if (rsi[0].frame_restoration_type == RESTORE_NONE &&
-        rsi[1].frame_restoration_type == RESTORE_NONE &&
-        rsi[2].frame_restoration_type == RESTORE_NONE) {
-      if (dst) aom_yv12_copy_frame(frame, dst);
-      return;
+  }
+}
+
+void av1_loop_restoration_start(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                RestorationInfo *rsi, int components_pattern,
+                                int partial_frame, YV12_BUFFER_CONFIG *dst,
+                                int num_workers, AV1LrSync *lr_sync) {
+  const int ywidth = frame->y_crop_width;
+  const int ystride = frame->y_stride;
+  const int uvwidth = frame->uv_crop_width;
+  const int uvstride = frame->uv_stride;
+  const int nworkers = AOMMAX(num_workers, 1);
+  int start_mi_row, end_mi_row, mi_rows_to_filter;
+  int ystart, uvstart, yend, uvend;
+  int plane, i;
+
+  start_mi_row = 0;
+  mi_rows_to_filter = cm->mi_rows;
+  if (partial_frame && cm->mi_rows > 8) {
+    start_mi_row = cm->mi_rows >> 1;
+    start_mi_row &= 0xfffffff8;
+    mi_rows_to_filter = AOMMAX(cm->mi_rows / 8, 8);
+  }
+  end_mi_row = start_mi_row + mi_rows_to_filter;
+  loop_restoration_init(&cm->rst_internal, cm->frame_type == KEY_FRAME);
+
+  ystart = start_mi_row << MI_SIZE_LOG2;
+  uvstart = ystart >> cm->subsampling_y;
+  yend = AOMMIN(end_mi_row << MI_SIZE_LOG2, cm->height);
+  uvend = AOMMIN((end_mi_row << MI_SIZE_LOG2) >> cm->subsampling_y,
+                 cm->subsampling_y ? (cm->height + 1) >> 1 : cm->height);
+
+  if (nworkers > lr_sync->num_workers) {
+    for (i = 1; i < lr_sync->num_workers; ++i)
+      aom_free(lr_sync->lrworkerdata[i].tmpbuf);
+    aom_free(lr_sync->lrworkerdata);
+    lr_sync->num_workers = 0;
+    CHECK_MEM_ERROR(cm, lr_sync->lrworkerdata,
+                    aom_calloc(nworkers, sizeof(*lr_sync->lrworkerdata)));
+    lr_sync->num_workers = nworkers;
+    for (i = 1; i < nworkers; ++i) {
+      CHECK_MEM_ERROR(cm, lr_sync->lrworkerdata[i].tmpbuf,
+                      (int32_t *)aom_memalign(16, RESTORATION_TMPBUF_SIZE));
     }
   }
+  // The first worker uses the buffer of the frame.
+  lr_sync->lrworkerdata[0].tmpbuf = cm->rst_internal.tmpbuf;
 
-  if (!dst) {
-    dst = &dst_;
-    memset(dst, 0, sizeof(YV12_BUFFER_CONFIG));
-    if (aom_realloc_frame_buffer(
-            dst, cm->width, cm->height, cm->subsampling_x, cm->subsampling_y,
-#if CONFIG_AOM_HIGHBITDEPTH
-            cm->use_highbitdepth,
-#endif
-            AOM_BORDER_IN_PIXELS, cm->byte_alignment, NULL, NULL, NULL) < 0)
-      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
-                         "Failed to allocate restoration dst buffer");
+#if CONFIG_MULTITHREAD
+  if (nworkers > 1 && lr_sync->mutex_ == NULL) {
+    CHECK_MEM_ERROR(cm, lr_sync->mutex_, aom_malloc(sizeof(*lr_sync->mutex_)));
+    if (lr_sync->mutex_) pthread_mutex_init(lr_sync->mutex_, NULL);
+    CHECK_MEM_ERROR(cm, lr_sync->cond_, aom_malloc(sizeof(*lr_sync->cond_)));
+    if (lr_sync->cond_) pthread_cond_init(lr_sync->cond_, NULL);
   }
+#endif  // CONFIG_MULTITHREAD
 
-  if ((components_pattern >> AOM_PLANE_Y) & 1) {
-    if (rsi[0].frame_restoration_type != RESTORE_NONE) {
-      cm->rst_internal.ntiles = av1_get_rest_ntiles(
-          cm->width, cm->height, cm->rst_info[AOM_PLANE_Y].restoration_tilesize,
-          &cm->rst_internal.tile_width, &cm->rst_internal.tile_height,
-          &cm->rst_internal.nhtiles, &cm->rst_internal.nvtiles);
-      cm->rst_internal.rsi = &rsi[0];
-      restore_func =
-          restore_funcs[cm->rst_internal.rsi->frame_restoration_type];
 #if CONFIG_AOM_HIGHBITDEPTH
-      restore_func_highbd =
-          restore_funcs_highbd[cm->rst_internal.rsi->frame_restoration_type];
-      if (cm->use_highbitdepth)
-        restore_func_highbd(
-            frame->y_buffer + ystart * ystride, ywidth, yend - ystart, ystride,
-            &cm->rst_internal, cm->bit_depth,
-            dst->y_buffer + ystart * dst->y_stride, dst->y_stride);
-      else
+  lr_sync->highbd = cm->use_highbitdepth;
+#else
+  lr_sync->highbd = 0;
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-        restore_func(frame->y_buffer + ystart * ystride, ywidth, yend - ystart,
-                     ystride, &cm->rst_internal,
-                     dst->y_buffer + ystart * dst->y_stride, dst->y_stride);
-    } else {
-      aom_yv12_copy_y(frame, dst);
+  lr_sync->bit_depth = cm->bit_depth;
+  lr_sync->rows_ready = 0;
+  lr_sync->planes_left = 0;
+
+  for (plane = AOM_PLANE_Y; plane <= AOM_PLANE_V; ++plane) {
+    LRPlaneData *const pd = &lr_sync->planes[plane];
+    const int start = plane ? uvstart : ystart;
+    const int end = plane ? uvend : yend;
+    const int stride = plane ? uvstride : ystride;
+    uint8_t *data8 = plane == AOM_PLANE_Y
+                         ? frame->y_buffer
+                         : plane == AOM_PLANE_U ? frame->u_buffer
+                                                : frame->v_buffer;
+    uint8_t *dst8 = NULL;
+    int dst_stride = 0;
+
+    pd->nsteps = 0;
+    pd->step = 0;
+    if (!((components_pattern >> plane) & 1)) continue;
+    if (rsi[plane].frame_restoration_type == RESTORE_NONE) {
+      if (dst) {
+        if (plane == AOM_PLANE_Y)
+          aom_yv12_copy_y(frame, dst);
+        else if (plane == AOM_PLANE_U)
+          aom_yv12_copy_u(frame, dst);
+        else
+          aom_yv12_copy_v(frame, dst);
+      }
+      continue;
     }
-  }
 
-  if ((components_pattern >> AOM_PLANE_U) & 1) {
-    if (rsi[AOM_PLANE_U].frame_restoration_type != RESTORE_NONE) {
+    if (plane == AOM_PLANE_Y) {
       cm->rst_internal.ntiles = av1_get_rest_ntiles(
-          ROUND_POWER_OF_TWO(cm->width, cm->subsampling_x),
-          ROUND_POWER_OF_TWO(cm->height, cm->subsampling_y),
-          cm->rst_info[AOM_PLANE_U].restoration_tilesize,
+          cm->width, cm->height, cm->rst_info[AOM_PLANE_Y].restoration_tilesize,
           &cm->rst_internal.tile_width, &cm->rst_internal.tile_height,
           &cm->rst_internal.nhtiles, &cm->rst_internal.nvtiles);
-      cm->rst_internal.rsi = &rsi[AOM_PLANE_U];
-      restore_func =
-          restore_funcs[cm->rst_internal.rsi->frame_restoration_type];
-#if CONFIG_AOM_HIGHBITDEPTH
-      restore_func_highbd =
-          restore_funcs_highbd[cm->rst_internal.rsi->frame_restoration_type];
-      if (cm->use_highbitdepth)
-        restore_func_highbd(
-            frame->u_buffer + uvstart * uvstride, uvwidth, uvend - uvstart,
-            uvstride, &cm->rst_internal, cm->bit_depth,
-            dst->u_buffer + uvstart * dst->uv_stride, dst->uv_stride);
-      else
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-        restore_func(frame->u_buffer + uvstart * uvstride, uvwidth,
-                     uvend - uvstart, uvstride, &cm->rst_internal,
-                     dst->u_buffer + uvstart * dst->uv_stride, dst->uv_stride);
     } else {
-      aom_yv12_copy_u(frame, dst);
-    }
-  }
-
-  if ((components_pattern >> AOM_PLANE_V) & 1) {
-    if (rsi[AOM_PLANE_V].frame_restoration_type != RESTORE_NONE) {
       cm->rst_internal.ntiles = av1_get_rest_ntiles(
           ROUND_POWER_OF_TWO(cm->width, cm->subsampling_x),
           ROUND_POWER_OF_TWO(cm->height, cm->subsampling_y),
-          cm->rst_info[AOM_PLANE_V].restoration_tilesize,
+          cm->rst_info[plane].restoration_tilesize,
           &cm->rst_internal.tile_width, &cm->rst_internal.tile_height,
           &cm->rst_internal.nhtiles, &cm->rst_internal.nvtiles);
-      cm->rst_internal.rsi = &rsi[AOM_PLANE_V];
-      restore_func =
-          restore_funcs[cm->rst_internal.rsi->frame_restoration_type];
+    }
+    cm->rst_internal.rsi = &rsi[plane];
+
+    if (dst) {
+      dst8 = plane == AOM_PLANE_Y
+                 ? dst->y_buffer
+                 : plane == AOM_PLANE_U ? dst->u_buffer : dst->v_buffer;
+      dst_stride = plane ? dst->uv_stride : dst->y_stride;
+    }
 #if CONFIG_AOM_HIGHBITDEPTH
-      restore_func_highbd =
-          restore_funcs_highbd[cm->rst_internal.rsi->frame_restoration_type];
-      if (cm->use_highbitdepth)
-        restore_func_highbd(
-            frame->v_buffer + uvstart * uvstride, uvwidth, uvend - uvstart,
-            uvstride, &cm->rst_internal, cm->bit_depth,
-            dst->v_buffer + uvstart * dst->uv_stride, dst->uv_stride);
-      else
+    if (cm->use_highbitdepth) {
+      data8 = CONVERT_TO_BYTEPTR(CONVERT_TO_SHORTPTR(data8) + start * stride);
+      if (dst)
+        dst8 =
+            CONVERT_TO_BYTEPTR(CONVERT_TO_SHORTPTR(dst8) + start * dst_stride);
+    } else {
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-        restore_func(frame->v_buffer + uvstart * uvstride, uvwidth,
-                     uvend - uvstart, uvstride, &cm->rst_internal,
-                     dst->v_buffer + uvstart * dst->uv_stride, dst->uv_stride);
+      data8 += start * stride;
+      if (dst) dst8 += start * dst_stride;
+#if CONFIG_AOM_HIGHBITDEPTH
+    }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    loop_restoration_plane_start(cm, pd, data8, plane ? uvwidth : ywidth,
+                                 end - start, stride, dst8, dst_stride,
+                                 nworkers);
+    pd->subsampling_y = plane ? cm->subsampling_y : 0;
+    if (pd->nsteps) ++lr_sync->planes_left;
+  }
+}
+
+static int loop_restoration_worker(AV1LrSync *const lr_sync,
+                                   LRWorkerData *const lr_data) {
+  restore_tiles(lr_sync, lr_data->tmpbuf, 1);
+  return 1;
+}
+
+void av1_loop_restoration_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                   RestorationInfo *rsi, int components_pattern,
+                                   int partial_frame, YV12_BUFFER_CONFIG *dst,
+                                   AVxWorker *workers, int num_workers,
+                                   AV1LrSync *lr_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
+
+  av1_loop_restoration_start(frame, cm, rsi, components_pattern, partial_frame,
+                             dst, num_workers, lr_sync);
+  // All the rows of the frame are final.
+  av1_loop_restoration_rows_ready(lr_sync, INT_MAX);
+
+  if (num_workers <= 1) {
+    av1_loop_restoration_tiles(lr_sync, 0, 1);
+    return;
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    AVxWorker *const worker = &workers[i];
+    worker->hook = (AVxWorkerHook)loop_restoration_worker;
+    worker->data1 = lr_sync;
+    worker->data2 = &lr_sync->lrworkerdata[i];
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
     } else {
-      aom_yv12_copy_v(frame, dst);
+      winterface->launch(worker);
     }
   }
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+}
+
+void av1_loop_restoration_tile(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                               RestorationInfo *rsi, int plane, int tile_idx,
+                               YV12_BUFFER_CONFIG *dst, int32_t *tmpbuf) {
+  const int width = plane ? frame->uv_crop_width : frame->y_crop_width;
+  const int height = plane ? frame->uv_crop_height : frame->y_crop_height;
+  const int stride = plane ? frame->uv_stride : frame->y_stride;
+  const int dst_stride = plane ? dst->uv_stride : dst->y_stride;
+  uint8_t *data8 = plane == AOM_PLANE_Y
+                       ? frame->y_buffer
+                       : plane == AOM_PLANE_U ? frame->u_buffer
+                                              : frame->v_buffer;
+  uint8_t *dst8 = plane == AOM_PLANE_Y
+                      ? dst->y_buffer
+                      : plane == AOM_PLANE_U ? dst->u_buffer : dst->v_buffer;
+  RestorationInternal rst;
+  int h_start, h_end, v_start, v_end;
 
-  if (dst == &dst_) {
-    if ((components_pattern >> AOM_PLANE_Y) & 1) aom_yv12_copy_y(dst, frame);
-    if ((components_pattern >> AOM_PLANE_U) & 1) aom_yv12_copy_u(dst, frame);
-    if ((components_pattern >> AOM_PLANE_V) & 1) aom_yv12_copy_v(dst, frame);
-    aom_free_frame_buffer(dst);
+  assert(rsi->frame_restoration_type != RESTORE_NONE);
+  // Same tile layout as av1_loop_restoration_start().
+  if (plane == AOM_PLANE_Y) {
+    rst.ntiles = av1_get_rest_ntiles(
+        cm->width, cm->height, cm->rst_info[AOM_PLANE_Y].restoration_tilesize,
+        &rst.tile_width, &rst.tile_height, &rst.nhtiles, &rst.nvtiles);
+  } else {
+    rst.ntiles = av1_get_rest_ntiles(
+        ROUND_POWER_OF_TWO(cm->width, cm->subsampling_x),
+        ROUND_POWER_OF_TWO(cm->height, cm->subsampling_y),
+        cm->rst_info[plane].restoration_tilesize, &rst.tile_width,
+        &rst.tile_height, &rst.nhtiles, &rst.nvtiles);
+  }
+  rst.rsi = rsi;
+  rst.tmpbuf = tmpbuf;
+  loop_restoration_init(&rst, cm->frame_type == KEY_FRAME);
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, rst.nhtiles, rst.nvtiles,
+                           rst.tile_width, rst.tile_height, width, height, 0, 0,
+                           &h_start, &h_end, &v_start, &v_end);
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth) {
+    restore_funcs_highbd[rsi->frame_restoration_type](
+        CONVERT_TO_SHORTPTR(data8), tile_idx, width, height, stride, &rst,
+        cm->bit_depth,
+        CONVERT_TO_SHORTPTR(dst8) + v_start * dst_stride + h_start,
+        dst_stride);
+    return;
   }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  restore_funcs[rsi->frame_restoration_type](
+      data8, tile_idx, width, height, stride, &rst,
+      dst8 + v_start * dst_stride + h_start, dst_stride);
 }
 
 void av1_loop_restoration_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
                                 RestorationInfo *rsi, int components_pattern,
                                 int partial_frame, YV12_BUFFER_CONFIG *dst) {
-  int start_mi_row, end_mi_row, mi_rows_to_filter;
-  start_mi_row = 0;
-  mi_rows_to_filter = cm->mi_rows;
-  if (partial_frame && cm->mi_rows > 8) {
-    start_mi_row = cm->mi_rows >> 1;
-    start_mi_row &= 0xfffffff8;
-    mi_rows_to_filter = AOMMAX(cm->mi_rows / 8, 8);
+  AV1LrSync lr_sync;
+  av1_zero(lr_sync);
+  av1_loop_restoration_frame_mt(frame, cm, rsi, components_pattern,
+                                partial_frame, dst, NULL, 0, &lr_sync);
+  av1_loop_restoration_dealloc(&lr_sync);
+}
+
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync) {
+  if (lr_sync != NULL) {
+    int i;
+#if CONFIG_MULTITHREAD
+    if (lr_sync->mutex_ != NULL) {
+      pthread_mutex_destroy(lr_sync->mutex_);
+      aom_free(lr_sync->mutex_);
+    }
+    if (lr_sync->cond_ != NULL) {
+      pthread_cond_destroy(lr_sync->cond_);
+      aom_free(lr_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    for (i = 1; i < lr_sync->num_workers; ++i)
+      aom_free(lr_sync->lrworkerdata[i].tmpbuf);
+    aom_free(lr_sync->lrworkerdata);
+    for (i = 0; i < MAX_MB_PLANE; ++i) {
+      aom_free(lr_sync->planes[i].stripe_buf[0]);
+      aom_free(lr_sync->planes[i].stripe_buf[1]);
+    }
+    av1_zero(*lr_sync);
   }
-  end_mi_row = start_mi_row + mi_rows_to_filter;
-  loop_restoration_init(&cm->rst_internal, cm->frame_type == KEY_FRAME);
-  loop_restoration_rows(frame, cm, start_mi_row, end_mi_row, components_pattern,
-                        rsi, dst);
 }
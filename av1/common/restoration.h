@@ -16,6 +16,7 @@
 #include "./aom_config.h"
 
 #include "av1/common/blockd.h"
+#include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -159,6 +160,60 @@ typedef struct {
   int32_t *tmpbuf;
 } RestorationInternal;
 
+typedef struct {
+  // Scratch buffer of the worker, the one of the frame for the first worker.
+  int32_t *tmpbuf;
+} LRWorkerData;
+
+// Loop restoration state of a plane. A stripe is a row of restoration tiles.
+// The restored pixels of a stripe are kept in a stripe buffer until the
+// stripe below has been filtered, as that stripe reads the unrestored bottom
+// lines of the stripe above. Step s filters stripe s and writes back stripe
+// s - 2, one tile column at a time.
+typedef struct {
+  // Tile layout and filters of the plane.
+  RestorationInternal rst;
+  uint8_t *data8;
+  int width, height, stride;
+  uint8_t *dst8;
+  int dst_stride;
+  int subsampling_y;
+  // Whether the plane borders are extended for the Wiener filter, and the
+  // number of rows extended so far.
+  int extend;
+  int rows_extended;
+
+  uint8_t *stripe_buf[2];
+  size_t stripe_buf_size;
+  // 0 if the tiles are filtered to dst8 directly.
+  int stripe_stride;
+
+  int nsteps;
+  int step;
+  // Next tile column of the step to restore, and the number of columns of
+  // the step already restored.
+  int next_col;
+  int cols_done;
+} LRPlaneData;
+
+// Loop restoration thread data. The tiles of a frame are restored by any
+// number of threads, in step order for each plane, and each step only once
+// the rows it reads are final.
+typedef struct AV1LrSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  LRWorkerData *lrworkerdata;
+  int num_workers;
+
+  LRPlaneData planes[MAX_MB_PLANE];
+  int planes_left;
+  // Number of luma rows of the frame that may be read by the filters.
+  int rows_ready;
+  int highbd, bit_depth;
+} AV1LrSync;
+
 static INLINE int av1_get_rest_ntiles(int width, int height, int tilesize,
                                       int *tile_width, int *tile_height,
                                       int *nhtiles, int *nvtiles) {
@@ -227,6 +282,44 @@ void av1_loop_restoration_frame(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
                                 RestorationInfo *rsi, int components_pattern,
                                 int partial_frame, YV12_BUFFER_CONFIG *dst);
 void av1_loop_restoration_precal();
+
+// Restore tile tile_idx of a plane of frame into the same place in dst, as
+// av1_loop_restoration_frame() would over the whole frame, with tmpbuf as
+// scratch buffer. The Wiener filter needs the borders of the plane to be
+// extended already. cm is not modified, so tiles can be restored by several
+// threads as long as they do not share dst: the Wiener filter may write up to
+// 15 pixels past the right and bottom edges of the tile.
+void av1_loop_restoration_tile(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
+                               RestorationInfo *rsi, int plane, int tile_idx,
+                               YV12_BUFFER_CONFIG *dst, int32_t *tmpbuf);
+
+// Restore the frame with the restoration tiles of each stripe split among
+// the workers. The result does not depend on the number of workers.
+// av1_loop_restoration_frame() is the same with a single thread.
+void av1_loop_restoration_frame_mt(YV12_BUFFER_CONFIG *frame,
+                                   struct AV1Common *cm, RestorationInfo *rsi,
+                                   int components_pattern, int partial_frame,
+                                   YV12_BUFFER_CONFIG *dst, AVxWorker *workers,
+                                   int num_workers, AV1LrSync *lr_sync);
+
+// Set up the restoration of the frame by up to num_workers threads calling
+// av1_loop_restoration_tiles(). No row of the frame is final yet.
+void av1_loop_restoration_start(YV12_BUFFER_CONFIG *frame,
+                                struct AV1Common *cm, RestorationInfo *rsi,
+                                int components_pattern, int partial_frame,
+                                YV12_BUFFER_CONFIG *dst, int num_workers,
+                                AV1LrSync *lr_sync);
+
+// Signal that the first rows luma rows of the frame will not be modified by
+// the filters applied before loop restoration any more.
+void av1_loop_restoration_rows_ready(AV1LrSync *lr_sync, int rows);
+
+// Restore the tiles that only read final rows, with the scratch buffer of the
+// given worker. If wait is set, return only once the frame is restored.
+void av1_loop_restoration_tiles(AV1LrSync *lr_sync, int worker, int wait);
+
+// Deallocate the loop restoration thread data and stripe buffers.
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync);
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -6644,10 +6644,6 @@ void av1_update_scan_count_facade(AV1_COMMON *cm, FRAME_COUNTS *counts,
   ++counts->txb_count[tx_size][tx_type];
 }
 
-static int cmp_prob(const void *a, const void *b) {
-  return *(const uint32_t *)b > *(const uint32_t *)a ? 1 : -1;
-}
-
 void av1_augment_prob(TX_SIZE tx_size, TX_TYPE tx_type, uint32_t *prob) {
   // TODO(angiebird): check if we need is_inter here
   const SCAN_ORDER *sc = get_default_scan(tx_size, tx_type, 0);
@@ -6726,21 +6722,66 @@ void av1_update_neighbors(int tx_size, const int16_t *scan,
   neighbors[tx2d_size * MAX_NEIGHBORS + 1] = scan[0];
 }
 
+// Below this size, an insertion sort is cheaper than the counting sorts.
+#define SORT_ORDER_INSERTION_MAX 16
+
+// Stable counting sort of the coefficients in src[] by the digit of their
+// probabilities at bit shift, in decreasing order.
+static void sort_by_prob_digit(const int16_t *src, int size,
+                               const uint32_t *non_zero_prob, int shift,
+                               int digit_bits, int16_t *dst) {
+  const int digit_max = (1 << digit_bits) - 1;
+  int start[256] = { 0 };
+  int i, sum = 0;
+  for (i = 0; i < size; ++i)
+    ++start[digit_max - ((non_zero_prob[src[i]] >> shift) & digit_max)];
+  for (i = 0; i <= digit_max; ++i) {
+    const int count = start[i];
+    start[i] = sum;
+    sum += count;
+  }
+  for (i = 0; i < size; ++i) {
+    const int digit = (non_zero_prob[src[i]] >> shift) & digit_max;
+    dst[start[digit_max - digit]++] = src[i];
+  }
+}
+
 void av1_update_sort_order(TX_SIZE tx_size, TX_TYPE tx_type,
                            const uint32_t *non_zero_prob, int16_t *sort_order) {
   const SCAN_ORDER *sc = get_default_scan(tx_size, tx_type, 0);
-  uint32_t temp[COEFF_IDX_SIZE];
   const int tx2d_size = tx_size_2d[tx_size];
   int sort_idx;
   assert(tx2d_size <= COEFF_IDX_SIZE);
-  memcpy(temp, non_zero_prob, tx2d_size * sizeof(*non_zero_prob));
-  av1_augment_prob(tx_size, tx_type, temp);
-  qsort(temp, tx2d_size, sizeof(*temp), cmp_prob);
-  for (sort_idx = 0; sort_idx < tx2d_size; ++sort_idx) {
-    const int default_scan_idx =
-        (temp[sort_idx] & COEFF_IDX_MASK) ^ COEFF_IDX_MASK;
-    const int coeff_idx = sc->scan[default_scan_idx];
-    sort_order[sort_idx] = coeff_idx;
+#ifndef NDEBUG
+  for (sort_idx = 0; sort_idx < tx2d_size; ++sort_idx)
+    assert(non_zero_prob[sort_idx] <= UINT16_MAX);
+#endif
+  // Both sorts are stable and start from the default scan order, so ties are
+  // broken as av1_augment_prob() does.
+  if (tx2d_size <= SORT_ORDER_INSERTION_MAX) {
+    for (sort_idx = 0; sort_idx < tx2d_size; ++sort_idx) {
+      const int16_t coeff_idx = sc->scan[sort_idx];
+      const uint32_t prob = non_zero_prob[coeff_idx];
+      int i = sort_idx;
+      while (i > 0 && non_zero_prob[sort_order[i - 1]] < prob) {
+        sort_order[i] = sort_order[i - 1];
+        --i;
+      }
+      sort_order[i] = coeff_idx;
+    }
+  } else {
+    // Least significant digit first, with smaller digits for smaller blocks.
+    // The number of passes is even, so the last one writes sort_order[].
+    const int digit_bits = tx2d_size > 256 ? 8 : 4;
+    int16_t temp[COEFF_IDX_SIZE];
+    const int16_t *src = sc->scan;
+    int shift;
+    for (shift = 0; shift < 16; shift += digit_bits) {
+      int16_t *const dst = src == temp ? sort_order : temp;
+      sort_by_prob_digit(src, tx2d_size, non_zero_prob, shift, digit_bits,
+                         dst);
+      src = dst;
+    }
   }
 }
 
@@ -6811,6 +6852,9 @@ void av1_adapt_scan_order(AV1_COMMON *cm) {
 #endif  // CONFIG_RECT_TX && (CONFIG_EXT_TX || CONFIG_VAR_TX)
     TX_TYPE tx_type;
     for (tx_type = DCT_DCT; tx_type < TX_TYPES; ++tx_type) {
+      // Without any block of this type, the probabilities and the scan order
+      // are kept as they are.
+      if (cm->counts.txb_count[tx_size][tx_type] == 0) continue;
       update_scan_prob(cm, tx_size, tx_type, ADAPT_SCAN_UPDATE_RATE_16);
       update_scan_order_facade(cm, tx_size, tx_type);
     }
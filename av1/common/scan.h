@@ -39,7 +39,8 @@ void av1_update_scan_count_facade(AV1_COMMON *cm, FRAME_COUNTS *counts,
 // will be scanned first
 void av1_augment_prob(TX_SIZE tx_size, TX_TYPE tx_type, uint32_t *prob);
 
-// apply quick sort on nonzero probabilities to obtain a sort order
+// sort the coefficients by decreasing nonzero probability, in the order of
+// av1_augment_prob(), to obtain a sort order
 void av1_update_sort_order(TX_SIZE tx_size, TX_TYPE tx_type,
                            const uint32_t *non_zero_prob, int16_t *sort_order);
 
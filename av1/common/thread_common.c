@@ -73,7 +73,8 @@ static INLINE void sync_write(AV1LfSync *const lf_sync, int r, int c,
 
     lf_sync->cur_sb_col[r] = cur;
 
-    pthread_cond_signal(&lf_sync->cond_[r]);
+    // CDEF may also wait for the row when it runs on the same threads.
+    pthread_cond_broadcast(&lf_sync->cond_[r]);
     pthread_mutex_unlock(&lf_sync->mutex_[r]);
   }
 #else
@@ -515,6 +516,327 @@ void av1_loop_filter_dealloc(AV1LfSync *lf_sync) {
   }
 }
 
+#if CONFIG_CDEF
+void av1_cdef_sync_read(AV1CdefSync *const cdef_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  if (cdef_sync != NULL && r) {
+    pthread_mutex_t *const mutex = &cdef_sync->mutex_[r - 1];
+    mutex_lock(mutex);
+
+    // A superblock reads the lines saved by the top-right superblock, and
+    // overwrites pixels read by the top-left and top-right superblocks.
+    while (c >= cdef_sync->cur_sb_col[r - 1]) {
+      pthread_cond_wait(&cdef_sync->cond_[r - 1], mutex);
+    }
+    pthread_mutex_unlock(mutex);
+  }
+#else
+  (void)cdef_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_cdef_sync_write(AV1CdefSync *const cdef_sync, int r, int c,
+                         const int sb_cols) {
+#if CONFIG_MULTITHREAD
+  if (cdef_sync != NULL) {
+    mutex_lock(&cdef_sync->mutex_[r]);
+
+    cdef_sync->cur_sb_col[r] = c < sb_cols - 1 ? c : sb_cols;
+
+    pthread_cond_signal(&cdef_sync->cond_[r]);
+    pthread_mutex_unlock(&cdef_sync->mutex_[r]);
+  }
+#else
+  (void)cdef_sync;
+  (void)r;
+  (void)c;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+#if !CONFIG_PARALLEL_DEBLOCKING
+// Wait until the loop filter has completed superblock row r.
+static void lf_sync_wait_row(AV1LfSync *const lf_sync, int r, int sb_cols) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *const mutex = &lf_sync->mutex_[r];
+  mutex_lock(mutex);
+
+  while (lf_sync->cur_sb_col[r] < sb_cols) {
+    pthread_cond_wait(&lf_sync->cond_[r], mutex);
+  }
+  pthread_mutex_unlock(mutex);
+#else
+  (void)lf_sync;
+  (void)r;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+
+#if !CONFIG_PARALLEL_DEBLOCKING
+// Deblock the superblock rows of the worker up to row r.
+static void cdef_worker_loop_filter(CdefWorkerData *const cdef_data, int r) {
+  LFWorkerData *const lf_data = cdef_data->lf_data;
+  const AV1_COMMON *const cm = lf_data->cm;
+  const int step = cdef_data->lf_sync->num_workers * cm->mib_size;
+  const int stop = AOMMIN((r + 1) << cm->mib_size_log2, cm->mi_rows);
+
+  if (lf_data->start >= stop) return;
+  lf_data->stop = stop;
+  loop_filter_row_worker(cdef_data->lf_sync, lf_data);
+  while (lf_data->start < stop) lf_data->start += step;
+}
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+
+// Row-based multi-threaded CDEF hook
+static int cdef_row_worker(AV1CdefSync *const cdef_sync,
+                           CdefWorkerData *const cdef_data) {
+  const CdefFrameData *const fd = &cdef_sync->frame_data;
+  int sbr;
+
+  for (sbr = cdef_data->start; sbr < fd->nvsb;
+       sbr += cdef_sync->num_workers) {
+#if !CONFIG_PARALLEL_DEBLOCKING
+    // CDEF reads the top lines of the superblock row below, and deblocking
+    // that row modifies the bottom lines of the current one. The worker
+    // deblocks its own rows first, and a loop filter row never waits for
+    // CDEF, so the rows waited for are eventually deblocked.
+    if (cdef_data->lf_data != NULL) cdef_worker_loop_filter(cdef_data, sbr + 1);
+    if (cdef_data->lf_sync != NULL)
+      lf_sync_wait_row(cdef_data->lf_sync, AOMMIN(sbr + 1, fd->nvsb - 1),
+                       fd->nhsb);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+    av1_cdef_sb_row(fd, sbr, cdef_sync);
+#if CONFIG_LOOP_RESTORATION
+    // The rows of a superblock row are finished in order. Restore the
+    // stripes they complete, if no other thread is on them already.
+    if (cdef_data->lr_sync != NULL) {
+      av1_loop_restoration_rows_ready(cdef_data->lr_sync,
+                                      (sbr + 1) * MAX_MIB_SIZE << MI_SIZE_LOG2);
+      av1_loop_restoration_tiles(cdef_data->lr_sync, cdef_data->start, 0);
+    }
+#endif  // CONFIG_LOOP_RESTORATION
+  }
+
+#if !CONFIG_PARALLEL_DEBLOCKING
+  if (cdef_data->lf_data != NULL) cdef_worker_loop_filter(cdef_data, fd->nvsb);
+#endif  // !CONFIG_PARALLEL_DEBLOCKING
+#if CONFIG_LOOP_RESTORATION
+  if (cdef_data->lr_sync != NULL)
+    av1_loop_restoration_tiles(cdef_data->lr_sync, cdef_data->start, 1);
+#endif  // CONFIG_LOOP_RESTORATION
+  return 1;
+}
+
+// Single-threaded version of av1_loop_filter_cdef_frame_mt().
+static void loop_filter_cdef_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                   MACROBLOCKD *xd, int frame_filter_level,
+                                   struct AV1LrSyncData *lr_sync) {
+#if CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+  // The loop filter of a superblock row depends on the rows above.
+  const int pipeline = 0;
+#else
+  const int pipeline = 1;
+#endif  // CONFIG_VAR_TX || CONFIG_PARALLEL_DEBLOCKING
+  // The loop filter moves the planes over the frame.
+  struct macroblockd_plane lf_planes[MAX_MB_PLANE];
+  CdefFrameData fd;
+  int sbr;
+
+  if (frame_filter_level) {
+    memcpy(lf_planes, xd->plane, sizeof(lf_planes));
+    av1_loop_filter_frame_init(cm, frame_filter_level);
+    if (!pipeline)
+      av1_loop_filter_rows(frame, cm, lf_planes, 0, cm->mi_rows, 0);
+  }
+
+  av1_cdef_frame_init(&fd, frame, cm, xd);
+  for (sbr = 0; sbr < fd.nvsb; sbr++) {
+    if (frame_filter_level && pipeline) {
+      // Deblock the superblock row below, whose top lines CDEF reads.
+      const int start = sbr ? (sbr + 1) * MAX_MIB_SIZE : 0;
+      const int stop = AOMMIN((sbr + 2) * MAX_MIB_SIZE, cm->mi_rows);
+      if (start < stop)
+        av1_loop_filter_rows(frame, cm, lf_planes, start, stop, 0);
+    }
+    av1_cdef_sb_row(&fd, sbr, NULL);
+#if CONFIG_LOOP_RESTORATION
+    if (lr_sync != NULL) {
+      av1_loop_restoration_rows_ready(lr_sync,
+                                      (sbr + 1) * MAX_MIB_SIZE << MI_SIZE_LOG2);
+      av1_loop_restoration_tiles(lr_sync, 0, 0);
+    }
+#endif  // CONFIG_LOOP_RESTORATION
+  }
+  av1_cdef_frame_free(&fd);
+#if CONFIG_LOOP_RESTORATION
+  if (lr_sync != NULL) av1_loop_restoration_tiles(lr_sync, 0, 1);
+#else
+  (void)lr_sync;
+#endif  // CONFIG_LOOP_RESTORATION
+}
+
+void av1_loop_filter_cdef_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                   MACROBLOCKD *xd, int frame_filter_level,
+                                   AVxWorker *workers, int num_workers,
+                                   AV1LfSync *lf_sync, AV1CdefSync *cdef_sync,
+                                   struct AV1LrSyncData *lr_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  CdefFrameData *fd;
+  // The loop filter uses at most one thread per tile column, see
+  // loop_filter_rows_mt().
+  const int lf_workers = AOMMIN(num_workers, cm->tile_cols);
+  const int cdef_rows = (cm->mi_rows + MAX_MIB_SIZE - 1) / MAX_MIB_SIZE;
+#if CONFIG_PARALLEL_DEBLOCKING
+  const int pipeline = 0;
+#else
+  const int pipeline = frame_filter_level && cm->mib_size == MAX_MIB_SIZE;
+#endif  // CONFIG_PARALLEL_DEBLOCKING
+  int i;
+
+#if CONFIG_LOOP_RESTORATION
+  if (lr_sync != NULL)
+    av1_loop_restoration_start(frame, cm, cm->rst_info, 7, 0, NULL,
+                               AOMMAX(num_workers, 1), lr_sync);
+#endif  // CONFIG_LOOP_RESTORATION
+
+  if (num_workers <= 1) {
+    loop_filter_cdef_frame(frame, cm, xd, frame_filter_level, lr_sync);
+    return;
+  }
+
+  if (frame_filter_level && !pipeline) {
+    av1_loop_filter_frame_mt(frame, cm, xd->plane, frame_filter_level, 0, 0,
+                             workers, num_workers, lf_sync);
+  }
+
+  if (!cdef_sync->rows || cdef_rows != cdef_sync->rows ||
+      num_workers != cdef_sync->num_workers) {
+    av1_cdef_sync_dealloc(cdef_sync);
+    av1_cdef_sync_alloc(cdef_sync, cm, cdef_rows, num_workers);
+  }
+  fd = &cdef_sync->frame_data;
+  av1_cdef_frame_init(fd, frame, cm, xd);
+  // Initialize cur_sb_col to -1 for all SB rows.
+  memset(cdef_sync->cur_sb_col, -1,
+         sizeof(*cdef_sync->cur_sb_col) * cdef_sync->rows);
+
+  if (pipeline) {
+    const int sb_rows = mi_rows_aligned_to_sb(cm) >> cm->mib_size_log2;
+
+    av1_loop_filter_frame_init(cm, frame_filter_level);
+    if (!lf_sync->sync_range || sb_rows != lf_sync->rows ||
+        lf_workers != lf_sync->num_workers) {
+      av1_loop_filter_dealloc(lf_sync);
+      av1_loop_filter_alloc(lf_sync, cm, sb_rows, cm->width, lf_workers);
+    }
+    memset(lf_sync->cur_sb_col, -1, sizeof(*lf_sync->cur_sb_col) * sb_rows);
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    AVxWorker *const worker = &workers[i];
+    CdefWorkerData *const cdef_data = &cdef_sync->cdefdata[i];
+
+    worker->hook = (AVxWorkerHook)cdef_row_worker;
+    worker->data1 = cdef_sync;
+    worker->data2 = cdef_data;
+
+    cdef_data->cdef_sync = cdef_sync;
+    cdef_data->lf_sync = pipeline ? lf_sync : NULL;
+    cdef_data->lf_data = NULL;
+    cdef_data->lr_sync = lr_sync;
+    cdef_data->start = i;
+    if (pipeline && i < lf_workers) {
+      LFWorkerData *const lf_data = &lf_sync->lfdata[i];
+      av1_loop_filter_data_reset(lf_data, frame, cm, xd->plane);
+      lf_data->start = i * cm->mib_size;
+      lf_data->stop = cm->mi_rows;
+      lf_data->y_only = 0;
+      cdef_data->lf_data = lf_data;
+    }
+  }
+
+  for (i = 0; i < num_workers; ++i) {
+    // Start filtering
+    if (i == num_workers - 1) {
+      winterface->execute(&workers[i]);
+    } else {
+      winterface->launch(&workers[i]);
+    }
+  }
+
+  // Wait till all rows are finished
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+
+  av1_cdef_frame_free(fd);
+}
+
+// Allocate memory for CDEF row synchronization
+void av1_cdef_sync_alloc(AV1CdefSync *cdef_sync, AV1_COMMON *cm, int rows,
+                         int num_workers) {
+  cdef_sync->rows = rows;
+#if CONFIG_MULTITHREAD
+  {
+    int i;
+
+    CHECK_MEM_ERROR(cm, cdef_sync->mutex_,
+                    aom_malloc(sizeof(*cdef_sync->mutex_) * rows));
+    if (cdef_sync->mutex_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_mutex_init(&cdef_sync->mutex_[i], NULL);
+      }
+    }
+
+    CHECK_MEM_ERROR(cm, cdef_sync->cond_,
+                    aom_malloc(sizeof(*cdef_sync->cond_) * rows));
+    if (cdef_sync->cond_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_cond_init(&cdef_sync->cond_[i], NULL);
+      }
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, cdef_sync->cdefdata,
+                  aom_malloc(num_workers * sizeof(*cdef_sync->cdefdata)));
+  cdef_sync->num_workers = num_workers;
+
+  CHECK_MEM_ERROR(cm, cdef_sync->cur_sb_col,
+                  aom_malloc(sizeof(*cdef_sync->cur_sb_col) * rows));
+}
+
+// Deallocate CDEF synchronization related mutex and data
+void av1_cdef_sync_dealloc(AV1CdefSync *cdef_sync) {
+  if (cdef_sync != NULL) {
+#if CONFIG_MULTITHREAD
+    int i;
+
+    if (cdef_sync->mutex_ != NULL) {
+      for (i = 0; i < cdef_sync->rows; ++i) {
+        pthread_mutex_destroy(&cdef_sync->mutex_[i]);
+      }
+      aom_free(cdef_sync->mutex_);
+    }
+    if (cdef_sync->cond_ != NULL) {
+      for (i = 0; i < cdef_sync->rows; ++i) {
+        pthread_cond_destroy(&cdef_sync->cond_[i]);
+      }
+      aom_free(cdef_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    aom_free(cdef_sync->cdefdata);
+    aom_free(cdef_sync->cur_sb_col);
+    // clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    av1_zero(*cdef_sync);
+  }
+}
+#endif  // CONFIG_CDEF
+
 // Accumulate frame counts. FRAME_COUNTS consist solely of 'unsigned int'
 // members, so we treat it as an array, and sum over the whole length.
 void av1_accumulate_frame_counts(FRAME_COUNTS *acc_counts,
@@ -13,6 +13,9 @@
 #define AV1_COMMON_LOOPFILTER_THREAD_H_
 #include "./aom_config.h"
 #include "av1/common/av1_loopfilter.h"
+#if CONFIG_CDEF
+#include "av1/common/cdef.h"
+#endif  // CONFIG_CDEF
 #include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
@@ -54,6 +57,67 @@ void av1_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
                               int partial_frame, AVxWorker *workers,
                               int num_workers, AV1LfSync *lf_sync);
 
+#if CONFIG_CDEF
+struct AV1CdefSyncData;
+struct AV1LrSyncData;
+
+// Per thread data of the multi-threaded CDEF.
+typedef struct CdefWorkerData {
+  struct AV1CdefSyncData *cdef_sync;
+  // Loop filter run by the same thread before CDEF, if any.
+  AV1LfSync *lf_sync;
+  LFWorkerData *lf_data;
+  // Loop restoration run by the same thread after CDEF, if any.
+  struct AV1LrSyncData *lr_sync;
+  // First superblock row filtered by the thread, and index of the thread.
+  int start;
+} CdefWorkerData;
+
+// CDEF superblock row synchronization
+typedef struct AV1CdefSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Allocate memory to store the filtered superblock index in each row.
+  int *cur_sb_col;
+  int rows;
+
+  CdefFrameData frame_data;
+  CdefWorkerData *cdefdata;
+  int num_workers;
+} AV1CdefSync;
+
+// Allocate memory for CDEF row synchronization.
+void av1_cdef_sync_alloc(AV1CdefSync *cdef_sync, struct AV1Common *cm,
+                         int rows, int num_workers);
+
+// Deallocate CDEF synchronization related mutex and data.
+void av1_cdef_sync_dealloc(AV1CdefSync *cdef_sync);
+
+// Wait until the superblock row above has been filtered far enough for
+// superblock (r, c) to be filtered. Does nothing if cdef_sync is NULL.
+void av1_cdef_sync_read(AV1CdefSync *const cdef_sync, int r, int c);
+// Signal that superblock (r, c) has been filtered.
+void av1_cdef_sync_write(AV1CdefSync *const cdef_sync, int r, int c,
+                         const int sb_cols);
+
+// Multi-threaded CDEF that uses the tile threads. If frame_filter_level is
+// not 0, the frame is loop filtered first by the same threads, and each
+// superblock row is filtered by CDEF as soon as the deblocked rows it reads
+// are final. If lr_sync is not NULL, the frame is then restored by the same
+// threads too, each stripe as soon as CDEF has finished the rows it reads.
+// With less than two workers, the frame is filtered by the calling thread
+// one superblock row at a time, and lf_sync and cdef_sync are not used.
+// The result is the same as applying the filters one after the other.
+void av1_loop_filter_cdef_frame_mt(YV12_BUFFER_CONFIG *frame,
+                                   struct AV1Common *cm, MACROBLOCKD *xd,
+                                   int frame_filter_level, AVxWorker *workers,
+                                   int num_workers, AV1LfSync *lf_sync,
+                                   AV1CdefSync *cdef_sync,
+                                   struct AV1LrSyncData *lr_sync);
+#endif  // CONFIG_CDEF
+
 void av1_accumulate_frame_counts(struct FRAME_COUNTS *acc_counts,
                                  struct FRAME_COUNTS *counts);
 
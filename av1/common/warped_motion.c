@@ -18,8 +18,11 @@
 #include "./av1_rtcd.h"
 #include "av1/common/warped_motion.h"
 
+// Size of the blocks in which av1_warp_error() warps and measures the frame.
+#define WARP_ERROR_BLOCK 32
+
 /* clang-format off */
-static const int error_measure_lut[512] = {
+const int error_measure_lut[512] = {
   // pow 0.7
   16384, 16339, 16294, 16249, 16204, 16158, 16113, 16068,
   16022, 15977, 15932, 15886, 15840, 15795, 15749, 15703,
@@ -1019,32 +1022,47 @@ static void highbd_warp_plane(WarpedMotionParams *wm, uint8_t *ref8, int width,
   }
 }
 
-static double highbd_warp_erroradv(WarpedMotionParams *wm, uint8_t *ref8,
-                                   int width, int height, int stride,
-                                   uint8_t *dst8, int p_col, int p_row,
-                                   int p_width, int p_height, int p_stride,
-                                   int subsampling_x, int subsampling_y,
-                                   int x_scale, int y_scale, int bd) {
-  int gm_err = 0, no_gm_err = 0;
-  int64_t gm_sumerr = 0, no_gm_sumerr = 0;
+static int64_t highbd_frame_error(const uint16_t *const ref, int stride,
+                                  const uint16_t *const dst, int p_width,
+                                  int p_height, int p_stride, int bd) {
+  int64_t sum_error = 0;
   int i, j;
-  uint16_t *tmp = aom_malloc(p_width * p_height * sizeof(*tmp));
-  uint16_t *dst = CONVERT_TO_SHORTPTR(dst8);
-  uint16_t *ref = CONVERT_TO_SHORTPTR(ref8);
-  highbd_warp_plane(wm, ref8, width, height, stride, CONVERT_TO_BYTEPTR(tmp),
-                    p_col, p_row, p_width, p_height, p_width, subsampling_x,
-                    subsampling_y, x_scale, y_scale, bd, 0);
   for (i = 0; i < p_height; ++i) {
     for (j = 0; j < p_width; ++j) {
-      gm_err = dst[j + i * p_stride] - tmp[j + i * p_width];
-      no_gm_err =
-          dst[j + i * p_stride] - ref[(j + p_col) + (i + p_row) * stride];
-      gm_sumerr += highbd_error_measure(gm_err, bd);
-      no_gm_sumerr += highbd_error_measure(no_gm_err, bd);
+      sum_error +=
+          highbd_error_measure(dst[j + i * p_stride] - ref[j + i * stride], bd);
+    }
+  }
+  return sum_error;
+}
+
+static int64_t highbd_warp_error(WarpedMotionParams *wm, uint8_t *ref8,
+                                 int width, int height, int stride,
+                                 uint8_t *dst8, int p_col, int p_row,
+                                 int p_width, int p_height, int p_stride,
+                                 int subsampling_x, int subsampling_y,
+                                 int x_scale, int y_scale, int bd,
+                                 int64_t best_error) {
+  int64_t gm_sumerr = 0;
+  int i, j;
+  uint16_t tmp[WARP_ERROR_BLOCK * WARP_ERROR_BLOCK];
+  const uint16_t *const dst = CONVERT_TO_SHORTPTR(dst8);
+
+  for (i = 0; i < p_height; i += WARP_ERROR_BLOCK) {
+    for (j = 0; j < p_width; j += WARP_ERROR_BLOCK) {
+      const int warp_w = AOMMIN(WARP_ERROR_BLOCK, p_width - j);
+      const int warp_h = AOMMIN(WARP_ERROR_BLOCK, p_height - i);
+      highbd_warp_plane(wm, ref8, width, height, stride,
+                        CONVERT_TO_BYTEPTR(tmp), p_col + j, p_row + i, warp_w,
+                        warp_h, WARP_ERROR_BLOCK, subsampling_x, subsampling_y,
+                        x_scale, y_scale, bd, 0);
+      gm_sumerr += highbd_frame_error(tmp, WARP_ERROR_BLOCK,
+                                      dst + j + i * p_stride, warp_w, warp_h,
+                                      p_stride, bd);
+      if (gm_sumerr > best_error) return gm_sumerr;
     }
   }
-  aom_free(tmp);
-  return (double)gm_sumerr / no_gm_sumerr;
+  return gm_sumerr;
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
@@ -1052,6 +1070,19 @@ static INLINE int error_measure(int err) {
   return error_measure_lut[255 + err];
 }
 
+int64_t av1_calc_frame_error_c(const uint8_t *const ref, int stride,
+                               const uint8_t *const dst, int p_width,
+                               int p_height, int p_stride) {
+  int64_t sum_error = 0;
+  int i, j;
+  for (i = 0; i < p_height; ++i) {
+    for (j = 0; j < p_width; ++j) {
+      sum_error += error_measure(dst[j + i * p_stride] - ref[j + i * stride]);
+    }
+  }
+  return sum_error;
+}
+
 static void warp_plane_old(WarpedMotionParams *wm, uint8_t *ref, int width,
                            int height, int stride, uint8_t *pred, int p_col,
                            int p_row, int p_width, int p_height, int p_stride,
@@ -1272,52 +1303,71 @@ static void warp_plane(WarpedMotionParams *wm, uint8_t *ref, int width,
   }
 }
 
-static double warp_erroradv(WarpedMotionParams *wm, uint8_t *ref, int width,
-                            int height, int stride, uint8_t *dst, int p_col,
-                            int p_row, int p_width, int p_height, int p_stride,
-                            int subsampling_x, int subsampling_y, int x_scale,
-                            int y_scale) {
-  int gm_err = 0, no_gm_err = 0;
-  int gm_sumerr = 0, no_gm_sumerr = 0;
+static int64_t warp_error(WarpedMotionParams *wm, uint8_t *ref, int width,
+                          int height, int stride, uint8_t *dst, int p_col,
+                          int p_row, int p_width, int p_height, int p_stride,
+                          int subsampling_x, int subsampling_y, int x_scale,
+                          int y_scale, int64_t best_error) {
+  int64_t gm_sumerr = 0;
   int i, j;
-  uint8_t *tmp = aom_malloc(p_width * p_height);
-  warp_plane(wm, ref, width, height, stride, tmp, p_col, p_row, p_width,
-             p_height, p_width, subsampling_x, subsampling_y, x_scale, y_scale,
-             0);
-
-  for (i = 0; i < p_height; ++i) {
-    for (j = 0; j < p_width; ++j) {
-      gm_err = dst[j + i * p_stride] - tmp[j + i * p_width];
-      no_gm_err =
-          dst[j + i * p_stride] - ref[(j + p_col) + (i + p_row) * stride];
-      gm_sumerr += error_measure(gm_err);
-      no_gm_sumerr += error_measure(no_gm_err);
+  uint8_t tmp[WARP_ERROR_BLOCK * WARP_ERROR_BLOCK];
+
+  for (i = 0; i < p_height; i += WARP_ERROR_BLOCK) {
+    for (j = 0; j < p_width; j += WARP_ERROR_BLOCK) {
+      const int warp_w = AOMMIN(WARP_ERROR_BLOCK, p_width - j);
+      const int warp_h = AOMMIN(WARP_ERROR_BLOCK, p_height - i);
+      warp_plane(wm, ref, width, height, stride, tmp, p_col + j, p_row + i,
+                 warp_w, warp_h, WARP_ERROR_BLOCK, subsampling_x,
+                 subsampling_y, x_scale, y_scale, 0);
+      gm_sumerr += av1_calc_frame_error(tmp, WARP_ERROR_BLOCK,
+                                        dst + j + i * p_stride, warp_w, warp_h,
+                                        p_stride);
+      if (gm_sumerr > best_error) return gm_sumerr;
     }
   }
+  return gm_sumerr;
+}
 
-  aom_free(tmp);
-  return (double)gm_sumerr / no_gm_sumerr;
+int64_t av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+    int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    const uint8_t *ref, int stride, const uint8_t *dst, int p_width,
+    int p_height, int p_stride) {
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (use_hbd)
+    return highbd_frame_error(CONVERT_TO_SHORTPTR(ref), stride,
+                              CONVERT_TO_SHORTPTR(dst), p_width, p_height,
+                              p_stride, bd);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return av1_calc_frame_error(ref, stride, dst, p_width, p_height, p_stride);
 }
 
-double av1_warp_erroradv(WarpedMotionParams *wm,
+int64_t av1_warp_error(WarpedMotionParams *wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-                         int use_hbd, int bd,
+                       int use_hbd, int bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-                         uint8_t *ref, int width, int height, int stride,
-                         uint8_t *dst, int p_col, int p_row, int p_width,
-                         int p_height, int p_stride, int subsampling_x,
-                         int subsampling_y, int x_scale, int y_scale) {
+                       uint8_t *ref, int width, int height, int stride,
+                       uint8_t *dst, int p_col, int p_row, int p_width,
+                       int p_height, int p_stride, int subsampling_x,
+                       int subsampling_y, int x_scale, int y_scale,
+                       int64_t best_error) {
+  // The shear parameters must be derived from the matrix that is warped with.
+  if (wm->wmtype == ROTZOOM) {
+    wm->wmmat[5] = wm->wmmat[2];
+    wm->wmmat[4] = -wm->wmmat[3];
+  }
   if (wm->wmtype <= AFFINE)
-    if (!get_shear_params(wm)) return 1;
+    if (!get_shear_params(wm)) return INT64_MAX;
 #if CONFIG_AOM_HIGHBITDEPTH
   if (use_hbd)
-    return highbd_warp_erroradv(
-        wm, ref, width, height, stride, dst, p_col, p_row, p_width, p_height,
-        p_stride, subsampling_x, subsampling_y, x_scale, y_scale, bd);
+    return highbd_warp_error(wm, ref, width, height, stride, dst, p_col, p_row,
+                             p_width, p_height, p_stride, subsampling_x,
+                             subsampling_y, x_scale, y_scale, bd, best_error);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-  return warp_erroradv(wm, ref, width, height, stride, dst, p_col, p_row,
-                       p_width, p_height, p_stride, subsampling_x,
-                       subsampling_y, x_scale, y_scale);
+  return warp_error(wm, ref, width, height, stride, dst, p_col, p_row, p_width,
+                    p_height, p_stride, subsampling_x, subsampling_y, x_scale,
+                    y_scale, best_error);
 }
 
 void av1_warp_plane(WarpedMotionParams *wm,
@@ -32,6 +32,9 @@
 
 const int16_t warped_filter[WARPEDPIXEL_PREC_SHIFTS * 3 + 1][8];
 
+// Error measure of the pixel differences, indexed by 255 plus the difference.
+extern const int error_measure_lut[512];
+
 typedef void (*ProjectPointsFunc)(int32_t *mat, int *points, int *proj,
                                   const int n, const int stride_points,
                                   const int stride_proj,
@@ -68,14 +71,29 @@ void project_points(WarpedMotionParams *wm_params, int *points, int *proj,
                     const int n, const int stride_points, const int stride_proj,
                     const int subsampling_x, const int subsampling_y);
 
-double av1_warp_erroradv(WarpedMotionParams *wm,
+// Returns the sum of the error measures of the differences between the
+// p_width x p_height blocks "ref" and "dst".
+int64_t av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+    int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    const uint8_t *ref, int stride, const uint8_t *dst, int p_width,
+    int p_height, int p_stride);
+
+// Returns the error of the prediction of the p_width x p_height block "dst" by
+// warping "ref" with "wm", where "dst" is at (p_col, p_row) in the frame.
+// The prediction is made and measured in blocks, and the search stops as soon
+// as the error exceeds "best_error". INT64_MAX is returned if "wm" cannot be
+// used for warping.
+int64_t av1_warp_error(WarpedMotionParams *wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-                         int use_hbd, int bd,
+                       int use_hbd, int bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-                         uint8_t *ref, int width, int height, int stride,
-                         uint8_t *dst, int p_col, int p_row, int p_width,
-                         int p_height, int p_stride, int subsampling_x,
-                         int subsampling_y, int x_scale, int y_scale);
+                       uint8_t *ref, int width, int height, int stride,
+                       uint8_t *dst, int p_col, int p_row, int p_width,
+                       int p_height, int p_stride, int subsampling_x,
+                       int subsampling_y, int x_scale, int y_scale,
+                       int64_t best_error);
 
 void av1_warp_plane(WarpedMotionParams *wm,
 #if CONFIG_AOM_HIGHBITDEPTH
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "./av1_rtcd.h"
+#include "aom/aom_integer.h"
+#include "aom_ports/mem.h"
+#include "av1/common/warped_motion.h"
+
+static INLINE __m256i load_8_pixels(const uint8_t *p) {
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+int64_t av1_calc_frame_error_avx2(const uint8_t *const ref, int stride,
+                                  const uint8_t *const dst, int p_width,
+                                  int p_height, int p_stride) {
+  const __m256i lut_offset = _mm256_set1_epi32(255);
+  __m256i sum = _mm256_setzero_si256();
+  DECLARE_ALIGNED(32, int64_t, lane_sums[4]);
+  int64_t sum_error = 0;
+  int i, j;
+
+  for (i = 0; i < p_height; ++i) {
+    const uint8_t *const ref_row = ref + i * stride;
+    const uint8_t *const dst_row = dst + i * p_stride;
+    __m256i row_sum = _mm256_setzero_si256();
+    for (j = 0; j + 16 <= p_width; j += 16) {
+      const __m256i idx_lo = _mm256_add_epi32(
+          _mm256_sub_epi32(load_8_pixels(dst_row + j),
+                           load_8_pixels(ref_row + j)),
+          lut_offset);
+      const __m256i idx_hi = _mm256_add_epi32(
+          _mm256_sub_epi32(load_8_pixels(dst_row + j + 8),
+                           load_8_pixels(ref_row + j + 8)),
+          lut_offset);
+      row_sum = _mm256_add_epi32(
+          row_sum, _mm256_i32gather_epi32(error_measure_lut, idx_lo, 4));
+      row_sum = _mm256_add_epi32(
+          row_sum, _mm256_i32gather_epi32(error_measure_lut, idx_hi, 4));
+    }
+    for (; j + 8 <= p_width; j += 8) {
+      const __m256i idx = _mm256_add_epi32(
+          _mm256_sub_epi32(load_8_pixels(dst_row + j),
+                           load_8_pixels(ref_row + j)),
+          lut_offset);
+      row_sum = _mm256_add_epi32(
+          row_sum, _mm256_i32gather_epi32(error_measure_lut, idx, 4));
+    }
+    // Each lane of a row sums at most p_width / 8 measures of at most 2^14,
+    // so the row sums fit in 32 bits, and are accumulated in 64 bits.
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(row_sum)));
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(row_sum, 1)));
+    for (; j < p_width; ++j)
+      sum_error += error_measure_lut[255 + dst_row[j] - ref_row[j]];
+  }
+
+  _mm256_store_si256((__m256i *)lane_sums, sum);
+  return sum_error + lane_sums[0] + lane_sums[1] + lane_sums[2] + lane_sums[3];
+}
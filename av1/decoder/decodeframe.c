@@ -3345,6 +3345,19 @@ static void daala_dec_init(AV1_COMMON *const cm, daala_dec_ctx *daala_dec,
 }
 #endif  // #if CONFIG_PVQ
 
+// Whether the frame is deblocked together with CDEF once all its tiles are
+// decoded, rather than by decode_tiles() as the tile rows are decoded.
+static INLINE int loop_filter_with_cdef(const AV1_COMMON *cm) {
+#if CONFIG_CDEF && !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+  // The rows of a frame decoded in parallel with the next one are signalled
+  // to it as soon as they are deblocked.
+  return !cm->skip_loop_filter && !cm->frame_parallel_decode;
+#else
+  (void)cm;
+  return 0;
+#endif  // CONFIG_CDEF && !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
+}
+
 static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
                                    const uint8_t *data_end) {
   AV1_COMMON *const cm = &pbi->common;
@@ -3549,7 +3562,8 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
 // after the entire frame is decoded.
 #if !CONFIG_VAR_TX && !CONFIG_PARALLEL_DEBLOCKING
     // Loopfilter one tile row.
-    if (cm->lf.filter_level && !cm->skip_loop_filter) {
+    if (cm->lf.filter_level && !cm->skip_loop_filter &&
+        !loop_filter_with_cdef(cm)) {
       LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
       const int lf_start = AOMMAX(0, tile_info.mi_row_start - cm->mib_size);
       const int lf_end = tile_info.mi_row_end - cm->mib_size;
@@ -3594,7 +3608,8 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   }
 #else
   // Loopfilter remaining rows in the frame.
-  if (cm->lf.filter_level && !cm->skip_loop_filter) {
+  if (cm->lf.filter_level && !cm->skip_loop_filter &&
+      !loop_filter_with_cdef(cm)) {
     LFWorkerData *const lf_data = (LFWorkerData *)pbi->lf_worker.data1;
     winterface->sync(&pbi->lf_worker);
     lf_data->start = lf_data->stop;
@@ -3663,6 +3678,7 @@ static int tile_worker_hook(TileWorkerData *const tile_data,
 
     for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
          mi_col += cm->mib_size) {
+      av1_update_boundary_info(cm, tile, mi_row, mi_col);
       decode_partition(pbi, &tile_data->xd,
 #if CONFIG_SUPERTX
                        0,
@@ -3685,6 +3701,38 @@ static int compare_tile_buffers(const void *a, const void *b) {
   return (int)(buf2->size - buf1->size);
 }
 
+static void create_tile_workers(AV1Decoder *pbi) {
+  AV1_COMMON *const cm = &pbi->common;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
+
+  // TODO(jzern): See if we can remove the restriction of passing in max
+  // threads to the decoder.
+  if (pbi->num_tile_workers == 0) {
+    const int num_threads = pbi->max_threads & ~1;
+    CHECK_MEM_ERROR(cm, pbi->tile_workers,
+                    aom_malloc(num_threads * sizeof(*pbi->tile_workers)));
+    // Ensure tile data offsets will be properly aligned. This may fail on
+    // platforms without DECLARE_ALIGNED().
+    assert((sizeof(*pbi->tile_worker_data) % 16) == 0);
+    CHECK_MEM_ERROR(
+        cm, pbi->tile_worker_data,
+        aom_memalign(32, num_threads * sizeof(*pbi->tile_worker_data)));
+    CHECK_MEM_ERROR(cm, pbi->tile_worker_info,
+                    aom_malloc(num_threads * sizeof(*pbi->tile_worker_info)));
+    for (i = 0; i < num_threads; ++i) {
+      AVxWorker *const worker = &pbi->tile_workers[i];
+      ++pbi->num_tile_workers;
+
+      winterface->init(worker);
+      if (i < num_threads - 1 && !winterface->reset(worker)) {
+        aom_internal_error(&cm->error, AOM_CODEC_ERROR,
+                           "Tile decoder thread creation failed");
+      }
+    }
+  }
+}
+
 static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
                                       const uint8_t *data_end) {
   AV1_COMMON *const cm = &pbi->common;
@@ -3720,31 +3768,7 @@ static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
 
   assert(tile_cols * tile_rows > 1);
 
-  // TODO(jzern): See if we can remove the restriction of passing in max
-  // threads to the decoder.
-  if (pbi->num_tile_workers == 0) {
-    const int num_threads = pbi->max_threads & ~1;
-    CHECK_MEM_ERROR(cm, pbi->tile_workers,
-                    aom_malloc(num_threads * sizeof(*pbi->tile_workers)));
-    // Ensure tile data offsets will be properly aligned. This may fail on
-    // platforms without DECLARE_ALIGNED().
-    assert((sizeof(*pbi->tile_worker_data) % 16) == 0);
-    CHECK_MEM_ERROR(
-        cm, pbi->tile_worker_data,
-        aom_memalign(32, num_threads * sizeof(*pbi->tile_worker_data)));
-    CHECK_MEM_ERROR(cm, pbi->tile_worker_info,
-                    aom_malloc(num_threads * sizeof(*pbi->tile_worker_info)));
-    for (i = 0; i < num_threads; ++i) {
-      AVxWorker *const worker = &pbi->tile_workers[i];
-      ++pbi->num_tile_workers;
-
-      winterface->init(worker);
-      if (i < num_threads - 1 && !winterface->reset(worker)) {
-        aom_internal_error(&cm->error, AOM_CODEC_ERROR,
-                           "Tile decoder thread creation failed");
-      }
-    }
-  }
+  create_tile_workers(pbi);
 
   // Reset tile decoding hook
   for (i = 0; i < num_workers; ++i) {
@@ -4833,6 +4857,11 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
   uint8_t clear_data[MAX_AV1_HEADER_SIZE];
   size_t first_partition_size;
   YV12_BUFFER_CONFIG *new_fb;
+#if CONFIG_CDEF
+  int cdef_done = 0;
+  // Loop restoration done in the same pass as CDEF, if any.
+  struct AV1LrSyncData *lr_sync = NULL;
+#endif  // CONFIG_CDEF
 
 #if CONFIG_BITSTREAM_DEBUG
   bitstream_queue_set_frame_read(cm->current_video_frame * 2 + cm->show_frame);
@@ -4946,6 +4975,14 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
   cm->coef_probs_update_idx = 0;
 #endif  // CONFIG_SUBFRAME_PROB_UPDATE
 
+#if CONFIG_CDEF && CONFIG_LOOP_RESTORATION
+  if (!cm->skip_loop_filter &&
+      (cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
+       cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
+       cm->rst_info[2].frame_restoration_type != RESTORE_NONE))
+    lr_sync = &pbi->lr_row_sync;
+#endif  // CONFIG_CDEF && CONFIG_LOOP_RESTORATION
+
   if (pbi->max_threads > 1
 #if CONFIG_EXT_TILE
       && pbi->dec_tile_col < 0  // Decoding all columns
@@ -4955,11 +4992,22 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
     *p_data_end = decode_tiles_mt(pbi, data + first_partition_size, data_end);
     if (!xd->corrupted) {
       if (!cm->skip_loop_filter) {
+#if CONFIG_CDEF
+        // If multiple threads are used to decode tiles, then we use those
+        // threads to do parallel loopfiltering, followed by CDEF and loop
+        // restoration.
+        av1_loop_filter_cdef_frame_mt(
+            new_fb, cm, &pbi->mb, cm->lf.filter_level, pbi->tile_workers,
+            pbi->num_tile_workers, &pbi->lf_row_sync, &pbi->cdef_row_sync,
+            lr_sync);
+        cdef_done = 1;
+#else
         // If multiple threads are used to decode tiles, then we use those
         // threads to do parallel loopfiltering.
         av1_loop_filter_frame_mt(new_fb, cm, pbi->mb.plane, cm->lf.filter_level,
                                  0, 0, pbi->tile_workers, pbi->num_tile_workers,
                                  &pbi->lf_row_sync);
+#endif  // CONFIG_CDEF
       }
     } else {
       aom_internal_error(&cm->error, AOM_CODEC_CORRUPT_FRAME,
@@ -4970,16 +5018,40 @@ void av1_decode_frame(AV1Decoder *pbi, const uint8_t *data,
   }
 
 #if CONFIG_CDEF
-  if (!cm->skip_loop_filter) {
-    av1_cdef_frame(&pbi->cur_buf->buf, cm, &pbi->mb);
+  if (!cm->skip_loop_filter && !cdef_done) {
+    // Deblock the frame unless decode_tiles() did, then filter it with CDEF
+    // and restore it, in a single pass over its superblock rows.
+    const int filter_level =
+        loop_filter_with_cdef(cm) ? cm->lf.filter_level : 0;
+    if (pbi->max_threads > 1) {
+      create_tile_workers(pbi);
+      av1_loop_filter_cdef_frame_mt(new_fb, cm, &pbi->mb, filter_level,
+                                    pbi->tile_workers, pbi->num_tile_workers,
+                                    &pbi->lf_row_sync, &pbi->cdef_row_sync,
+                                    lr_sync);
+    } else {
+      av1_loop_filter_cdef_frame_mt(new_fb, cm, &pbi->mb, filter_level, NULL,
+                                    0, NULL, NULL, lr_sync);
+    }
   }
 #endif  // CONFIG_CDEF
 
 #if CONFIG_LOOP_RESTORATION
-  if (cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
-      cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
-      cm->rst_info[2].frame_restoration_type != RESTORE_NONE) {
-    av1_loop_restoration_frame(new_fb, cm, cm->rst_info, 7, 0, NULL);
+  if (
+#if CONFIG_CDEF
+      lr_sync == NULL &&
+#endif  // CONFIG_CDEF
+      (cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
+       cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
+       cm->rst_info[2].frame_restoration_type != RESTORE_NONE)) {
+    if (pbi->max_threads > 1) {
+      create_tile_workers(pbi);
+      av1_loop_restoration_frame_mt(new_fb, cm, cm->rst_info, 7, 0, NULL,
+                                    pbi->tile_workers, pbi->num_tile_workers,
+                                    &pbi->lr_row_sync);
+    } else {
+      av1_loop_restoration_frame(new_fb, cm, cm->rst_info, 7, 0, NULL);
+    }
   }
 #endif  // CONFIG_LOOP_RESTORATION
 
@@ -175,7 +175,13 @@ void av1_decoder_remove(AV1Decoder *pbi) {
 
   if (pbi->num_tile_workers > 0) {
     av1_loop_filter_dealloc(&pbi->lf_row_sync);
+#if CONFIG_CDEF
+    av1_cdef_sync_dealloc(&pbi->cdef_row_sync);
+#endif  // CONFIG_CDEF
   }
+#if CONFIG_LOOP_RESTORATION
+  av1_loop_restoration_dealloc(&pbi->lr_row_sync);
+#endif  // CONFIG_LOOP_RESTORATION
 
 #if CONFIG_ACCOUNTING
   aom_accounting_clear(&pbi->accounting);
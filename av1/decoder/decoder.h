@@ -112,6 +112,12 @@ typedef struct AV1Decoder {
   TileBufferDec tile_buffers[MAX_TILE_ROWS][MAX_TILE_COLS];
 
   AV1LfSync lf_row_sync;
+#if CONFIG_CDEF
+  AV1CdefSync cdef_row_sync;
+#endif  // CONFIG_CDEF
+#if CONFIG_LOOP_RESTORATION
+  AV1LrSync lr_row_sync;
+#endif  // CONFIG_LOOP_RESTORATION
 
   aom_decrypt_cb decrypt_cb;
   void *decrypt_state;
@@ -50,6 +50,7 @@
 #include "av1/encoder/bitstream.h"
 #include "av1/encoder/cost.h"
 #include "av1/encoder/encodemv.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/mcomp.h"
 #include "av1/encoder/segmentation.h"
 #include "av1/encoder/subexp.h"
@@ -139,6 +140,8 @@ static int remux_tiles(const AV1_COMMON *const cm, uint8_t *dst,
                        const uint32_t max_tile_col_size,
                        int *const tile_size_bytes,
                        int *const tile_col_size_bytes);
+static int choose_size_bytes(uint32_t size, int spare_msbs);
+static void mem_put_varsize(uint8_t *const dst, const int sz, const int val);
 
 void av1_encode_token_init(void) {
 #if CONFIG_EXT_TX || CONFIG_PALETTE
@@ -784,14 +787,27 @@ static void update_ext_tx_probs(AV1_COMMON *cm, aom_writer *w) {
 #endif  // CONFIG_EXT_TX
 #endif  // !CONFIG_EC_ADAPT
 #if CONFIG_PALETTE
-static void pack_palette_tokens(aom_writer *w, const TOKENEXTRA **tp, int n,
-                                int num) {
+static void pack_palette_tokens(aom_writer *w, const TOKENEXTRA **tp,
+                                int plane, int n, int num) {
   int i;
   const TOKENEXTRA *p = *tp;
+#if CONFIG_NEW_TOKENSET
+  const aom_prob(
+      *const probs)[PALETTE_COLOR_INDEX_CONTEXTS][PALETTE_COLORS - 1] =
+      plane == 0 ? av1_default_palette_y_color_index_prob
+                 : av1_default_palette_uv_color_index_prob;
+#else
+  (void)plane;
+#endif  // CONFIG_NEW_TOKENSET
 
   for (i = 0; i < num; ++i) {
     av1_write_token(
-        w, av1_palette_color_index_tree[n - PALETTE_MIN_SIZE], p->context_tree,
+        w, av1_palette_color_index_tree[n - PALETTE_MIN_SIZE],
+#if CONFIG_NEW_TOKENSET
+        probs[n - PALETTE_MIN_SIZE][p->ctx],
+#else
+        p->context_tree,
+#endif  // CONFIG_NEW_TOKENSET
         &palette_color_index_encodings[n - PALETTE_MIN_SIZE][p->token]);
     ++p;
   }
@@ -856,8 +872,8 @@ static INLINE void write_coeff_extra(const aom_prob *pb, int value,
 #endif
 
 #if CONFIG_NEW_TOKENSET && !CONFIG_LV_MAP
-static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
-                           const TOKENEXTRA *const stop,
+static void pack_mb_tokens(aom_writer *w, FRAME_CONTEXT *ec_ctx,
+                           const TOKENEXTRA **tp, const TOKENEXTRA *const stop,
                            aom_bit_depth_t bit_depth, const TX_SIZE tx_size,
                            TOKEN_STATS *token_stats) {
   const TOKENEXTRA *p = *tp;
@@ -868,26 +884,41 @@ static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
 
   while (p < stop && p->token != EOSB_TOKEN) {
     const int token = p->token;
+    const int eob_val = p->flags & TOKEN_EOB_VAL_MASK;
+    const int first_val = (p->flags >> TOKEN_FIRST_VAL_SHIFT) & 1;
+    // Unpack the context as packed by av1_get_token_ctx().
+    const int tx_size_sqr = p->ctx >> 8;
+    const int type = (p->ctx >> 7) & 1;
+    const int ref = (p->ctx >> 6) & 1;
+    const int band = (p->ctx >> 3) & 7;
+    const int pt = p->ctx & 7;
+    aom_cdf_prob *const head_cdf =
+        ec_ctx->coef_head_cdfs[tx_size_sqr][type][ref][band][pt];
+    aom_cdf_prob *const tail_cdf =
+        ec_ctx->coef_tail_cdfs[tx_size_sqr][type][ref][band][pt];
     const av1_extra_bit *const extra_bits = &av1_extra_bits[token];
 
     if (token == BLOCK_Z_TOKEN) {
-      aom_write_symbol(w, 0, *p->head_cdf, HEAD_TOKENS + 1);
+      aom_write_symbol(w, 0, head_cdf, HEAD_TOKENS + 1);
       p++;
       continue;
     }
-    if (p->eob_val == LAST_EOB) {
+    if (eob_val == LAST_EOB) {
       // Just code a flag indicating whether the value is >1 or 1.
       aom_write_bit(w, token != ONE_TOKEN);
     } else {
-      int comb_symb = 2 * AOMMIN(token, TWO_TOKEN) - p->eob_val + p->first_val;
-      aom_write_symbol(w, comb_symb, *p->head_cdf, HEAD_TOKENS + p->first_val);
+      int comb_symb = 2 * AOMMIN(token, TWO_TOKEN) - eob_val + first_val;
+      aom_write_symbol(w, comb_symb, head_cdf, HEAD_TOKENS + first_val);
     }
     if (token > ONE_TOKEN) {
-      aom_write_symbol(w, token - TWO_TOKEN, *p->tail_cdf, TAIL_TOKENS);
+      aom_write_symbol(w, token - TWO_TOKEN, tail_cdf, TAIL_TOKENS);
     }
 
     if (extra_bits->base_val) {
-      const int bit_string = p->extra;
+      const int bit_string = (av1_token_has_extra_bits(token)
+                                  ? av1_get_token_extra_bits(p + 1) << 1
+                                  : 0) |
+                             ((p->flags >> TOKEN_SIGN_SHIFT) & 1);
       const int bit_string_length = extra_bits->len;  // Length of extra bits to
       const int is_cat6 = (extra_bits->base_val == CAT6_MIN_VAL);
       // be written excluding
@@ -909,7 +940,7 @@ static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
 
       aom_write_bit_record(w, bit_string & 1, token_stats);
     }
-    ++p;
+    p += 1 + av1_token_has_extra_bits(token);
 
 #if CONFIG_VAR_TX
     ++count;
@@ -921,8 +952,8 @@ static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
 }
 #else  //  CONFIG_NEW_TOKENSET
 #if !CONFIG_LV_MAP
-static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
-                           const TOKENEXTRA *const stop,
+static void pack_mb_tokens(aom_writer *w, FRAME_CONTEXT *ec_ctx,
+                           const TOKENEXTRA **tp, const TOKENEXTRA *const stop,
                            aom_bit_depth_t bit_depth, const TX_SIZE tx_size,
                            TOKEN_STATS *token_stats) {
   const TOKENEXTRA *p = *tp;
@@ -930,6 +961,7 @@ static void pack_mb_tokens(aom_writer *w, const TOKENEXTRA **tp,
   int count = 0;
   const int seg_eob = tx_size_2d[tx_size];
 #endif
+  (void)ec_ctx;
 
   while (p < stop && p->token != EOSB_TOKEN) {
     const int token = p->token;
@@ -1099,7 +1131,8 @@ static void pack_pvq_tokens(aom_writer *w, MACROBLOCK *const x,
 #endif  // !CONFIG_PVG
 
 #if CONFIG_VAR_TX && !CONFIG_COEF_INTERLEAVE
-static void pack_txb_tokens(aom_writer *w, const TOKENEXTRA **tp,
+static void pack_txb_tokens(aom_writer *w, FRAME_CONTEXT *ec_ctx,
+                            const TOKENEXTRA **tp,
                             const TOKENEXTRA *const tok_end,
 #if CONFIG_PVQ
                             MACROBLOCK *const x,
@@ -1126,7 +1159,8 @@ static void pack_txb_tokens(aom_writer *w, const TOKENEXTRA **tp,
     TOKEN_STATS tmp_token_stats;
     init_token_stats(&tmp_token_stats);
 #if !CONFIG_PVQ
-    pack_mb_tokens(w, tp, tok_end, bit_depth, tx_size, &tmp_token_stats);
+    pack_mb_tokens(w, ec_ctx, tp, tok_end, bit_depth, tx_size,
+                   &tmp_token_stats);
 #else
     pack_pvq_tokens(w, x, xd, plane, bsize, tx_size);
 #endif
@@ -1148,7 +1182,7 @@ static void pack_txb_tokens(aom_writer *w, const TOKENEXTRA **tp,
 
       if (offsetr >= max_blocks_high || offsetc >= max_blocks_wide) continue;
 
-      pack_txb_tokens(w, tp, tok_end,
+      pack_txb_tokens(w, ec_ctx, tp, tok_end,
 #if CONFIG_PVQ
                       x,
 #endif
@@ -1329,8 +1363,8 @@ static void write_intra_angle_info(const MACROBLOCKD *xd,
 }
 #endif  // CONFIG_EXT_INTRA
 
-static void write_mb_interp_filter(AV1_COMP *cpi, const MACROBLOCKD *xd,
-                                   aom_writer *w) {
+static void write_mb_interp_filter(AV1_COMP *cpi, ThreadData *const td,
+                                   const MACROBLOCKD *xd, aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
   const MB_MODE_INFO *const mbmi = &xd->mi[0]->mbmi;
 #if CONFIG_EC_ADAPT
@@ -1359,7 +1393,7 @@ static void write_mb_interp_filter(AV1_COMP *cpi, const MACROBLOCKD *xd,
                         ec_ctx->switchable_interp_prob[ctx],
                         &switchable_interp_encodings[mbmi->interp_filter[dir]]);
 #endif
-        ++cpi->interp_filter_selected[0][mbmi->interp_filter[dir]];
+        ++td->interp_filter_selected[mbmi->interp_filter[dir]];
       } else {
         assert(mbmi->interp_filter[dir] == EIGHTTAP_REGULAR);
       }
@@ -1375,7 +1409,7 @@ static void write_mb_interp_filter(AV1_COMP *cpi, const MACROBLOCKD *xd,
                       ec_ctx->switchable_interp_prob[ctx],
                       &switchable_interp_encodings[mbmi->interp_filter]);
 #endif
-      ++cpi->interp_filter_selected[0][mbmi->interp_filter];
+      ++td->interp_filter_selected[mbmi->interp_filter];
     }
 #endif  // CONFIG_DUAL_FILTER
   }
@@ -1559,18 +1593,19 @@ static void write_intra_uv_mode(FRAME_CONTEXT *frame_ctx,
 #endif
 }
 
-static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
-                                const int mi_row, const int mi_col,
+static void pack_inter_mode_mvs(AV1_COMP *cpi, ThreadData *const td,
+                                const MODE_INFO *mi, const int mi_row,
+                                const int mi_col,
 #if CONFIG_SUPERTX
                                 int supertx_enabled,
 #endif
                                 aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
 #if CONFIG_DELTA_Q || CONFIG_EC_ADAPT
-  MACROBLOCK *const x = &cpi->td.mb;
+  MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
 #else
-  const MACROBLOCK *x = &cpi->td.mb;
+  const MACROBLOCK *x = &td->mb;
   const MACROBLOCKD *xd = &x->e_mbd;
 #endif
 #if CONFIG_EC_ADAPT
@@ -1755,7 +1790,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
     }
 
 #if !CONFIG_DUAL_FILTER && !CONFIG_WARPED_MOTION && !CONFIG_GLOBAL_MOTION
-    write_mb_interp_filter(cpi, xd, w);
+    write_mb_interp_filter(cpi, td, xd, w);
 #endif  // !CONFIG_DUAL_FILTER && !CONFIG_WARPED_MOTION
 
     if (bsize < BLOCK_8X8 && !unify_bsize) {
@@ -1798,7 +1833,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
                                         mbmi->ref_mv_idx);
               nmv_context *nmvc = &ec_ctx->nmvc[nmv_ctx];
 #endif
-              av1_encode_mv(cpi, w, &mi->bmi[j].as_mv[ref].as_mv,
+              av1_encode_mv(cpi, td, w, &mi->bmi[j].as_mv[ref].as_mv,
 #if CONFIG_EXT_INTER
                             &mi->bmi[j].ref_mv[ref].as_mv,
 #else
@@ -1820,7 +1855,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
                                       mbmi->ref_mv_idx);
             nmv_context *nmvc = &ec_ctx->nmvc[nmv_ctx];
 #endif
-            av1_encode_mv(cpi, w, &mi->bmi[j].as_mv[1].as_mv,
+            av1_encode_mv(cpi, td, w, &mi->bmi[j].as_mv[1].as_mv,
                           &mi->bmi[j].ref_mv[1].as_mv, nmvc, allow_hp);
           } else if (b_mode == NEW_NEARESTMV || b_mode == NEW_NEARMV) {
 #if CONFIG_REF_MV
@@ -1830,7 +1865,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
                                       mbmi->ref_mv_idx);
             nmv_context *nmvc = &ec_ctx->nmvc[nmv_ctx];
 #endif
-            av1_encode_mv(cpi, w, &mi->bmi[j].as_mv[0].as_mv,
+            av1_encode_mv(cpi, td, w, &mi->bmi[j].as_mv[0].as_mv,
                           &mi->bmi[j].ref_mv[0].as_mv, nmvc, allow_hp);
           }
 #endif  // CONFIG_EXT_INTER
@@ -1854,13 +1889,13 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
           ref_mv = mbmi_ext->ref_mvs[mbmi->ref_frame[ref]][0];
 #if CONFIG_EXT_INTER
           if (mode == NEWFROMNEARMV)
-            av1_encode_mv(cpi, w, &mbmi->mv[ref].as_mv,
+            av1_encode_mv(cpi, td, w, &mbmi->mv[ref].as_mv,
                           &mbmi_ext->ref_mvs[mbmi->ref_frame[ref]][1].as_mv,
                           nmvc, allow_hp);
           else
 #endif  // CONFIG_EXT_INTER
-            av1_encode_mv(cpi, w, &mbmi->mv[ref].as_mv, &ref_mv.as_mv, nmvc,
-                          allow_hp);
+            av1_encode_mv(cpi, td, w, &mbmi->mv[ref].as_mv, &ref_mv.as_mv,
+                          nmvc, allow_hp);
         }
 #if CONFIG_EXT_INTER
       } else if (mode == NEAREST_NEWMV || mode == NEAR_NEWMV) {
@@ -1871,7 +1906,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
                         mbmi_ext->ref_mv_stack[rf_type], 1, mbmi->ref_mv_idx);
         nmv_context *nmvc = &ec_ctx->nmvc[nmv_ctx];
 #endif
-        av1_encode_mv(cpi, w, &mbmi->mv[1].as_mv,
+        av1_encode_mv(cpi, td, w, &mbmi->mv[1].as_mv,
                       &mbmi_ext->ref_mvs[mbmi->ref_frame[1]][0].as_mv, nmvc,
                       allow_hp);
       } else if (mode == NEW_NEARESTMV || mode == NEW_NEARMV) {
@@ -1882,7 +1917,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
                         mbmi_ext->ref_mv_stack[rf_type], 0, mbmi->ref_mv_idx);
         nmv_context *nmvc = &ec_ctx->nmvc[nmv_ctx];
 #endif
-        av1_encode_mv(cpi, w, &mbmi->mv[0].as_mv,
+        av1_encode_mv(cpi, td, w, &mbmi->mv[0].as_mv,
                       &mbmi_ext->ref_mvs[mbmi->ref_frame[0]][0].as_mv, nmvc,
                       allow_hp);
 #endif  // CONFIG_EXT_INTER
@@ -1952,7 +1987,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const MODE_INFO *mi,
     if (mbmi->motion_mode != WARPED_CAUSAL)
 #endif  // CONFIG_WARPED_MOTION
 #if CONFIG_DUAL_FILTER || CONFIG_WARPED_MOTION || CONFIG_GLOBAL_MOTION
-      write_mb_interp_filter(cpi, xd, w);
+      write_mb_interp_filter(cpi, td, xd, w);
 #endif  // CONFIG_DUAL_FILTE || CONFIG_WARPED_MOTION
   }
 
@@ -2070,13 +2105,14 @@ static void write_mb_modes_kf(AV1_COMMON *cm, const MACROBLOCKD *xd,
 }
 
 #if CONFIG_SUPERTX
-#define write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled, \
-                              mi_row, mi_col)                              \
-  write_modes_b(cpi, tile, w, tok, tok_end, supertx_enabled, mi_row, mi_col)
+#define write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end,            \
+                              supertx_enabled, mi_row, mi_col)           \
+  write_modes_b(cpi, td, tile, w, tok, tok_end, supertx_enabled, mi_row, \
+                mi_col)
 #else
-#define write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled, \
-                              mi_row, mi_col)                              \
-  write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col)
+#define write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end,  \
+                              supertx_enabled, mi_row, mi_col) \
+  write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col)
 #endif  // CONFIG_SUPERTX
 
 #if CONFIG_RD_DEBUG
@@ -2122,14 +2158,14 @@ static int rd_token_stats_mismatch(RD_STATS *rd_stats, TOKEN_STATS *token_stats,
 }
 #endif
 
-static void write_mbmi_b(AV1_COMP *cpi, const TileInfo *const tile,
-                         aom_writer *w,
+static void write_mbmi_b(AV1_COMP *cpi, ThreadData *const td,
+                         const TileInfo *const tile, aom_writer *w,
 #if CONFIG_SUPERTX
                          int supertx_enabled,
 #endif
                          int mi_row, int mi_col) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   MODE_INFO *m;
   int bh, bw;
   xd->mi = cm->mi_grid_visible + (mi_row * cm->mi_stride + mi_col);
@@ -2140,7 +2176,7 @@ static void write_mbmi_b(AV1_COMP *cpi, const TileInfo *const tile,
   bh = mi_size_high[m->mbmi.sb_type];
   bw = mi_size_wide[m->mbmi.sb_type];
 
-  cpi->td.mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
+  td->mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
 
 #if CONFIG_DEPENDENT_HORZTILES
   set_mi_row_col(xd, tile, mi_row, bh, mi_col, bw, cm->mi_rows, cm->mi_cols,
@@ -2187,7 +2223,7 @@ static void write_mbmi_b(AV1_COMP *cpi, const TileInfo *const tile,
              m->mbmi.ref_frame[0], m->mbmi.ref_frame[1]);
     }
 #endif  // 0
-    pack_inter_mode_mvs(cpi, m, mi_row, mi_col,
+    pack_inter_mode_mvs(cpi, td, m, mi_row, mi_col,
 #if CONFIG_SUPERTX
                         supertx_enabled,
 #endif
@@ -2195,20 +2231,27 @@ static void write_mbmi_b(AV1_COMP *cpi, const TileInfo *const tile,
   }
 }
 
-static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
-                           aom_writer *w, const TOKENEXTRA **tok,
+static void write_tokens_b(AV1_COMP *cpi, ThreadData *const td,
+                           const TileInfo *const tile, aom_writer *w,
+                           const TOKENEXTRA **tok,
                            const TOKENEXTRA *const tok_end, int mi_row,
                            int mi_col) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   MODE_INFO *const m = xd->mi[0];
   MB_MODE_INFO *const mbmi = &m->mbmi;
+#if CONFIG_EC_ADAPT
+  FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
+#else
+  FRAME_CONTEXT *ec_ctx = cm->fc;
+#endif
   int plane;
   int bh, bw;
 #if CONFIG_PVQ || CONFIG_LV_MAP
-  MACROBLOCK *const x = &cpi->td.mb;
+  MACROBLOCK *const x = &td->mb;
   (void)tok;
   (void)tok_end;
+  (void)ec_ctx;
 #endif
   xd->mi = cm->mi_grid_visible + (mi_row * cm->mi_stride + mi_col);
 
@@ -2216,7 +2259,7 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
 
   bh = mi_size_high[mbmi->sb_type];
   bw = mi_size_wide[mbmi->sb_type];
-  cpi->td.mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
+  td->mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
 
 #if CONFIG_DEPENDENT_HORZTILES
   set_mi_row_col(xd, tile, mi_row, bh, mi_col, bw, cm->mi_rows, cm->mi_cols,
@@ -2235,7 +2278,7 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
       av1_get_block_dimensions(mbmi->sb_type, plane, xd, NULL, NULL, &rows,
                                &cols);
       assert(*tok < tok_end);
-      pack_palette_tokens(w, tok, palette_size_plane, rows * cols - 1);
+      pack_palette_tokens(w, tok, plane, palette_size_plane, rows * cols - 1);
       assert(*tok < tok_end + mbmi->skip);
     }
   }
@@ -2285,17 +2328,20 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
     assert(*tok < tok_end);
 
     while (tu_idx_y < tu_num_y) {
-      pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx_log2_y, &token_stats);
+      pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx_log2_y,
+                     &token_stats);
       assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
       (*tok)++;
       tu_idx_y++;
 
       if (tu_idx_c < tu_num_c) {
-        pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx_log2_c, &token_stats);
+        pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx_log2_c,
+                       &token_stats);
         assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
         (*tok)++;
 
-        pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx_log2_c, &token_stats);
+        pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx_log2_c,
+                       &token_stats);
         assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
         (*tok)++;
 
@@ -2305,11 +2351,13 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
 
     // In 422 case, it's possilbe that Chroma has more TUs than Luma
     while (tu_idx_c < tu_num_c) {
-      pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx_log2_c, &token_stats);
+      pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx_log2_c,
+                     &token_stats);
       assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
       (*tok)++;
 
-      pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx_log2_c, &token_stats);
+      pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx_log2_c,
+                     &token_stats);
       assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
       (*tok)++;
 
@@ -2364,7 +2412,7 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
         const int bkh = tx_size_high_unit[max_tx_size];
         for (row = 0; row < num_4x4_h; row += bkh) {
           for (col = 0; col < num_4x4_w; col += bkw) {
-            pack_txb_tokens(w, tok, tok_end,
+            pack_txb_tokens(w, ec_ctx, tok, tok_end,
 #if CONFIG_PVQ
                             x,
 #endif
@@ -2390,7 +2438,8 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
         for (row = 0; row < num_4x4_h; row += bkh) {
           for (col = 0; col < num_4x4_w; col += bkw) {
 #if !CONFIG_PVQ
-            pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx, &token_stats);
+            pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx,
+                           &token_stats);
 #else
             pack_pvq_tokens(w, x, xd, plane, bsize, tx);
 #endif
@@ -2406,7 +2455,7 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
       (void)tx;
       av1_write_coeffs_mb(cm, x, w, plane);
 #else   // CONFIG_LV_MAP
-      pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx, &token_stats);
+      pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx, &token_stats);
 #endif  // CONFIG_LV_MAP
 
 #else
@@ -2432,8 +2481,9 @@ static void write_tokens_b(AV1_COMP *cpi, const TileInfo *const tile,
 }
 
 #if CONFIG_MOTION_VAR && CONFIG_NCOBMC
-static void write_tokens_sb(AV1_COMP *cpi, const TileInfo *const tile,
-                            aom_writer *w, const TOKENEXTRA **tok,
+static void write_tokens_sb(AV1_COMP *cpi, ThreadData *const td,
+                            const TileInfo *const tile, aom_writer *w,
+                            const TOKENEXTRA **tok,
                             const TOKENEXTRA *const tok_end, int mi_row,
                             int mi_col, BLOCK_SIZE bsize) {
   const AV1_COMMON *const cm = &cpi->common;
@@ -2452,51 +2502,54 @@ static void write_tokens_sb(AV1_COMP *cpi, const TileInfo *const tile,
   subsize = get_subsize(bsize, partition);
 
   if (subsize < BLOCK_8X8 && !unify_bsize) {
-    write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+    write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
   } else {
     switch (partition) {
       case PARTITION_NONE:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
         break;
       case PARTITION_HORZ:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
         if (mi_row + hbs < cm->mi_rows)
-          write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col);
+          write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs, mi_col);
         break;
       case PARTITION_VERT:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
         if (mi_col + hbs < cm->mi_cols)
-          write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs);
+          write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs);
         break;
       case PARTITION_SPLIT:
-        write_tokens_sb(cpi, tile, w, tok, tok_end, mi_row, mi_col, subsize);
-        write_tokens_sb(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs,
+        write_tokens_sb(cpi, td, tile, w, tok, tok_end, mi_row, mi_col,
                         subsize);
-        write_tokens_sb(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col,
+        write_tokens_sb(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs,
                         subsize);
-        write_tokens_sb(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col + hbs,
+        write_tokens_sb(cpi, td, tile, w, tok, tok_end, mi_row + hbs, mi_col,
                         subsize);
+        write_tokens_sb(cpi, td, tile, w, tok, tok_end, mi_row + hbs,
+                        mi_col + hbs, subsize);
         break;
 #if CONFIG_EXT_PARTITION_TYPES
       case PARTITION_HORZ_A:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs, mi_col);
         break;
       case PARTITION_HORZ_B:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col + hbs);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs,
+                       mi_col + hbs);
         break;
       case PARTITION_VERT_A:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs);
         break;
       case PARTITION_VERT_B:
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs);
-        write_tokens_b(cpi, tile, w, tok, tok_end, mi_row + hbs, mi_col + hbs);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs);
+        write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs,
+                       mi_col + hbs);
         break;
 #endif  // CONFIG_EXT_PARTITION_TYPES
       default: assert(0);
@@ -2505,14 +2558,15 @@ static void write_tokens_sb(AV1_COMP *cpi, const TileInfo *const tile,
 }
 #endif
 
-static void write_modes_b(AV1_COMP *cpi, const TileInfo *const tile,
-                          aom_writer *w, const TOKENEXTRA **tok,
+static void write_modes_b(AV1_COMP *cpi, ThreadData *const td,
+                          const TileInfo *const tile, aom_writer *w,
+                          const TOKENEXTRA **tok,
                           const TOKENEXTRA *const tok_end,
 #if CONFIG_SUPERTX
                           int supertx_enabled,
 #endif
                           int mi_row, int mi_col) {
-  write_mbmi_b(cpi, tile, w,
+  write_mbmi_b(cpi, td, tile, w,
 #if CONFIG_SUPERTX
                supertx_enabled,
 #endif
@@ -2524,7 +2578,7 @@ static void write_modes_b(AV1_COMP *cpi, const TileInfo *const tile,
 #if !CONFIG_PVQ && CONFIG_SUPERTX
   if (!supertx_enabled)
 #endif
-    write_tokens_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+    write_tokens_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
 #endif
 }
 
@@ -2592,25 +2646,26 @@ static void write_partition(const AV1_COMMON *const cm,
 }
 
 #if CONFIG_SUPERTX
-#define write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,   \
-                               mi_row, mi_col, bsize)                         \
-  write_modes_sb(cpi, tile, w, tok, tok_end, supertx_enabled, mi_row, mi_col, \
-                 bsize)
+#define write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end,            \
+                               supertx_enabled, mi_row, mi_col, bsize)    \
+  write_modes_sb(cpi, td, tile, w, tok, tok_end, supertx_enabled, mi_row, \
+                 mi_col, bsize)
 #else
-#define write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled, \
-                               mi_row, mi_col, bsize)                       \
-  write_modes_sb(cpi, tile, w, tok, tok_end, mi_row, mi_col, bsize)
+#define write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end,         \
+                               supertx_enabled, mi_row, mi_col, bsize) \
+  write_modes_sb(cpi, td, tile, w, tok, tok_end, mi_row, mi_col, bsize)
 #endif  // CONFIG_SUPERTX
 
-static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
-                           aom_writer *const w, const TOKENEXTRA **tok,
+static void write_modes_sb(AV1_COMP *const cpi, ThreadData *const td,
+                           const TileInfo *const tile, aom_writer *const w,
+                           const TOKENEXTRA **tok,
                            const TOKENEXTRA *const tok_end,
 #if CONFIG_SUPERTX
                            int supertx_enabled,
 #endif
                            int mi_row, int mi_col, BLOCK_SIZE bsize) {
   const AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   const int hbs = mi_size_wide[bsize] / 2;
   const PARTITION_TYPE partition = get_partition(cm, mi_row, mi_col, bsize);
   const BLOCK_SIZE subsize = get_subsize(bsize, partition);
@@ -2654,69 +2709,69 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
   }
 #endif  // CONFIG_SUPERTX
   if (subsize < BLOCK_8X8 && !unify_bsize) {
-    write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled, mi_row,
-                          mi_col);
+    write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
+                          mi_row, mi_col);
   } else {
     switch (partition) {
       case PARTITION_NONE:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
         break;
       case PARTITION_HORZ:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
         if (mi_row + hbs < cm->mi_rows)
-          write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+          write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                 mi_row + hbs, mi_col);
         break;
       case PARTITION_VERT:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
         if (mi_col + hbs < cm->mi_cols)
-          write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+          write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                 mi_row, mi_col + hbs);
         break;
       case PARTITION_SPLIT:
-        write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                mi_row, mi_col, subsize);
-        write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                mi_row, mi_col + hbs, subsize);
-        write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                mi_row + hbs, mi_col, subsize);
-        write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                                mi_row + hbs, mi_col + hbs, subsize);
         break;
 #if CONFIG_EXT_PARTITION_TYPES
       case PARTITION_HORZ_A:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col + hbs);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row + hbs, mi_col);
         break;
       case PARTITION_HORZ_B:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row + hbs, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row + hbs, mi_col + hbs);
         break;
       case PARTITION_VERT_A:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row + hbs, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col + hbs);
         break;
       case PARTITION_VERT_B:
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row, mi_col + hbs);
-        write_modes_b_wrapper(cpi, tile, w, tok, tok_end, supertx_enabled,
+        write_modes_b_wrapper(cpi, td, tile, w, tok, tok_end, supertx_enabled,
                               mi_row + hbs, mi_col + hbs);
         break;
 #endif  // CONFIG_EXT_PARTITION_TYPES
@@ -2774,6 +2829,11 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
 #endif  // CONFIG_EXT_TX
 
     if (!skip) {
+#if CONFIG_EC_ADAPT
+      FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
+#else
+      FRAME_CONTEXT *ec_ctx = cm->fc;
+#endif
       assert(*tok < tok_end);
       for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
         const struct macroblockd_plane *const pd = &xd->plane[plane];
@@ -2794,7 +2854,8 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
         token_stats.cost = 0;
         for (row = 0; row < max_blocks_high; row += stepr)
           for (col = 0; col < max_blocks_wide; col += stepc)
-            pack_mb_tokens(w, tok, tok_end, cm->bit_depth, tx, &token_stats);
+            pack_mb_tokens(w, ec_ctx, tok, tok_end, cm->bit_depth, tx,
+                           &token_stats);
         assert(*tok < tok_end && (*tok)->token == EOSB_TOKEN);
         (*tok)++;
       }
@@ -2837,11 +2898,12 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
 #endif
 }
 
-static void write_modes(AV1_COMP *const cpi, const TileInfo *const tile,
-                        aom_writer *const w, const TOKENEXTRA **tok,
+static void write_modes(AV1_COMP *const cpi, ThreadData *const td,
+                        const TileInfo *const tile, aom_writer *const w,
+                        const TOKENEXTRA **tok,
                         const TOKENEXTRA *const tok_end) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   const int mi_row_start = tile->mi_row_start;
   const int mi_row_end = tile->mi_row_end;
   const int mi_col_start = tile->mi_col_start;
@@ -2861,7 +2923,7 @@ static void write_modes(AV1_COMP *const cpi, const TileInfo *const tile,
   av1_zero_above_context(cm, mi_col_start, mi_col_end);
 #endif
 #if CONFIG_PVQ
-  assert(cpi->td.mb.pvq_q->curr_pos == 0);
+  assert(td->mb.pvq_q->curr_pos == 0);
 #endif
 #if CONFIG_DELTA_Q
   if (cpi->common.delta_q_present_flag) {
@@ -2873,19 +2935,20 @@ static void write_modes(AV1_COMP *const cpi, const TileInfo *const tile,
     av1_zero_left_context(xd);
 
     for (mi_col = mi_col_start; mi_col < mi_col_end; mi_col += cm->mib_size) {
-      write_modes_sb_wrapper(cpi, tile, w, tok, tok_end, 0, mi_row, mi_col,
+      write_modes_sb_wrapper(cpi, td, tile, w, tok, tok_end, 0, mi_row, mi_col,
                              cm->sb_size);
 #if CONFIG_MOTION_VAR && CONFIG_NCOBMC
-      write_tokens_sb(cpi, tile, w, tok, tok_end, mi_row, mi_col, cm->sb_size);
+      write_tokens_sb(cpi, td, tile, w, tok, tok_end, mi_row, mi_col,
+                      cm->sb_size);
 #endif
     }
   }
 #if CONFIG_PVQ
   // Check that the number of PVQ blocks encoded and written to the bitstream
   // are the same
-  assert(cpi->td.mb.pvq_q->curr_pos == cpi->td.mb.pvq_q->last_pos);
+  assert(td->mb.pvq_q->curr_pos == td->mb.pvq_q->last_pos);
   // Reset curr_pos in case we repack the bitstream
-  cpi->td.mb.pvq_q->curr_pos = 0;
+  td->mb.pvq_q->curr_pos = 0;
 #endif
 }
 
@@ -3833,57 +3896,143 @@ static int get_refresh_mask(AV1_COMP *cpi) {
 }
 
 #if CONFIG_EXT_TILE
+#define TILE_HASH_BITS 8
+
+// The tiles of a column whose data is in the bitstream, by hash of their data.
+// Tiles with the same hash are chained from the most recent one.
+typedef struct {
+  int head[1 << TILE_HASH_BITS];
+  int next[MAX_TILE_ROWS];
+  uint32_t hash[MAX_TILE_ROWS];
+} TileHashTable;
+
+static void reset_tile_hash_table(TileHashTable *const table) {
+  memset(table->head, -1, sizeof(table->head));
+}
+
+// FNV-1a hash of the data of a tile.
+static uint32_t get_tile_hash(const uint8_t *data, unsigned int size) {
+  uint32_t hash = 2166136261u;
+  unsigned int i;
+
+  for (i = 0; i < size; ++i) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+// Returns the row offset of an earlier tile of the column with the same data
+// as the current tile, or 0 if there is none, in which case the current tile
+// is added to the table.
 static INLINE int find_identical_tile(
     const int tile_row, const int tile_col,
-    TileBufferEnc (*const tile_buffers)[1024]) {
-  const MV32 candidate_offset[1] = { { 1, 0 } };
+    TileBufferEnc (*const tile_buffers)[1024], TileHashTable *const table) {
   const uint8_t *const cur_tile_data =
       tile_buffers[tile_row][tile_col].data + 4;
   const unsigned int cur_tile_size = tile_buffers[tile_row][tile_col].size;
-
-  int i;
-
-  if (tile_row == 0) return 0;
-
-  // (TODO: yunqingwang) For now, only above tile is checked and used.
-  // More candidates such as left tile can be added later.
-  for (i = 0; i < 1; i++) {
-    int row_offset = candidate_offset[0].row;
-    int col_offset = candidate_offset[0].col;
-    int row = tile_row - row_offset;
-    int col = tile_col - col_offset;
-    uint8_t tile_hdr;
-    const uint8_t *tile_data;
-    TileBufferEnc *candidate;
-
-    if (row < 0 || col < 0) continue;
-
-    tile_hdr = *(tile_buffers[row][col].data);
-
-    // Read out tcm bit
-    if ((tile_hdr >> 7) == 1) {
-      // The candidate is a copy tile itself
-      row_offset += tile_hdr & 0x7f;
-      row = tile_row - row_offset;
+  const uint32_t hash = get_tile_hash(cur_tile_data, cur_tile_size);
+  int *const head = &table->head[hash & ((1 << TILE_HASH_BITS) - 1)];
+  int row;
+
+  // Copy tiles can only signal row offsets below 128, and only refer to tiles
+  // in the same column.
+  for (row = *head; row >= 0 && tile_row - row < 128; row = table->next[row]) {
+    const TileBufferEnc *const candidate = &tile_buffers[row][tile_col];
+
+    if (table->hash[row] == hash && candidate->size == cur_tile_size &&
+        memcmp(candidate->data + 4, cur_tile_data, cur_tile_size) == 0) {
+      // Identical tile found
+      assert(tile_row - row > 0);
+      return tile_row - row;
     }
+  }
 
-    candidate = &tile_buffers[row][col];
+  table->hash[tile_row] = hash;
+  table->next[tile_row] = *head;
+  *head = tile_row;
+  return 0;
+}
+#endif  // CONFIG_EXT_TILE
+
+int av1_pack_tile(AV1_COMP *const cpi, ThreadData *const td, int tile_row,
+                  int tile_col, uint8_t *const dst, uint8_t *const dst_end) {
+  const AV1_COMMON *const cm = &cpi->common;
+  TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  TileBufferEnc *const buf = &cpi->tile_buffers[tile_row][tile_col];
+  const TOKENEXTRA *tok = cpi->tile_tok[tile_row][tile_col];
+  const TOKENEXTRA *tok_end = tok + cpi->tok_count[tile_row][tile_col];
+#if CONFIG_ANS
+  struct BufAnsCoder *buf_ans = &cpi->buf_ans;
+#else
+  aom_writer mode_bc;
+#endif  // CONFIG_ANS
 
-    if (row_offset >= 128 || candidate->size != cur_tile_size) continue;
+#if CONFIG_EC_ADAPT
+  // Initialise tile context from the frame context
+  this_tile->tctx = *cm->fc;
+  td->mb.e_mbd.tile_ctx = &this_tile->tctx;
+#endif
+#if CONFIG_PVQ
+  td->mb.pvq_q = &this_tile->pvq_q;
+  td->mb.daala_enc.state.adapt = &this_tile->tctx.pvq_context;
+#endif  // CONFIG_PVQ
+#if CONFIG_ANS
+  assert(dst_end == NULL);
+  buf_ans_write_init(buf_ans, dst);
+  write_modes(cpi, td, &this_tile->tile_info, buf_ans, &tok, tok_end);
+  assert(tok == tok_end);
+  aom_buf_ans_flush(buf_ans);
+  buf->size = buf_ans_write_end(buf_ans);
+#else
+  aom_start_encode(&mode_bc, dst);
+#if CONFIG_DAALA_EC
+  mode_bc.buffer_end = dst_end;
+#else
+  assert(dst_end == NULL);
+#endif  // CONFIG_DAALA_EC
+  write_modes(cpi, td, &this_tile->tile_info, &mode_bc, &tok, tok_end);
+#if !CONFIG_LV_MAP
+  assert(tok == tok_end);
+#endif  // !CONFIG_LV_MAP
+  aom_stop_encode(&mode_bc);
+  buf->size = mode_bc.pos;
+#endif  // CONFIG_ANS
+#if CONFIG_PVQ
+  td->mb.pvq_q = NULL;
+#endif
+  if (buf->size == 0) {
+    buf->data = NULL;
+    return 0;
+  }
+  buf->data = dst;
+  return 1;
+}
 
-    tile_data = candidate->data + 4;
+void av1_accumulate_pack_stats(AV1_COMP *const cpi, const ThreadData *td) {
+  int i;
 
-    if (memcmp(tile_data, cur_tile_data, cur_tile_size) != 0) continue;
+  for (i = 0; i < SWITCHABLE; ++i)
+    cpi->interp_filter_selected[0][i] += td->interp_filter_selected[i];
+  cpi->max_mv_magnitude = AOMMAX(cpi->max_mv_magnitude, td->max_mv_magnitude);
+}
 
-    // Identical tile found
-    assert(row_offset > 0);
-    return row_offset;
-  }
+#if !CONFIG_EXT_TILE
+// Tiles can only be packed in any order when they have their own entropy
+// contexts. Segment ids are coded with the frame context, so the segment map
+// must not be updated either. Only the Daala entropy coder checks that a tile
+// fits in the part of the buffer given to its column.
+static int use_tile_pack_workers(const AV1_COMP *const cpi) {
+#if CONFIG_EC_ADAPT && CONFIG_DAALA_EC && !CONFIG_PVQ && !CONFIG_LV_MAP && \
+    !CONFIG_BITSTREAM_DEBUG
+  const AV1_COMMON *const cm = &cpi->common;
 
-  // No identical tile found
+  return AOMMIN(cpi->oxcf.max_threads, cm->tile_cols) > 1 &&
+         !(cm->seg.enabled && cm->seg.update_map);
+#else
+  (void)cpi;
   return 0;
+#endif
 }
-#endif  // CONFIG_EXT_TILE
+#endif  // !CONFIG_EXT_TILE
 
 #if CONFIG_TILE_GROUPS
 static uint32_t write_tiles(AV1_COMP *const cpi,
@@ -3896,13 +4045,18 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
                             unsigned int *max_tile_col_size) {
 #endif
   const AV1_COMMON *const cm = &cpi->common;
+#if CONFIG_EXT_TILE
 #if CONFIG_ANS
   struct BufAnsCoder *buf_ans = &cpi->buf_ans;
 #else
   aom_writer mode_bc;
 #endif  // CONFIG_ANS
-  int tile_row, tile_col;
   TOKENEXTRA *(*const tok_buffers)[MAX_TILE_COLS] = cpi->tile_tok;
+#else
+  const int pack_tiles_mt = use_tile_pack_workers(cpi);
+  int tile_size_bytes = 4;
+#endif  // CONFIG_EXT_TILE
+  int tile_row, tile_col;
   TileBufferEnc(*const tile_buffers)[MAX_TILE_COLS] = cpi->tile_buffers;
   size_t total_size = 0;
   const int tile_cols = cm->tile_cols;
@@ -3917,7 +4071,6 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
   const int tg_size = (tile_rows * tile_cols + num_tg_hdrs - 1) / num_tg_hdrs;
   int tile_count = 0;
   int tg_count = 1;
-  int tile_size_bytes = 4;
   int tile_col_size_bytes;
   int uncompressed_hdr_size = 0;
   uint8_t *dst = NULL;
@@ -3931,10 +4084,13 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
 #endif
 #if CONFIG_EXT_TILE
   const int have_tiles = tile_cols * tile_rows > 1;
+  TileHashTable tile_hash_table;
 #endif  // CONFIG_EXT_TILE
 
   *max_tile_size = 0;
   *max_tile_col_size = 0;
+  av1_zero(cpi->td.interp_filter_selected);
+  cpi->td.max_mv_magnitude = 0;
 
 // All tile size fields are output on 4 bytes. A call to remux_tiles will
 // later compact the data if smaller headers are adequate.
@@ -3950,6 +4106,8 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
     // The last column does not have a column header
     if (!is_last_col) total_size += 4;
 
+    reset_tile_hash_table(&tile_hash_table);
+
     for (tile_row = 0; tile_row < tile_rows; tile_row++) {
       TileBufferEnc *const buf = &tile_buffers[tile_row][tile_col];
       const TOKENEXTRA *tok = tok_buffers[tile_row][tile_col];
@@ -3977,13 +4135,13 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
 #endif  // CONFIG_PVQ
 #if !CONFIG_ANS
       aom_start_encode(&mode_bc, buf->data + data_offset);
-      write_modes(cpi, &tile_info, &mode_bc, &tok, tok_end);
+      write_modes(cpi, &cpi->td, &tile_info, &mode_bc, &tok, tok_end);
       assert(tok == tok_end);
       aom_stop_encode(&mode_bc);
       tile_size = mode_bc.pos;
 #else
       buf_ans_write_init(buf_ans, buf->data + data_offset);
-      write_modes(cpi, &tile_info, buf_ans, &tok, tok_end);
+      write_modes(cpi, &cpi->td, &tile_info, buf_ans, &tok, tok_end);
       assert(tok == tok_end);
       aom_buf_ans_flush(buf_ans);
       tile_size = buf_ans_write_end(buf_ans);
@@ -4000,18 +4158,15 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
         // tile header: size of this tile, or copy offset
         uint32_t tile_header = tile_size;
 
-        // Check if this tile is a copy tile.
-        // Very low chances to have copy tiles on the key frames, so don't
-        // search on key frames to reduce unnecessary search.
-        if (cm->frame_type != KEY_FRAME) {
-          const int idendical_tile_offset =
-              find_identical_tile(tile_row, tile_col, tile_buffers);
-
-          if (idendical_tile_offset > 0) {
-            tile_size = 0;
-            tile_header = idendical_tile_offset | 0x80;
-            tile_header <<= 24;
-          }
+        // Check if this tile is a copy tile. The search is cheap enough to
+        // be done on key frames as well.
+        const int idendical_tile_offset = find_identical_tile(
+            tile_row, tile_col, tile_buffers, &tile_hash_table);
+
+        if (idendical_tile_offset > 0) {
+          tile_size = 0;
+          tile_header = idendical_tile_offset | 0x80;
+          tile_header <<= 24;
         }
 
         mem_put_le32(buf->data, tile_header);
@@ -4064,19 +4219,33 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
   total_size += hdr_size;
 #endif
 
+  if (pack_tiles_mt) {
+    // Pack all the tiles first, so that they only need to be concatenated.
+    const int all_packed = av1_pack_tiles_mt(cpi);
+#if CONFIG_TILE_GROUPS
+    // With a single tile group, the size fields can be written with their
+    // final length rather than be compacted by remux_tiles later.
+    if (all_packed && have_tiles && !mtu_size &&
+        tile_rows * tile_cols - 1 <= tg_size) {
+      size_t max_size = 0;
+      for (tile_row = 0; tile_row < tile_rows; tile_row++)
+        for (tile_col = 0; tile_col < tile_cols; tile_col++)
+          if (tile_row < tile_rows - 1 || tile_col < tile_cols - 1)
+            max_size =
+                AOMMAX(max_size, tile_buffers[tile_row][tile_col].size);
+      tile_size_bytes = choose_size_bytes((uint32_t)max_size, 0);
+    }
+#else
+    (void)all_packed;
+#endif
+  }
+
   for (tile_row = 0; tile_row < tile_rows; tile_row++) {
-    TileInfo tile_info;
     const int is_last_row = (tile_row == tile_rows - 1);
-    av1_tile_set_row(&tile_info, cm, tile_row);
 
     for (tile_col = 0; tile_col < tile_cols; tile_col++) {
       const int tile_idx = tile_row * tile_cols + tile_col;
       TileBufferEnc *const buf = &tile_buffers[tile_row][tile_col];
-#if CONFIG_PVQ || CONFIG_EC_ADAPT
-      TileDataEnc *this_tile = &cpi->tile_data[tile_idx];
-#endif
-      const TOKENEXTRA *tok = tok_buffers[tile_row][tile_col];
-      const TOKENEXTRA *tok_end = tok + cpi->tok_count[tile_row][tile_col];
       const int is_last_col = (tile_col == tile_cols - 1);
       const int is_last_tile = is_last_col && is_last_row;
 #if !CONFIG_TILE_GROUPS
@@ -4134,55 +4303,31 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
       }
       tile_count++;
 #endif
-      av1_tile_set_col(&tile_info, cm, tile_col);
-
-#if CONFIG_DEPENDENT_HORZTILES && CONFIG_TILE_GROUPS
-      av1_tile_set_tg_boundary(&tile_info, cm, tile_row, tile_col);
-#endif
-      buf->data = dst + total_size;
-
       // The last tile does not have a header.
-      if (!is_last_tile) total_size += 4;
+      if (!is_last_tile) total_size += tile_size_bytes;
 
-#if CONFIG_EC_ADAPT
-      // Initialise tile context from the frame context
-      this_tile->tctx = *cm->fc;
-      cpi->td.mb.e_mbd.tile_ctx = &this_tile->tctx;
-#endif
-#if CONFIG_PVQ
-      cpi->td.mb.pvq_q = &this_tile->pvq_q;
-      cpi->td.mb.daala_enc.state.adapt = &this_tile->tctx.pvq_context;
-#endif  // CONFIG_PVQ
-#if CONFIG_ANS
-      buf_ans_write_init(buf_ans, dst + total_size);
-      write_modes(cpi, &tile_info, buf_ans, &tok, tok_end);
-      assert(tok == tok_end);
-      aom_buf_ans_flush(buf_ans);
-      tile_size = buf_ans_write_end(buf_ans);
-#else
-      aom_start_encode(&mode_bc, dst + total_size);
-      write_modes(cpi, &tile_info, &mode_bc, &tok, tok_end);
-#if !CONFIG_LV_MAP
-      assert(tok == tok_end);
-#endif  // !CONFIG_LV_MAP
-      aom_stop_encode(&mode_bc);
-      tile_size = mode_bc.pos;
-#endif  // CONFIG_ANS
-#if CONFIG_PVQ
-      cpi->td.mb.pvq_q = NULL;
-#endif
+      // The tiles that did not fit in the buffer of their column are packed
+      // here.
+      if (pack_tiles_mt && buf->data != NULL) {
+        memcpy(dst + total_size, buf->data, buf->size);
+        buf->data = dst + total_size;
+      } else {
+        av1_pack_tile(cpi, &cpi->td, tile_row, tile_col, dst + total_size,
+                      NULL);
+      }
+      tile_size = (unsigned int)buf->size;
 
       assert(tile_size > 0);
 
 #if CONFIG_TILE_GROUPS
       curr_tg_data_size += tile_size + 4;
 #endif
-      buf->size = tile_size;
 
       if (!is_last_tile) {
         *max_tile_size = AOMMAX(*max_tile_size, tile_size);
         // size of this tile
-        mem_put_le32(buf->data, tile_size);
+        mem_put_varsize(buf->data - tile_size_bytes, tile_size_bytes,
+                        tile_size);
       }
 
       total_size += tile_size;
@@ -4198,16 +4343,20 @@ static uint32_t write_tiles(AV1_COMP *const cpi, uint8_t *const dst,
   // Remux if possible. TODO (Thomas Davies): do this for more than one tile
   // group
   if (have_tiles && tg_count == 1) {
-    int data_size = total_size - (uncompressed_hdr_size + comp_hdr_size);
-    data_size = remux_tiles(cm, dst + uncompressed_hdr_size + comp_hdr_size,
-                            data_size, *max_tile_size, *max_tile_col_size,
-                            &tile_size_bytes, &tile_col_size_bytes);
-    total_size = data_size + uncompressed_hdr_size + comp_hdr_size;
+    // The size fields of tiles packed in parallel may already be compact.
+    if (tile_size_bytes == 4) {
+      int data_size = total_size - (uncompressed_hdr_size + comp_hdr_size);
+      data_size = remux_tiles(cm, dst + uncompressed_hdr_size + comp_hdr_size,
+                              data_size, *max_tile_size, *max_tile_col_size,
+                              &tile_size_bytes, &tile_col_size_bytes);
+      total_size = data_size + uncompressed_hdr_size + comp_hdr_size;
+    }
     aom_wb_overwrite_literal(&tile_size_bytes_wb, tile_size_bytes - 1, 2);
   }
 
 #endif
 #endif  // CONFIG_EXT_TILE
+  av1_accumulate_pack_stats(cpi, &cpi->td);
   return (uint32_t)total_size;
 }
 
@@ -24,6 +24,16 @@ void write_sequence_header(SequenceHeader *seq_params);
 
 void av1_pack_bitstream(AV1_COMP *const cpi, uint8_t *dest, size_t *size);
 
+// Pack the modes and tokens of a tile into dst, and record where they are in
+// cpi->tile_buffers. If dst_end is not NULL, returns 0 if the tile does not
+// fit before it, which is only checked with the Daala entropy coder.
+int av1_pack_tile(AV1_COMP *const cpi, ThreadData *const td, int tile_row,
+                  int tile_col, uint8_t *const dst, uint8_t *const dst_end);
+
+// Add the statistics gathered by a thread while packing tiles to the ones of
+// the frame.
+void av1_accumulate_pack_stats(AV1_COMP *const cpi, const ThreadData *td);
+
 void av1_encode_token_init(void);
 
 static INLINE int av1_preserve_existing_gf(AV1_COMP *cpi) {
@@ -14,11 +14,10 @@
 #include <memory.h>
 #include <math.h>
 
+#include "./av1_rtcd.h"
+#include "aom_dsp/aom_dsp_common.h"
 #include "av1/encoder/corner_match.h"
 
-#define MATCH_SZ 13
-#define MATCH_SZ_BY2 ((MATCH_SZ - 1) / 2)
-#define MATCH_SZ_SQ (MATCH_SZ * MATCH_SZ)
 #define SEARCH_SZ 9
 #define SEARCH_SZ_BY2 ((SEARCH_SZ - 1) / 2)
 
@@ -46,9 +45,9 @@ static double compute_variance(unsigned char *im, int stride, int x, int y) {
    correlation/standard deviation are taken over MATCH_SZ by MATCH_SZ windows
    of each image, centered at (x1, y1) and (x2, y2) respectively.
 */
-static double compute_cross_correlation(unsigned char *im1, int stride1, int x1,
-                                        int y1, unsigned char *im2, int stride2,
-                                        int x2, int y2) {
+double compute_cross_correlation_c(unsigned char *im1, int stride1, int x1,
+                                   int y1, unsigned char *im2, int stride2,
+                                   int x2, int y2) {
   int v1, v2;
   int sum1 = 0;
   int sum2 = 0;
@@ -141,6 +140,62 @@ static void improve_correspondence(unsigned char *frm, unsigned char *ref,
   }
 }
 
+/* The eligible reference corners, sorted into square cells whose side is the
+   largest eligible distance, so that the candidate matches of a corner are
+   all in the 3x3 cells around it. The corners of each cell are in ascending
+   order.
+*/
+typedef struct {
+  int cell_size;
+  int cols, rows;
+  int *cell_start;
+  int *corner_index;
+} CornerGrid;
+
+static int grid_cell(const CornerGrid *grid, int x, int y) {
+  return (y / grid->cell_size) * grid->cols + x / grid->cell_size;
+}
+
+static int build_corner_grid(CornerGrid *grid, int *corners, int num_corners,
+                             int width, int height) {
+  const int thresh = (width < height ? height : width) >> 4;
+  int i, num_cells;
+  grid->cell_size = thresh > 0 ? thresh : 1;
+  grid->cols = width / grid->cell_size + 1;
+  grid->rows = height / grid->cell_size + 1;
+  num_cells = grid->cols * grid->rows;
+  grid->cell_start = (int *)calloc(num_cells + 1, sizeof(*grid->cell_start));
+  grid->corner_index =
+      (int *)malloc(AOMMAX(num_corners, 1) * sizeof(*grid->corner_index));
+  if (!grid->cell_start || !grid->corner_index) {
+    free(grid->cell_start);
+    free(grid->corner_index);
+    return 0;
+  }
+  // Count the corners of each cell, then place them with a counting sort.
+  for (i = 0; i < num_corners; ++i) {
+    const int x = corners[2 * i], y = corners[2 * i + 1];
+    if (!is_eligible_point(x, y, width, height)) continue;
+    grid->cell_start[grid_cell(grid, x, y) + 1]++;
+  }
+  for (i = 0; i < num_cells; ++i)
+    grid->cell_start[i + 1] += grid->cell_start[i];
+  for (i = 0; i < num_corners; ++i) {
+    const int x = corners[2 * i], y = corners[2 * i + 1];
+    if (!is_eligible_point(x, y, width, height)) continue;
+    grid->corner_index[grid->cell_start[grid_cell(grid, x, y)]++] = i;
+  }
+  // Placing the corners advanced each start to the start of the next cell.
+  for (i = num_cells; i > 0; --i) grid->cell_start[i] = grid->cell_start[i - 1];
+  grid->cell_start[0] = 0;
+  return 1;
+}
+
+static void free_corner_grid(CornerGrid *grid) {
+  free(grid->cell_start);
+  free(grid->corner_index);
+}
+
 int determine_correspondence(unsigned char *frm, int *frm_corners,
                              int num_frm_corners, unsigned char *ref,
                              int *ref_corners, int num_ref_corners, int width,
@@ -150,43 +205,54 @@ int determine_correspondence(unsigned char *frm, int *frm_corners,
   int i, j;
   Correspondence *correspondences = (Correspondence *)correspondence_pts;
   int num_correspondences = 0;
+  CornerGrid grid;
+  if (!build_corner_grid(&grid, ref_corners, num_ref_corners, width, height))
+    return 0;
   for (i = 0; i < num_frm_corners; ++i) {
+    const int x = frm_corners[2 * i], y = frm_corners[2 * i + 1];
     double best_match_ncc = 0.0;
     double template_norm;
     int best_match_j = -1;
-    if (!is_eligible_point(frm_corners[2 * i], frm_corners[2 * i + 1], width,
-                           height))
-      continue;
-    for (j = 0; j < num_ref_corners; ++j) {
-      double match_ncc;
-      if (!is_eligible_point(ref_corners[2 * j], ref_corners[2 * j + 1], width,
-                             height))
-        continue;
-      if (!is_eligible_distance(frm_corners[2 * i], frm_corners[2 * i + 1],
-                                ref_corners[2 * j], ref_corners[2 * j + 1],
-                                width, height))
-        continue;
-      match_ncc = compute_cross_correlation(
-          frm, frm_stride, frm_corners[2 * i], frm_corners[2 * i + 1], ref,
-          ref_stride, ref_corners[2 * j], ref_corners[2 * j + 1]);
-      if (match_ncc > best_match_ncc) {
-        best_match_ncc = match_ncc;
-        best_match_j = j;
+    int cell_x, cell_y, k;
+    if (!is_eligible_point(x, y, width, height)) continue;
+    for (cell_y = AOMMAX(y / grid.cell_size - 1, 0);
+         cell_y <= AOMMIN(y / grid.cell_size + 1, grid.rows - 1); ++cell_y) {
+      for (cell_x = AOMMAX(x / grid.cell_size - 1, 0);
+           cell_x <= AOMMIN(x / grid.cell_size + 1, grid.cols - 1); ++cell_x) {
+        const int cell = cell_y * grid.cols + cell_x;
+        for (k = grid.cell_start[cell]; k < grid.cell_start[cell + 1]; ++k) {
+          double match_ncc;
+          j = grid.corner_index[k];
+          if (!is_eligible_distance(x, y, ref_corners[2 * j],
+                                    ref_corners[2 * j + 1], width, height))
+            continue;
+          match_ncc = compute_cross_correlation(frm, frm_stride, x, y, ref,
+                                                ref_stride, ref_corners[2 * j],
+                                                ref_corners[2 * j + 1]);
+          // The cells are not visited in the order of the corners, so ties
+          // go to the first corner, as with a scan of the whole list.
+          if (match_ncc > best_match_ncc ||
+              (best_match_j >= 0 && match_ncc == best_match_ncc &&
+               j < best_match_j)) {
+            best_match_ncc = match_ncc;
+            best_match_j = j;
+          }
+        }
       }
     }
     // Note: We want to test if the best correlation is >= THRESHOLD_NCC,
     // but need to account for the normalization in compute_cross_correlation.
-    template_norm = compute_variance(frm, frm_stride, frm_corners[2 * i],
-                                     frm_corners[2 * i + 1]);
+    template_norm = compute_variance(frm, frm_stride, x, y);
     if (best_match_ncc > THRESHOLD_NCC * sqrt(template_norm)) {
-      correspondences[num_correspondences].x = frm_corners[2 * i];
-      correspondences[num_correspondences].y = frm_corners[2 * i + 1];
+      correspondences[num_correspondences].x = x;
+      correspondences[num_correspondences].y = y;
       correspondences[num_correspondences].rx = ref_corners[2 * best_match_j];
       correspondences[num_correspondences].ry =
           ref_corners[2 * best_match_j + 1];
       num_correspondences++;
     }
   }
+  free_corner_grid(&grid);
   improve_correspondence(frm, ref, width, height, frm_stride, ref_stride,
                          correspondences, num_correspondences);
   return num_correspondences;
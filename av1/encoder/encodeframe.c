@@ -4566,6 +4566,11 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
   MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   SPEED_FEATURES *const sf = &cpi->sf;
+  const int sb_row_in_tile =
+      (mi_row - tile_info->mi_row_start) >> cm->mib_size_log2;
+  const int sb_cols_in_tile =
+      (tile_info->mi_col_end - tile_info->mi_col_start + cm->mib_size - 1) >>
+      cm->mib_size_log2;
   int mi_col;
 #if CONFIG_EXT_PARTITION
   const int leaf_nodes = 256;
@@ -4586,7 +4591,7 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
   for (mi_col = tile_info->mi_col_start; mi_col < tile_info->mi_col_end;
        mi_col += cm->mib_size) {
     const struct segmentation *const seg = &cm->seg;
-    int dummy_rate;
+    int sb_rate;
     int64_t dummy_dist;
     RD_COST dummy_rdc;
 #if CONFIG_SUPERTX
@@ -4598,6 +4603,12 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
     const int idx_str = cm->mi_stride * mi_row + mi_col;
     MODE_INFO **mi = cm->mi_grid_visible + idx_str;
     PC_TREE *const pc_root = td->pc_root[cm->mib_size_log2 - MIN_MIB_SIZE_LOG2];
+    const int sb_col_in_tile =
+        (mi_col - tile_info->mi_col_start) >> cm->mib_size_log2;
+
+    // Wait for the top-right superblock of the row above to be encoded.
+    (*cpi->row_mt_sync_read_ptr)(&tile_data->row_mt_sync, sb_row_in_tile,
+                                 sb_col_in_tile);
 
     av1_update_boundary_info(cm, tile_info, mi_row, mi_col);
 
@@ -4657,7 +4668,7 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
       bsize = seg_skip ? cm->sb_size : sf->always_this_block_size;
       set_fixed_partitioning(cpi, tile_info, mi, mi_row, mi_col, bsize);
       rd_use_partition(cpi, td, tile_data, mi, tp, mi_row, mi_col, cm->sb_size,
-                       &dummy_rate, &dummy_dist,
+                       &sb_rate, &dummy_dist,
 #if CONFIG_SUPERTX
                        &dummy_rate_nocoef,
 #endif  // CONFIG_SUPERTX
@@ -4668,7 +4679,7 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
       bsize = get_rd_var_based_fixed_partition(cpi, x, mi_row, mi_col);
       set_fixed_partitioning(cpi, tile_info, mi, mi_row, mi_col, bsize);
       rd_use_partition(cpi, td, tile_data, mi, tp, mi_row, mi_col, cm->sb_size,
-                       &dummy_rate, &dummy_dist,
+                       &sb_rate, &dummy_dist,
 #if CONFIG_SUPERTX
                        &dummy_rate_nocoef,
 #endif  // CONFIG_SUPERTX
@@ -4676,7 +4687,7 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
     } else if (sf->partition_search_type == VAR_BASED_PARTITION) {
       choose_partitioning(cpi, td, tile_info, x, mi_row, mi_col);
       rd_use_partition(cpi, td, tile_data, mi, tp, mi_row, mi_col, cm->sb_size,
-                       &dummy_rate, &dummy_dist,
+                       &sb_rate, &dummy_dist,
 #if CONFIG_SUPERTX
                        &dummy_rate_nocoef,
 #endif  // CONFIG_SUPERTX
@@ -4694,7 +4705,12 @@ static void encode_rd_sb_row(AV1_COMP *cpi, ThreadData *td,
                         &dummy_rate_nocoef,
 #endif  // CONFIG_SUPERTX
                         INT64_MAX, pc_root);
+      sb_rate = dummy_rdc.rate;
     }
+    if (sb_rate < INT_MAX) td->rd_counts.sb_rate += sb_rate;
+
+    (*cpi->row_mt_sync_write_ptr)(&tile_data->row_mt_sync, sb_row_in_tile,
+                                  sb_col_in_tile, sb_cols_in_tile);
   }
 #if CONFIG_SUBFRAME_PROB_UPDATE
   if (cm->do_subframe_update &&
@@ -4817,7 +4833,10 @@ void av1_init_tile_data(AV1_COMP *cpi) {
   unsigned int tile_tok = 0;
 
   if (cpi->tile_data == NULL || cpi->allocated_tiles < tile_cols * tile_rows) {
-    if (cpi->tile_data != NULL) aom_free(cpi->tile_data);
+    if (cpi->tile_data != NULL) {
+      av1_row_mt_mem_dealloc(cpi);
+      aom_free(cpi->tile_data);
+    }
     CHECK_MEM_ERROR(cm, cpi->tile_data, aom_malloc(tile_cols * tile_rows *
                                                    sizeof(*cpi->tile_data)));
     cpi->allocated_tiles = tile_cols * tile_rows;
@@ -4833,6 +4852,7 @@ void av1_init_tile_data(AV1_COMP *cpi) {
             tile_data->mode_map[i][j] = j;
           }
         }
+        av1_zero(tile_data->row_mt_sync);
 #if CONFIG_PVQ
         // This will be dynamically increased as more pvq block is encoded.
         tile_data->pvq_q.buf_len = 1000;
@@ -4860,14 +4880,11 @@ void av1_init_tile_data(AV1_COMP *cpi) {
   }
 }
 
-void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
-                     int tile_col) {
+void av1_init_tile_encode(AV1_COMP *cpi, int tile_row, int tile_col) {
   AV1_COMMON *const cm = &cpi->common;
   TileDataEnc *const this_tile =
       &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
   const TileInfo *const tile_info = &this_tile->tile_info;
-  TOKENEXTRA *tok = cpi->tile_tok[tile_row][tile_col];
-  int mi_row;
 
 #if CONFIG_DEPENDENT_HORZTILES
 #if CONFIG_TILE_GROUPS
@@ -4882,9 +4899,26 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
   av1_zero_above_context(cm, tile_info->mi_col_start, tile_info->mi_col_end);
 #endif
 
-  // Set up pointers to per thread motion search counters.
   this_tile->m_search_count = 0;   // Count of motion search hits.
   this_tile->ex_search_count = 0;  // Exhaustive mesh search hits.
+
+#if CONFIG_EC_ADAPT
+  this_tile->tctx = *cm->fc;
+#endif  // CONFIG_EC_ADAPT
+}
+
+void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
+                     int tile_col) {
+  AV1_COMMON *const cm = &cpi->common;
+  TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  const TileInfo *const tile_info = &this_tile->tile_info;
+  TOKENEXTRA *tok = cpi->tile_tok[tile_row][tile_col];
+  int mi_row;
+
+  av1_init_tile_encode(cpi, tile_row, tile_col);
+
+  // Set up pointers to per thread motion search counters.
   td->mb.m_search_count_ptr = &this_tile->m_search_count;
   td->mb.ex_search_count_ptr = &this_tile->ex_search_count;
 
@@ -4965,7 +4999,6 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
 #endif  // #if CONFIG_PVQ
 
 #if CONFIG_EC_ADAPT
-  this_tile->tctx = *cm->fc;
   td->mb.e_mbd.tile_ctx = &this_tile->tctx;
 #endif  // #if CONFIG_EC_ADAPT
 
@@ -4997,6 +5030,52 @@ void av1_encode_tile(AV1_COMP *cpi, ThreadData *td, int tile_row,
 #endif
 }
 
+void av1_encode_sb_row(AV1_COMP *cpi, ThreadData *td, int tile_row,
+                       int tile_col, int mi_row) {
+  AV1_COMMON *const cm = &cpi->common;
+  TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  const TileInfo *const tile_info = &this_tile->tile_info;
+  TileDataEnc *const row_data = td->row_tile_data;
+  const int sb_row = (mi_row - tile_info->mi_row_start) >> cm->mib_size_log2;
+  TOKENEXTRA *const tok_start =
+      cpi->tile_tok[tile_row][tile_col] +
+      get_sb_row_token_offset(*tile_info, mi_row);
+  TOKENEXTRA *tok = tok_start;
+
+  // Every superblock row starts from the adaptive RD state the tile had at the
+  // start of the frame, so that the result does not depend on which thread
+  // encoded the previous rows. The row synchronization data is shared.
+  row_data->tile_info = this_tile->tile_info;
+  memcpy(row_data->thresh_freq_fact, this_tile->thresh_freq_fact,
+         sizeof(row_data->thresh_freq_fact));
+  memcpy(row_data->mode_map, this_tile->mode_map, sizeof(row_data->mode_map));
+  row_data->m_search_count = 0;
+  row_data->ex_search_count = 0;
+  row_data->row_mt_sync = this_tile->row_mt_sync;
+
+  td->mb.m_search_count_ptr = &row_data->m_search_count;
+  td->mb.ex_search_count_ptr = &row_data->ex_search_count;
+#if CONFIG_EC_ADAPT
+  td->mb.e_mbd.tile_ctx = &this_tile->tctx;
+#endif  // CONFIG_EC_ADAPT
+
+  encode_rd_sb_row(cpi, td, row_data, mi_row, &tok);
+
+  this_tile->row_mt_sync.tok_count[sb_row] = (unsigned int)(tok - tok_start);
+  assert(tok - cpi->tile_tok[tile_row][tile_col] <=
+         (int)allocated_tokens(*tile_info));
+
+  // The last row of the tile carries its state over to the next frame. All
+  // the other rows of the tile are done by now.
+  if (mi_row + cm->mib_size >= tile_info->mi_row_end) {
+    memcpy(this_tile->thresh_freq_fact, row_data->thresh_freq_fact,
+           sizeof(this_tile->thresh_freq_fact));
+    memcpy(this_tile->mode_map, row_data->mode_map,
+           sizeof(this_tile->mode_map));
+  }
+}
+
 static void encode_tiles(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   int tile_col, tile_row;
@@ -5090,6 +5169,22 @@ static int gm_get_params_cost(WarpedMotionParams *gm,
 }
 #endif  // CONFIG_GLOBAL_MOTION
 
+// Superblock rows of a tile can be encoded in parallel only when no state is
+// carried from the end of one row to the start of the next.
+static int use_row_mt(const AV1_COMP *cpi) {
+#if CONFIG_PVQ || CONFIG_SUBFRAME_PROB_UPDATE
+  (void)cpi;
+  return 0;
+#else
+#if CONFIG_DELTA_Q
+  // The delta q of a superblock is coded relative to the previous superblock
+  // in raster order.
+  if (cpi->common.delta_q_present_flag) return 0;
+#endif  // CONFIG_DELTA_Q
+  return cpi->oxcf.row_mt;
+#endif  // CONFIG_PVQ || CONFIG_SUBFRAME_PROB_UPDATE
+}
+
 static void encode_frame_internal(AV1_COMP *cpi) {
   ThreadData *const td = &cpi->td;
   MACROBLOCK *const x = &td->mb;
@@ -5110,6 +5205,7 @@ static void encode_frame_internal(AV1_COMP *cpi) {
   av1_zero(*td->counts);
   av1_zero(rdc->coef_counts);
   av1_zero(rdc->comp_pred_diff);
+  rdc->sb_rate = 0;
 
 #if CONFIG_GLOBAL_MOTION
   av1_zero(cpi->global_motion_used);
@@ -5302,7 +5398,12 @@ static void encode_frame_internal(AV1_COMP *cpi) {
     // TODO(geza.lore): The multi-threaded encoder is not safe with more than
     // 1 tile rows, as it uses the single above_context et al arrays from
     // cpi->common
-    if (AOMMIN(cpi->oxcf.max_threads, cm->tile_cols) > 1 && cm->tile_rows == 1)
+    cpi->row_mt_sync_read_ptr = av1_row_mt_sync_read_dummy;
+    cpi->row_mt_sync_write_ptr = av1_row_mt_sync_write_dummy;
+    if (use_row_mt(cpi))
+      av1_encode_tiles_row_mt(cpi);
+    else if (AOMMIN(cpi->oxcf.max_threads, cm->tile_cols) > 1 &&
+             cm->tile_rows == 1)
       av1_encode_tiles_mt(cpi);
     else
       encode_tiles(cpi);
@@ -37,8 +37,13 @@ void av1_setup_src_planes(struct macroblock *x,
 void av1_encode_frame(struct AV1_COMP *cpi);
 
 void av1_init_tile_data(struct AV1_COMP *cpi);
+void av1_init_tile_encode(struct AV1_COMP *cpi, int tile_row, int tile_col);
 void av1_encode_tile(struct AV1_COMP *cpi, struct ThreadData *td, int tile_row,
                      int tile_col);
+// Encode one superblock row of a tile. The tile must have been set up with
+// av1_init_tile_encode().
+void av1_encode_sb_row(struct AV1_COMP *cpi, struct ThreadData *td,
+                       int tile_row, int tile_col, int mi_row);
 
 void av1_set_variance_partition_thresholds(struct AV1_COMP *cpi, int q);
 
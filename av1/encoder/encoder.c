@@ -200,6 +200,8 @@ int av1_set_active_map(AV1_COMP *cpi, unsigned char *new_map_16x16, int rows,
                   : AM_SEGMENT_ID_INACTIVE;
         }
       }
+      for (r = 0; r < rows * cols; ++r)
+        cpi->active_map.mb_map[r] = new_map_16x16[r] != 0;
       cpi->active_map.enabled = 1;
     } else {
       cpi->active_map.enabled = 0;
@@ -420,7 +422,9 @@ void av1_initialize_enc(void) {
 
 static void dealloc_compressor_data(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
+#if CONFIG_LOOP_RESTORATION
   int i;
+#endif  // CONFIG_LOOP_RESTORATION
 
   aom_free(cpi->mbmi_ext_base);
   cpi->mbmi_ext_base = NULL;
@@ -439,9 +443,16 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
       }
   }
 #endif
+  av1_row_mt_mem_dealloc(cpi);
   aom_free(cpi->tile_data);
   cpi->tile_data = NULL;
 
+  av1_row_mt_sync_mem_dealloc(&cpi->fp_row_mt_sync);
+  aom_free(cpi->twopass.row_stats);
+  cpi->twopass.row_stats = NULL;
+  aom_free(cpi->twopass.mb_factors);
+  cpi->twopass.mb_factors = NULL;
+
   // Delete sementation map
   aom_free(cpi->segmentation_map);
   cpi->segmentation_map = NULL;
@@ -451,10 +462,8 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
 
   aom_free(cpi->active_map.map);
   cpi->active_map.map = NULL;
-
-  // Free up-sampled reference buffers.
-  for (i = 0; i < (REF_FRAMES + 1); i++)
-    aom_free_frame_buffer(&cpi->upsampled_ref_bufs[i].buf);
+  aom_free(cpi->active_map.mb_map);
+  cpi->active_map.mb_map = NULL;
 
   av1_free_ref_frame_buffers(cm->buffer_pool);
 #if CONFIG_LV_MAP
@@ -470,6 +479,7 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
   aom_free(cpi->extra_rstbuf);
   for (i = 0; i < MAX_MB_PLANE; ++i)
     av1_free_restoration_struct(&cpi->rst_search[i]);
+  av1_free_restoration_search_buffers(cpi);
 #endif  // CONFIG_LOOP_RESTORATION
   aom_free_frame_buffer(&cpi->scaled_source);
   aom_free_frame_buffer(&cpi->scaled_last_source);
@@ -478,9 +488,14 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
 
   aom_free(cpi->tile_tok[0][0]);
   cpi->tile_tok[0][0] = 0;
+  aom_free(cpi->tile_pack_buf);
+  cpi->tile_pack_buf = NULL;
+  cpi->tile_pack_buf_size = 0;
 
   av1_free_pc_tree(&cpi->td);
   av1_free_var_tree(&cpi->td);
+  aom_free(cpi->td.row_tile_data);
+  cpi->td.row_tile_data = NULL;
 
 #if CONFIG_PALETTE
   if (cpi->common.allow_screen_content_tools)
@@ -815,6 +830,15 @@ void av1_alloc_compressor_data(AV1_COMP *cpi) {
 #endif  // CONFIG_ANS
   }
 
+  if (cpi->oxcf.pass == 1) {
+    aom_free(cpi->twopass.row_stats);
+    CHECK_MEM_ERROR(cm, cpi->twopass.row_stats,
+                    aom_calloc(cm->mb_rows, sizeof(*cpi->twopass.row_stats)));
+    aom_free(cpi->twopass.mb_factors);
+    CHECK_MEM_ERROR(cm, cpi->twopass.mb_factors,
+                    aom_calloc(cm->MBs, sizeof(*cpi->twopass.mb_factors)));
+  }
+
   av1_setup_pc_tree(&cpi->common, &cpi->td);
 }
 
@@ -1962,11 +1986,19 @@ static void realloc_segmentation_maps(AV1_COMP *cpi) {
   aom_free(cpi->active_map.map);
   CHECK_MEM_ERROR(cm, cpi->active_map.map,
                   aom_calloc(cm->mi_rows * cm->mi_cols, 1));
+  // Mark all macroblocks active, like the map above, so they are copied into
+  // the lookahead until a map is set for the new size.
+  aom_free(cpi->active_map.mb_map);
+  CHECK_MEM_ERROR(cm, cpi->active_map.mb_map,
+                  aom_malloc(cm->mb_rows * cm->mb_cols));
+  memset(cpi->active_map.mb_map, 1, cm->mb_rows * cm->mb_cols);
 }
 
 void av1_change_config(struct AV1_COMP *cpi, const AV1EncoderConfig *oxcf) {
   AV1_COMMON *const cm = &cpi->common;
   RATE_CONTROL *const rc = &cpi->rc;
+  const int last_mb_rows = cm->mb_rows;
+  const int last_mb_cols = cm->mb_cols;
 
   if (cm->profile != oxcf->profile) cm->profile = oxcf->profile;
   cm->bit_depth = oxcf->bit_depth;
@@ -2058,6 +2090,11 @@ void av1_change_config(struct AV1_COMP *cpi, const AV1EncoderConfig *oxcf) {
   }
   update_frame_size(cpi);
 
+  // A map set for another size does not tell which macroblocks changed.
+  if (cpi->active_map.mb_map != NULL &&
+      (cm->mb_rows != last_mb_rows || cm->mb_cols != last_mb_cols))
+    memset(cpi->active_map.mb_map, 1, cm->mb_rows * cm->mb_cols);
+
   cpi->alt_ref_source = NULL;
   rc->is_src_frame_alt_ref = 0;
 
@@ -2136,15 +2173,6 @@ static void cal_nmvsadcosts_hp(int *mvsadcost[2]) {
   } while (++i <= MV_MAX);
 }
 
-static INLINE void init_upsampled_ref_frame_bufs(AV1_COMP *cpi) {
-  int i;
-
-  for (i = 0; i < (REF_FRAMES + 1); ++i) {
-    cpi->upsampled_ref_bufs[i].ref_count = 0;
-    cpi->upsampled_ref_idx[i] = INVALID_IDX;
-  }
-}
-
 AV1_COMP *av1_create_compressor(AV1EncoderConfig *oxcf,
                                 BufferPool *const pool) {
   unsigned int i;
@@ -2348,8 +2376,6 @@ AV1_COMP *av1_create_compressor(AV1EncoderConfig *oxcf,
   }
 #endif
 
-  init_upsampled_ref_frame_bufs(cpi);
-
   av1_set_speed_features_framesize_independent(cpi);
   av1_set_speed_features_framesize_dependent(cpi);
 
@@ -2645,6 +2671,10 @@ void av1_remove_compressor(AV1_COMP *cpi) {
 #endif
   }
 
+#if CONFIG_GLOBAL_MOTION
+  av1_lookahead_analysis_end(cpi);
+#endif  // CONFIG_GLOBAL_MOTION
+
   for (t = 0; t < cpi->num_workers; ++t) {
     AVxWorker *const worker = &cpi->workers[t];
     EncWorkerData *const thread_data = &cpi->tile_thr_data[t];
@@ -2661,13 +2691,19 @@ void av1_remove_compressor(AV1_COMP *cpi) {
       aom_free(thread_data->td->counts);
       av1_free_pc_tree(thread_data->td);
       av1_free_var_tree(thread_data->td);
+      aom_free(thread_data->td->row_tile_data);
       aom_free(thread_data->td);
     }
   }
   aom_free(cpi->tile_thr_data);
   aom_free(cpi->workers);
 
-  if (cpi->num_workers > 1) av1_loop_filter_dealloc(&cpi->lf_row_sync);
+  if (cpi->num_workers > 1) {
+    av1_loop_filter_dealloc(&cpi->lf_row_sync);
+#if CONFIG_LOOP_RESTORATION
+    av1_loop_restoration_dealloc(&cpi->lr_row_sync);
+#endif  // CONFIG_LOOP_RESTORATION
+  }
 
   dealloc_compressor_data(cpi);
 
@@ -2784,6 +2820,7 @@ int av1_set_reference_enc(AV1_COMP *cpi, AOM_REFFRAME ref_frame_flag,
   YV12_BUFFER_CONFIG *cfg = get_av1_ref_frame_buffer(cpi, ref_frame_flag);
   if (cfg) {
     aom_yv12_copy_frame(sd, cfg);
+    aom_invalidate_frame_buffer_cache(cfg);
     return 0;
   } else {
     return -1;
@@ -3100,52 +3137,6 @@ static int recode_loop_test(AV1_COMP *cpi, int high_limit, int low_limit, int q,
   return force_recode;
 }
 
-static INLINE int get_free_upsampled_ref_buf(EncRefCntBuffer *ubufs) {
-  int i;
-
-  for (i = 0; i < (REF_FRAMES + 1); i++) {
-    if (!ubufs[i].ref_count) {
-      return i;
-    }
-  }
-  return INVALID_IDX;
-}
-
-// Up-sample 1 reference frame.
-static INLINE int upsample_ref_frame(AV1_COMP *cpi,
-                                     const YV12_BUFFER_CONFIG *const ref) {
-  AV1_COMMON *const cm = &cpi->common;
-  EncRefCntBuffer *ubufs = cpi->upsampled_ref_bufs;
-  int new_uidx = get_free_upsampled_ref_buf(ubufs);
-
-  if (new_uidx == INVALID_IDX) {
-    return INVALID_IDX;
-  } else {
-    YV12_BUFFER_CONFIG *upsampled_ref = &ubufs[new_uidx].buf;
-
-    // Can allocate buffer for Y plane only.
-    if (upsampled_ref->buffer_alloc_sz < (ref->buffer_alloc_sz << 6))
-      if (aom_realloc_frame_buffer(upsampled_ref, (cm->width << 3),
-                                   (cm->height << 3), cm->subsampling_x,
-                                   cm->subsampling_y,
-#if CONFIG_AOM_HIGHBITDEPTH
-                                   cm->use_highbitdepth,
-#endif
-                                   (AOM_BORDER_IN_PIXELS << 3),
-                                   cm->byte_alignment, NULL, NULL, NULL))
-        aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
-                           "Failed to allocate up-sampled frame buffer");
-
-// Currently, only Y plane is up-sampled, U, V are not used.
-#if CONFIG_AOM_HIGHBITDEPTH
-    scale_and_extend_frame(ref, upsampled_ref, 1, (int)cm->bit_depth);
-#else
-    scale_and_extend_frame(ref, upsampled_ref, 1);
-#endif
-    return new_uidx;
-  }
-}
-
 #define DUMP_REF_FRAME_IMAGES 0
 
 #if DUMP_REF_FRAME_IMAGES == 1
@@ -3222,31 +3213,11 @@ static INLINE void shift_last_ref_frames(AV1_COMP *cpi) {
 void av1_update_reference_frames(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   BufferPool *const pool = cm->buffer_pool;
-  const int use_upsampled_ref = cpi->sf.use_upsampled_references;
-  int new_uidx = 0;
 
   // NOTE: Save the new show frame buffer index for --test-code=warn, i.e.,
   //       for the purpose to verify no mismatch between encoder and decoder.
   if (cm->show_frame) cpi->last_show_frame_buf_idx = cm->new_fb_idx;
 
-  if (use_upsampled_ref) {
-#if CONFIG_EXT_REFS
-    if (cm->show_existing_frame) {
-      new_uidx = cpi->upsampled_ref_idx[cpi->existing_fb_idx_to_show];
-      // TODO(zoeliu): Once following is confirmed, remove it.
-      assert(cpi->upsampled_ref_bufs[new_uidx].ref_count > 0);
-    } else {
-#endif  // CONFIG_EXT_REFS
-      // Up-sample the current encoded frame.
-      RefCntBuffer *bufs = pool->frame_bufs;
-      const YV12_BUFFER_CONFIG *const ref = &bufs[cm->new_fb_idx].buf;
-
-      new_uidx = upsample_ref_frame(cpi, ref);
-#if CONFIG_EXT_REFS
-      assert(new_uidx != INVALID_IDX);
-    }
-#endif  // CONFIG_EXT_REFS
-  }
   // At this point the new frame has been encoded.
   // If any buffer copy / swapping is signaled it should be done here.
   if (cm->frame_type == KEY_FRAME) {
@@ -3258,17 +3229,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
 #endif  // CONFIG_EXT_REFS
     ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[cpi->alt_fb_idx],
                cm->new_fb_idx);
-
-    if (use_upsampled_ref) {
-      uref_cnt_fb(cpi->upsampled_ref_bufs,
-                  &cpi->upsampled_ref_idx[cpi->gld_fb_idx], new_uidx);
-#if CONFIG_EXT_REFS
-      uref_cnt_fb(cpi->upsampled_ref_bufs,
-                  &cpi->upsampled_ref_idx[cpi->bwd_fb_idx], new_uidx);
-#endif  // CONFIG_EXT_REFS
-      uref_cnt_fb(cpi->upsampled_ref_bufs,
-                  &cpi->upsampled_ref_idx[cpi->alt_fb_idx], new_uidx);
-    }
   } else if (av1_preserve_existing_gf(cpi)) {
     // We have decided to preserve the previously existing golden frame as our
     // new ARF frame. However, in the short term in function
@@ -3282,9 +3242,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
 
     ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[cpi->alt_fb_idx],
                cm->new_fb_idx);
-    if (use_upsampled_ref)
-      uref_cnt_fb(cpi->upsampled_ref_bufs,
-                  &cpi->upsampled_ref_idx[cpi->alt_fb_idx], new_uidx);
 
     tmp = cpi->alt_fb_idx;
     cpi->alt_fb_idx = cpi->gld_fb_idx;
@@ -3346,9 +3303,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
       }
 #endif  // CONFIG_EXT_REFS
       ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[arf_idx], cm->new_fb_idx);
-      if (use_upsampled_ref)
-        uref_cnt_fb(cpi->upsampled_ref_bufs, &cpi->upsampled_ref_idx[arf_idx],
-                    new_uidx);
 
       memcpy(cpi->interp_filter_selected[ALTREF_FRAME + which_arf],
              cpi->interp_filter_selected[0],
@@ -3358,9 +3312,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
     if (cpi->refresh_golden_frame) {
       ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[cpi->gld_fb_idx],
                  cm->new_fb_idx);
-      if (use_upsampled_ref)
-        uref_cnt_fb(cpi->upsampled_ref_bufs,
-                    &cpi->upsampled_ref_idx[cpi->gld_fb_idx], new_uidx);
 
 #if !CONFIG_EXT_REFS
       if (!cpi->rc.is_src_frame_alt_ref)
@@ -3385,9 +3336,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
 
       ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[cpi->bwd_fb_idx],
                  cm->new_fb_idx);
-      if (use_upsampled_ref)
-        uref_cnt_fb(cpi->upsampled_ref_bufs,
-                    &cpi->upsampled_ref_idx[cpi->bwd_fb_idx], new_uidx);
 
       memcpy(cpi->interp_filter_selected[BWDREF_FRAME],
              cpi->interp_filter_selected[0],
@@ -3444,11 +3392,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
         ref_cnt_fb(pool->frame_bufs,
                    &cm->ref_frame_map[cpi->lst_fb_idxes[ref_frame]],
                    cm->new_fb_idx);
-
-        if (use_upsampled_ref)
-          uref_cnt_fb(cpi->upsampled_ref_bufs,
-                      &cpi->upsampled_ref_idx[cpi->lst_fb_idxes[ref_frame]],
-                      new_uidx);
       }
     } else {
       int tmp;
@@ -3457,12 +3400,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
                  &cm->ref_frame_map[cpi->lst_fb_idxes[LAST_REF_FRAMES - 1]],
                  cm->new_fb_idx);
 
-      if (use_upsampled_ref)
-        uref_cnt_fb(
-            cpi->upsampled_ref_bufs,
-            &cpi->upsampled_ref_idx[cpi->lst_fb_idxes[LAST_REF_FRAMES - 1]],
-            new_uidx);
-
       tmp = cpi->lst_fb_idxes[LAST_REF_FRAMES - 1];
 
       shift_last_ref_frames(cpi);
@@ -3478,9 +3415,6 @@ void av1_update_reference_frames(AV1_COMP *cpi) {
 #else
     ref_cnt_fb(pool->frame_bufs, &cm->ref_frame_map[cpi->lst_fb_idx],
                cm->new_fb_idx);
-    if (use_upsampled_ref)
-      uref_cnt_fb(cpi->upsampled_ref_bufs,
-                  &cpi->upsampled_ref_idx[cpi->lst_fb_idx], new_uidx);
     if (!cpi->rc.is_src_frame_alt_ref) {
       memcpy(cpi->interp_filter_selected[LAST_FRAME],
              cpi->interp_filter_selected[0],
@@ -3532,7 +3466,9 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
     cm->nb_cdef_strengths = 1;
   } else {
     // Find cm->dering_level, cm->clpf_strength_u and cm->clpf_strength_v
-    av1_cdef_search(cm->frame_to_show, cpi->Source, cm, xd);
+    av1_cdef_search(cm->frame_to_show, cpi->Source, cm, xd,
+                    cpi->sf.cdef_prune_strengths, cpi->workers,
+                    cpi->num_workers);
 
     // Apply the filter
     av1_cdef_frame(cm->frame_to_show, cm, xd);
@@ -3543,7 +3479,13 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
   if (cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
       cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
       cm->rst_info[2].frame_restoration_type != RESTORE_NONE) {
-    av1_loop_restoration_frame(cm->frame_to_show, cm, cm->rst_info, 7, 0, NULL);
+    if (cpi->num_workers > 1)
+      av1_loop_restoration_frame_mt(cm->frame_to_show, cm, cm->rst_info, 7, 0,
+                                    NULL, cpi->workers, cpi->num_workers,
+                                    &cpi->lr_row_sync);
+    else
+      av1_loop_restoration_frame(cm->frame_to_show, cm, cm->rst_info, 7, 0,
+                                 NULL);
   }
 #endif  // CONFIG_LOOP_RESTORATION
   aom_extend_frame_inner_borders(cm->frame_to_show);
@@ -3639,30 +3581,6 @@ void av1_scale_references(AV1_COMP *cpi) {
         }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
-        if (cpi->sf.use_upsampled_references &&
-            (force_scaling || new_fb_ptr->buf.y_crop_width != cm->width ||
-             new_fb_ptr->buf.y_crop_height != cm->height)) {
-          const int map_idx = get_ref_frame_map_idx(cpi, ref_frame);
-          EncRefCntBuffer *ubuf =
-              &cpi->upsampled_ref_bufs[cpi->upsampled_ref_idx[map_idx]];
-
-          if (aom_realloc_frame_buffer(&ubuf->buf, (cm->width << 3),
-                                       (cm->height << 3), cm->subsampling_x,
-                                       cm->subsampling_y,
-#if CONFIG_AOM_HIGHBITDEPTH
-                                       cm->use_highbitdepth,
-#endif
-                                       (AOM_BORDER_IN_PIXELS << 3),
-                                       cm->byte_alignment, NULL, NULL, NULL))
-            aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
-                               "Failed to allocate up-sampled frame buffer");
-#if CONFIG_AOM_HIGHBITDEPTH
-          scale_and_extend_frame(&new_fb_ptr->buf, &ubuf->buf, 1,
-                                 (int)cm->bit_depth);
-#else
-          scale_and_extend_frame(&new_fb_ptr->buf, &ubuf->buf, 1);
-#endif
-        }
       } else {
         const int buf_idx = get_ref_frame_buf_idx(cpi, ref_frame);
         RefCntBuffer *const buf = &pool->frame_bufs[buf_idx];
@@ -4000,26 +3918,9 @@ static void set_frame_size(AV1_COMP *cpi) {
   set_ref_ptrs(cm, xd, LAST_FRAME, LAST_FRAME);
 }
 
-static void reset_use_upsampled_references(AV1_COMP *cpi) {
-  MV_REFERENCE_FRAME ref_frame;
-
-  // reset up-sampled reference buffer structure.
-  init_upsampled_ref_frame_bufs(cpi);
-
-  for (ref_frame = LAST_FRAME; ref_frame <= ALTREF_FRAME; ++ref_frame) {
-    const YV12_BUFFER_CONFIG *const ref = get_ref_frame_buffer(cpi, ref_frame);
-    int new_uidx = upsample_ref_frame(cpi, ref);
-
-    // Update the up-sampled reference index.
-    cpi->upsampled_ref_idx[get_ref_frame_map_idx(cpi, ref_frame)] = new_uidx;
-    cpi->upsampled_ref_bufs[new_uidx].ref_count++;
-  }
-}
-
 static void encode_without_recode_loop(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   int q = 0, bottom_index = 0, top_index = 0;  // Dummy variables.
-  const int use_upsampled_ref = cpi->sf.use_upsampled_references;
 
   aom_clear_system_state();
 
@@ -4051,13 +3952,6 @@ static void encode_without_recode_loop(AV1_COMP *cpi) {
   set_size_independent_vars(cpi);
   set_size_dependent_vars(cpi, &q, &bottom_index, &top_index);
 
-  // cpi->sf.use_upsampled_references can be different from frame to frame.
-  // Every time when cpi->sf.use_upsampled_references is changed from 0 to 1.
-  // The reference frames for this frame have to be up-sampled before encoding.
-  if (!use_upsampled_ref && cpi->sf.use_upsampled_references &&
-      cm->frame_type != KEY_FRAME)
-    reset_use_upsampled_references(cpi);
-
   av1_set_quantizer(cm, q);
   av1_set_variance_partition_thresholds(cpi, q);
 
@@ -4098,6 +3992,12 @@ static void encode_without_recode_loop(AV1_COMP *cpi) {
   aom_clear_system_state();
 }
 
+// Whether a frame size estimate is within an eighth of a recode limit, and
+// could fall on the other side of it.
+static int is_size_near_limit(int estimate, int limit) {
+  return abs(estimate - limit) <= limit / 8;
+}
+
 static void encode_with_recode_loop(AV1_COMP *cpi, size_t *size,
                                     uint8_t *dest) {
   AV1_COMMON *const cm = &cpi->common;
@@ -4113,7 +4013,6 @@ static void encode_with_recode_loop(AV1_COMP *cpi, size_t *size,
   int frame_over_shoot_limit;
   int frame_under_shoot_limit;
   int q = 0, q_low = 0, q_high = 0;
-  const int use_upsampled_ref = cpi->sf.use_upsampled_references;
 
   set_size_independent_vars(cpi);
 
@@ -4125,15 +4024,6 @@ static void encode_with_recode_loop(AV1_COMP *cpi, size_t *size,
     if (loop_count == 0 || cpi->resize_pending != 0) {
       set_size_dependent_vars(cpi, &q, &bottom_index, &top_index);
 
-      // cpi->sf.use_upsampled_references can be different from frame to frame.
-      // Every time when cpi->sf.use_upsampled_references is changed from 0 to
-      // 1.
-      // The reference frames for this frame have to be up-sampled before
-      // encoding.
-      if (!use_upsampled_ref && cpi->sf.use_upsampled_references &&
-          cm->frame_type != KEY_FRAME)
-        reset_use_upsampled_references(cpi);
-
       // TODO(agrange) Scale cpi->max_mv_magnitude if frame-size has changed.
       set_mv_search_params(cpi);
 
@@ -4231,14 +4121,24 @@ static void encode_with_recode_loop(AV1_COMP *cpi, size_t *size,
 
     // Dummy pack of the bitstream using up to date stats to get an
     // accurate estimate of output frame size to determine if we need
-    // to recode.
+    // to recode, unless the rates of the RD search are deemed enough.
     if (cpi->sf.recode_loop >= ALLOW_RECODE_KFARFGF) {
-      save_coding_context(cpi);
+      const int estimate = av1_rc_estimate_frame_size(cpi);
 
-      av1_pack_bitstream(cpi, dest, size);
+      if (cpi->sf.recode_size == RECODE_SIZE_PACK ||
+          (cpi->sf.recode_size == RECODE_SIZE_ESTIMATE_NEAR_LIMITS &&
+           (is_size_near_limit(estimate, frame_under_shoot_limit) ||
+            is_size_near_limit(estimate, frame_over_shoot_limit)))) {
+        save_coding_context(cpi);
 
-      rc->projected_frame_size = (int)(*size) << 3;
-      restore_coding_context(cpi);
+        av1_pack_bitstream(cpi, dest, size);
+
+        rc->projected_frame_size = (int)(*size) << 3;
+        restore_coding_context(cpi);
+        av1_rc_update_size_estimate_factor(cpi, rc->projected_frame_size);
+      } else {
+        rc->projected_frame_size = estimate;
+      }
 
       if (frame_over_shoot_limit == 0) frame_over_shoot_limit = 1;
     }
@@ -4501,6 +4401,7 @@ YV12_BUFFER_CONFIG *av1_scale_if_required_fast(AV1_COMMON *cm,
     // For 2x2 scaling down.
     aom_scale_frame(unscaled, scaled, unscaled->y_buffer, 9, 2, 1, 2, 1, 0);
     aom_extend_frame_borders(scaled);
+    aom_invalidate_frame_buffer_cache(scaled);
     return scaled;
   } else {
     return unscaled;
@@ -4517,6 +4418,7 @@ YV12_BUFFER_CONFIG *av1_scale_if_required(AV1_COMMON *cm,
 #else
     scale_and_extend_frame_nonnormative(unscaled, scaled);
 #endif  // CONFIG_AOM_HIGHBITDEPTH
+    aom_invalidate_frame_buffer_cache(scaled);
     return scaled;
   } else {
     return unscaled;
@@ -4923,6 +4825,7 @@ static void encode_frame_to_data_rate(AV1_COMP *cpi, size_t *size,
 
   // Build the bitstream
   av1_pack_bitstream(cpi, dest, size);
+  av1_rc_update_size_estimate_factor(cpi, (int)(*size) << 3);
 
   if (skip_adapt) return;
 
@@ -5173,10 +5076,24 @@ static void check_initial_width(AV1_COMP *cpi,
   }
 }
 
+// Whether the image can be read in place, with room to extend its edges.
+static int can_lend_input(const AV1_COMP *cpi, const YV12_BUFFER_CONFIG *sd,
+                          const aom_image_t *img) {
+  const aom_zero_copy_input_t *const zero_copy = &cpi->zero_copy_input;
+  const int border = (int)zero_copy->border;
+  const int uv_border_x = border >> sd->subsampling_x;
+  return img != NULL && zero_copy->release_cb != NULL &&
+         zero_copy->border >= AOM_ENC_MIN_INPUT_BORDER &&
+         sd->y_stride >= sd->y_crop_width + 2 * border &&
+         sd->uv_stride >= sd->uv_crop_width + 2 * uv_border_x;
+}
+
 int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
-                          int64_t end_time) {
+                          int64_t end_time, aom_image_t *img) {
   AV1_COMMON *const cm = &cpi->common;
+  const aom_zero_copy_input_t *const zero_copy = &cpi->zero_copy_input;
+  const unsigned char *active_map = NULL;
   struct aom_usec_timer timer;
   int res = 0;
   const int subsampling_x = sd->subsampling_x;
@@ -5185,6 +5102,10 @@ int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
   const int use_highbitdepth = (sd->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
 #endif
 
+#if CONFIG_GLOBAL_MOTION
+  av1_lookahead_analysis_sync(cpi);
+#endif  // CONFIG_GLOBAL_MOTION
+
 #if CONFIG_AOM_HIGHBITDEPTH
   check_initial_width(cpi, use_highbitdepth, subsampling_x, subsampling_y);
 #else
@@ -5193,12 +5114,29 @@ int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
 
   aom_usec_timer_start(&timer);
 
-  if (av1_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
+  // The active map is taken to mark the macroblocks that changed since the
+  // previous frame, so only those are copied.
+  if (cpi->active_map.enabled && cm->mb_rows == (sd->y_crop_height + 15) >> 4 &&
+      cm->mb_cols == (sd->y_crop_width + 15) >> 4)
+    active_map = cpi->active_map.mb_map;
+
+  if (can_lend_input(cpi, sd, img)) {
+    if (av1_lookahead_push_lent(cpi->lookahead, sd, img, zero_copy,
+                                time_stamp, end_time, frame_flags)) {
+      zero_copy->release_cb(zero_copy->cb_priv, img);
+      res = -1;
+    }
+  } else {
+    if (av1_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
 #if CONFIG_AOM_HIGHBITDEPTH
-                         use_highbitdepth,
+                           use_highbitdepth,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-                         frame_flags))
-    res = -1;
+                           frame_flags, active_map))
+      res = -1;
+    // The frame was copied, or dropped, so the image can be returned now.
+    if (img != NULL && zero_copy->release_cb != NULL)
+      zero_copy->release_cb(zero_copy->cb_priv, img);
+  }
   aom_usec_timer_mark(&timer);
   cpi->time_receive_data += aom_usec_timer_elapsed(&timer);
 
@@ -5482,6 +5420,12 @@ int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
 
   aom_usec_timer_start(&cmptimer);
 
+#if CONFIG_GLOBAL_MOTION
+  // The background analysis must be done before the queue is popped.
+  av1_lookahead_analysis_sync(cpi);
+  cpi->source_entry = NULL;
+#endif  // CONFIG_GLOBAL_MOTION
+
   av1_set_high_precision_mv(cpi, ALTREF_HIGH_PRECISION_MV);
 
   // Is multi-arf enabled.
@@ -5589,6 +5533,7 @@ int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
         // Produce the filtered ARF frame.
         av1_temporal_filter(cpi, arf_src_index);
         aom_extend_frame_borders(&cpi->alt_ref_buffer);
+        aom_invalidate_frame_buffer_cache(&cpi->alt_ref_buffer);
         force_src_buffer = &cpi->alt_ref_buffer;
       }
 
@@ -5643,6 +5588,9 @@ int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
   if (source) {
     cpi->un_scaled_source = cpi->Source =
         force_src_buffer ? force_src_buffer : &source->img;
+#if CONFIG_GLOBAL_MOTION
+    cpi->source_entry = source;
+#endif  // CONFIG_GLOBAL_MOTION
 
     cpi->unscaled_last_source = last_source != NULL ? &last_source->img : NULL;
 
@@ -5734,6 +5682,11 @@ int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
   }
 #endif
 
+#if CONFIG_GLOBAL_MOTION
+  // Analyze the next source frames while this one is encoded.
+  av1_lookahead_analysis_launch(cpi);
+#endif  // CONFIG_GLOBAL_MOTION
+
 #if CONFIG_XIPHRC
   if (oxcf->pass == 1) {
     size_t tmp;
@@ -248,6 +248,8 @@ typedef struct AV1EncoderConfig {
 #endif  // CONFIG_LOOPFILTERING_ACROSS_TILES
 
   int max_threads;
+  // Encode the superblock rows of a tile in parallel (wavefront order).
+  int row_mt;
 
   aom_fixed_buf_t two_pass_stats_in;
   struct aom_codec_pkt_list *output_pkt_list;
@@ -279,6 +281,22 @@ static INLINE int is_lossless_requested(const AV1EncoderConfig *cfg) {
 }
 
 // TODO(jingning) All spatially adaptive variables should go to TileDataEnc.
+// Superblock row synchronization for the row-based multi-threaded encoder.
+typedef struct AV1RowMTSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Allocate memory to store the index of the last encoded superblock in
+  // each row of the tile.
+  int *cur_col;
+  // Number of tokens emitted by each superblock row of the tile.
+  unsigned int *tok_count;
+  // A row is signalled every sync_range encoded superblocks.
+  int sync_range;
+  int rows;
+} AV1RowMTSync;
+
 typedef struct TileDataEnc {
   TileInfo tile_info;
   int thresh_freq_fact[BLOCK_SIZES][MAX_MODES];
@@ -291,11 +309,14 @@ typedef struct TileDataEnc {
 #if CONFIG_EC_ADAPT
   FRAME_CONTEXT tctx;
 #endif
+  AV1RowMTSync row_mt_sync;
 } TileDataEnc;
 
 typedef struct RD_COUNTS {
   av1_coeff_count coef_counts[TX_SIZES][PLANE_TYPES];
   int64_t comp_pred_diff[REFERENCE_MODES];
+  // Sum of the rates of the coded superblocks found by the RD search.
+  int64_t sb_rate;
 } RD_COUNTS;
 
 typedef struct ThreadData {
@@ -309,6 +330,15 @@ typedef struct ThreadData {
 
   VAR_TREE *var_tree;
   VAR_TREE *var_root[MAX_MIB_SIZE_LOG2 - MIN_MIB_SIZE_LOG2 + 1];
+
+  // Private copy of the adaptive RD state of the tile, used when encoding
+  // one superblock row at a time with the row-based multi-threaded encoder.
+  TileDataEnc *row_tile_data;
+
+  // Statistics gathered while packing tiles, added to the ones in AV1_COMP
+  // once the whole frame is packed.
+  int interp_filter_selected[SWITCHABLE];
+  unsigned int max_mv_magnitude;
 } ThreadData;
 
 struct EncWorkerData;
@@ -317,6 +347,7 @@ typedef struct ActiveMap {
   int enabled;
   int update;
   unsigned char *map;
+  unsigned char *mb_map;  // The map as set, with a flag per macroblock
 } ActiveMap;
 
 #define NUM_STAT_TYPES 4  // types of stats: Y, U, V and ALL
@@ -328,10 +359,19 @@ typedef struct IMAGE_STAT {
 
 #undef NUM_STAT_TYPES
 
+#if CONFIG_LOOP_RESTORATION
+// Buffers of a thread of the loop restoration search, which searches the
+// restoration tiles start, start + number of threads, ...
 typedef struct {
-  int ref_count;
-  YV12_BUFFER_CONFIG buf;
-} EncRefCntBuffer;
+  int start;
+  // Frame the tiles are restored to, and scratch buffer. The first thread
+  // uses trial_frame_rst and the scratch buffer of the frame, the others
+  // their own frame_buf and tmpbuf.
+  YV12_BUFFER_CONFIG *dst_frame;
+  int32_t *tmpbuf;
+  YV12_BUFFER_CONFIG frame_buf;
+} RestSearchThreadData;
+#endif  // CONFIG_LOOP_RESTORATION
 
 #if CONFIG_SUBFRAME_PROB_UPDATE
 typedef struct SUBFRAME_STATS {
@@ -364,6 +404,7 @@ typedef struct AV1_COMP {
   AV1EncoderConfig oxcf;
   struct lookahead_ctx *lookahead;
   struct lookahead_entry *alt_ref_source;
+  aom_zero_copy_input_t zero_copy_input;
 
   YV12_BUFFER_CONFIG *Source;
   YV12_BUFFER_CONFIG *Last_Source;  // NULL for first frame and alt_ref frames
@@ -372,13 +413,6 @@ typedef struct AV1_COMP {
   YV12_BUFFER_CONFIG *unscaled_last_source;
   YV12_BUFFER_CONFIG scaled_last_source;
 
-  // Up-sampled reference buffers
-  // NOTE(zoeliu): It is needed to allocate sufficient space to the up-sampled
-  // reference buffers, which should include the up-sampled version of all the
-  // possibly stored references plus the currently coded frame itself.
-  EncRefCntBuffer upsampled_ref_bufs[REF_FRAMES + 1];
-  int upsampled_ref_idx[REF_FRAMES + 1];
-
   // For a still frame, this flag is set to 1 to skip partition search.
   int partition_search_skippable_frame;
 
@@ -610,6 +644,9 @@ typedef struct AV1_COMP {
   unsigned int tok_count[MAX_TILE_ROWS][MAX_TILE_COLS];
 
   TileBufferEnc tile_buffers[MAX_TILE_ROWS][MAX_TILE_COLS];
+  // Tiles packed in parallel are written here before being concatenated.
+  uint8_t *tile_pack_buf;
+  size_t tile_pack_buf_size;
 
   int resize_pending;
   int resize_state;
@@ -638,6 +675,24 @@ typedef struct AV1_COMP {
   AVxWorker *workers;
   struct EncWorkerData *tile_thr_data;
   AV1LfSync lf_row_sync;
+#if CONFIG_LOOP_RESTORATION
+  AV1LrSync lr_row_sync;
+  RestSearchThreadData *rst_search_thr_data;
+  int num_rst_search_threads;
+#endif  // CONFIG_LOOP_RESTORATION
+  void (*row_mt_sync_read_ptr)(AV1RowMTSync *const, int, int);
+  void (*row_mt_sync_write_ptr)(AV1RowMTSync *const, int, int, const int);
+  // Synchronization of the macroblock rows analyzed by the first pass.
+  AV1RowMTSync fp_row_mt_sync;
+#if CONFIG_GLOBAL_MOTION
+  // Lookahead entry of the source frame being encoded.
+  struct lookahead_entry *source_entry;
+  // Analysis of the following source frames of the lookahead, run in the
+  // background while the current frame is encoded.
+  AVxWorker lookahead_worker;
+  int lookahead_worker_created;
+  struct lookahead_analysis lookahead_analysis;
+#endif  // CONFIG_GLOBAL_MOTION
 #if CONFIG_SUBFRAME_PROB_UPDATE
   SUBFRAME_STATS subframe_stats;
   // TODO(yaowu): minimize the size of count buffers
@@ -675,11 +730,13 @@ void av1_remove_compressor(AV1_COMP *cpi);
 
 void av1_change_config(AV1_COMP *cpi, const AV1EncoderConfig *oxcf);
 
-// receive a frames worth of data. caller can assume that a copy of this
-// frame is made and not just a copy of the pointer..
+// receive a frames worth of data. unless a release callback is set in
+// zero_copy_input, caller can assume that a copy of this frame is made and
+// not just a copy of the pointer.. otherwise img is returned through the
+// callback once the frame is no longer read.
 int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
-                          int64_t end_time_stamp);
+                          int64_t end_time_stamp, aom_image_t *img);
 
 int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
                             size_t *size, uint8_t *dest, int64_t *time_stamp,
@@ -754,14 +811,6 @@ static INLINE YV12_BUFFER_CONFIG *get_ref_frame_buffer(
                                 : NULL;
 }
 
-static INLINE const YV12_BUFFER_CONFIG *get_upsampled_ref(
-    const AV1_COMP *cpi, const MV_REFERENCE_FRAME ref_frame) {
-  // Use up-sampled reference frames.
-  const int buf_idx =
-      cpi->upsampled_ref_idx[get_ref_frame_map_idx(cpi, ref_frame)];
-  return &cpi->upsampled_ref_bufs[buf_idx].buf;
-}
-
 #if CONFIG_EXT_REFS
 static INLINE int enc_is_ref_frame_buf(AV1_COMP *cpi, RefCntBuffer *frame_buf) {
   MV_REFERENCE_FRAME ref_frame;
@@ -777,9 +826,9 @@ static INLINE int enc_is_ref_frame_buf(AV1_COMP *cpi, RefCntBuffer *frame_buf) {
 
 static INLINE unsigned int get_token_alloc(int mb_rows, int mb_cols) {
   // We assume 3 planes all at full resolution. We assume up to 1 token per
-  // pixel, and then allow a head room of 1 EOSB token per 4x4 block per plane,
-  // plus EOSB_TOKEN per plane.
-  return mb_rows * mb_cols * (16 * 16 + 17) * 3;
+  // pixel, taking up to TOKEN_ENTRIES_PER_COEFF entries, and then allow a head
+  // room of 1 EOSB token per 4x4 block per plane, plus EOSB_TOKEN per plane.
+  return mb_rows * mb_cols * (16 * 16 * TOKEN_ENTRIES_PER_COEFF + 17) * 3;
 }
 
 // Get the allocated token size for a tile. It does the same calculation as in
@@ -796,6 +845,20 @@ static INLINE unsigned int allocated_tokens(TileInfo tile) {
   return get_token_alloc(tile_mb_rows, tile_mb_cols);
 }
 
+// Get the offset of the tokens of the superblock row starting at mi_row in the
+// token buffer of a tile, when each row is given its own share of the buffer.
+static INLINE unsigned int get_sb_row_token_offset(TileInfo tile, int mi_row) {
+#if CONFIG_CB4X4
+  int tile_mb_rows = (mi_row - tile.mi_row_start + 2) >> 2;
+  int tile_mb_cols = (tile.mi_col_end - tile.mi_col_start + 2) >> 2;
+#else
+  int tile_mb_rows = (mi_row - tile.mi_row_start + 1) >> 1;
+  int tile_mb_cols = (tile.mi_col_end - tile.mi_col_start + 1) >> 1;
+#endif
+
+  return get_token_alloc(tile_mb_rows, tile_mb_cols);
+}
+
 void av1_alloc_compressor_data(AV1_COMP *cpi);
 
 void av1_scale_references(AV1_COMP *cpi);
@@ -853,18 +916,6 @@ void av1_new_framerate(AV1_COMP *cpi, double framerate);
 
 #define LAYER_IDS_TO_IDX(sl, tl, num_tl) ((sl) * (num_tl) + (tl))
 
-// Update up-sampled reference frame index.
-static INLINE void uref_cnt_fb(EncRefCntBuffer *ubufs, int *uidx,
-                               int new_uidx) {
-  const int ref_index = *uidx;
-
-  if (ref_index >= 0 && ubufs[ref_index].ref_count > 0)
-    ubufs[ref_index].ref_count--;
-
-  *uidx = new_uidx;
-  ubufs[new_uidx].ref_count++;
-}
-
 #ifdef __cplusplus
 }  // extern "C"
 #endif
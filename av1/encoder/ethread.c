@@ -9,9 +9,12 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include "av1/encoder/bitstream.h"
 #include "av1/encoder/encodeframe.h"
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/ethread.h"
+#include "av1/encoder/firstpass.h"
+#include "av1/encoder/temporal_filter.h"
 #include "aom_dsp/aom_dsp_common.h"
 
 static void accumulate_rd_opt(ThreadData *td, ThreadData *td_t) {
@@ -20,6 +23,8 @@ static void accumulate_rd_opt(ThreadData *td, ThreadData *td_t) {
   for (i = 0; i < REFERENCE_MODES; i++)
     td->rd_counts.comp_pred_diff[i] += td_t->rd_counts.comp_pred_diff[i];
 
+  td->rd_counts.sb_rate += td_t->rd_counts.sb_rate;
+
   for (i = 0; i < TX_SIZES; i++)
     for (j = 0; j < PLANE_TYPES; j++)
       for (k = 0; k < REF_TYPES; k++)
@@ -50,69 +55,68 @@ static int enc_worker_hook(EncWorkerData *const thread_data, void *unused) {
   return 0;
 }
 
-void av1_encode_tiles_mt(AV1_COMP *cpi) {
+static void create_enc_workers(AV1_COMP *cpi, int num_workers) {
   AV1_COMMON *const cm = &cpi->common;
-  const int tile_cols = cm->tile_cols;
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
-  const int num_workers = AOMMIN(cpi->oxcf.max_threads, tile_cols);
   int i;
 
-  av1_init_tile_data(cpi);
+  CHECK_MEM_ERROR(cm, cpi->workers,
+                  aom_malloc(num_workers * sizeof(*cpi->workers)));
 
-  // Only run once to create threads and allocate thread data.
-  if (cpi->num_workers == 0) {
-    CHECK_MEM_ERROR(cm, cpi->workers,
-                    aom_malloc(num_workers * sizeof(*cpi->workers)));
-
-    CHECK_MEM_ERROR(cm, cpi->tile_thr_data,
-                    aom_calloc(num_workers, sizeof(*cpi->tile_thr_data)));
-
-    for (i = 0; i < num_workers; i++) {
-      AVxWorker *const worker = &cpi->workers[i];
-      EncWorkerData *const thread_data = &cpi->tile_thr_data[i];
-
-      ++cpi->num_workers;
-      winterface->init(worker);
-
-      thread_data->cpi = cpi;
-
-      if (i < num_workers - 1) {
-        // Allocate thread data.
-        CHECK_MEM_ERROR(cm, thread_data->td,
-                        aom_memalign(32, sizeof(*thread_data->td)));
-        av1_zero(*thread_data->td);
-
-        // Set up pc_tree.
-        thread_data->td->leaf_tree = NULL;
-        thread_data->td->pc_tree = NULL;
-        av1_setup_pc_tree(cm, thread_data->td);
-
-        // Set up variance tree if needed.
-        if (cpi->sf.partition_search_type == VAR_BASED_PARTITION)
-          av1_setup_var_tree(cm, thread_data->td);
-
-        // Allocate frame counters in thread data.
-        CHECK_MEM_ERROR(cm, thread_data->td->counts,
-                        aom_calloc(1, sizeof(*thread_data->td->counts)));
-
-        // Create threads
-        if (!winterface->reset(worker))
-          aom_internal_error(&cm->error, AOM_CODEC_ERROR,
-                             "Tile encoder thread creation failed");
-      } else {
-        // Main thread acts as a worker and uses the thread data in cpi.
-        thread_data->td = &cpi->td;
-      }
+  CHECK_MEM_ERROR(cm, cpi->tile_thr_data,
+                  aom_calloc(num_workers, sizeof(*cpi->tile_thr_data)));
 
-      winterface->sync(worker);
+  for (i = 0; i < num_workers; i++) {
+    AVxWorker *const worker = &cpi->workers[i];
+    EncWorkerData *const thread_data = &cpi->tile_thr_data[i];
+
+    ++cpi->num_workers;
+    winterface->init(worker);
+
+    thread_data->cpi = cpi;
+
+    if (i < num_workers - 1) {
+      // Allocate thread data.
+      CHECK_MEM_ERROR(cm, thread_data->td,
+                      aom_memalign(32, sizeof(*thread_data->td)));
+      av1_zero(*thread_data->td);
+
+      // Set up pc_tree.
+      thread_data->td->leaf_tree = NULL;
+      thread_data->td->pc_tree = NULL;
+      av1_setup_pc_tree(cm, thread_data->td);
+
+      // Set up variance tree if needed.
+      if (cpi->sf.partition_search_type == VAR_BASED_PARTITION)
+        av1_setup_var_tree(cm, thread_data->td);
+
+      // Allocate frame counters in thread data.
+      CHECK_MEM_ERROR(cm, thread_data->td->counts,
+                      aom_calloc(1, sizeof(*thread_data->td->counts)));
+
+      // Create threads
+      if (!winterface->reset(worker))
+        aom_internal_error(&cm->error, AOM_CODEC_ERROR,
+                           "Tile encoder thread creation failed");
+    } else {
+      // Main thread acts as a worker and uses the thread data in cpi.
+      thread_data->td = &cpi->td;
     }
+
+    winterface->sync(worker);
   }
+}
+
+static void prepare_enc_workers(AV1_COMP *cpi, AVxWorkerHook hook,
+                                int num_workers) {
+  AV1_COMMON *const cm = &cpi->common;
+  int i;
 
   for (i = 0; i < num_workers; i++) {
     AVxWorker *const worker = &cpi->workers[i];
     EncWorkerData *thread_data;
 
-    worker->hook = (AVxWorkerHook)enc_worker_hook;
+    worker->hook = hook;
     worker->data1 = &cpi->tile_thr_data[i];
     worker->data2 = NULL;
     thread_data = (EncWorkerData *)worker->data1;
@@ -134,8 +138,15 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
       CHECK_MEM_ERROR(cm, x->palette_buffer,
                       aom_memalign(16, sizeof(*x->palette_buffer)));
     }
+#else
+    (void)cm;
 #endif  // CONFIG_PALETTE
   }
+}
+
+static void launch_enc_workers(AV1_COMP *cpi, int num_workers) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
 
   // Encode a frame
   for (i = 0; i < num_workers; i++) {
@@ -156,6 +167,11 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
     AVxWorker *const worker = &cpi->workers[i];
     winterface->sync(worker);
   }
+}
+
+static void accumulate_enc_worker_counts(AV1_COMP *cpi, int num_workers) {
+  AV1_COMMON *const cm = &cpi->common;
+  int i;
 
   for (i = 0; i < num_workers; i++) {
     AVxWorker *const worker = &cpi->workers[i];
@@ -168,3 +184,493 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
     }
   }
 }
+
+void av1_encode_tiles_mt(AV1_COMP *cpi) {
+  av1_init_tile_data(cpi);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  // The worker pool is shared with the other multi-threaded stages, so it may
+  // be larger than the number of tiles. Extra workers find no tiles.
+  prepare_enc_workers(cpi, (AVxWorkerHook)enc_worker_hook, cpi->num_workers);
+  launch_enc_workers(cpi, cpi->num_workers);
+  accumulate_enc_worker_counts(cpi, cpi->num_workers);
+}
+
+// The part of cpi->tile_pack_buf given to each mode info column: twice the
+// size of the raw pixels, which is also the room left for a frame by aomenc.
+static size_t tile_pack_buf_mi_col_size(const AV1_COMMON *cm) {
+  // Bytes for 4 pixels of all the planes.
+  size_t size = 4 + 2 * (4 >> (cm->subsampling_x + cm->subsampling_y));
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth) size *= 2;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  return 2 * size * cm->mi_rows * (MI_SIZE * MI_SIZE / 4);
+}
+
+static int pack_tiles_worker_hook(EncWorkerData *const thread_data,
+                                  void *unused) {
+  AV1_COMP *const cpi = thread_data->cpi;
+  const AV1_COMMON *const cm = &cpi->common;
+  const size_t mi_col_size = tile_pack_buf_mi_col_size(cm);
+  int tile_row, tile_col;
+
+  (void)unused;
+
+  // The tiles of a column share the above context arrays, so they are packed
+  // one after the other.
+  for (tile_col = thread_data->start; tile_col < cm->tile_cols;
+       tile_col += cpi->num_workers) {
+    const TileInfo *const tile_info = &cpi->tile_data[tile_col].tile_info;
+    uint8_t *dst = cpi->tile_pack_buf + tile_info->mi_col_start * mi_col_size;
+    uint8_t *const dst_end =
+        cpi->tile_pack_buf + tile_info->mi_col_end * mi_col_size;
+
+    for (tile_row = 0; tile_row < cm->tile_rows; ++tile_row) {
+      ThreadData *const td = thread_data->td;
+      int interp_filter_selected[SWITCHABLE];
+
+      memcpy(interp_filter_selected, td->interp_filter_selected,
+             sizeof(interp_filter_selected));
+      if (!av1_pack_tile(cpi, td, tile_row, tile_col, dst, dst_end)) {
+        // Leave this tile and the ones below to the serial packer, which
+        // counts their statistics again.
+        memcpy(td->interp_filter_selected, interp_filter_selected,
+               sizeof(interp_filter_selected));
+        for (; tile_row < cm->tile_rows; ++tile_row)
+          cpi->tile_buffers[tile_row][tile_col].data = NULL;
+        break;
+      }
+      dst += cpi->tile_buffers[tile_row][tile_col].size;
+    }
+  }
+
+  return 0;
+}
+
+int av1_pack_tiles_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const size_t size = tile_pack_buf_mi_col_size(cm) * cm->mi_cols;
+  int i, tile_col;
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  if (cpi->tile_pack_buf_size < size) {
+    aom_free(cpi->tile_pack_buf);
+    CHECK_MEM_ERROR(cm, cpi->tile_pack_buf, (uint8_t *)aom_malloc(size));
+    cpi->tile_pack_buf_size = size;
+  }
+
+  for (i = 0; i < cpi->num_workers; i++) {
+    AVxWorker *const worker = &cpi->workers[i];
+    ThreadData *const td = cpi->tile_thr_data[i].td;
+
+    worker->hook = (AVxWorkerHook)pack_tiles_worker_hook;
+    worker->data1 = &cpi->tile_thr_data[i];
+    worker->data2 = NULL;
+
+    // The main thread accumulates its statistics in cpi->td itself.
+    if (td != &cpi->td) {
+      td->mb.e_mbd = cpi->td.mb.e_mbd;
+      av1_zero(td->interp_filter_selected);
+      td->max_mv_magnitude = 0;
+    }
+  }
+
+  launch_enc_workers(cpi, cpi->num_workers);
+
+  for (i = 0; i < cpi->num_workers - 1; i++)
+    av1_accumulate_pack_stats(cpi, cpi->tile_thr_data[i].td);
+
+  // A column is only left unfinished from its first tile that did not fit.
+  for (tile_col = 0; tile_col < cm->tile_cols; tile_col++) {
+    if (cpi->tile_buffers[cm->tile_rows - 1][tile_col].data == NULL) return 0;
+  }
+  return 1;
+}
+
+static int enc_row_mt_worker_hook(EncWorkerData *const thread_data,
+                                  void *unused) {
+  AV1_COMP *const cpi = thread_data->cpi;
+  const AV1_COMMON *const cm = &cpi->common;
+  const int tile_cols = cm->tile_cols;
+  const int tile_row = thread_data->tile_row;
+  // All the tiles of a tile row have the same superblock rows.
+  const TileInfo *const tile_info =
+      &cpi->tile_data[tile_row * tile_cols].tile_info;
+  const int sb_rows = (tile_info->mi_row_end - tile_info->mi_row_start +
+                       cm->mib_size - 1) >>
+                      cm->mib_size_log2;
+  int job;
+
+  (void)unused;
+
+  // Jobs are ordered so that the superblock row above a row of the same tile
+  // always comes first. Since each worker takes its jobs in increasing order,
+  // the oldest unfinished job can always make progress.
+  for (job = thread_data->start; job < sb_rows * tile_cols;
+       job += cpi->num_workers) {
+    const int sb_row = job / tile_cols;
+    const int tile_col = job % tile_cols;
+    const int mi_row = tile_info->mi_row_start + (sb_row << cm->mib_size_log2);
+
+    av1_encode_sb_row(cpi, thread_data->td, tile_row, tile_col, mi_row);
+  }
+
+  return 0;
+}
+
+// Move the tokens of each superblock row of a tile right after the ones of the
+// row above, so that the tile can be packed as if it was encoded in one pass.
+static void merge_sb_row_tokens(AV1_COMP *cpi, int tile_row, int tile_col) {
+  const AV1_COMMON *const cm = &cpi->common;
+  const TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  const TileInfo *const tile_info = &this_tile->tile_info;
+  TOKENEXTRA *const tile_tok = cpi->tile_tok[tile_row][tile_col];
+  TOKENEXTRA *tok = tile_tok;
+  int mi_row, sb_row;
+
+  for (mi_row = tile_info->mi_row_start, sb_row = 0;
+       mi_row < tile_info->mi_row_end; mi_row += cm->mib_size, ++sb_row) {
+    const TOKENEXTRA *const row_tok =
+        tile_tok + get_sb_row_token_offset(*tile_info, mi_row);
+    const unsigned int count = this_tile->row_mt_sync.tok_count[sb_row];
+
+    if (tok != row_tok) memmove(tok, row_tok, count * sizeof(*tok));
+    tok += count;
+  }
+
+  cpi->tok_count[tile_row][tile_col] = (unsigned int)(tok - tile_tok);
+}
+
+void av1_encode_tiles_row_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const int tile_cols = cm->tile_cols;
+  const int tile_rows = cm->tile_rows;
+  int tile_row, tile_col, i;
+
+  av1_init_tile_data(cpi);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, AOMMAX(cpi->oxcf.max_threads, 1));
+
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      TileDataEnc *const this_tile =
+          &cpi->tile_data[tile_row * tile_cols + tile_col];
+      const TileInfo *const tile_info = &this_tile->tile_info;
+      const int sb_rows = (tile_info->mi_row_end - tile_info->mi_row_start +
+                           cm->mib_size - 1) >>
+                          cm->mib_size_log2;
+
+      if (this_tile->row_mt_sync.rows != sb_rows) {
+        av1_row_mt_sync_mem_dealloc(&this_tile->row_mt_sync);
+        av1_row_mt_sync_mem_alloc(&this_tile->row_mt_sync, cm, sb_rows);
+      }
+    }
+  }
+
+  prepare_enc_workers(cpi, (AVxWorkerHook)enc_row_mt_worker_hook,
+                      cpi->num_workers);
+
+  for (i = 0; i < cpi->num_workers; i++) {
+    ThreadData *const td = cpi->tile_thr_data[i].td;
+    if (td->row_tile_data == NULL)
+      CHECK_MEM_ERROR(cm, td->row_tile_data,
+                      aom_memalign(32, sizeof(*td->row_tile_data)));
+  }
+
+  cpi->row_mt_sync_read_ptr = av1_row_mt_sync_read;
+  cpi->row_mt_sync_write_ptr = av1_row_mt_sync_write;
+
+  // Tile rows share the above context arrays, so they are encoded one after
+  // the other.
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      TileDataEnc *const this_tile =
+          &cpi->tile_data[tile_row * tile_cols + tile_col];
+
+      av1_init_tile_encode(cpi, tile_row, tile_col);
+      memset(this_tile->row_mt_sync.cur_col, -1,
+             sizeof(*this_tile->row_mt_sync.cur_col) *
+                 this_tile->row_mt_sync.rows);
+    }
+
+    for (i = 0; i < cpi->num_workers; i++)
+      cpi->tile_thr_data[i].tile_row = tile_row;
+
+    launch_enc_workers(cpi, cpi->num_workers);
+
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col)
+      merge_sb_row_tokens(cpi, tile_row, tile_col);
+  }
+
+  accumulate_enc_worker_counts(cpi, cpi->num_workers);
+}
+
+static int first_pass_worker_hook(EncWorkerData *const thread_data,
+                                  void *unused) {
+  AV1_COMP *const cpi = thread_data->cpi;
+  int mb_row;
+
+  (void)unused;
+
+  // Each worker takes its rows in increasing order, so the row above the
+  // oldest unfinished one is always complete.
+  for (mb_row = thread_data->start; mb_row < cpi->common.mb_rows;
+       mb_row += cpi->num_workers)
+    av1_first_pass_row(cpi, thread_data->td, mb_row);
+
+  return 0;
+}
+
+void av1_first_pass_row_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  AV1RowMTSync *const row_mt_sync = &cpi->fp_row_mt_sync;
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  if (row_mt_sync->rows != cm->mb_rows) {
+    av1_row_mt_sync_mem_dealloc(row_mt_sync);
+    av1_row_mt_sync_mem_alloc(row_mt_sync, cm, cm->mb_rows);
+  }
+  memset(row_mt_sync->cur_col, -1,
+         sizeof(*row_mt_sync->cur_col) * row_mt_sync->rows);
+
+  cpi->row_mt_sync_read_ptr = av1_row_mt_sync_read;
+  cpi->row_mt_sync_write_ptr = av1_row_mt_sync_write;
+
+  prepare_enc_workers(cpi, (AVxWorkerHook)first_pass_worker_hook,
+                      cpi->num_workers);
+  launch_enc_workers(cpi, cpi->num_workers);
+}
+
+static int temporal_filter_worker_hook(EncWorkerData *const thread_data,
+                                       const TemporalFilterData *tf) {
+  AV1_COMP *const cpi = thread_data->cpi;
+  int mb_row;
+
+  for (mb_row = thread_data->start; mb_row < tf->mb_rows;
+       mb_row += cpi->num_workers)
+    av1_temporal_filter_row(cpi, thread_data->td, tf, mb_row);
+
+  return 0;
+}
+
+void av1_temporal_filter_row_mt(AV1_COMP *cpi, const TemporalFilterData *tf) {
+  int i;
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  prepare_enc_workers(cpi, (AVxWorkerHook)temporal_filter_worker_hook,
+                      cpi->num_workers);
+  for (i = 0; i < cpi->num_workers; i++)
+    cpi->workers[i].data2 = (void *)tf;
+  launch_enc_workers(cpi, cpi->num_workers);
+}
+
+void av1_row_mt_sync_read(AV1RowMTSync *const row_mt_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  const int nsync = row_mt_sync->sync_range;
+
+  if (r && !(c & (nsync - 1))) {
+    pthread_mutex_t *const mutex = &row_mt_sync->mutex_[r - 1];
+    pthread_mutex_lock(mutex);
+
+    while (c > row_mt_sync->cur_col[r - 1] - nsync) {
+      pthread_cond_wait(&row_mt_sync->cond_[r - 1], mutex);
+    }
+    pthread_mutex_unlock(mutex);
+  }
+#else
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_row_mt_sync_write(AV1RowMTSync *const row_mt_sync, int r, int c,
+                           const int cols) {
+#if CONFIG_MULTITHREAD
+  const int nsync = row_mt_sync->sync_range;
+  int cur;
+  // Only signal when there are enough encoded SB for next row to run.
+  int sig = 1;
+
+  if (c < cols - 1) {
+    cur = c;
+    if (c % nsync) sig = 0;
+  } else {
+    cur = cols + nsync;
+  }
+
+  if (sig) {
+    pthread_mutex_lock(&row_mt_sync->mutex_[r]);
+
+    row_mt_sync->cur_col[r] = cur;
+
+    pthread_cond_signal(&row_mt_sync->cond_[r]);
+    pthread_mutex_unlock(&row_mt_sync->mutex_[r]);
+  }
+#else
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+  (void)cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_row_mt_sync_read_dummy(AV1RowMTSync *const row_mt_sync, int r,
+                                int c) {
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+}
+
+void av1_row_mt_sync_write_dummy(AV1RowMTSync *const row_mt_sync, int r, int c,
+                                 const int cols) {
+  (void)row_mt_sync;
+  (void)r;
+  (void)c;
+  (void)cols;
+}
+
+// Allocate memory for superblock row synchronization
+void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync, AV1_COMMON *cm,
+                               int rows) {
+  row_mt_sync->rows = rows;
+#if CONFIG_MULTITHREAD
+  {
+    int i;
+
+    CHECK_MEM_ERROR(cm, row_mt_sync->mutex_,
+                    aom_malloc(sizeof(*row_mt_sync->mutex_) * rows));
+    if (row_mt_sync->mutex_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_mutex_init(&row_mt_sync->mutex_[i], NULL);
+      }
+    }
+
+    CHECK_MEM_ERROR(cm, row_mt_sync->cond_,
+                    aom_malloc(sizeof(*row_mt_sync->cond_) * rows));
+    if (row_mt_sync->cond_) {
+      for (i = 0; i < rows; ++i) {
+        pthread_cond_init(&row_mt_sync->cond_[i], NULL);
+      }
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, row_mt_sync->cur_col,
+                  aom_malloc(sizeof(*row_mt_sync->cur_col) * rows));
+
+  CHECK_MEM_ERROR(cm, row_mt_sync->tok_count,
+                  aom_calloc(rows, sizeof(*row_mt_sync->tok_count)));
+
+  // Set up nsync. The top-right superblock of the row above is the furthest
+  // one a superblock depends on, so a range of 1 is enough.
+  row_mt_sync->sync_range = 1;
+}
+
+// Deallocate superblock row synchronization related mutex and data
+void av1_row_mt_sync_mem_dealloc(AV1RowMTSync *row_mt_sync) {
+  if (row_mt_sync != NULL) {
+#if CONFIG_MULTITHREAD
+    int i;
+
+    if (row_mt_sync->mutex_ != NULL) {
+      for (i = 0; i < row_mt_sync->rows; ++i) {
+        pthread_mutex_destroy(&row_mt_sync->mutex_[i]);
+      }
+      aom_free(row_mt_sync->mutex_);
+    }
+    if (row_mt_sync->cond_ != NULL) {
+      for (i = 0; i < row_mt_sync->rows; ++i) {
+        pthread_cond_destroy(&row_mt_sync->cond_[i]);
+      }
+      aom_free(row_mt_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+    aom_free(row_mt_sync->cur_col);
+    aom_free(row_mt_sync->tok_count);
+    // clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    av1_zero(*row_mt_sync);
+  }
+}
+
+void av1_row_mt_mem_dealloc(AV1_COMP *cpi) {
+  int i;
+
+  if (cpi->tile_data == NULL) return;
+
+  for (i = 0; i < cpi->allocated_tiles; ++i)
+    av1_row_mt_sync_mem_dealloc(&cpi->tile_data[i].row_mt_sync);
+}
+
+#if CONFIG_GLOBAL_MOTION
+static int lookahead_analysis_hook(struct lookahead_analysis *analysis,
+                                   void *unused) {
+  int i;
+
+  (void)unused;
+
+  for (i = 0; i < analysis->num_entries; ++i)
+    av1_lookahead_analyze(analysis->entries[i], analysis->bit_depth);
+
+  return 1;
+}
+
+void av1_lookahead_analysis_launch(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  AVxWorker *const worker = &cpi->lookahead_worker;
+  struct lookahead_analysis *const analysis = &cpi->lookahead_analysis;
+  const int depth = av1_lookahead_depth(cpi->lookahead);
+  int i;
+
+  if (cpi->oxcf.max_threads <= 1 || cpi->oxcf.pass == 1) return;
+
+  // The frame being encoded is analyzed on demand by the encoder itself.
+  analysis->num_entries = 0;
+  for (i = 0; i < depth; ++i) {
+    struct lookahead_entry *const entry = av1_lookahead_peek(cpi->lookahead, i);
+    if (entry != cpi->source_entry && !entry->img.corners)
+      analysis->entries[analysis->num_entries++] = entry;
+  }
+  if (analysis->num_entries == 0) return;
+  analysis->bit_depth = cm->bit_depth;
+
+  // Only run once to create the thread.
+  if (!cpi->lookahead_worker_created) {
+    winterface->init(worker);
+    if (!winterface->reset(worker))
+      aom_internal_error(&cm->error, AOM_CODEC_ERROR,
+                         "Lookahead analysis thread creation failed");
+    cpi->lookahead_worker_created = 1;
+  }
+
+  worker->hook = (AVxWorkerHook)lookahead_analysis_hook;
+  worker->data1 = analysis;
+  worker->data2 = NULL;
+  winterface->launch(worker);
+}
+
+void av1_lookahead_analysis_sync(AV1_COMP *cpi) {
+  if (cpi->lookahead_worker_created)
+    aom_get_worker_interface()->sync(&cpi->lookahead_worker);
+}
+
+void av1_lookahead_analysis_end(AV1_COMP *cpi) {
+  if (cpi->lookahead_worker_created) {
+    aom_get_worker_interface()->end(&cpi->lookahead_worker);
+    cpi->lookahead_worker_created = 0;
+  }
+}
+#endif  // CONFIG_GLOBAL_MOTION
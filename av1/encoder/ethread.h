@@ -12,21 +12,80 @@
 #ifndef AV1_ENCODER_ETHREAD_H_
 #define AV1_ENCODER_ETHREAD_H_
 
+#include "./aom_config.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 struct AV1_COMP;
+struct AV1Common;
 struct ThreadData;
+struct AV1RowMTSyncData;
+struct TemporalFilterData;
 
 typedef struct EncWorkerData {
   struct AV1_COMP *cpi;
   struct ThreadData *td;
   int start;
+  // Tile row being encoded by the row-based multi-threaded encoder.
+  int tile_row;
 } EncWorkerData;
 
 void av1_encode_tiles_mt(struct AV1_COMP *cpi);
 
+// Encode the superblock rows of each tile in parallel, in wavefront order.
+// The result does not depend on the number of threads.
+void av1_encode_tiles_row_mt(struct AV1_COMP *cpi);
+
+// Pack the tile columns in parallel, each one into its own part of
+// cpi->tile_pack_buf. The tiles still have to be concatenated. The tiles of a
+// column from the first one that does not fit in its part are left with a
+// NULL data pointer, to be packed serially. Returns 1 if all the tiles fit.
+int av1_pack_tiles_mt(struct AV1_COMP *cpi);
+
+// Analyze the macroblock rows of the first pass in parallel, in wavefront
+// order. The statistics do not depend on the number of threads.
+void av1_first_pass_row_mt(struct AV1_COMP *cpi);
+
+// Filter the macroblock rows of the ARF in parallel. The result does not
+// depend on the number of threads.
+void av1_temporal_filter_row_mt(struct AV1_COMP *cpi,
+                                const struct TemporalFilterData *tf);
+
+void av1_row_mt_sync_read(struct AV1RowMTSyncData *const row_mt_sync, int r,
+                          int c);
+void av1_row_mt_sync_write(struct AV1RowMTSyncData *const row_mt_sync, int r,
+                           int c, const int cols);
+
+void av1_row_mt_sync_read_dummy(struct AV1RowMTSyncData *const row_mt_sync,
+                                int r, int c);
+void av1_row_mt_sync_write_dummy(struct AV1RowMTSyncData *const row_mt_sync,
+                                 int r, int c, const int cols);
+
+// Allocate memory for superblock row synchronization.
+void av1_row_mt_sync_mem_alloc(struct AV1RowMTSyncData *row_mt_sync,
+                               struct AV1Common *cm, int rows);
+
+// Deallocate superblock row synchronization related mutex and data.
+void av1_row_mt_sync_mem_dealloc(struct AV1RowMTSyncData *row_mt_sync);
+
+// Deallocate the row synchronization data of all the tiles.
+void av1_row_mt_mem_dealloc(struct AV1_COMP *cpi);
+
+#if CONFIG_GLOBAL_MOTION
+// Analyze the source frames queued in the lookahead, other than the one being
+// encoded, on a background thread while the current frame is encoded.
+void av1_lookahead_analysis_launch(struct AV1_COMP *cpi);
+
+// Wait for the background analysis of the lookahead to complete. It must be
+// called before the lookahead queue is modified.
+void av1_lookahead_analysis_sync(struct AV1_COMP *cpi);
+
+// Stop the background analysis thread.
+void av1_lookahead_analysis_end(struct AV1_COMP *cpi);
+#endif  // CONFIG_GLOBAL_MOTION
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
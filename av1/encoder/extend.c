@@ -30,7 +30,7 @@ static void copy_and_extend_plane(const uint8_t *src, int src_pitch,
 
   for (i = 0; i < h; i++) {
     memset(dst_ptr1, src_ptr1[0], extend_left);
-    memcpy(dst_ptr1 + extend_left, src_ptr1, w);
+    if (src != dst) memcpy(dst_ptr1 + extend_left, src_ptr1, w);
     memset(dst_ptr2, src_ptr2[0], extend_right);
     src_ptr1 += src_pitch;
     src_ptr2 += src_pitch;
@@ -74,7 +74,8 @@ static void highbd_copy_and_extend_plane(const uint8_t *src8, int src_pitch,
 
   for (i = 0; i < h; i++) {
     aom_memset16(dst_ptr1, src_ptr1[0], extend_left);
-    memcpy(dst_ptr1 + extend_left, src_ptr1, w * sizeof(src_ptr1[0]));
+    if (src != dst)
+      memcpy(dst_ptr1 + extend_left, src_ptr1, w * sizeof(src_ptr1[0]));
     aom_memset16(dst_ptr2, src_ptr2[0], extend_right);
     src_ptr1 += src_pitch;
     src_ptr2 += src_pitch;
@@ -102,81 +103,135 @@ static void highbd_copy_and_extend_plane(const uint8_t *src8, int src_pitch,
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
-void av1_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
-                               YV12_BUFFER_CONFIG *dst) {
-  // Extend src frame in buffer
-  // Altref filtering assumes 16 pixel extension
-  const int et_y = 16;
-  const int el_y = 16;
-  // Motion estimation may use src block variance with the block size up
-  // to 64x64, so the right and bottom need to be extended to 64 multiple
-  // or up to 16, whichever is greater.
-  const int er_y =
-      AOMMAX(src->y_width + 16, ALIGN_POWER_OF_TWO(src->y_width, 6)) -
-      src->y_crop_width;
-  const int eb_y =
-      AOMMAX(src->y_height + 16, ALIGN_POWER_OF_TWO(src->y_height, 6)) -
-      src->y_crop_height;
+// Copies the planes of src into dst, or extends them in place if src and dst
+// are the same frame, with the given extension of the luma plane. The width
+// and height of the copied area are extended by the given amounts, so that
+// a frame whose right and bottom are already extended may be extended to the
+// top and left.
+static void copy_and_extend_planes(const YV12_BUFFER_CONFIG *src,
+                                   YV12_BUFFER_CONFIG *dst, int et_y, int el_y,
+                                   int eb_y, int er_y, int extra_w,
+                                   int extra_h) {
   const int uv_width_subsampling = (src->uv_width != src->y_width);
   const int uv_height_subsampling = (src->uv_height != src->y_height);
   const int et_uv = et_y >> uv_height_subsampling;
   const int el_uv = el_y >> uv_width_subsampling;
   const int eb_uv = eb_y >> uv_height_subsampling;
   const int er_uv = er_y >> uv_width_subsampling;
+  const int w_y = src->y_crop_width + extra_w;
+  const int h_y = src->y_crop_height + extra_h;
+  const int w_uv = src->uv_crop_width + (extra_w >> uv_width_subsampling);
+  const int h_uv = src->uv_crop_height + (extra_h >> uv_height_subsampling);
 
 #if CONFIG_AOM_HIGHBITDEPTH
   if (src->flags & YV12_FLAG_HIGHBITDEPTH) {
     highbd_copy_and_extend_plane(src->y_buffer, src->y_stride, dst->y_buffer,
-                                 dst->y_stride, src->y_crop_width,
-                                 src->y_crop_height, et_y, el_y, eb_y, er_y);
+                                 dst->y_stride, w_y, h_y, et_y, el_y, eb_y,
+                                 er_y);
 
-    highbd_copy_and_extend_plane(
-        src->u_buffer, src->uv_stride, dst->u_buffer, dst->uv_stride,
-        src->uv_crop_width, src->uv_crop_height, et_uv, el_uv, eb_uv, er_uv);
+    highbd_copy_and_extend_plane(src->u_buffer, src->uv_stride, dst->u_buffer,
+                                 dst->uv_stride, w_uv, h_uv, et_uv, el_uv,
+                                 eb_uv, er_uv);
 
-    highbd_copy_and_extend_plane(
-        src->v_buffer, src->uv_stride, dst->v_buffer, dst->uv_stride,
-        src->uv_crop_width, src->uv_crop_height, et_uv, el_uv, eb_uv, er_uv);
+    highbd_copy_and_extend_plane(src->v_buffer, src->uv_stride, dst->v_buffer,
+                                 dst->uv_stride, w_uv, h_uv, et_uv, el_uv,
+                                 eb_uv, er_uv);
     return;
   }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
   copy_and_extend_plane(src->y_buffer, src->y_stride, dst->y_buffer,
-                        dst->y_stride, src->y_crop_width, src->y_crop_height,
-                        et_y, el_y, eb_y, er_y);
+                        dst->y_stride, w_y, h_y, et_y, el_y, eb_y, er_y);
 
   copy_and_extend_plane(src->u_buffer, src->uv_stride, dst->u_buffer,
-                        dst->uv_stride, src->uv_crop_width, src->uv_crop_height,
-                        et_uv, el_uv, eb_uv, er_uv);
+                        dst->uv_stride, w_uv, h_uv, et_uv, el_uv, eb_uv, er_uv);
 
   copy_and_extend_plane(src->v_buffer, src->uv_stride, dst->v_buffer,
-                        dst->uv_stride, src->uv_crop_width, src->uv_crop_height,
-                        et_uv, el_uv, eb_uv, er_uv);
+                        dst->uv_stride, w_uv, h_uv, et_uv, el_uv, eb_uv, er_uv);
+}
+
+// Altref filtering assumes 16 pixel extension
+#define SRC_EXTEND_TOP_LEFT 16
+
+// Motion estimation may use src block variance with the block size up
+// to 64x64, so the right and bottom need to be extended to 64 multiple
+// or up to 16, whichever is greater.
+static int src_extend_right(const YV12_BUFFER_CONFIG *src) {
+  return AOMMAX(src->y_width + 16, ALIGN_POWER_OF_TWO(src->y_width, 6)) -
+         src->y_crop_width;
+}
+
+static int src_extend_bottom(const YV12_BUFFER_CONFIG *src) {
+  return AOMMAX(src->y_height + 16, ALIGN_POWER_OF_TWO(src->y_height, 6)) -
+         src->y_crop_height;
+}
+
+void av1_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
+                               YV12_BUFFER_CONFIG *dst) {
+  // Extend src frame in buffer
+  copy_and_extend_planes(src, dst, SRC_EXTEND_TOP_LEFT, SRC_EXTEND_TOP_LEFT,
+                         src_extend_bottom(src), src_extend_right(src), 0, 0);
+}
+
+void av1_extend_frame_bottom_right(YV12_BUFFER_CONFIG *ybf) {
+  copy_and_extend_planes(ybf, ybf, 0, 0, src_extend_bottom(ybf),
+                         src_extend_right(ybf), 0, 0);
+}
+
+void av1_extend_frame_top_left(YV12_BUFFER_CONFIG *ybf) {
+  copy_and_extend_planes(ybf, ybf, SRC_EXTEND_TOP_LEFT, SRC_EXTEND_TOP_LEFT, 0,
+                         0, src_extend_right(ybf), src_extend_bottom(ybf));
 }
 
 void av1_copy_and_extend_frame_with_rect(const YV12_BUFFER_CONFIG *src,
                                          YV12_BUFFER_CONFIG *dst, int srcy,
                                          int srcx, int srch, int srcw) {
-  // If the side is not touching the bounder then don't extend.
-  const int et_y = srcy ? 0 : dst->border;
-  const int el_y = srcx ? 0 : dst->border;
-  const int eb_y = srcy + srch != src->y_height
-                       ? 0
-                       : dst->border + dst->y_height - src->y_height;
-  const int er_y = srcx + srcw != src->y_width
-                       ? 0
-                       : dst->border + dst->y_width - src->y_width;
+  const int ss_x = src->subsampling_x;
+  const int ss_y = src->subsampling_y;
+  // The rectangle is clipped to the frame, and only its sides that touch the
+  // sides of the frame are extended, as av1_copy_and_extend_frame() would.
+  const int bottom = AOMMIN(srcy + srch, src->y_crop_height);
+  const int right = AOMMIN(srcx + srcw, src->y_crop_width);
+  const int et_y = srcy ? 0 : SRC_EXTEND_TOP_LEFT;
+  const int el_y = srcx ? 0 : SRC_EXTEND_TOP_LEFT;
+  const int eb_y = bottom < src->y_crop_height ? 0 : src_extend_bottom(src);
+  const int er_y = right < src->y_crop_width ? 0 : src_extend_right(src);
   const int src_y_offset = srcy * src->y_stride + srcx;
   const int dst_y_offset = srcy * dst->y_stride + srcx;
 
-  const int et_uv = ROUND_POWER_OF_TWO(et_y, 1);
-  const int el_uv = ROUND_POWER_OF_TWO(el_y, 1);
-  const int eb_uv = ROUND_POWER_OF_TWO(eb_y, 1);
-  const int er_uv = ROUND_POWER_OF_TWO(er_y, 1);
-  const int src_uv_offset = ((srcy * src->uv_stride) >> 1) + (srcx >> 1);
-  const int dst_uv_offset = ((srcy * dst->uv_stride) >> 1) + (srcx >> 1);
-  const int srch_uv = ROUND_POWER_OF_TWO(srch, 1);
-  const int srcw_uv = ROUND_POWER_OF_TWO(srcw, 1);
+  const int uv_top = srcy >> ss_y;
+  const int uv_left = srcx >> ss_x;
+  const int srch_uv =
+      AOMMIN((bottom + ss_y) >> ss_y, src->uv_crop_height) - uv_top;
+  const int srcw_uv =
+      AOMMIN((right + ss_x) >> ss_x, src->uv_crop_width) - uv_left;
+  const int et_uv = et_y >> ss_y;
+  const int el_uv = el_y >> ss_x;
+  const int eb_uv = eb_y >> ss_y;
+  const int er_uv = er_y >> ss_x;
+  const int src_uv_offset = uv_top * src->uv_stride + uv_left;
+  const int dst_uv_offset = uv_top * dst->uv_stride + uv_left;
+
+  if (bottom <= srcy || right <= srcx) return;
+  srch = bottom - srcy;
+  srcw = right - srcx;
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (src->flags & YV12_FLAG_HIGHBITDEPTH) {
+    highbd_copy_and_extend_plane(src->y_buffer + src_y_offset, src->y_stride,
+                                 dst->y_buffer + dst_y_offset, dst->y_stride,
+                                 srcw, srch, et_y, el_y, eb_y, er_y);
+
+    highbd_copy_and_extend_plane(src->u_buffer + src_uv_offset, src->uv_stride,
+                                 dst->u_buffer + dst_uv_offset, dst->uv_stride,
+                                 srcw_uv, srch_uv, et_uv, el_uv, eb_uv, er_uv);
+
+    highbd_copy_and_extend_plane(src->v_buffer + src_uv_offset, src->uv_stride,
+                                 dst->v_buffer + dst_uv_offset, dst->uv_stride,
+                                 srcw_uv, srch_uv, et_uv, el_uv, eb_uv, er_uv);
+    return;
+  }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
 
   copy_and_extend_plane(src->y_buffer + src_y_offset, src->y_stride,
                         dst->y_buffer + dst_y_offset, dst->y_stride, srcw, srch,
@@ -22,6 +22,18 @@ extern "C" {
 void av1_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
                                YV12_BUFFER_CONFIG *dst);
 
+// Extends a source frame in place, as av1_copy_and_extend_frame() extends its
+// copy. The right and bottom are needed to encode the frame, the top and left
+// only for motion search in the frame. The right and bottom must be extended
+// first. The extension is at most 63 pixels wide.
+void av1_extend_frame_bottom_right(YV12_BUFFER_CONFIG *ybf);
+
+void av1_extend_frame_top_left(YV12_BUFFER_CONFIG *ybf);
+
+// Copies the rectangle at (srcx, srcy) of src into dst, and extends the sides
+// of the frame it touches, so that copying rectangles that cover the frame is
+// the same as av1_copy_and_extend_frame(). The top left corner of the
+// rectangle must be aligned to the chroma subsampling.
 void av1_copy_and_extend_frame_with_rect(const YV12_BUFFER_CONFIG *src,
                                          YV12_BUFFER_CONFIG *dst, int srcy,
                                          int srcx, int srch, int srcw);
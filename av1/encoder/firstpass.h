@@ -12,6 +12,7 @@
 #ifndef AV1_ENCODER_FIRSTPASS_H_
 #define AV1_ENCODER_FIRSTPASS_H_
 
+#include "av1/common/mv.h"
 #include "av1/encoder/lookahead.h"
 #include "av1/encoder/ratectrl.h"
 
@@ -79,6 +80,43 @@ typedef struct {
   double count;
 } FIRSTPASS_STATS;
 
+// Raw sums gathered by the first pass over one macroblock row. The rows are
+// analyzed independently and merged in raster order, so the frame statistics
+// do not depend on how the rows were distributed across threads.
+typedef struct {
+  int64_t intra_error;
+  int64_t coded_error;
+  int64_t sr_coded_error;
+  int64_t sum_mvrs;
+  int64_t sum_mvcs;
+  int sum_mvr;
+  int sum_mvc;
+  int sum_mvr_abs;
+  int sum_mvc_abs;
+  int mvcount;
+  int intercount;
+  int second_ref_count;
+  int intra_skip_count;
+  // Set if a block other than the first one of the row is not flat.
+  int image_data_start;
+  // Number of non-zero motion vectors that differ from the previous one,
+  // not counting the first one of the row.
+  int new_mv_count;
+  int sum_in_vectors;
+  // First and last non-zero motion vectors of the row.
+  MV first_mv;
+  MV last_mv;
+} FIRSTPASS_ROW_STATS;
+
+// Floating point contributions of one macroblock to the frame statistics.
+// These are summed in raster order as floating point addition is not
+// associative.
+typedef struct {
+  double intra_factor;
+  double brightness_factor;
+  double neutral_count;
+} FIRSTPASS_MB_FACTORS;
+
 typedef enum {
   KF_UPDATE = 0,
   LF_UPDATE = 1,
@@ -161,13 +199,21 @@ typedef struct {
   int extend_minq_fast;
 
   GF_GROUP gf_group;
+
+  // Per row and per macroblock data of the frame analyzed by the first pass.
+  FIRSTPASS_ROW_STATS *row_stats;
+  FIRSTPASS_MB_FACTORS *mb_factors;
 } TWO_PASS;
 
 struct AV1_COMP;
+struct ThreadData;
 
 void av1_init_first_pass(struct AV1_COMP *cpi);
 void av1_rc_get_first_pass_params(struct AV1_COMP *cpi);
 void av1_first_pass(struct AV1_COMP *cpi, const struct lookahead_entry *source);
+// Analyze one macroblock row of the current frame in the first pass.
+void av1_first_pass_row(struct AV1_COMP *cpi, struct ThreadData *td,
+                        int mb_row);
 void av1_end_first_pass(struct AV1_COMP *cpi);
 
 void av1_init_second_pass(struct AV1_COMP *cpi);
@@ -15,6 +15,7 @@
 #include <math.h>
 #include <assert.h>
 
+#include "aom_mem/aom_mem.h"
 #include "av1/encoder/global_motion.h"
 
 #include "av1/common/warped_motion.h"
@@ -24,7 +25,6 @@
 #include "av1/encoder/corner_match.h"
 #include "av1/encoder/ransac.h"
 
-#define MAX_CORNERS 4096
 #define MIN_INLIER_PROB 0.1
 
 #define MIN_TRANS_THRESH (1 * GM_TRANS_DECODE_FACTOR)
@@ -125,6 +125,134 @@ void force_wmtype(WarpedMotionParams *wm, TransformationType wmtype) {
   wm->wmtype = wmtype;
 }
 
+// A pair of frames over which the warp error is measured.
+typedef struct {
+  uint8_t *ref;
+  int r_width, r_height, r_stride;
+  uint8_t *dst;
+  int d_width, d_height, d_stride;
+  // The frames are a 2x2 decimation of the original ones.
+  int decimated;
+  // Buffers allocated for the decimated frames.
+  uint8_t *ref_alloc, *dst_alloc;
+} RefineFrames;
+
+// The warp filter reads up to 13 pixels to the left and right of the
+// reference, so the decimated reference is extended by this many pixels.
+#define DECIMATED_BORDER 16
+// Smallest decimated frame over which the coarse refinement steps are run.
+#define MIN_DECIMATED_SIZE 16
+
+static void decimate_plane(const uint8_t *src, int src_stride, uint8_t *dst,
+                           int dst_stride, int width, int height) {
+  int i, j;
+  for (i = 0; i < height; ++i) {
+    const uint8_t *const s0 = src + 2 * i * src_stride;
+    const uint8_t *const s1 = s0 + src_stride;
+    for (j = 0; j < width; ++j)
+      dst[i * dst_stride + j] = ROUND_POWER_OF_TWO(
+          s0[2 * j] + s0[2 * j + 1] + s1[2 * j] + s1[2 * j + 1], 2);
+  }
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+static void highbd_decimate_plane(const uint16_t *src, int src_stride,
+                                  uint16_t *dst, int dst_stride, int width,
+                                  int height) {
+  int i, j;
+  for (i = 0; i < height; ++i) {
+    const uint16_t *const s0 = src + 2 * i * src_stride;
+    const uint16_t *const s1 = s0 + src_stride;
+    for (j = 0; j < width; ++j)
+      dst[i * dst_stride + j] = ROUND_POWER_OF_TWO(
+          s0[2 * j] + s0[2 * j + 1] + s1[2 * j] + s1[2 * j + 1], 2);
+  }
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+// Sets up "half" as the 2x2 decimation of "full". The pixels of the decimated
+// frames are centered between those of the original ones, as chroma pixels
+// are between luma pixels, so the warp models apply to them as they do to
+// subsampled chroma planes. Returns 0 if the frames are too small, or if
+// memory could not be allocated.
+static int decimate_frames(RefineFrames *half, const RefineFrames *full,
+                           int use_hbd) {
+  const int bytes = use_hbd ? 2 : 1;
+  int i;
+
+  half->r_width = full->r_width >> 1;
+  half->r_height = full->r_height >> 1;
+  half->r_stride = half->r_width + 2 * DECIMATED_BORDER;
+  half->d_width = full->d_width >> 1;
+  half->d_height = full->d_height >> 1;
+  half->d_stride = half->d_width;
+  half->decimated = 1;
+  if (half->d_width < MIN_DECIMATED_SIZE ||
+      half->d_height < MIN_DECIMATED_SIZE)
+    return 0;
+
+  half->ref_alloc = (uint8_t *)aom_malloc(half->r_stride * half->r_height *
+                                          bytes);
+  half->dst_alloc = (uint8_t *)aom_malloc(half->d_stride * half->d_height *
+                                          bytes);
+  if (!half->ref_alloc || !half->dst_alloc) {
+    aom_free(half->ref_alloc);
+    aom_free(half->dst_alloc);
+    return 0;
+  }
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (use_hbd) {
+    uint16_t *const ref = (uint16_t *)half->ref_alloc + DECIMATED_BORDER;
+    highbd_decimate_plane(CONVERT_TO_SHORTPTR(full->ref), full->r_stride, ref,
+                          half->r_stride, half->r_width, half->r_height);
+    highbd_decimate_plane(CONVERT_TO_SHORTPTR(full->dst), full->d_stride,
+                          (uint16_t *)half->dst_alloc, half->d_stride,
+                          half->d_width, half->d_height);
+    for (i = 0; i < half->r_height; ++i) {
+      uint16_t *const row = ref + i * half->r_stride;
+      aom_memset16(row - DECIMATED_BORDER, row[0], DECIMATED_BORDER);
+      aom_memset16(row + half->r_width, row[half->r_width - 1],
+                   DECIMATED_BORDER);
+    }
+    half->ref = CONVERT_TO_BYTEPTR(ref);
+    half->dst = CONVERT_TO_BYTEPTR(half->dst_alloc);
+    return 1;
+  }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  half->ref = half->ref_alloc + DECIMATED_BORDER;
+  half->dst = half->dst_alloc;
+  decimate_plane(full->ref, full->r_stride, half->ref, half->r_stride,
+                 half->r_width, half->r_height);
+  decimate_plane(full->dst, full->d_stride, half->dst, half->d_stride,
+                 half->d_width, half->d_height);
+  for (i = 0; i < half->r_height; ++i) {
+    uint8_t *const row = half->ref + i * half->r_stride;
+    memset(row - DECIMATED_BORDER, row[0], DECIMATED_BORDER);
+    memset(row + half->r_width, row[half->r_width - 1], DECIMATED_BORDER);
+  }
+  return 1;
+}
+
+static int64_t frames_warp_error(WarpedMotionParams *wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                 int use_hbd, int bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+                                 const RefineFrames *frames,
+                                 int64_t best_error) {
+  const int border = ERRORADV_BORDER >> frames->decimated;
+  return av1_warp_error(
+      wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+      use_hbd, bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      frames->ref, frames->r_width, frames->r_height, frames->r_stride,
+      frames->dst + border * frames->d_stride + border, border, border,
+      frames->d_width - 2 * border, frames->d_height - 2 * border,
+      frames->d_stride, frames->decimated, frames->decimated, 16, 16,
+      best_error);
+}
+
 double refine_integerized_param(WarpedMotionParams *wm,
                                 TransformationType wmtype,
 #if CONFIG_AOM_HIGHBITDEPTH
@@ -140,24 +268,52 @@ double refine_integerized_param(WarpedMotionParams *wm,
   int i = 0, p;
   int n_params = max_trans_model_params[wmtype];
   int32_t *param_mat = wm->wmmat;
-  double step_error;
+  int64_t step_error;
   int32_t step;
   int32_t *param;
   int32_t curr_param;
   int32_t best_param;
-  double best_error;
+  int64_t best_error;
+  RefineFrames full, half;
+  const RefineFrames *frames = &full;
+  int use_decimated;
+#if !CONFIG_AOM_HIGHBITDEPTH
+  const int use_hbd = 0;
+#endif  // !CONFIG_AOM_HIGHBITDEPTH
+
+  full.ref = ref;
+  full.r_width = r_width;
+  full.r_height = r_height;
+  full.r_stride = r_stride;
+  full.dst = dst;
+  full.d_width = d_width;
+  full.d_height = d_height;
+  full.d_stride = d_stride;
+  full.decimated = 0;
+
+  // All the refinement steps but the last one are coarse enough to be
+  // evaluated on the decimated frames, at a quarter of the cost.
+  use_decimated = n_refinements > 1 && decimate_frames(&half, &full, use_hbd);
+  if (use_decimated) frames = &half;
 
   force_wmtype(wm, wmtype);
-  best_error = av1_warp_erroradv(wm,
+  best_error = frames_warp_error(wm,
 #if CONFIG_AOM_HIGHBITDEPTH
                                  use_hbd, bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-                                 ref, r_width, r_height, r_stride,
-                                 dst + border * d_stride + border, border,
-                                 border, d_width - 2 * border,
-                                 d_height - 2 * border, d_stride, 0, 0, 16, 16);
+                                 frames, INT64_MAX);
   step = 1 << (n_refinements + 1);
   for (i = 0; i < n_refinements; i++, step >>= 1) {
+    if (i == n_refinements - 1 && use_decimated) {
+      // The errors are not comparable across resolutions, so the last step
+      // starts over from the error of the current parameters.
+      frames = &full;
+      best_error = frames_warp_error(wm,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                     use_hbd, bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+                                     frames, INT64_MAX);
+    }
     for (p = 0; p < n_params; ++p) {
       int step_dir = 0;
       // Skip searches for parameters that are forced to be 0
@@ -168,14 +324,11 @@ double refine_integerized_param(WarpedMotionParams *wm,
       best_param = curr_param;
       // look to the left
       *param = add_param_offset(p, curr_param, -step);
-      step_error = av1_warp_erroradv(
-          wm,
+      step_error = frames_warp_error(wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-          use_hbd, bd,
+                                     use_hbd, bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-          ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-          border, border, d_width - 2 * border, d_height - 2 * border, d_stride,
-          0, 0, 16, 16);
+                                     frames, best_error);
       if (step_error < best_error) {
         best_error = step_error;
         best_param = *param;
@@ -184,14 +337,11 @@ double refine_integerized_param(WarpedMotionParams *wm,
 
       // look to the right
       *param = add_param_offset(p, curr_param, step);
-      step_error = av1_warp_erroradv(
-          wm,
+      step_error = frames_warp_error(wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-          use_hbd, bd,
+                                     use_hbd, bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-          ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-          border, border, d_width - 2 * border, d_height - 2 * border, d_stride,
-          0, 0, 16, 16);
+                                     frames, best_error);
       if (step_error < best_error) {
         best_error = step_error;
         best_param = *param;
@@ -203,14 +353,11 @@ double refine_integerized_param(WarpedMotionParams *wm,
       // for the biggest step size
       while (step_dir) {
         *param = add_param_offset(p, best_param, step * step_dir);
-        step_error = av1_warp_erroradv(
-            wm,
+        step_error = frames_warp_error(wm,
 #if CONFIG_AOM_HIGHBITDEPTH
-            use_hbd, bd,
+                                       use_hbd, bd,
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-            ref, r_width, r_height, r_stride, dst + border * d_stride + border,
-            border, border, d_width - 2 * border, d_height - 2 * border,
-            d_stride, 0, 0, 16, 16);
+                                       frames, best_error);
         if (step_error < best_error) {
           best_error = step_error;
           best_param = *param;
@@ -221,9 +368,21 @@ double refine_integerized_param(WarpedMotionParams *wm,
       }
     }
   }
+  if (use_decimated) {
+    aom_free(half.ref_alloc);
+    aom_free(half.dst_alloc);
+  }
   force_wmtype(wm, wmtype);
   wm->wmtype = get_gmtype(wm);
-  return best_error;
+  // The error is returned relative to that of the reference without warping.
+  return (double)best_error /
+         av1_frame_error(
+#if CONFIG_AOM_HIGHBITDEPTH
+             use_hbd, bd,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+             ref + border * r_stride + border, r_stride,
+             dst + border * d_stride + border, d_width - 2 * border,
+             d_height - 2 * border, d_stride);
 }
 
 static INLINE RansacFunc get_ransac_type(TransformationType type) {
@@ -253,6 +412,37 @@ unsigned char *downconvert_frame(YV12_BUFFER_CONFIG *frm, int bit_depth) {
 }
 #endif
 
+#if CONFIG_AOM_HIGHBITDEPTH
+// The frame buffer is 16-bit, so we need to convert to 8 bits for the
+// feature based code. We cache the result until the frame is released.
+static unsigned char *get_frame_buffer_8bit(YV12_BUFFER_CONFIG *frm,
+                                            int bit_depth) {
+  if (!(frm->flags & YV12_FLAG_HIGHBITDEPTH)) return frm->y_buffer;
+  if (!frm->y_buffer_8bit)
+    frm->y_buffer_8bit = downconvert_frame(frm, bit_depth);
+  return frm->y_buffer_8bit;
+}
+#endif
+
+int compute_frame_corners(YV12_BUFFER_CONFIG *frm, int bit_depth) {
+  unsigned char *frm_buffer = frm->y_buffer;
+
+  if (frm->corners) return frm->num_corners;
+  frm->corners = (int *)malloc(2 * MAX_CORNERS * sizeof(*frm->corners));
+  if (!frm->corners) return 0;
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  frm_buffer = get_frame_buffer_8bit(frm, bit_depth);
+#else
+  (void)bit_depth;
+#endif
+  // compute interest points in images using FAST features
+  frm->num_corners =
+      fast_corner_detect(frm_buffer, frm->y_width, frm->y_height,
+                         frm->y_stride, frm->corners, MAX_CORNERS);
+  return frm->num_corners;
+}
+
 int compute_global_motion_feature_based(
     TransformationType type, YV12_BUFFER_CONFIG *frm, YV12_BUFFER_CONFIG *ref,
 #if CONFIG_AOM_HIGHBITDEPTH
@@ -263,41 +453,29 @@ int compute_global_motion_feature_based(
   int num_frm_corners, num_ref_corners;
   int num_correspondences;
   int *correspondences;
-  int frm_corners[2 * MAX_CORNERS], ref_corners[2 * MAX_CORNERS];
   unsigned char *frm_buffer = frm->y_buffer;
   unsigned char *ref_buffer = ref->y_buffer;
   RansacFunc ransac = get_ransac_type(type);
 
+  // The corners of both frames are cached in the frame buffers, so they are
+  // only found once for all the models and references that use the frames.
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (frm->flags & YV12_FLAG_HIGHBITDEPTH) {
-    // The frame buffer is 16-bit, so we need to convert to 8 bits for the
-    // following code. We cache the result until the frame is released.
-    if (frm->y_buffer_8bit)
-      frm_buffer = frm->y_buffer_8bit;
-    else
-      frm_buffer = frm->y_buffer_8bit = downconvert_frame(frm, bit_depth);
-  }
-  if (ref->flags & YV12_FLAG_HIGHBITDEPTH) {
-    if (ref->y_buffer_8bit)
-      ref_buffer = ref->y_buffer_8bit;
-    else
-      ref_buffer = ref->y_buffer_8bit = downconvert_frame(ref, bit_depth);
-  }
+  num_frm_corners = compute_frame_corners(frm, bit_depth);
+  num_ref_corners = compute_frame_corners(ref, bit_depth);
+  frm_buffer = get_frame_buffer_8bit(frm, bit_depth);
+  ref_buffer = get_frame_buffer_8bit(ref, bit_depth);
+#else
+  num_frm_corners = compute_frame_corners(frm, 8);
+  num_ref_corners = compute_frame_corners(ref, 8);
 #endif
 
-  // compute interest points in images using FAST features
-  num_frm_corners = fast_corner_detect(frm_buffer, frm->y_width, frm->y_height,
-                                       frm->y_stride, frm_corners, MAX_CORNERS);
-  num_ref_corners = fast_corner_detect(ref_buffer, ref->y_width, ref->y_height,
-                                       ref->y_stride, ref_corners, MAX_CORNERS);
-
   // find correspondences between the two images
   correspondences =
       (int *)malloc(num_frm_corners * 4 * sizeof(*correspondences));
   num_correspondences = determine_correspondence(
-      frm_buffer, (int *)frm_corners, num_frm_corners, ref_buffer,
-      (int *)ref_corners, num_ref_corners, frm->y_width, frm->y_height,
-      frm->y_stride, ref->y_stride, correspondences);
+      frm_buffer, frm->corners, num_frm_corners, ref_buffer, ref->corners,
+      num_ref_corners, frm->y_width, frm->y_height, frm->y_stride,
+      ref->y_stride, correspondences);
 
   ransac(correspondences, num_correspondences, num_inliers_by_motion,
          params_by_motion, num_motions);
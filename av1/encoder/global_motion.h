@@ -21,6 +21,7 @@ extern "C" {
 #endif
 
 #define RANSAC_NUM_MOTIONS 1
+#define MAX_CORNERS 4096
 
 extern const double gm_advantage_thresh[TRANS_TYPES];
 
@@ -42,6 +43,14 @@ double refine_integerized_param(WarpedMotionParams *wm,
                                 int r_stride, uint8_t *dst, int d_width,
                                 int d_height, int d_stride, int n_refinements);
 
+/*
+  Finds the FAST corners of the luma plane of "frm" and returns their number.
+  The corners are stored in frm->corners as (x, y) pairs, where they are kept
+  until the contents of the frame buffer change, so that they are only found
+  once for all the motion models and frames that they are matched against.
+*/
+int compute_frame_corners(YV12_BUFFER_CONFIG *frm, int bit_depth);
+
 /*
   Computes "num_motions" candidate global motion parameters between two frames.
   The array "params_by_motion" should be length 8 * "num_motions", where the
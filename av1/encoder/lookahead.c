@@ -9,7 +9,9 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "./aom_config.h"
 
@@ -17,6 +19,9 @@
 
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/extend.h"
+#if CONFIG_GLOBAL_MOTION
+#include "av1/encoder/global_motion.h"
+#endif
 #include "av1/encoder/lookahead.h"
 
 /* Return the buffer at the given absolute index and increment the index */
@@ -30,14 +35,28 @@ static struct lookahead_entry *pop(struct lookahead_ctx *ctx, int *idx) {
   return buf;
 }
 
+/* Return the image lent to the buffer, if any, leaving the buffer empty */
+static void release_lent_image(struct lookahead_entry *buf) {
+  if (buf->lent_img) {
+    aom_invalidate_frame_buffer_cache(&buf->img);
+    memset(&buf->img, 0, sizeof(buf->img));
+    buf->release_cb(buf->release_cb_priv, buf->lent_img);
+    buf->lent_img = NULL;
+  }
+}
+
 void av1_lookahead_destroy(struct lookahead_ctx *ctx) {
   if (ctx) {
     if (ctx->buf) {
       int i;
 
-      for (i = 0; i < ctx->max_sz; i++) aom_free_frame_buffer(&ctx->buf[i].img);
+      for (i = 0; i < ctx->max_sz; i++) {
+        release_lent_image(&ctx->buf[i]);
+        aom_free_frame_buffer(&ctx->buf[i].img);
+      }
       free(ctx->buf);
     }
+    free(ctx->static_age);
     free(ctx);
   }
 }
@@ -81,31 +100,60 @@ bail:
   return NULL;
 }
 
-#define USE_PARTIAL_COPY 0
+// Counts the frames each macroblock has been unchanged, as marked by the
+// active map, and returns whether any macroblock is unchanged. The counts are
+// reset if there is no map or the size of the frames changes.
+static int update_static_age(struct lookahead_ctx *ctx,
+                             const unsigned char *active_map, int mb_rows,
+                             int mb_cols) {
+  int i, any_static = 0;
+
+  if (mb_rows != ctx->mb_rows || mb_cols != ctx->mb_cols) {
+    free(ctx->static_age);
+    ctx->static_age = calloc(mb_rows * mb_cols, sizeof(*ctx->static_age));
+    ctx->mb_rows = ctx->static_age ? mb_rows : 0;
+    ctx->mb_cols = ctx->static_age ? mb_cols : 0;
+    return 0;
+  }
+  if (!active_map) {
+    memset(ctx->static_age, 0, mb_rows * mb_cols * sizeof(*ctx->static_age));
+    return 0;
+  }
+  for (i = 0; i < mb_rows * mb_cols; ++i) {
+    if (active_map[i]) {
+      ctx->static_age[i] = 0;
+    } else {
+      if (ctx->static_age[i] < UCHAR_MAX) ++ctx->static_age[i];
+      any_static = 1;
+    }
+  }
+  return any_static;
+}
 
 int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end,
 #if CONFIG_AOM_HIGHBITDEPTH
                        int use_highbitdepth,
 #endif
-                       aom_enc_frame_flags_t flags) {
+                       aom_enc_frame_flags_t flags,
+                       const unsigned char *active_map) {
   struct lookahead_entry *buf;
-#if USE_PARTIAL_COPY
   int row, col, active_end;
-  int mb_rows = (src->y_height + 15) >> 4;
-  int mb_cols = (src->y_width + 15) >> 4;
-#endif
+  int mb_rows = (src->y_crop_height + 15) >> 4;
+  int mb_cols = (src->y_crop_width + 15) >> 4;
   int width = src->y_crop_width;
   int height = src->y_crop_height;
   int uv_width = src->uv_crop_width;
   int uv_height = src->uv_crop_height;
   int subsampling_x = src->subsampling_x;
   int subsampling_y = src->subsampling_y;
-  int larger_dimensions, new_dimensions;
+  int larger_dimensions, new_dimensions, any_static;
 
   if (ctx->sz + 1 + MAX_PRE_FRAMES > ctx->max_sz) return 1;
   ctx->sz++;
   buf = pop(ctx, &ctx->write_idx);
+  release_lent_image(buf);
+  any_static = update_static_age(ctx, active_map, mb_rows, mb_cols);
 
   new_dimensions = width != buf->img.y_crop_width ||
                    height != buf->img.y_crop_height ||
@@ -116,46 +164,41 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                       uv_height > buf->img.uv_height;
   assert(!larger_dimensions || new_dimensions);
 
-#if USE_PARTIAL_COPY
-  // TODO(jkoleszar): This is disabled for now, as
-  // av1_copy_and_extend_frame_with_rect is not subsampling/alpha aware.
-
-  // Only do this partial copy if the following conditions are all met:
-  // 1. Lookahead queue has has size of 1.
-  // 2. Active map is provided.
-  // 3. This is not a key frame, golden nor altref frame.
-  if (!new_dimensions && ctx->max_sz == 1 && active_map && !flags) {
+  // Only do a partial copy if the buffer holds the frame pushed max_sz frames
+  // ago, and some macroblocks are unchanged since then. The copy of those is
+  // kept, including their extension when they touch the sides of the frame.
+  if (!new_dimensions && buf->copied && any_static) {
+    const unsigned char *static_age = ctx->static_age;
     for (row = 0; row < mb_rows; ++row) {
       col = 0;
 
       while (1) {
-        // Find the first active macroblock in this row.
+        // Find the first changed macroblock in this row.
         for (; col < mb_cols; ++col) {
-          if (active_map[col]) break;
+          if (static_age[col] < ctx->max_sz) break;
         }
 
-        // No more active macroblock in this row.
+        // No more changed macroblock in this row.
         if (col == mb_cols) break;
 
-        // Find the end of active region in this row.
+        // Find the end of changed region in this row.
         active_end = col;
 
         for (; active_end < mb_cols; ++active_end) {
-          if (!active_map[active_end]) break;
+          if (static_age[active_end] >= ctx->max_sz) break;
         }
 
-        // Only copy this active region.
+        // Only copy this changed region.
         av1_copy_and_extend_frame_with_rect(src, &buf->img, row << 4, col << 4,
                                             16, (active_end - col) << 4);
 
-        // Start again from the end of this active region.
+        // Start again from the end of this changed region.
         col = active_end;
       }
 
-      active_map += mb_cols;
+      static_age += mb_cols;
     }
   } else {
-#endif
     if (larger_dimensions) {
       YV12_BUFFER_CONFIG new_img;
       memset(&new_img, 0, sizeof(new_img));
@@ -176,18 +219,86 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
       buf->img.subsampling_x = src->subsampling_x;
       buf->img.subsampling_y = src->subsampling_y;
     }
-    // Partial copy not implemented yet
     av1_copy_and_extend_frame(src, &buf->img);
-#if USE_PARTIAL_COPY
   }
-#endif
 
+  // Drop the analysis cached for the previous image of this buffer.
+  aom_invalidate_frame_buffer_cache(&buf->img);
+
+  buf->ts_start = ts_start;
+  buf->ts_end = ts_end;
+  buf->flags = flags;
+  buf->top_left_extended = 1;
+  buf->copied = 1;
+  return 0;
+}
+
+int av1_lookahead_push_lent(struct lookahead_ctx *ctx,
+                            const YV12_BUFFER_CONFIG *src, aom_image_t *img,
+                            const aom_zero_copy_input_t *zero_copy,
+                            int64_t ts_start, int64_t ts_end,
+                            aom_enc_frame_flags_t flags) {
+  struct lookahead_entry *buf;
+  YV12_BUFFER_CONFIG *dst;
+
+  if (ctx->sz + 1 + MAX_PRE_FRAMES > ctx->max_sz) return 1;
+  ctx->sz++;
+  buf = pop(ctx, &ctx->write_idx);
+  release_lent_image(buf);
+  // The buffer of the entry is not needed while it holds lent images. It is
+  // allocated again if a later image of the entry is copied.
+  aom_free_frame_buffer(&buf->img);
+  // Which macroblocks of the image are unchanged is not known.
+  if (ctx->static_age)
+    memset(ctx->static_age, 0,
+           ctx->mb_rows * ctx->mb_cols * sizeof(*ctx->static_age));
+
+  // Describe the planes as a buffer allocated for the frame would.
+  dst = &buf->img;
+  dst->y_crop_width = src->y_crop_width;
+  dst->y_crop_height = src->y_crop_height;
+  dst->y_width = (src->y_crop_width + 7) & ~7;
+  dst->y_height = (src->y_crop_height + 7) & ~7;
+  dst->y_stride = src->y_stride;
+  dst->uv_crop_width = src->uv_crop_width;
+  dst->uv_crop_height = src->uv_crop_height;
+  dst->uv_width = dst->y_width >> src->subsampling_x;
+  dst->uv_height = dst->y_height >> src->subsampling_y;
+  dst->uv_stride = src->uv_stride;
+  dst->y_buffer = src->y_buffer;
+  dst->u_buffer = src->u_buffer;
+  dst->v_buffer = src->v_buffer;
+  dst->border = zero_copy->border;
+  dst->subsampling_x = src->subsampling_x;
+  dst->subsampling_y = src->subsampling_y;
+  dst->flags = src->flags;
+  av1_extend_frame_bottom_right(dst);
+
+  buf->lent_img = img;
+  buf->release_cb = zero_copy->release_cb;
+  buf->release_cb_priv = zero_copy->cb_priv;
+  buf->top_left_extended = 0;
+  buf->copied = 0;
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
   buf->flags = flags;
   return 0;
 }
 
+void av1_lookahead_prepare_search(struct lookahead_entry *entry) {
+  if (!entry->top_left_extended) {
+    av1_extend_frame_top_left(&entry->img);
+    entry->top_left_extended = 1;
+  }
+}
+
+#if CONFIG_GLOBAL_MOTION
+int av1_lookahead_analyze(struct lookahead_entry *entry, int bit_depth) {
+  compute_frame_corners(&entry->img, bit_depth);
+  return entry->img.corners == NULL;
+}
+#endif  // CONFIG_GLOBAL_MOTION
+
 struct lookahead_entry *av1_lookahead_pop(struct lookahead_ctx *ctx,
                                           int drain) {
   struct lookahead_entry *buf = NULL;
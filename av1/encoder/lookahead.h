@@ -14,6 +14,7 @@
 
 #include "aom_scale/yv12config.h"
 #include "aom/aom_integer.h"
+#include "aom/aomcx.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,11 @@ struct lookahead_entry {
   int64_t ts_start;
   int64_t ts_end;
   aom_enc_frame_flags_t flags;
+  aom_image_t *lent_img; /* Image lent by the application, read in place */
+  aom_release_input_cb_fn_t release_cb; /* Returns lent_img */
+  void *release_cb_priv;
+  int top_left_extended; /* Whether img may be searched for motion */
+  int copied; /* Whether img holds a copy of the frame last pushed to it */
 };
 
 // The max of past frames we want to keep in the queue.
@@ -37,8 +43,19 @@ struct lookahead_ctx {
   int read_idx;                /* Read index */
   int write_idx;               /* Write index */
   struct lookahead_entry *buf; /* Buffer list */
+  unsigned char *static_age;   /* Frames each macroblock has been unchanged */
+  int mb_rows;                 /* Size of static_age, in macroblocks */
+  int mb_cols;
 };
 
+#if CONFIG_GLOBAL_MOTION
+struct lookahead_analysis {
+  struct lookahead_entry *entries[MAX_LAG_BUFFERS]; /* Buffers to analyze */
+  int num_entries;                                  /* Number of buffers */
+  int bit_depth; /* Bit depth of the source images */
+};
+#endif  // CONFIG_GLOBAL_MOTION
+
 /**\brief Initializes the lookahead stage
  *
  * The lookahead stage is a queue of frame buffers on which some analysis
@@ -62,8 +79,9 @@ void av1_lookahead_destroy(struct lookahead_ctx *ctx);
  * This function will copy the source image into a new framebuffer with
  * the expected stride/border.
  *
- * If active_map is non-NULL and there is only one frame in the queue, then copy
- * only active macroblocks.
+ * If active_map is non-NULL, its inactive macroblocks are taken as unchanged
+ * since the previous frame. They are not copied if they were unchanged since
+ * the frame last pushed to the buffer, which holds them already.
  *
  * \param[in] ctx         Pointer to the lookahead context
  * \param[in] src         Pointer to the image to enqueue
@@ -77,7 +95,56 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
 #if CONFIG_AOM_HIGHBITDEPTH
                        int use_highbitdepth,
 #endif
-                       aom_enc_frame_flags_t flags);
+                       aom_enc_frame_flags_t flags,
+                       const unsigned char *active_map);
+
+/**\brief Enqueue a source buffer lent by the application
+ *
+ * The image is used in place, without a copy. Its right and bottom edges are
+ * extended into its border at once, its top and left ones only if it is
+ * searched for motion, see av1_lookahead_prepare_search(). The image is
+ * returned through the release callback once its buffer is reused or the
+ * lookahead stage is destroyed.
+ *
+ * \param[in] ctx         Pointer to the lookahead context
+ * \param[in] src         Pointer to the planes of the image to enqueue
+ * \param[in] img         Pointer to the image to return
+ * \param[in] zero_copy   Release callback and border of the image
+ * \param[in] ts_start    Timestamp for the start of this frame
+ * \param[in] ts_end      Timestamp for the end of this frame
+ * \param[in] flags       Flags set on this frame
+ *
+ * \retval 0, if the image was enqueued, in which case it is returned later
+ */
+int av1_lookahead_push_lent(struct lookahead_ctx *ctx,
+                            const YV12_BUFFER_CONFIG *src, aom_image_t *img,
+                            const aom_zero_copy_input_t *zero_copy,
+                            int64_t ts_start, int64_t ts_end,
+                            aom_enc_frame_flags_t flags);
+
+/**\brief Prepare a queued buffer to be searched for motion
+ *
+ * Extends the borders of a lent image that motion search reads around the
+ * frame, if that was not done yet.
+ *
+ * \param[in] entry       Pointer to the queued buffer
+ */
+void av1_lookahead_prepare_search(struct lookahead_entry *entry);
+
+#if CONFIG_GLOBAL_MOTION
+/**\brief Run the source analysis of a queued buffer
+ *
+ * The analysis only depends on the source image, so it may be run on any
+ * buffer of the queue ahead of its encoding, including from another thread
+ * while a different buffer is being encoded.
+ *
+ * \param[in] entry       Pointer to the queued buffer
+ * \param[in] bit_depth   Bit depth of the source image
+ *
+ * \retval 0, if the analysis is available
+ */
+int av1_lookahead_analyze(struct lookahead_entry *entry, int bit_depth);
+#endif  // CONFIG_GLOBAL_MOTION
 
 /**\brief Get the next source buffer to encode
  *
@@ -185,18 +185,13 @@ static INLINE const uint8_t *pre(const uint8_t *buf, int stride, int r, int c) {
 
 #define CHECK_BETTER0(v, r, c) CHECK_BETTER(v, r, c)
 
-static INLINE const uint8_t *upre(const uint8_t *buf, int stride, int r,
-                                  int c) {
-  return &buf[(r)*stride + (c)];
-}
-
 /* checks if (r, c) has better score than previous best */
 #define CHECK_BETTER1(v, r, c)                                         \
   if (c >= minc && c <= maxc && r >= minr && r <= maxr) {              \
     MV this_mv = { r, c };                                             \
     thismse = upsampled_pref_error(xd, vfp, src_address, src_stride,   \
-                                   upre(y, y_stride, r, c), y_stride,  \
-                                   second_pred, w, h, &sse);           \
+                                   pre_buf, r, c, second_pred, w, h,   \
+                                   &sse);                              \
     v = mv_err_cost(&this_mv, ref_mv, mvjcost, mvcost, error_per_bit); \
     v += thismse;                                                      \
     if (v < besterr) {                                                 \
@@ -605,49 +600,172 @@ static const MV search_step_table[12] = {
 };
 /* clang-format on */
 
+// Returns the pixel at (y, x) of the 8x up-sampled reference plane. As the
+// border of an up-sampled frame extends it, the positions outside the frame
+// take the value of the nearest up-sampled pixel inside it.
+static int upsampled_pixel(const MACROBLOCKD *xd, const struct buf_2d *pre,
+                           const int16_t *kernel, int y, int x) {
+  const int yc = clamp(y, 0, (pre->height << 3) - 1);
+  const int xc = clamp(x, 0, (pre->width << 3) - 1);
+  const int16_t *const filter_x = kernel + ((xc & 7) << 1) * SUBPEL_TAPS;
+  const int16_t *const filter_y = kernel + ((yc & 7) << 1) * SUBPEL_TAPS;
+  const int offset = ((yc >> 3) - SUBPEL_TAPS / 2 + 1) * pre->stride +
+                     (xc >> 3) - SUBPEL_TAPS / 2 + 1;
+  int sum = 0;
+  int i, k;
+
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+    const uint16_t *src = CONVERT_TO_SHORTPTR(pre->buf0) + offset;
+    for (i = 0; i < SUBPEL_TAPS; ++i, src += pre->stride) {
+      int hsum = 0;
+      for (k = 0; k < SUBPEL_TAPS; ++k) hsum += filter_x[k] * src[k];
+      sum += filter_y[i] *
+             clip_pixel_highbd(ROUND_POWER_OF_TWO(hsum, FILTER_BITS), xd->bd);
+    }
+    return clip_pixel_highbd(ROUND_POWER_OF_TWO(sum, FILTER_BITS), xd->bd);
+  }
+#else
+  (void)xd;
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  {
+    const uint8_t *src = pre->buf0 + offset;
+    for (i = 0; i < SUBPEL_TAPS; ++i, src += pre->stride) {
+      int hsum = 0;
+      for (k = 0; k < SUBPEL_TAPS; ++k) hsum += filter_x[k] * src[k];
+      sum += filter_y[i] * clip_pixel(ROUND_POWER_OF_TWO(hsum, FILTER_BITS));
+    }
+    return clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
+  }
+}
+
+// Predicts the w x h block at the 1/8 pel position (r, c) relative to the
+// block of pre, as the 8x up-sampled reference frame would: with the regular
+// 8-tap filter at the even 1/16 pel phases. The prediction is averaged with
+// second_pred if it is not NULL. Returns the prediction, which is either in
+// the reference itself or in dst, and its stride in *stride.
+static const uint8_t *upsampled_pred(const MACROBLOCKD *xd,
+                                     const struct buf_2d *pre, int r, int c,
+                                     const uint8_t *second_pred, uint8_t *dst,
+                                     int w, int h, int *stride) {
+  const InterpFilterParams params =
+      av1_get_interp_filter_params(EIGHTTAP_REGULAR);
+  const int16_t *const kernel = params.filter_ptr;
+  const int16_t *const filter_x = kernel + ((c & 7) << 1) * SUBPEL_TAPS;
+  const int16_t *const filter_y = kernel + ((r & 7) << 1) * SUBPEL_TAPS;
+  const int pos = (int)(pre->buf - pre->buf0);
+  // Full pixel position of the prediction in the frame.
+  const int row = pos / pre->stride + (r >> 3);
+  const int col = pos % pre->stride + (c >> 3);
+  const uint8_t *const src = pre->buf + (r >> 3) * pre->stride + (c >> 3);
+  const int inside = row >= 0 && col >= 0 && row + h <= pre->height &&
+                     col + w <= pre->width;
+  const int avg = second_pred != NULL;
+  int i, j;
+
+  assert(params.taps == SUBPEL_TAPS);
+
+  if (inside && !avg && !(r & 7) && !(c & 7)) {
+    *stride = pre->stride;
+    return src;
+  }
+
+  *stride = w;
+  if (!inside) {
+    // The block reaches the border of the up-sampled frame.
+    const int y = row * 8 + (r & 7);
+    const int x = col * 8 + (c & 7);
+#if CONFIG_AOM_HIGHBITDEPTH
+    if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+      const uint16_t *const pred16 = CONVERT_TO_SHORTPTR(second_pred);
+      uint16_t *const dst16 = CONVERT_TO_SHORTPTR(dst);
+      for (i = 0; i < h; ++i) {
+        for (j = 0; j < w; ++j) {
+          const int p = upsampled_pixel(xd, pre, kernel, y + i * 8, x + j * 8);
+          dst16[i * w + j] =
+              avg ? ROUND_POWER_OF_TWO(pred16[i * w + j] + p, 1) : p;
+        }
+      }
+      return dst;
+    }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    for (i = 0; i < h; ++i) {
+      for (j = 0; j < w; ++j) {
+        const int p = upsampled_pixel(xd, pre, kernel, y + i * 8, x + j * 8);
+        dst[i * w + j] =
+            avg ? ROUND_POWER_OF_TWO(second_pred[i * w + j] + p, 1) : p;
+      }
+    }
+    return dst;
+  }
+
+  // The average variants of the filters average with dst.
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+    highbd_convolve_fn_t convolve;
+    if (!(r & 7) && !(c & 7))
+      convolve = avg ? aom_highbd_convolve_avg : aom_highbd_convolve_copy;
+    else if (!(r & 7))
+      convolve =
+          avg ? aom_highbd_convolve8_avg_horiz : aom_highbd_convolve8_horiz;
+    else if (!(c & 7))
+      convolve =
+          avg ? aom_highbd_convolve8_avg_vert : aom_highbd_convolve8_vert;
+    else
+      convolve = avg ? aom_highbd_convolve8_avg : aom_highbd_convolve8;
+    if (avg)
+      memcpy(CONVERT_TO_SHORTPTR(dst), CONVERT_TO_SHORTPTR(second_pred),
+             w * h * sizeof(uint16_t));
+    convolve(src, pre->stride, dst, w, filter_x, 16, filter_y, 16, w, h,
+             xd->bd);
+    return dst;
+  }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+  {
+    convolve_fn_t convolve;
+    if (!(r & 7) && !(c & 7))
+      convolve = avg ? aom_convolve_avg : aom_convolve_copy;
+    else if (!(r & 7))
+      convolve = avg ? aom_convolve8_avg_horiz : aom_convolve8_horiz;
+    else if (!(c & 7))
+      convolve = avg ? aom_convolve8_avg_vert : aom_convolve8_vert;
+    else
+      convolve = avg ? aom_convolve8_avg : aom_convolve8;
+    if (avg) memcpy(dst, second_pred, w * h);
+    convolve(src, pre->stride, dst, w, filter_x, 16, filter_y, 16, w, h);
+    return dst;
+  }
+}
+
 static int upsampled_pref_error(const MACROBLOCKD *xd,
                                 const aom_variance_fn_ptr_t *vfp,
                                 const uint8_t *const src, const int src_stride,
-                                const uint8_t *const y, int y_stride,
+                                const struct buf_2d *pre, int r, int c,
                                 const uint8_t *second_pred, int w, int h,
                                 unsigned int *sse) {
-  unsigned int besterr;
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
-    DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
-    if (second_pred != NULL)
-      aom_highbd_comp_avg_upsampled_pred(pred16, second_pred, w, h, y,
-                                         y_stride);
-    else
-      aom_highbd_upsampled_pred(pred16, w, h, y, y_stride);
-
-    besterr = vfp->vf(CONVERT_TO_BYTEPTR(pred16), w, src, src_stride, sse);
-  } else {
-    DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
+  uint8_t *const pred = xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH
+                            ? CONVERT_TO_BYTEPTR(pred16)
+                            : (uint8_t *)pred16;
 #else
   DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
-  (void)xd;
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-    if (second_pred != NULL)
-      aom_comp_avg_upsampled_pred(pred, second_pred, w, h, y, y_stride);
-    else
-      aom_upsampled_pred(pred, w, h, y, y_stride);
-
-    besterr = vfp->vf(pred, w, src, src_stride, sse);
-#if CONFIG_AOM_HIGHBITDEPTH
-  }
-#endif
-  return besterr;
+  int stride;
+  const uint8_t *const p =
+      upsampled_pred(xd, pre, r, c, second_pred, pred, w, h, &stride);
+  return vfp->vf(p, stride, src, src_stride, sse);
 }
 
 static unsigned int upsampled_setup_center_error(
     const MACROBLOCKD *xd, const MV *bestmv, const MV *ref_mv,
     int error_per_bit, const aom_variance_fn_ptr_t *vfp,
-    const uint8_t *const src, const int src_stride, const uint8_t *const y,
-    int y_stride, const uint8_t *second_pred, int w, int h, int offset,
-    int *mvjcost, int *mvcost[2], unsigned int *sse1, int *distortion) {
-  unsigned int besterr = upsampled_pref_error(
-      xd, vfp, src, src_stride, y + offset, y_stride, second_pred, w, h, sse1);
+    const uint8_t *const src, const int src_stride, const struct buf_2d *pre,
+    const uint8_t *second_pred, int w, int h, int *mvjcost, int *mvcost[2],
+    unsigned int *sse1, int *distortion) {
+  unsigned int besterr =
+      upsampled_pref_error(xd, vfp, src, src_stride, pre, bestmv->row,
+                           bestmv->col, second_pred, w, h, sse1);
   *distortion = besterr;
   besterr += mv_err_cost(bestmv, ref_mv, mvjcost, mvcost, error_per_bit);
   return besterr;
@@ -671,6 +789,7 @@ int av1_find_best_sub_pixel_tree(MACROBLOCK *x, const MV *ref_mv, int allow_hp,
   MV *bestmv = &x->best_mv.as_mv;
   const int offset = bestmv->row * y_stride + bestmv->col;
   const uint8_t *const y = xd->plane[0].pre[0].buf;
+  const struct buf_2d *const pre_buf = &xd->plane[0].pre[0];
 
   int br = bestmv->row * 8;
   int bc = bestmv->col * 8;
@@ -696,9 +815,8 @@ int av1_find_best_sub_pixel_tree(MACROBLOCK *x, const MV *ref_mv, int allow_hp,
   // use_upsampled_ref can be 0 or 1
   if (use_upsampled_ref)
     besterr = upsampled_setup_center_error(
-        xd, bestmv, ref_mv, error_per_bit, vfp, src_address, src_stride, y,
-        y_stride, second_pred, w, h, (offset * 8), mvjcost, mvcost, sse1,
-        distortion);
+        xd, bestmv, ref_mv, error_per_bit, vfp, src_address, src_stride,
+        pre_buf, second_pred, w, h, mvjcost, mvcost, sse1, distortion);
   else
     besterr = setup_center_error(
         xd, bestmv, ref_mv, error_per_bit, vfp, src_address, src_stride, y,
@@ -715,11 +833,9 @@ int av1_find_best_sub_pixel_tree(MACROBLOCK *x, const MV *ref_mv, int allow_hp,
         MV this_mv = { tr, tc };
 
         if (use_upsampled_ref) {
-          const uint8_t *const pre_address = y + tr * y_stride + tc;
-
           thismse = upsampled_pref_error(xd, vfp, src_address, src_stride,
-                                         pre_address, y_stride, second_pred, w,
-                                         h, &sse);
+                                         pre_buf, tr, tc, second_pred, w, h,
+                                         &sse);
         } else {
           const uint8_t *const pre_address =
               y + (tr >> 3) * y_stride + (tc >> 3);
@@ -755,11 +871,9 @@ int av1_find_best_sub_pixel_tree(MACROBLOCK *x, const MV *ref_mv, int allow_hp,
       MV this_mv = { tr, tc };
 
       if (use_upsampled_ref) {
-        const uint8_t *const pre_address = y + tr * y_stride + tc;
-
-        thismse =
-            upsampled_pref_error(xd, vfp, src_address, src_stride, pre_address,
-                                 y_stride, second_pred, w, h, &sse);
+        thismse = upsampled_pref_error(xd, vfp, src_address, src_stride,
+                                       pre_buf, tr, tc, second_pred, w, h,
+                                       &sse);
       } else {
         const uint8_t *const pre_address = y + (tr >> 3) * y_stride + (tc >> 3);
 
@@ -2369,8 +2483,8 @@ int av1_full_pixel_search(const AV1_COMP *cpi, MACROBLOCK *x, BLOCK_SIZE bsize,
 #define CHECK_BETTER1(v, r, c)                                                 \
   if (c >= minc && c <= maxc && r >= minr && r <= maxr) {                      \
     thismse = upsampled_masked_pref_error(xd, mask, mask_stride, vfp, z,       \
-                                          src_stride, upre(y, y_stride, r, c), \
-                                          y_stride, w, h, &sse);               \
+                                          src_stride, pre_buf, r, c, w, h,     \
+                                          &sse);                               \
     if ((v = MVC(r, c) + thismse) < besterr) {                                 \
       besterr = v;                                                             \
       br = r;                                                                  \
@@ -2488,57 +2602,46 @@ static int upsampled_masked_pref_error(const MACROBLOCKD *xd,
                                        const aom_variance_fn_ptr_t *vfp,
                                        const uint8_t *const src,
                                        const int src_stride,
-                                       const uint8_t *const y, int y_stride,
+                                       const struct buf_2d *pre, int r, int c,
                                        int w, int h, unsigned int *sse) {
-  unsigned int besterr;
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
-    DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
-    aom_highbd_upsampled_pred(pred16, w, h, y, y_stride);
-
-    besterr = vfp->mvf(CONVERT_TO_BYTEPTR(pred16), w, src, src_stride, mask,
-                       mask_stride, sse);
-  } else {
-    DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
+  uint8_t *const pred = xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH
+                            ? CONVERT_TO_BYTEPTR(pred16)
+                            : (uint8_t *)pred16;
 #else
   DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
-  (void)xd;
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-    aom_upsampled_pred(pred, w, h, y, y_stride);
-
-    besterr = vfp->mvf(pred, w, src, src_stride, mask, mask_stride, sse);
-#if CONFIG_AOM_HIGHBITDEPTH
-  }
-#endif
-  return besterr;
+  int stride;
+  const uint8_t *const p =
+      upsampled_pred(xd, pre, r, c, NULL, pred, w, h, &stride);
+  return vfp->mvf(p, stride, src, src_stride, mask, mask_stride, sse);
 }
 
 static unsigned int upsampled_setup_masked_center_error(
     const MACROBLOCKD *xd, const uint8_t *mask, int mask_stride,
     const MV *bestmv, const MV *ref_mv, int error_per_bit,
     const aom_variance_fn_ptr_t *vfp, const uint8_t *const src,
-    const int src_stride, const uint8_t *const y, int y_stride, int w, int h,
-    int offset, int *mvjcost, int *mvcost[2], unsigned int *sse1,
-    int *distortion) {
+    const int src_stride, const struct buf_2d *pre, int w, int h,
+    int *mvjcost, int *mvcost[2], unsigned int *sse1, int *distortion) {
   unsigned int besterr =
       upsampled_masked_pref_error(xd, mask, mask_stride, vfp, src, src_stride,
-                                  y + offset, y_stride, w, h, sse1);
+                                  pre, bestmv->row, bestmv->col, w, h, sse1);
   *distortion = besterr;
   besterr += mv_err_cost(bestmv, ref_mv, mvjcost, mvcost, error_per_bit);
   return besterr;
 }
 
 int av1_find_best_masked_sub_pixel_tree_up(
-    const AV1_COMP *cpi, MACROBLOCK *x, const uint8_t *mask, int mask_stride,
-    int mi_row, int mi_col, MV *bestmv, const MV *ref_mv, int allow_hp,
-    int error_per_bit, const aom_variance_fn_ptr_t *vfp, int forced_stop,
-    int iters_per_step, int *mvjcost, int *mvcost[2], int *distortion,
-    unsigned int *sse1, int is_second, int use_upsampled_ref) {
+    MACROBLOCK *x, const uint8_t *mask, int mask_stride, MV *bestmv,
+    const MV *ref_mv, int allow_hp, int error_per_bit,
+    const aom_variance_fn_ptr_t *vfp, int forced_stop, int iters_per_step,
+    int *mvjcost, int *mvcost[2], int *distortion, unsigned int *sse1,
+    int is_second, int use_upsampled_ref) {
   const uint8_t *const z = x->plane[0].src.buf;
   const uint8_t *const src_address = z;
   const int src_stride = x->plane[0].src.stride;
   MACROBLOCKD *xd = &x->e_mbd;
-  struct macroblockd_plane *const pd = &xd->plane[0];
   MB_MODE_INFO *mbmi = &xd->mi[0]->mbmi;
   unsigned int besterr = INT_MAX;
   unsigned int sse;
@@ -2563,22 +2666,10 @@ int av1_find_best_masked_sub_pixel_tree_up(
   int kr, kc;
   const int w = block_size_wide[mbmi->sb_type];
   const int h = block_size_high[mbmi->sb_type];
-  int offset;
-  int y_stride;
-  const uint8_t *y;
-
-  const struct buf_2d backup_pred = pd->pre[is_second];
-  if (use_upsampled_ref) {
-    int ref = xd->mi[0]->mbmi.ref_frame[is_second];
-    const YV12_BUFFER_CONFIG *upsampled_ref = get_upsampled_ref(cpi, ref);
-    setup_pred_plane(&pd->pre[is_second], upsampled_ref->y_buffer,
-                     upsampled_ref->y_crop_width, upsampled_ref->y_crop_height,
-                     upsampled_ref->y_stride, (mi_row << 3), (mi_col << 3),
-                     NULL, pd->subsampling_x, pd->subsampling_y);
-  }
-  y = pd->pre[is_second].buf;
-  y_stride = pd->pre[is_second].stride;
-  offset = bestmv->row * y_stride + bestmv->col;
+  const struct buf_2d *const pre_buf = &xd->plane[0].pre[is_second];
+  const uint8_t *const y = pre_buf->buf;
+  const int y_stride = pre_buf->stride;
+  const int offset = bestmv->row * y_stride + bestmv->col;
 
   if (!allow_hp)
     if (round == 3) round = 2;
@@ -2590,8 +2681,7 @@ int av1_find_best_masked_sub_pixel_tree_up(
   if (use_upsampled_ref)
     besterr = upsampled_setup_masked_center_error(
         xd, mask, mask_stride, bestmv, ref_mv, error_per_bit, vfp, z,
-        src_stride, y, y_stride, w, h, (offset * 8), mvjcost, mvcost, sse1,
-        distortion);
+        src_stride, pre_buf, w, h, mvjcost, mvcost, sse1, distortion);
   else
     besterr = setup_masked_center_error(
         mask, mask_stride, bestmv, ref_mv, error_per_bit, vfp, z, src_stride, y,
@@ -2606,11 +2696,9 @@ int av1_find_best_masked_sub_pixel_tree_up(
         MV this_mv = { tr, tc };
 
         if (use_upsampled_ref) {
-          const uint8_t *const pre_address = y + tr * y_stride + tc;
-
-          thismse = upsampled_masked_pref_error(
-              xd, mask, mask_stride, vfp, src_address, src_stride, pre_address,
-              y_stride, w, h, &sse);
+          thismse = upsampled_masked_pref_error(xd, mask, mask_stride, vfp,
+                                                src_address, src_stride,
+                                                pre_buf, tr, tc, w, h, &sse);
         } else {
           const uint8_t *const pre_address =
               y + (tr >> 3) * y_stride + (tc >> 3);
@@ -2642,11 +2730,9 @@ int av1_find_best_masked_sub_pixel_tree_up(
       MV this_mv = { tr, tc };
 
       if (use_upsampled_ref) {
-        const uint8_t *const pre_address = y + tr * y_stride + tc;
-
-        thismse = upsampled_masked_pref_error(
-            xd, mask, mask_stride, vfp, src_address, src_stride, pre_address,
-            y_stride, w, h, &sse);
+        thismse = upsampled_masked_pref_error(xd, mask, mask_stride, vfp,
+                                              src_address, src_stride, pre_buf,
+                                              tr, tc, w, h, &sse);
       } else {
         const uint8_t *const pre_address = y + (tr >> 3) * y_stride + (tc >> 3);
 
@@ -2699,10 +2785,6 @@ int av1_find_best_masked_sub_pixel_tree_up(
   bestmv->row = br;
   bestmv->col = bc;
 
-  if (use_upsampled_ref) {
-    pd->pre[is_second] = backup_pred;
-  }
-
   if ((abs(bestmv->col - ref_mv->col) > (MAX_FULL_PEL_VAL << 3)) ||
       (abs(bestmv->row - ref_mv->row) > (MAX_FULL_PEL_VAL << 3)))
     return INT_MAX;
@@ -2964,8 +3046,8 @@ int av1_masked_full_pixel_diamond(const AV1_COMP *cpi, MACROBLOCK *x,
 #undef CHECK_BETTER1
 #define CHECK_BETTER1(v, r, c)                                            \
   if (c >= minc && c <= maxc && r >= minr && r <= maxr) {                 \
-    thismse = upsampled_obmc_pref_error(                                  \
-        xd, mask, vfp, z, upre(y, y_stride, r, c), y_stride, w, h, &sse); \
+    thismse = upsampled_obmc_pref_error(xd, mask, vfp, z, pre_buf, r, c, w, \
+                                        h, &sse);                         \
     if ((v = MVC(r, c) + thismse) < besterr) {                            \
       besterr = v;                                                        \
       br = r;                                                             \
@@ -2992,55 +3074,44 @@ static unsigned int setup_obmc_center_error(
 static int upsampled_obmc_pref_error(const MACROBLOCKD *xd, const int32_t *mask,
                                      const aom_variance_fn_ptr_t *vfp,
                                      const int32_t *const wsrc,
-                                     const uint8_t *const y, int y_stride,
+                                     const struct buf_2d *pre, int r, int c,
                                      int w, int h, unsigned int *sse) {
-  unsigned int besterr;
 #if CONFIG_AOM_HIGHBITDEPTH
-  if (xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
-    DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
-    aom_highbd_upsampled_pred(pred16, w, h, y, y_stride);
-
-    besterr = vfp->ovf(CONVERT_TO_BYTEPTR(pred16), w, wsrc, mask, sse);
-  } else {
-    DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, pred16[MAX_SB_SQUARE]);
+  uint8_t *const pred = xd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH
+                            ? CONVERT_TO_BYTEPTR(pred16)
+                            : (uint8_t *)pred16;
 #else
   DECLARE_ALIGNED(16, uint8_t, pred[MAX_SB_SQUARE]);
-  (void)xd;
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-    aom_upsampled_pred(pred, w, h, y, y_stride);
-
-    besterr = vfp->ovf(pred, w, wsrc, mask, sse);
-#if CONFIG_AOM_HIGHBITDEPTH
-  }
-#endif
-  return besterr;
+  int stride;
+  const uint8_t *const p =
+      upsampled_pred(xd, pre, r, c, NULL, pred, w, h, &stride);
+  return vfp->ovf(p, stride, wsrc, mask, sse);
 }
 
 static unsigned int upsampled_setup_obmc_center_error(
     const MACROBLOCKD *xd, const int32_t *mask, const MV *bestmv,
     const MV *ref_mv, int error_per_bit, const aom_variance_fn_ptr_t *vfp,
-    const int32_t *const wsrc, const uint8_t *const y, int y_stride, int w,
-    int h, int offset, int *mvjcost, int *mvcost[2], unsigned int *sse1,
-    int *distortion) {
+    const int32_t *const wsrc, const struct buf_2d *pre, int w, int h,
+    int *mvjcost, int *mvcost[2], unsigned int *sse1, int *distortion) {
   unsigned int besterr = upsampled_obmc_pref_error(
-      xd, mask, vfp, wsrc, y + offset, y_stride, w, h, sse1);
+      xd, mask, vfp, wsrc, pre, bestmv->row, bestmv->col, w, h, sse1);
   *distortion = besterr;
   besterr += mv_err_cost(bestmv, ref_mv, mvjcost, mvcost, error_per_bit);
   return besterr;
 }
 
 int av1_find_best_obmc_sub_pixel_tree_up(
-    const AV1_COMP *cpi, MACROBLOCK *x, int mi_row, int mi_col, MV *bestmv,
-    const MV *ref_mv, int allow_hp, int error_per_bit,
-    const aom_variance_fn_ptr_t *vfp, int forced_stop, int iters_per_step,
-    int *mvjcost, int *mvcost[2], int *distortion, unsigned int *sse1,
-    int is_second, int use_upsampled_ref) {
+    MACROBLOCK *x, MV *bestmv, const MV *ref_mv, int allow_hp,
+    int error_per_bit, const aom_variance_fn_ptr_t *vfp, int forced_stop,
+    int iters_per_step, int *mvjcost, int *mvcost[2], int *distortion,
+    unsigned int *sse1, int is_second, int use_upsampled_ref) {
   const int32_t *wsrc = x->wsrc_buf;
   const int32_t *mask = x->mask_buf;
   const int *const z = wsrc;
   const int *const src_address = z;
   MACROBLOCKD *xd = &x->e_mbd;
-  struct macroblockd_plane *const pd = &xd->plane[0];
   MB_MODE_INFO *mbmi = &xd->mi[0]->mbmi;
   unsigned int besterr = INT_MAX;
   unsigned int sse;
@@ -3065,22 +3136,10 @@ int av1_find_best_obmc_sub_pixel_tree_up(
   int kr, kc;
   const int w = block_size_wide[mbmi->sb_type];
   const int h = block_size_high[mbmi->sb_type];
-  int offset;
-  int y_stride;
-  const uint8_t *y;
-
-  const struct buf_2d backup_pred = pd->pre[is_second];
-  if (use_upsampled_ref) {
-    int ref = xd->mi[0]->mbmi.ref_frame[is_second];
-    const YV12_BUFFER_CONFIG *upsampled_ref = get_upsampled_ref(cpi, ref);
-    setup_pred_plane(&pd->pre[is_second], upsampled_ref->y_buffer,
-                     upsampled_ref->y_crop_width, upsampled_ref->y_crop_height,
-                     upsampled_ref->y_stride, (mi_row << 3), (mi_col << 3),
-                     NULL, pd->subsampling_x, pd->subsampling_y);
-  }
-  y = pd->pre[is_second].buf;
-  y_stride = pd->pre[is_second].stride;
-  offset = bestmv->row * y_stride + bestmv->col;
+  const struct buf_2d *const pre_buf = &xd->plane[0].pre[is_second];
+  const uint8_t *const y = pre_buf->buf;
+  const int y_stride = pre_buf->stride;
+  const int offset = bestmv->row * y_stride + bestmv->col;
 
   if (!allow_hp)
     if (round == 3) round = 2;
@@ -3090,8 +3149,8 @@ int av1_find_best_obmc_sub_pixel_tree_up(
   // use_upsampled_ref can be 0 or 1
   if (use_upsampled_ref)
     besterr = upsampled_setup_obmc_center_error(
-        xd, mask, bestmv, ref_mv, error_per_bit, vfp, z, y, y_stride, w, h,
-        (offset * 8), mvjcost, mvcost, sse1, distortion);
+        xd, mask, bestmv, ref_mv, error_per_bit, vfp, z, pre_buf, w, h,
+        mvjcost, mvcost, sse1, distortion);
   else
     besterr = setup_obmc_center_error(mask, bestmv, ref_mv, error_per_bit, vfp,
                                       z, y, y_stride, offset, mvjcost, mvcost,
@@ -3106,10 +3165,8 @@ int av1_find_best_obmc_sub_pixel_tree_up(
         MV this_mv = { tr, tc };
 
         if (use_upsampled_ref) {
-          const uint8_t *const pre_address = y + tr * y_stride + tc;
-
-          thismse = upsampled_obmc_pref_error(
-              xd, mask, vfp, src_address, pre_address, y_stride, w, h, &sse);
+          thismse = upsampled_obmc_pref_error(xd, mask, vfp, src_address,
+                                              pre_buf, tr, tc, w, h, &sse);
         } else {
           const uint8_t *const pre_address =
               y + (tr >> 3) * y_stride + (tc >> 3);
@@ -3140,10 +3197,8 @@ int av1_find_best_obmc_sub_pixel_tree_up(
       MV this_mv = { tr, tc };
 
       if (use_upsampled_ref) {
-        const uint8_t *const pre_address = y + tr * y_stride + tc;
-
-        thismse = upsampled_obmc_pref_error(xd, mask, vfp, src_address,
-                                            pre_address, y_stride, w, h, &sse);
+        thismse = upsampled_obmc_pref_error(xd, mask, vfp, src_address, pre_buf,
+                                            tr, tc, w, h, &sse);
       } else {
         const uint8_t *const pre_address = y + (tr >> 3) * y_stride + (tc >> 3);
 
@@ -3196,10 +3251,6 @@ int av1_find_best_obmc_sub_pixel_tree_up(
   bestmv->row = br;
   bestmv->col = bc;
 
-  if (use_upsampled_ref) {
-    pd->pre[is_second] = backup_pred;
-  }
-
   if ((abs(bestmv->col - ref_mv->col) > (MAX_FULL_PEL_VAL << 3)) ||
       (abs(bestmv->row - ref_mv->row) > (MAX_FULL_PEL_VAL << 3)))
     return INT_MAX;
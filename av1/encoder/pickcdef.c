@@ -9,18 +9,25 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
-#include <math.h>
 #include <string.h>
 
 #include "./aom_scale_rtcd.h"
+#include "./av1_rtcd.h"
 #include "aom/aom_integer.h"
 #include "av1/common/cdef.h"
 #include "av1/common/onyxc_int.h"
 #include "av1/common/reconinter.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/pickcdef.h"
 
 #define TOTAL_STRENGTHS (DERING_STRENGTHS * CLPF_STRENGTHS)
 
+/* With prune_strengths, the luma dering levels are first tried every
+   CDEF_PRUNE_STEP levels, then around the best of them. */
+#define CDEF_PRUNE_STEP 4
+
+#define MAX_NUM_CDEF_SEARCH_THREADS 64
+
 /* Search for the best strength to add as an option, knowing we
    already selected nb_strengths options. */
 static uint64_t search_one(int *lev, int nb_strengths,
@@ -165,10 +172,8 @@ static void copy_sb16_16(uint16_t *dst, int dstride, const uint16_t *src,
   }
 }
 
-static INLINE uint64_t dist_8x8_16bit(uint16_t *dst, int dstride, uint16_t *src,
-                                      int sstride, int coeff_shift) {
-  uint64_t svar = 0;
-  uint64_t dvar = 0;
+uint64_t dist_8x8_16bit_c(uint16_t *dst, int dstride, uint16_t *src,
+                          int sstride, int coeff_shift) {
   uint64_t sum_s = 0;
   uint64_t sum_d = 0;
   uint64_t sum_s2 = 0;
@@ -184,18 +189,11 @@ static INLINE uint64_t dist_8x8_16bit(uint16_t *dst, int dstride, uint16_t *src,
       sum_sd += src[i * sstride + j] * dst[i * dstride + j];
     }
   }
-  /* Compute the variance -- the calculation cannot go negative. */
-  svar = sum_s2 - ((sum_s * sum_s + 32) >> 6);
-  dvar = sum_d2 - ((sum_d * sum_d + 32) >> 6);
-  return (uint64_t)floor(
-      .5 +
-      (sum_d2 + sum_s2 - 2 * sum_sd) * .5 *
-          (svar + dvar + (400 << 2 * coeff_shift)) /
-          (sqrt((20000 << 4 * coeff_shift) + svar * (double)dvar)));
+  return dist_8x8_from_sums(sum_s, sum_d, sum_s2, sum_d2, sum_sd, coeff_shift);
 }
 
-static INLINE uint64_t mse_8x8_16bit(uint16_t *dst, int dstride, uint16_t *src,
-                                     int sstride) {
+uint64_t mse_8x8_16bit_c(uint16_t *dst, int dstride, uint16_t *src,
+                         int sstride) {
   uint64_t sum = 0;
   int i, j;
   for (i = 0; i < 8; i++) {
@@ -221,9 +219,9 @@ static INLINE uint64_t mse_4x4_16bit(uint16_t *dst, int dstride, uint16_t *src,
 }
 
 /* Compute MSE only on the blocks we filtered. */
-uint64_t compute_dering_dist(uint16_t *dst, int dstride, uint16_t *src,
-                             dering_list *dlist, int dering_count,
-                             BLOCK_SIZE bsize, int coeff_shift, int pli) {
+uint64_t compute_dering_dist_c(uint16_t *dst, int dstride, uint16_t *src,
+                               dering_list *dlist, int dering_count,
+                               BLOCK_SIZE bsize, int coeff_shift, int pli) {
   uint64_t sum = 0;
   int bi, bx, by;
   if (bsize == BLOCK_8X8) {
@@ -231,11 +229,11 @@ uint64_t compute_dering_dist(uint16_t *dst, int dstride, uint16_t *src,
       by = dlist[bi].by;
       bx = dlist[bi].bx;
       if (pli == 0) {
-        sum += dist_8x8_16bit(&dst[(by << 3) * dstride + (bx << 3)], dstride,
-                              &src[bi << (3 + 3)], 8, coeff_shift);
+        sum += dist_8x8_16bit_c(&dst[(by << 3) * dstride + (bx << 3)],
+                                dstride, &src[bi << (3 + 3)], 8, coeff_shift);
       } else {
-        sum += mse_8x8_16bit(&dst[(by << 3) * dstride + (bx << 3)], dstride,
-                             &src[bi << (3 + 3)], 8);
+        sum += mse_8x8_16bit_c(&dst[(by << 3) * dstride + (bx << 3)], dstride,
+                               &src[bi << (3 + 3)], 8);
       }
     }
   } else if (bsize == BLOCK_4X8) {
@@ -268,24 +266,243 @@ uint64_t compute_dering_dist(uint16_t *dst, int dstride, uint16_t *src,
   return sum >> 2 * coeff_shift;
 }
 
-void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                     AV1_COMMON *cm, MACROBLOCKD *xd) {
-  int r, c;
-  int sbr, sbc;
+/* Frame level state of the strength search, shared by the threads that
+   search the superblocks. */
+typedef struct {
+  AV1_COMMON *cm;
   uint16_t *src[3];
   uint16_t *ref_coeff[3];
-  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
-  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
-  int var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS] = { { 0 } };
   int stride[3];
   int bsize[3];
   int mi_wide_l2[3];
   int mi_high_l2[3];
   int xdec[3];
   int ydec[3];
-  int pli;
+  int nplanes;
+  int nvsb;
+  int nhsb;
+  int coeff_shift;
+  int clpf_damping;
+  int chroma_dering;
+  int prune_strengths;
+  /* Position (sbr * nhsb + sbc) of the superblocks that have blocks to
+     filter. */
+  int *sb_pos;
+  int sb_count;
+  uint64_t (*mse[2])[TOTAL_STRENGTHS];
+  int num_threads;
+} CdefSearchCtxt;
+
+/* State of the superblock being searched. */
+typedef struct {
+  int sbr;
+  int sbc;
+  int nvb;
+  int nhb;
+  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
   int dering_count;
-  int coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
+  int dir[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  int var[OD_DERING_NBLOCKS][OD_DERING_NBLOCKS];
+  int dirinit;
+  uint16_t *in;
+  uint16_t *tmp_dst;
+} CdefSearchSb;
+
+/* Filter a plane of the superblock with strength gi and return the
+   distortion. The strengths of a dering level must be tried in increasing
+   clpf strength, as the clpf is applied on top of the dering output left in
+   sb->in. */
+static uint64_t try_strength(const CdefSearchCtxt *ctxt, CdefSearchSb *sb,
+                             int pli, int gi) {
+  const int sbr = sb->sbr;
+  const int sbc = sb->sbc;
+  int threshold;
+  int clpf_strength;
+  threshold = gi / CLPF_STRENGTHS;
+  if (pli > 0 && !ctxt->chroma_dering) threshold = 0;
+  /* We avoid filtering the pixels for which some of the pixels to average
+     are outside the frame. We could change the filter instead, but it would
+     add special cases for any future vectorization. */
+  int yoff = OD_FILT_VBORDER * (sbr != 0);
+  int xoff = OD_FILT_HBORDER * (sbc != 0);
+  int ysize = (sb->nvb << ctxt->mi_high_l2[pli]) +
+              OD_FILT_VBORDER * (sbr != ctxt->nvsb - 1) + yoff;
+  int xsize = (sb->nhb << ctxt->mi_wide_l2[pli]) +
+              OD_FILT_HBORDER * (sbc != ctxt->nhsb - 1) + xoff;
+  clpf_strength = gi % CLPF_STRENGTHS;
+  if (clpf_strength == 0)
+    copy_sb16_16(&sb->in[(-yoff * OD_FILT_BSTRIDE - xoff)], OD_FILT_BSTRIDE,
+                 ctxt->src[pli],
+                 (sbr * MAX_MIB_SIZE << ctxt->mi_high_l2[pli]) - yoff,
+                 (sbc * MAX_MIB_SIZE << ctxt->mi_wide_l2[pli]) - xoff,
+                 ctxt->stride[pli], ysize, xsize);
+  od_dering(clpf_strength ? NULL : (uint8_t *)sb->in, OD_FILT_BSTRIDE,
+            sb->tmp_dst, sb->in, ctxt->xdec[pli], ctxt->ydec[pli], sb->dir,
+            &sb->dirinit, sb->var, pli, sb->dlist, sb->dering_count, threshold,
+            clpf_strength + (clpf_strength == 3), ctxt->clpf_damping,
+            ctxt->coeff_shift, clpf_strength != 0, 1);
+  return compute_dering_dist(
+      ctxt->ref_coeff[pli] +
+          (sbr * MAX_MIB_SIZE << ctxt->mi_high_l2[pli]) * ctxt->stride[pli] +
+          (sbc * MAX_MIB_SIZE << ctxt->mi_wide_l2[pli]),
+      ctxt->stride[pli], sb->tmp_dst, sb->dlist, sb->dering_count,
+      ctxt->bsize[pli], ctxt->coeff_shift, pli);
+}
+
+/* Try all the clpf strengths with a dering level, and return the lowest
+   distortion. */
+static uint64_t try_level(const CdefSearchCtxt *ctxt, CdefSearchSb *sb,
+                          int pli, int level, uint64_t *plane_mse) {
+  uint64_t best_mse = (uint64_t)1 << 63;
+  int gi;
+  for (gi = level * CLPF_STRENGTHS; gi < (level + 1) * CLPF_STRENGTHS; gi++) {
+    plane_mse[gi] = try_strength(ctxt, sb, pli, gi);
+    best_mse = AOMMIN(best_mse, plane_mse[gi]);
+  }
+  return best_mse;
+}
+
+/* Whether od_dir_find8() found a direction in any block of the superblock.
+   Its var is the contrast between the best direction and the orthogonal
+   one, which od_adjust_thresh() turns into the dering threshold. */
+static int sb_has_direction(const CdefSearchSb *sb) {
+  int bi;
+  for (bi = 0; bi < sb->dering_count; bi++)
+    if (sb->var[sb->dlist[bi].by][sb->dlist[bi].bx] >> 6) return 1;
+  return 0;
+}
+
+/* Try a subset of the luma dering levels, chosen from the directions found
+   by the level 0 pass. Superblocks without any direction only try level 0,
+   the others try every CDEF_PRUNE_STEP levels and then the levels around the
+   best one. The levels that are not tried get the distortion of the nearest
+   level tried. */
+static void search_luma_pruned(const CdefSearchCtxt *ctxt, CdefSearchSb *sb,
+                               uint64_t *plane_mse) {
+  int tried[DERING_STRENGTHS] = { 0 };
+  int level;
+  int best_level = 0;
+  uint64_t best_mse;
+  int gi;
+  best_mse = try_level(ctxt, sb, 0, 0, plane_mse);
+  tried[0] = 1;
+  if (sb_has_direction(sb)) {
+    for (level = CDEF_PRUNE_STEP; level < DERING_STRENGTHS;
+         level += CDEF_PRUNE_STEP) {
+      const uint64_t curr_mse = try_level(ctxt, sb, 0, level, plane_mse);
+      tried[level] = 1;
+      if (curr_mse < best_mse) {
+        best_mse = curr_mse;
+        best_level = level;
+      }
+    }
+    for (level = AOMMAX(best_level - CDEF_PRUNE_STEP + 1, 1);
+         level < AOMMIN(best_level + CDEF_PRUNE_STEP, DERING_STRENGTHS);
+         level++) {
+      if (tried[level]) continue;
+      try_level(ctxt, sb, 0, level, plane_mse);
+      tried[level] = 1;
+    }
+  }
+  for (level = 0; level < DERING_STRENGTHS; level++) {
+    int nearest = level;
+    int d;
+    for (d = 1; !tried[nearest]; d++) {
+      if (level - d >= 0 && tried[level - d])
+        nearest = level - d;
+      else if (level + d < DERING_STRENGTHS && tried[level + d])
+        nearest = level + d;
+    }
+    for (gi = 0; gi < CLPF_STRENGTHS; gi++)
+      plane_mse[level * CLPF_STRENGTHS + gi] =
+          plane_mse[nearest * CLPF_STRENGTHS + gi];
+  }
+}
+
+/* Try all the strengths on one superblock, and store their distortion. */
+static void search_sb(const CdefSearchCtxt *ctxt, int sb_idx) {
+  DECLARE_ALIGNED(32, uint16_t, inbuf[OD_DERING_INBUF_SIZE]);
+  DECLARE_ALIGNED(32, uint16_t, tmp_dst[MAX_SB_SQUARE]);
+  AV1_COMMON *const cm = ctxt->cm;
+  CdefSearchSb sb;
+  int pli;
+  int gi;
+  int i;
+  sb.sbr = ctxt->sb_pos[sb_idx] / ctxt->nhsb;
+  sb.sbc = ctxt->sb_pos[sb_idx] % ctxt->nhsb;
+  sb.nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sb.sbc);
+  sb.nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sb.sbr);
+  sb.dering_count = sb_compute_dering_list(cm, sb.sbr * MAX_MIB_SIZE,
+                                           sb.sbc * MAX_MIB_SIZE, sb.dlist);
+  memset(sb.dir, 0, sizeof(sb.dir));
+  memset(sb.var, 0, sizeof(sb.var));
+  sb.dirinit = 0;
+  sb.in = inbuf + OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER;
+  sb.tmp_dst = tmp_dst;
+  for (pli = 0; pli < ctxt->nplanes; pli++) {
+    uint64_t plane_mse[TOTAL_STRENGTHS];
+    for (i = 0; i < OD_DERING_INBUF_SIZE; i++) inbuf[i] = OD_DERING_VERY_LARGE;
+    if (pli == 0 && ctxt->prune_strengths) {
+      search_luma_pruned(ctxt, &sb, plane_mse);
+    } else {
+      for (gi = 0; gi < TOTAL_STRENGTHS; gi++)
+        plane_mse[gi] = try_strength(ctxt, &sb, pli, gi);
+    }
+    if (pli < 2) {
+      memcpy(ctxt->mse[pli][sb_idx], plane_mse, sizeof(plane_mse));
+    } else {
+      for (gi = 0; gi < TOTAL_STRENGTHS; gi++)
+        ctxt->mse[1][sb_idx][gi] += plane_mse[gi];
+    }
+  }
+}
+
+static int search_sbs_worker(const CdefSearchCtxt *ctxt, int *start) {
+  int sb;
+  for (sb = *start; sb < ctxt->sb_count; sb += ctxt->num_threads)
+    search_sb(ctxt, sb);
+  return 1;
+}
+
+/* Search the superblocks on num_workers threads. Each superblock only writes
+   its own entries of mse, so the result does not depend on the number of
+   threads. */
+static void search_sbs(CdefSearchCtxt *ctxt, AVxWorker *workers,
+                       int num_workers) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int start[MAX_NUM_CDEF_SEARCH_THREADS];
+  int i;
+  ctxt->num_threads =
+      AOMMIN(AOMMIN(num_workers, MAX_NUM_CDEF_SEARCH_THREADS), ctxt->sb_count);
+  if (ctxt->num_threads <= 1) {
+    ctxt->num_threads = 1;
+    start[0] = 0;
+    search_sbs_worker(ctxt, &start[0]);
+    return;
+  }
+  for (i = 0; i < ctxt->num_threads; ++i) {
+    AVxWorker *const worker = &workers[i];
+    start[i] = i;
+    worker->hook = (AVxWorkerHook)search_sbs_worker;
+    worker->data1 = ctxt;
+    worker->data2 = &start[i];
+    if (i == ctxt->num_threads - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+  for (i = 0; i < ctxt->num_threads; ++i) winterface->sync(&workers[i]);
+}
+
+void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
+                     AV1_COMMON *cm, MACROBLOCKD *xd, int prune_strengths,
+                     AVxWorker *workers, int num_workers) {
+  CdefSearchCtxt ctxt;
+  int r, c;
+  int sbr, sbc;
+  dering_list dlist[MAX_MIB_SIZE * MAX_MIB_SIZE];
+  int pli;
   uint64_t best_tot_mse = (uint64_t)1 << 63;
   uint64_t tot_mse;
   int sb_count;
@@ -294,29 +511,38 @@ void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
   int *sb_index = aom_malloc(nvsb * nhsb * sizeof(*sb_index));
   int *selected_strength = aom_malloc(nvsb * nhsb * sizeof(*sb_index));
   uint64_t(*mse[2])[TOTAL_STRENGTHS];
-  int clpf_damping = 3 + (cm->base_qindex >> 6);
   int i;
   int nb_strengths;
   int nb_strength_bits;
   int quantizer;
   double lambda;
   int nplanes = 3;
-  DECLARE_ALIGNED(32, uint16_t, inbuf[OD_DERING_INBUF_SIZE]);
-  uint16_t *in;
-  DECLARE_ALIGNED(32, uint16_t, tmp_dst[MAX_SB_SQUARE]);
-  int chroma_dering =
-      xd->plane[1].subsampling_x == xd->plane[1].subsampling_y &&
-      xd->plane[2].subsampling_x == xd->plane[2].subsampling_y;
   quantizer =
       av1_ac_quant(cm->base_qindex, 0, cm->bit_depth) >> (cm->bit_depth - 8);
   lambda = .12 * quantizer * quantizer / 256.;
 
+  ctxt.cm = cm;
+  ctxt.nplanes = nplanes;
+  ctxt.nvsb = nvsb;
+  ctxt.nhsb = nhsb;
+  ctxt.coeff_shift = AOMMAX(cm->bit_depth - 8, 0);
+  ctxt.clpf_damping = 3 + (cm->base_qindex >> 6);
+  ctxt.chroma_dering =
+      xd->plane[1].subsampling_x == xd->plane[1].subsampling_y &&
+      xd->plane[2].subsampling_x == xd->plane[2].subsampling_y;
+  ctxt.prune_strengths = prune_strengths;
   av1_setup_dst_planes(xd->plane, frame, 0, 0);
   mse[0] = aom_malloc(sizeof(**mse) * nvsb * nhsb);
   mse[1] = aom_malloc(sizeof(**mse) * nvsb * nhsb);
+  ctxt.mse[0] = mse[0];
+  ctxt.mse[1] = mse[1];
+  ctxt.sb_pos = aom_malloc(nvsb * nhsb * sizeof(*ctxt.sb_pos));
   for (pli = 0; pli < nplanes; pli++) {
     uint8_t *ref_buffer;
     int ref_stride;
+    uint16_t *src;
+    uint16_t *ref_coeff;
+    int stride;
     switch (pli) {
       case 0:
         ref_buffer = ref->y_buffer;
@@ -331,17 +557,18 @@ void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
         ref_stride = ref->uv_stride;
         break;
     }
-    src[pli] = aom_memalign(
+    src = ctxt.src[pli] = aom_memalign(
         32, sizeof(*src) * cm->mi_rows * cm->mi_cols * MI_SIZE * MI_SIZE);
-    ref_coeff[pli] = aom_memalign(
+    ref_coeff = ctxt.ref_coeff[pli] = aom_memalign(
         32, sizeof(*ref_coeff) * cm->mi_rows * cm->mi_cols * MI_SIZE * MI_SIZE);
-    xdec[pli] = xd->plane[pli].subsampling_x;
-    ydec[pli] = xd->plane[pli].subsampling_y;
-    bsize[pli] = ydec[pli] ? (xdec[pli] ? BLOCK_4X4 : BLOCK_8X4)
-                           : (xdec[pli] ? BLOCK_4X8 : BLOCK_8X8);
-    stride[pli] = cm->mi_cols << MI_SIZE_LOG2;
-    mi_wide_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_x;
-    mi_high_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_y;
+    ctxt.xdec[pli] = xd->plane[pli].subsampling_x;
+    ctxt.ydec[pli] = xd->plane[pli].subsampling_y;
+    ctxt.bsize[pli] = ctxt.ydec[pli]
+                          ? (ctxt.xdec[pli] ? BLOCK_4X4 : BLOCK_8X4)
+                          : (ctxt.xdec[pli] ? BLOCK_4X8 : BLOCK_8X8);
+    stride = ctxt.stride[pli] = cm->mi_cols << MI_SIZE_LOG2;
+    ctxt.mi_wide_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_x;
+    ctxt.mi_high_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_y;
 
     const int frame_height =
         (cm->mi_rows * MI_SIZE) >> xd->plane[pli].subsampling_y;
@@ -352,81 +579,35 @@ void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
       for (c = 0; c < frame_width; ++c) {
 #if CONFIG_AOM_HIGHBITDEPTH
         if (cm->use_highbitdepth) {
-          src[pli][r * stride[pli] + c] = CONVERT_TO_SHORTPTR(
+          src[r * stride + c] = CONVERT_TO_SHORTPTR(
               xd->plane[pli].dst.buf)[r * xd->plane[pli].dst.stride + c];
-          ref_coeff[pli][r * stride[pli] + c] =
+          ref_coeff[r * stride + c] =
               CONVERT_TO_SHORTPTR(ref_buffer)[r * ref_stride + c];
         } else {
 #endif
-          src[pli][r * stride[pli] + c] =
+          src[r * stride + c] =
               xd->plane[pli].dst.buf[r * xd->plane[pli].dst.stride + c];
-          ref_coeff[pli][r * stride[pli] + c] = ref_buffer[r * ref_stride + c];
+          ref_coeff[r * stride + c] = ref_buffer[r * ref_stride + c];
 #if CONFIG_AOM_HIGHBITDEPTH
         }
 #endif
       }
     }
   }
-  in = inbuf + OD_FILT_VBORDER * OD_FILT_BSTRIDE + OD_FILT_HBORDER;
   sb_count = 0;
   for (sbr = 0; sbr < nvsb; ++sbr) {
     for (sbc = 0; sbc < nhsb; ++sbc) {
-      int nvb, nhb;
-      int gi;
-      int dirinit = 0;
-      nhb = AOMMIN(MAX_MIB_SIZE, cm->mi_cols - MAX_MIB_SIZE * sbc);
-      nvb = AOMMIN(MAX_MIB_SIZE, cm->mi_rows - MAX_MIB_SIZE * sbr);
-      dering_count = sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE,
-                                            sbc * MAX_MIB_SIZE, dlist);
-      if (dering_count == 0) continue;
-      for (pli = 0; pli < nplanes; pli++) {
-        for (i = 0; i < OD_DERING_INBUF_SIZE; i++)
-          inbuf[i] = OD_DERING_VERY_LARGE;
-        for (gi = 0; gi < TOTAL_STRENGTHS; gi++) {
-          int threshold;
-          uint64_t curr_mse;
-          int clpf_strength;
-          threshold = gi / CLPF_STRENGTHS;
-          if (pli > 0 && !chroma_dering) threshold = 0;
-          /* We avoid filtering the pixels for which some of the pixels to
-             average
-             are outside the frame. We could change the filter instead, but it
-             would add special cases for any future vectorization. */
-          int yoff = OD_FILT_VBORDER * (sbr != 0);
-          int xoff = OD_FILT_HBORDER * (sbc != 0);
-          int ysize = (nvb << mi_high_l2[pli]) +
-                      OD_FILT_VBORDER * (sbr != nvsb - 1) + yoff;
-          int xsize = (nhb << mi_wide_l2[pli]) +
-                      OD_FILT_HBORDER * (sbc != nhsb - 1) + xoff;
-          clpf_strength = gi % CLPF_STRENGTHS;
-          if (clpf_strength == 0)
-            copy_sb16_16(&in[(-yoff * OD_FILT_BSTRIDE - xoff)], OD_FILT_BSTRIDE,
-                         src[pli],
-                         (sbr * MAX_MIB_SIZE << mi_high_l2[pli]) - yoff,
-                         (sbc * MAX_MIB_SIZE << mi_wide_l2[pli]) - xoff,
-                         stride[pli], ysize, xsize);
-          od_dering(clpf_strength ? NULL : (uint8_t *)in, OD_FILT_BSTRIDE,
-                    tmp_dst, in, xdec[pli], ydec[pli], dir, &dirinit, var, pli,
-                    dlist, dering_count, threshold,
-                    clpf_strength + (clpf_strength == 3), clpf_damping,
-                    coeff_shift, clpf_strength != 0, 1);
-          curr_mse = compute_dering_dist(
-              ref_coeff[pli] +
-                  (sbr * MAX_MIB_SIZE << mi_high_l2[pli]) * stride[pli] +
-                  (sbc * MAX_MIB_SIZE << mi_wide_l2[pli]),
-              stride[pli], tmp_dst, dlist, dering_count, bsize[pli],
-              coeff_shift, pli);
-          if (pli < 2)
-            mse[pli][sb_count][gi] = curr_mse;
-          else
-            mse[1][sb_count][gi] += curr_mse;
-          sb_index[sb_count] =
-              MAX_MIB_SIZE * sbr * cm->mi_stride + MAX_MIB_SIZE * sbc;
-        }
-      }
+      if (sb_compute_dering_list(cm, sbr * MAX_MIB_SIZE, sbc * MAX_MIB_SIZE,
+                                 dlist) == 0)
+        continue;
+      ctxt.sb_pos[sb_count] = sbr * nhsb + sbc;
+      sb_index[sb_count] =
+          MAX_MIB_SIZE * sbr * cm->mi_stride + MAX_MIB_SIZE * sbc;
       sb_count++;
     }
   }
+  ctxt.sb_count = sb_count;
+  search_sbs(&ctxt, workers, num_workers);
   nb_strength_bits = 0;
   /* Search for different number of signalling bits. */
   for (i = 0; i <= 3; i++) {
@@ -476,9 +657,10 @@ void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
   aom_free(mse[0]);
   aom_free(mse[1]);
   for (pli = 0; pli < nplanes; pli++) {
-    aom_free(src[pli]);
-    aom_free(ref_coeff[pli]);
+    aom_free(ctxt.src[pli]);
+    aom_free(ctxt.ref_coeff[pli]);
   }
+  aom_free(ctxt.sb_pos);
   aom_free(sb_index);
   aom_free(selected_strength);
 }
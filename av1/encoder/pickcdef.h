@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#ifndef AV1_ENCODER_PICKCDEF_H_
+#define AV1_ENCODER_PICKCDEF_H_
+
+#include <math.h>
+
+#include "aom/aom_integer.h"
+#include "aom_ports/mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Activity weighted distortion of an 8x8 block, given the sums of the source
+   and filtered pixels, of their squares and of their products. Shared by the
+   C and SIMD versions of dist_8x8_16bit() so that they match exactly. */
+static INLINE uint64_t dist_8x8_from_sums(uint64_t sum_s, uint64_t sum_d,
+                                          uint64_t sum_s2, uint64_t sum_d2,
+                                          uint64_t sum_sd, int coeff_shift) {
+  /* Compute the variance -- the calculation cannot go negative. */
+  const uint64_t svar = sum_s2 - ((sum_s * sum_s + 32) >> 6);
+  const uint64_t dvar = sum_d2 - ((sum_d * sum_d + 32) >> 6);
+  return (uint64_t)floor(
+      .5 +
+      (sum_d2 + sum_s2 - 2 * sum_sd) * .5 *
+          (svar + dvar + (400 << 2 * coeff_shift)) /
+          (sqrt((20000 << 4 * coeff_shift) + svar * (double)dvar)));
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AV1_ENCODER_PICKCDEF_H_
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+
+#include "./av1_rtcd.h"
+#include "av1/encoder/pickcdef.h"
+
+/* The pixels have at most 12 bits, so they can be used as signed 16-bit
+   values: a row sum of 8 pixels fits in 16 bits, and the sums of the
+   products of 64 pixels fit in 32 bits. */
+
+static INLINE uint32_t hsum_32(v128 a) {
+  a = v128_add_32(a, v128_shr_n_byte(a, 8));
+  a = v128_add_32(a, v128_shr_n_byte(a, 4));
+  return v128_low_u32(a);
+}
+
+uint64_t SIMD_FUNC(dist_8x8_16bit)(uint16_t *dst, int dstride, uint16_t *src,
+                                   int sstride, int coeff_shift) {
+  v128 sum_s = v128_zero();
+  v128 sum_d = v128_zero();
+  v128 sum_s2 = v128_zero();
+  v128 sum_d2 = v128_zero();
+  v128 sum_sd = v128_zero();
+  const v128 one = v128_dup_16(1);
+  int i;
+  for (i = 0; i < 8; i++) {
+    const v128 s = v128_load_unaligned(&src[i * sstride]);
+    const v128 d = v128_load_unaligned(&dst[i * dstride]);
+    sum_s = v128_add_16(sum_s, s);
+    sum_d = v128_add_16(sum_d, d);
+    sum_s2 = v128_add_32(sum_s2, v128_madd_s16(s, s));
+    sum_d2 = v128_add_32(sum_d2, v128_madd_s16(d, d));
+    sum_sd = v128_add_32(sum_sd, v128_madd_s16(s, d));
+  }
+  return dist_8x8_from_sums(
+      hsum_32(v128_madd_s16(sum_s, one)), hsum_32(v128_madd_s16(sum_d, one)),
+      hsum_32(sum_s2), hsum_32(sum_d2), hsum_32(sum_sd), coeff_shift);
+}
+
+uint64_t SIMD_FUNC(mse_8x8_16bit)(uint16_t *dst, int dstride, uint16_t *src,
+                                  int sstride) {
+  v128 sum = v128_zero();
+  int i;
+  for (i = 0; i < 8; i++) {
+    const v128 e = v128_sub_16(v128_load_unaligned(&dst[i * dstride]),
+                               v128_load_unaligned(&src[i * sstride]));
+    sum = v128_add_32(sum, v128_madd_s16(e, e));
+  }
+  return hsum_32(sum);
+}
+
+static INLINE uint64_t mse_4x4_16bit(uint16_t *dst, int dstride, uint16_t *src,
+                                     int sstride) {
+  v128 sum = v128_zero();
+  int i;
+  for (i = 0; i < 4; i += 2) {
+    const v128 d = v128_from_v64(v64_load_unaligned(&dst[(i + 1) * dstride]),
+                                 v64_load_unaligned(&dst[i * dstride]));
+    const v128 s = v128_from_v64(v64_load_unaligned(&src[(i + 1) * sstride]),
+                                 v64_load_unaligned(&src[i * sstride]));
+    const v128 e = v128_sub_16(d, s);
+    sum = v128_add_32(sum, v128_madd_s16(e, e));
+  }
+  return hsum_32(sum);
+}
+
+uint64_t SIMD_FUNC(compute_dering_dist)(uint16_t *dst, int dstride,
+                                        uint16_t *src, dering_list *dlist,
+                                        int dering_count, BLOCK_SIZE bsize,
+                                        int coeff_shift, int pli) {
+  uint64_t sum = 0;
+  int bi, bx, by;
+  if (bsize == BLOCK_8X8) {
+    for (bi = 0; bi < dering_count; bi++) {
+      by = dlist[bi].by;
+      bx = dlist[bi].bx;
+      if (pli == 0) {
+        sum += SIMD_FUNC(dist_8x8_16bit)(&dst[(by << 3) * dstride + (bx << 3)],
+                                         dstride, &src[bi << (3 + 3)], 8,
+                                         coeff_shift);
+      } else {
+        sum += SIMD_FUNC(mse_8x8_16bit)(&dst[(by << 3) * dstride + (bx << 3)],
+                                        dstride, &src[bi << (3 + 3)], 8);
+      }
+    }
+  } else if (bsize == BLOCK_4X8) {
+    for (bi = 0; bi < dering_count; bi++) {
+      by = dlist[bi].by;
+      bx = dlist[bi].bx;
+      sum += mse_4x4_16bit(&dst[(by << 3) * dstride + (bx << 2)], dstride,
+                           &src[bi << (3 + 2)], 4);
+      sum += mse_4x4_16bit(&dst[((by << 3) + 4) * dstride + (bx << 2)], dstride,
+                           &src[(bi << (3 + 2)) + 4 * 4], 4);
+    }
+  } else if (bsize == BLOCK_8X4) {
+    for (bi = 0; bi < dering_count; bi++) {
+      by = dlist[bi].by;
+      bx = dlist[bi].bx;
+      sum += mse_4x4_16bit(&dst[(by << 2) * dstride + (bx << 3)], dstride,
+                           &src[bi << (2 + 3)], 8);
+      sum += mse_4x4_16bit(&dst[(by << 2) * dstride + (bx << 3) + 4], dstride,
+                           &src[(bi << (2 + 3)) + 4], 8);
+    }
+  } else {
+    assert(bsize == BLOCK_4X4);
+    for (bi = 0; bi < dering_count; bi++) {
+      by = dlist[bi].by;
+      bx = dlist[bi].bx;
+      sum += mse_4x4_16bit(&dst[(by << 2) * dstride + (bx << 2)], dstride,
+                           &src[bi << (2 + 2)], 4);
+    }
+  }
+  return sum >> 2 * coeff_shift;
+}
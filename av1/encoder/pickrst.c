@@ -15,6 +15,7 @@
 #include <math.h>
 
 #include "./aom_scale_rtcd.h"
+#include "./av1_rtcd.h"
 
 #include "aom_dsp/psnr.h"
 #include "aom_dsp/aom_dsp_common.h"
@@ -123,7 +124,8 @@ static int64_t try_restoration_tile(const YV12_BUFFER_CONFIG *src,
                                     int components_pattern, int partial_frame,
                                     int tile_idx, int subtile_idx,
                                     int subtile_bits,
-                                    YV12_BUFFER_CONFIG *dst_frame) {
+                                    YV12_BUFFER_CONFIG *dst_frame,
+                                    int32_t *tmpbuf) {
   AV1_COMMON *const cm = &cpi->common;
   int64_t filt_err;
   int tile_width, tile_height, nhtiles, nvtiles;
@@ -146,8 +148,22 @@ static int64_t try_restoration_tile(const YV12_BUFFER_CONFIG *src,
       &tile_width, &tile_height, &nhtiles, &nvtiles);
   (void)ntiles;
 
-  av1_loop_restoration_frame(cm->frame_to_show, cm, rsi, components_pattern,
-                             partial_frame, dst_frame);
+  if (partial_frame) {
+    // Only a band of rows is restored, whose tiles are not the ones of the
+    // frame, so restore the frame.
+    av1_loop_restoration_frame(cm->frame_to_show, cm, rsi, components_pattern,
+                               partial_frame, dst_frame);
+  } else {
+    // The other tiles are not restored, so the pixels of the tile are the
+    // same as when restoring the frame.
+    const int plane = components_pattern == 1
+                          ? AOM_PLANE_Y
+                          : components_pattern == 2 ? AOM_PLANE_U : AOM_PLANE_V;
+    assert(components_pattern != 6);
+    assert(subtile_bits == 0);
+    av1_loop_restoration_tile(cm->frame_to_show, cm, &rsi[plane], plane,
+                              tile_idx, dst_frame, tmpbuf);
+  }
   av1_get_rest_tile_limits(tile_idx, subtile_idx, subtile_bits, nhtiles,
                            nvtiles, tile_width, tile_height, width, height, 0,
                            0, &h_start, &h_end, &v_start, &v_end);
@@ -163,12 +179,102 @@ static int64_t try_restoration_frame(const YV12_BUFFER_CONFIG *src,
                                      YV12_BUFFER_CONFIG *dst_frame) {
   AV1_COMMON *const cm = &cpi->common;
   int64_t filt_err;
-  av1_loop_restoration_frame(cm->frame_to_show, cm, rsi, components_pattern,
-                             partial_frame, dst_frame);
+  if (cpi->num_workers > 1)
+    av1_loop_restoration_frame_mt(cm->frame_to_show, cm, rsi,
+                                  components_pattern, partial_frame, dst_frame,
+                                  cpi->workers, cpi->num_workers,
+                                  &cpi->lr_row_sync);
+  else
+    av1_loop_restoration_frame(cm->frame_to_show, cm, rsi, components_pattern,
+                               partial_frame, dst_frame);
   filt_err = sse_restoration_frame(cm, src, dst_frame, components_pattern);
   return filt_err;
 }
 
+// Search of the filters of the restoration tiles of a plane. Each tile is
+// tried on its own, with the other tiles not restored, and only writes its
+// own entries of the arrays below, so the tiles are split among threads:
+// thread i searches tiles i, i + num_threads, ...
+typedef struct RestSearchCtxt {
+  const YV12_BUFFER_CONFIG *src;
+  AV1_COMP *cpi;
+  int plane;
+  int partial_frame;
+  // Filters tried for each plane, and best filters of the plane.
+  RestorationInfo *rsi;
+  RestorationInfo *info;
+  RestorationType *type;
+  // Cost of each tile with switchable restoration, or NULL.
+  double *best_tile_cost;
+  int width, height;
+  int ntiles, nhtiles, nvtiles, tile_width, tile_height;
+  void (*search_tile)(const struct RestSearchCtxt *ctxt, int tile_idx,
+                      RestSearchThreadData *thr);
+  int num_threads;
+} RestSearchCtxt;
+
+static void init_search_ctxt(RestSearchCtxt *ctxt,
+                             const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
+                             int plane, int partial_frame,
+                             RestorationInfo *info, RestorationType *type,
+                             double *best_tile_cost) {
+  AV1_COMMON *const cm = &cpi->common;
+  ctxt->src = src;
+  ctxt->cpi = cpi;
+  ctxt->plane = plane;
+  ctxt->partial_frame = partial_frame;
+  ctxt->rsi = cpi->rst_search;
+  ctxt->info = info;
+  ctxt->type = type;
+  ctxt->best_tile_cost = best_tile_cost;
+  ctxt->width = plane ? src->uv_crop_width : cm->width;
+  ctxt->height = plane ? src->uv_crop_height : cm->height;
+  ctxt->ntiles = av1_get_rest_ntiles(
+      ctxt->width, ctxt->height, cm->rst_info[plane].restoration_tilesize,
+      &ctxt->tile_width, &ctxt->tile_height, &ctxt->nhtiles, &ctxt->nvtiles);
+}
+
+static int search_tiles_worker(const RestSearchCtxt *ctxt,
+                               RestSearchThreadData *thr) {
+  int tile_idx;
+  for (tile_idx = thr->start; tile_idx < ctxt->ntiles;
+       tile_idx += ctxt->num_threads)
+    ctxt->search_tile(ctxt, tile_idx, thr);
+  return 1;
+}
+
+static void search_tiles(RestSearchCtxt *ctxt) {
+  AV1_COMP *const cpi = ctxt->cpi;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int i;
+
+  // A partial frame is restored as a whole for each tile, with the
+  // restoration state of cm.
+  ctxt->num_threads = ctxt->partial_frame
+                          ? 1
+                          : AOMMIN(cpi->num_rst_search_threads, ctxt->ntiles);
+  if (ctxt->num_threads <= 1) {
+    ctxt->num_threads = 1;
+    search_tiles_worker(ctxt, &cpi->rst_search_thr_data[0]);
+    return;
+  }
+
+  for (i = 0; i < ctxt->num_threads; ++i) {
+    AVxWorker *const worker = &cpi->workers[i];
+    worker->hook = (AVxWorkerHook)search_tiles_worker;
+    worker->data1 = ctxt;
+    worker->data2 = &cpi->rst_search_thr_data[i];
+    if (i == ctxt->num_threads - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+  for (i = 0; i < ctxt->num_threads; ++i) {
+    winterface->sync(&cpi->workers[i]);
+  }
+}
+
 static int64_t get_pixel_proj_error(uint8_t *src8, int width, int height,
                                     int src_stride, uint8_t *dat8,
                                     int dat_stride, int bit_depth,
@@ -343,73 +449,86 @@ static void search_selfguided_restoration(uint8_t *dat8, int width, int height,
   xqd[1] = bestxqd[1];
 }
 
+static void search_sgrproj_tile(const RestSearchCtxt *ctxt, int tile_idx,
+                                RestSearchThreadData *thr) {
+  const YV12_BUFFER_CONFIG *const src = ctxt->src;
+  AV1_COMP *const cpi = ctxt->cpi;
+  AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCK *x = &cpi->td.mb;
+  const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
+  RestorationInfo *rsi = &ctxt->rsi[AOM_PLANE_Y];
+  SgrprojInfo *sgrproj_info = ctxt->info->sgrproj_info;
+  double err, cost_norestore, cost_sgrproj;
+  int bits;
+  int h_start, h_end, v_start, v_end;
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, ctxt->nhtiles, ctxt->nvtiles,
+                           ctxt->tile_width, ctxt->tile_height, ctxt->width,
+                           ctxt->height, 0, 0, &h_start, &h_end, &v_start,
+                           &v_end);
+  err = sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
+                             h_end - h_start, v_start, v_end - v_start, 1);
+  // #bits when a tile is not restored
+  bits = av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 0);
+  cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  ctxt->best_tile_cost[tile_idx] = DBL_MAX;
+  search_selfguided_restoration(
+      dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
+      v_end - v_start, dgd->y_stride,
+      src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
+#if CONFIG_AOM_HIGHBITDEPTH
+      cm->bit_depth,
+#else
+      8,
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+      &rsi->sgrproj_info[tile_idx].ep, rsi->sgrproj_info[tile_idx].xqd,
+      thr->tmpbuf);
+  rsi->restoration_type[tile_idx] = RESTORE_SGRPROJ;
+  err = try_restoration_tile(src, cpi, ctxt->rsi, 1, ctxt->partial_frame,
+                             tile_idx, 0, 0, thr->dst_frame, thr->tmpbuf);
+  bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
+  bits += av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 1);
+  cost_sgrproj = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (cost_sgrproj >= cost_norestore) {
+    ctxt->type[tile_idx] = RESTORE_NONE;
+  } else {
+    ctxt->type[tile_idx] = RESTORE_SGRPROJ;
+    memcpy(&sgrproj_info[tile_idx], &rsi->sgrproj_info[tile_idx],
+           sizeof(sgrproj_info[tile_idx]));
+    bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
+    ctxt->best_tile_cost[tile_idx] = RDCOST_DBL(
+        x->rdmult, x->rddiv,
+        (bits + cpi->switchable_restore_cost[RESTORE_SGRPROJ]) >> 4, err);
+  }
+  rsi->restoration_type[tile_idx] = RESTORE_NONE;
+}
+
 static double search_sgrproj(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
                              int partial_frame, RestorationInfo *info,
                              RestorationType *type, double *best_tile_cost,
                              YV12_BUFFER_CONFIG *dst_frame) {
   SgrprojInfo *sgrproj_info = info->sgrproj_info;
-  double err, cost_norestore, cost_sgrproj;
+  double err, cost_sgrproj;
   int bits;
   MACROBLOCK *x = &cpi->td.mb;
-  AV1_COMMON *const cm = &cpi->common;
-  const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
   RestorationInfo *rsi = &cpi->rst_search[0];
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
-  int h_start, h_end, v_start, v_end;
-  // Allocate for the src buffer at high precision
-  const int ntiles = av1_get_rest_ntiles(
-      cm->width, cm->height, cm->rst_info[0].restoration_tilesize, &tile_width,
-      &tile_height, &nhtiles, &nvtiles);
+  RestSearchCtxt ctxt;
+  int tile_idx;
+
+  init_search_ctxt(&ctxt, src, cpi, AOM_PLANE_Y, partial_frame, info, type,
+                   best_tile_cost);
+  ctxt.search_tile = search_sgrproj_tile;
   rsi->frame_restoration_type = RESTORE_SGRPROJ;
 
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     rsi->restoration_type[tile_idx] = RESTORE_NONE;
   }
   // Compute best Sgrproj filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, cm->width, cm->height, 0, 0, &h_start,
-                             &h_end, &v_start, &v_end);
-    err = sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
-                               h_end - h_start, v_start, v_end - v_start, 1);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    best_tile_cost[tile_idx] = DBL_MAX;
-    search_selfguided_restoration(
-        dgd->y_buffer + v_start * dgd->y_stride + h_start, h_end - h_start,
-        v_end - v_start, dgd->y_stride,
-        src->y_buffer + v_start * src->y_stride + h_start, src->y_stride,
-#if CONFIG_AOM_HIGHBITDEPTH
-        cm->bit_depth,
-#else
-        8,
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-        &rsi->sgrproj_info[tile_idx].ep, rsi->sgrproj_info[tile_idx].xqd,
-        cm->rst_internal.tmpbuf);
-    rsi->restoration_type[tile_idx] = RESTORE_SGRPROJ;
-    err = try_restoration_tile(src, cpi, rsi, 1, partial_frame, tile_idx, 0, 0,
-                               dst_frame);
-    bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, 1);
-    cost_sgrproj = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_sgrproj >= cost_norestore) {
-      type[tile_idx] = RESTORE_NONE;
-    } else {
-      type[tile_idx] = RESTORE_SGRPROJ;
-      memcpy(&sgrproj_info[tile_idx], &rsi->sgrproj_info[tile_idx],
-             sizeof(sgrproj_info[tile_idx]));
-      bits = SGRPROJ_BITS << AV1_PROB_COST_SHIFT;
-      best_tile_cost[tile_idx] = RDCOST_DBL(
-          x->rdmult, x->rddiv,
-          (bits + cpi->switchable_restore_cost[RESTORE_SGRPROJ]) >> 4, err);
-    }
-    rsi->restoration_type[tile_idx] = RESTORE_NONE;
-  }
+  search_tiles(&ctxt);
   // Cost for Sgrproj filtering
   bits = frame_level_restore_bits[rsi->frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     bits +=
         av1_cost_bit(RESTORE_NONE_SGRPROJ_PROB, type[tile_idx] != RESTORE_NONE);
     memcpy(&rsi->sgrproj_info[tile_idx], &sgrproj_info[tile_idx],
@@ -425,108 +544,131 @@ static double search_sgrproj(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   return cost_sgrproj;
 }
 
-static double find_average(uint8_t *src, int h_start, int h_end, int v_start,
-                           int v_end, int stride) {
-  uint64_t sum = 0;
-  double avg = 0;
-  int i, j;
-  for (i = v_start; i < v_end; i++)
-    for (j = h_start; j < h_end; j++) sum += src[i * stride + j];
-  avg = (double)sum / ((v_end - v_start) * (h_end - h_start));
-  return avg;
-}
-
-static void compute_stats(uint8_t *dgd, uint8_t *src, int h_start, int h_end,
-                          int v_start, int v_end, int dgd_stride,
-                          int src_stride, double *M, double *H) {
+// Accumulates, over the width x height block of src and the co-located
+// block of dgd, the sum of the src pixels, and for each offset k in the
+// WIENER_WIN x WIENER_WIN window around the pixel the sum of the dgd pixels,
+// of their products with the src pixels and of their products with the dgd
+// pixels at each offset l >= k. Offsets are indexed column-major as in Y[]
+// below, and only the upper triangle of sum_yy is filled.
+void av1_compute_wiener_sums_c(const uint8_t *dgd, const uint8_t *src,
+                               int width, int height, int dgd_stride,
+                               int src_stride, int64_t *sum_x, int64_t *sum_y,
+                               int64_t *sum_xy, int64_t *sum_yy) {
   int i, j, k, l;
-  double Y[WIENER_WIN2];
-  const double avg =
-      find_average(dgd, h_start, h_end, v_start, v_end, dgd_stride);
-
-  memset(M, 0, sizeof(*M) * WIENER_WIN2);
-  memset(H, 0, sizeof(*H) * WIENER_WIN2 * WIENER_WIN2);
-  for (i = v_start; i < v_end; i++) {
-    for (j = h_start; j < h_end; j++) {
-      const double X = (double)src[i * src_stride + j] - avg;
+  int Y[WIENER_WIN2];
+
+  *sum_x = 0;
+  memset(sum_y, 0, sizeof(*sum_y) * WIENER_WIN2);
+  memset(sum_xy, 0, sizeof(*sum_xy) * WIENER_WIN2);
+  memset(sum_yy, 0, sizeof(*sum_yy) * WIENER_WIN2 * WIENER_WIN2);
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      const int X = src[i * src_stride + j];
       int idx = 0;
       for (k = -WIENER_HALFWIN; k <= WIENER_HALFWIN; k++) {
         for (l = -WIENER_HALFWIN; l <= WIENER_HALFWIN; l++) {
-          Y[idx] = (double)dgd[(i + l) * dgd_stride + (j + k)] - avg;
+          Y[idx] = dgd[(i + l) * dgd_stride + (j + k)];
           idx++;
         }
       }
+      *sum_x += X;
       for (k = 0; k < WIENER_WIN2; ++k) {
-        M[k] += Y[k] * X;
-        H[k * WIENER_WIN2 + k] += Y[k] * Y[k];
-        for (l = k + 1; l < WIENER_WIN2; ++l) {
-          // H is a symmetric matrix, so we only need to fill out the upper
-          // triangle here. We can copy it down to the lower triangle outside
-          // the (i, j) loops.
-          H[k * WIENER_WIN2 + l] += Y[k] * Y[l];
-        }
+        sum_y[k] += Y[k];
+        sum_xy[k] += Y[k] * X;
+        for (l = k; l < WIENER_WIN2; ++l)
+          sum_yy[k * WIENER_WIN2 + l] += Y[k] * Y[l];
       }
     }
   }
+}
+
+// Turns the sums of av1_compute_wiener_sums() over n pixels into the
+// statistics of the pixels minus the average of the dgd block, which is the
+// sum at the centre of the window divided by n:
+//   M[k] = sum((X - avg) * (Y[k] - avg))
+//   H[k][l] = sum((Y[k] - avg) * (Y[l] - avg))
+// The sums are exact, so this only rounds once per element.
+static void finish_stats(int n, int64_t sum_x, const int64_t *sum_y,
+                         const int64_t *sum_xy, const int64_t *sum_yy,
+                         double *M, double *H) {
+  int k, l;
+  const double avg = (double)sum_y[WIENER_WIN2 / 2] / n;
+  const double n_avg2 = n * avg * avg;
+
   for (k = 0; k < WIENER_WIN2; ++k) {
-    for (l = k + 1; l < WIENER_WIN2; ++l) {
-      H[l * WIENER_WIN2 + k] = H[k * WIENER_WIN2 + l];
+    M[k] = (double)sum_xy[k] - avg * (double)(sum_x + sum_y[k]) + n_avg2;
+    for (l = k; l < WIENER_WIN2; ++l) {
+      // H is a symmetric matrix, so only the upper triangle is computed.
+      H[k * WIENER_WIN2 + l] = H[l * WIENER_WIN2 + k] =
+          (double)sum_yy[k * WIENER_WIN2 + l] -
+          avg * (double)(sum_y[k] + sum_y[l]) + n_avg2;
     }
   }
 }
 
-#if CONFIG_AOM_HIGHBITDEPTH
-static double find_average_highbd(uint16_t *src, int h_start, int h_end,
-                                  int v_start, int v_end, int stride) {
-  uint64_t sum = 0;
-  double avg = 0;
-  int i, j;
-  for (i = v_start; i < v_end; i++)
-    for (j = h_start; j < h_end; j++) sum += src[i * stride + j];
-  avg = (double)sum / ((v_end - v_start) * (h_end - h_start));
-  return avg;
+static void compute_stats(uint8_t *dgd, uint8_t *src, int h_start, int h_end,
+                          int v_start, int v_end, int dgd_stride,
+                          int src_stride, double *M, double *H) {
+  int64_t sum_x, sum_y[WIENER_WIN2], sum_xy[WIENER_WIN2];
+  int64_t sum_yy[WIENER_WIN2 * WIENER_WIN2];
+
+  av1_compute_wiener_sums(dgd + v_start * dgd_stride + h_start,
+                          src + v_start * src_stride + h_start,
+                          h_end - h_start, v_end - v_start, dgd_stride,
+                          src_stride, &sum_x, sum_y, sum_xy, sum_yy);
+  finish_stats((h_end - h_start) * (v_end - v_start), sum_x, sum_y, sum_xy,
+               sum_yy, M, H);
 }
 
-static void compute_stats_highbd(uint8_t *dgd8, uint8_t *src8, int h_start,
-                                 int h_end, int v_start, int v_end,
-                                 int dgd_stride, int src_stride, double *M,
-                                 double *H) {
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_compute_wiener_sums_highbd_c(const uint16_t *dgd, const uint16_t *src,
+                                      int width, int height, int dgd_stride,
+                                      int src_stride, int64_t *sum_x,
+                                      int64_t *sum_y, int64_t *sum_xy,
+                                      int64_t *sum_yy) {
   int i, j, k, l;
-  double Y[WIENER_WIN2];
-  uint16_t *src = CONVERT_TO_SHORTPTR(src8);
-  uint16_t *dgd = CONVERT_TO_SHORTPTR(dgd8);
-  const double avg =
-      find_average_highbd(dgd, h_start, h_end, v_start, v_end, dgd_stride);
-
-  memset(M, 0, sizeof(*M) * WIENER_WIN2);
-  memset(H, 0, sizeof(*H) * WIENER_WIN2 * WIENER_WIN2);
-  for (i = v_start; i < v_end; i++) {
-    for (j = h_start; j < h_end; j++) {
-      const double X = (double)src[i * src_stride + j] - avg;
+  int Y[WIENER_WIN2];
+
+  *sum_x = 0;
+  memset(sum_y, 0, sizeof(*sum_y) * WIENER_WIN2);
+  memset(sum_xy, 0, sizeof(*sum_xy) * WIENER_WIN2);
+  memset(sum_yy, 0, sizeof(*sum_yy) * WIENER_WIN2 * WIENER_WIN2);
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      const int X = src[i * src_stride + j];
       int idx = 0;
       for (k = -WIENER_HALFWIN; k <= WIENER_HALFWIN; k++) {
         for (l = -WIENER_HALFWIN; l <= WIENER_HALFWIN; l++) {
-          Y[idx] = (double)dgd[(i + l) * dgd_stride + (j + k)] - avg;
+          Y[idx] = dgd[(i + l) * dgd_stride + (j + k)];
           idx++;
         }
       }
+      *sum_x += X;
       for (k = 0; k < WIENER_WIN2; ++k) {
-        M[k] += Y[k] * X;
-        H[k * WIENER_WIN2 + k] += Y[k] * Y[k];
-        for (l = k + 1; l < WIENER_WIN2; ++l) {
-          // H is a symmetric matrix, so we only need to fill out the upper
-          // triangle here. We can copy it down to the lower triangle outside
-          // the (i, j) loops.
-          H[k * WIENER_WIN2 + l] += Y[k] * Y[l];
-        }
+        sum_y[k] += Y[k];
+        sum_xy[k] += Y[k] * X;
+        for (l = k; l < WIENER_WIN2; ++l)
+          sum_yy[k * WIENER_WIN2 + l] += Y[k] * Y[l];
       }
     }
   }
-  for (k = 0; k < WIENER_WIN2; ++k) {
-    for (l = k + 1; l < WIENER_WIN2; ++l) {
-      H[l * WIENER_WIN2 + k] = H[k * WIENER_WIN2 + l];
-    }
-  }
+}
+
+static void compute_stats_highbd(uint8_t *dgd8, uint8_t *src8, int h_start,
+                                 int h_end, int v_start, int v_end,
+                                 int dgd_stride, int src_stride, double *M,
+                                 double *H) {
+  const uint16_t *const src = CONVERT_TO_SHORTPTR(src8);
+  const uint16_t *const dgd = CONVERT_TO_SHORTPTR(dgd8);
+  int64_t sum_x, sum_y[WIENER_WIN2], sum_xy[WIENER_WIN2];
+  int64_t sum_yy[WIENER_WIN2 * WIENER_WIN2];
+
+  av1_compute_wiener_sums_highbd(dgd + v_start * dgd_stride + h_start,
+                                 src + v_start * src_stride + h_start,
+                                 h_end - h_start, v_end - v_start, dgd_stride,
+                                 src_stride, &sum_x, sum_y, sum_xy, sum_yy);
+  finish_stats((h_end - h_start) * (v_end - v_start), sum_x, sum_y, sum_xy,
+               sum_yy, M, H);
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
@@ -738,6 +880,105 @@ static void quantize_sym_filter(double *f, InterpKernel fi) {
   fi[3] = -2 * (fi[0] + fi[1] + fi[2]);
 }
 
+static void search_wiener_tile(const RestSearchCtxt *ctxt, int tile_idx,
+                               RestSearchThreadData *thr) {
+  const YV12_BUFFER_CONFIG *const src = ctxt->src;
+  AV1_COMP *const cpi = ctxt->cpi;
+  AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCK *x = &cpi->td.mb;
+  const int plane = ctxt->plane;
+  RestorationInfo *rsi = &ctxt->rsi[plane];
+  WienerInfo *wiener_info = ctxt->info->wiener_info;
+  const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
+  uint8_t *const dgd_buffer =
+      plane == AOM_PLANE_Y ? dgd->y_buffer : plane == AOM_PLANE_U
+                                                 ? dgd->u_buffer
+                                                 : dgd->v_buffer;
+  uint8_t *const src_buffer =
+      plane == AOM_PLANE_Y ? src->y_buffer : plane == AOM_PLANE_U
+                                                 ? src->u_buffer
+                                                 : src->v_buffer;
+  const int src_stride = plane ? src->uv_stride : src->y_stride;
+  const int dgd_stride = plane ? dgd->uv_stride : dgd->y_stride;
+  // The statistics of the chroma tiles leave out the borders of the plane,
+  // which are not extended.
+  const int clamp = plane ? WIENER_HALFWIN : 0;
+  int64_t err;
+  int bits;
+  double cost_wiener, cost_norestore;
+  double M[WIENER_WIN2];
+  double H[WIENER_WIN2 * WIENER_WIN2];
+  double vfilterd[WIENER_WIN], hfilterd[WIENER_WIN];
+  double score;
+  int h_start, h_end, v_start, v_end;
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, ctxt->nhtiles, ctxt->nvtiles,
+                           ctxt->tile_width, ctxt->tile_height, ctxt->width,
+                           ctxt->height, 0, 0, &h_start, &h_end, &v_start,
+                           &v_end);
+  err = sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
+                             h_end - h_start, v_start, v_end - v_start,
+                             1 << plane);
+  // #bits when a tile is not restored
+  bits = av1_cost_bit(RESTORE_NONE_WIENER_PROB, 0);
+  cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (ctxt->best_tile_cost) ctxt->best_tile_cost[tile_idx] = DBL_MAX;
+
+  av1_get_rest_tile_limits(tile_idx, 0, 0, ctxt->nhtiles, ctxt->nvtiles,
+                           ctxt->tile_width, ctxt->tile_height, ctxt->width,
+                           ctxt->height, clamp, clamp, &h_start, &h_end,
+                           &v_start, &v_end);
+#if CONFIG_AOM_HIGHBITDEPTH
+  if (cm->use_highbitdepth)
+    compute_stats_highbd(dgd_buffer, src_buffer, h_start, h_end, v_start,
+                         v_end, dgd_stride, src_stride, M, H);
+  else
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    compute_stats(dgd_buffer, src_buffer, h_start, h_end, v_start, v_end,
+                  dgd_stride, src_stride, M, H);
+
+  ctxt->type[tile_idx] = RESTORE_WIENER;
+
+  if (!wiener_decompose_sep_sym(M, H, vfilterd, hfilterd)) {
+    ctxt->type[tile_idx] = RESTORE_NONE;
+    return;
+  }
+  quantize_sym_filter(vfilterd, rsi->wiener_info[tile_idx].vfilter);
+  quantize_sym_filter(hfilterd, rsi->wiener_info[tile_idx].hfilter);
+
+  // Filter score computes the value of the function x'*A*x - x'*b for the
+  // learned filter and compares it against identity filer. If there is no
+  // reduction in the function, the filter is reverted back to identity
+  score = compute_score(M, H, rsi->wiener_info[tile_idx].vfilter,
+                        rsi->wiener_info[tile_idx].hfilter);
+  if (score > 0.0) {
+    ctxt->type[tile_idx] = RESTORE_NONE;
+    return;
+  }
+
+  rsi->restoration_type[tile_idx] = RESTORE_WIENER;
+  err = try_restoration_tile(src, cpi, ctxt->rsi, 1 << plane,
+                             ctxt->partial_frame, tile_idx, 0, 0,
+                             thr->dst_frame, thr->tmpbuf);
+  bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
+  bits += av1_cost_bit(RESTORE_NONE_WIENER_PROB, 1);
+  cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
+  if (cost_wiener >= cost_norestore) {
+    ctxt->type[tile_idx] = RESTORE_NONE;
+  } else {
+    ctxt->type[tile_idx] = RESTORE_WIENER;
+    memcpy(&wiener_info[tile_idx], &rsi->wiener_info[tile_idx],
+           sizeof(wiener_info[tile_idx]));
+    if (ctxt->best_tile_cost) {
+      bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
+      ctxt->best_tile_cost[tile_idx] = RDCOST_DBL(
+          x->rdmult, x->rddiv,
+          (bits + cpi->switchable_restore_cost[RESTORE_WIENER]) >> 4, err);
+    }
+  }
+  rsi->restoration_type[tile_idx] = RESTORE_NONE;
+}
+
 static double search_wiener_uv(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
                                int partial_frame, int plane,
                                RestorationInfo *info, RestorationType *type,
@@ -747,24 +988,15 @@ static double search_wiener_uv(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   RestorationInfo *rsi = cpi->rst_search;
   int64_t err;
   int bits;
-  double cost_wiener, cost_norestore, cost_wiener_frame, cost_norestore_frame;
+  double cost_wiener_frame, cost_norestore_frame;
   MACROBLOCK *x = &cpi->td.mb;
-  double M[WIENER_WIN2];
-  double H[WIENER_WIN2 * WIENER_WIN2];
-  double vfilterd[WIENER_WIN], hfilterd[WIENER_WIN];
-  const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
-  const int width = src->uv_crop_width;
-  const int height = src->uv_crop_height;
-  const int src_stride = src->uv_stride;
-  const int dgd_stride = dgd->uv_stride;
-  double score;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
-  int h_start, h_end, v_start, v_end;
-  const int ntiles =
-      av1_get_rest_ntiles(width, height, cm->rst_info[1].restoration_tilesize,
-                          &tile_width, &tile_height, &nhtiles, &nvtiles);
-  assert(width == dgd->uv_crop_width);
-  assert(height == dgd->uv_crop_height);
+  RestSearchCtxt ctxt;
+  int tile_idx;
+
+  init_search_ctxt(&ctxt, src, cpi, plane, partial_frame, info, type, NULL);
+  ctxt.search_tile = search_wiener_tile;
+  assert(ctxt.width == cm->frame_to_show->uv_crop_width);
+  assert(ctxt.height == cm->frame_to_show->uv_crop_height);
 
   rsi[plane].frame_restoration_type = RESTORE_NONE;
   err = sse_restoration_frame(cm, src, cm->frame_to_show, (1 << plane));
@@ -773,86 +1005,30 @@ static double search_wiener_uv(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
 
   rsi[plane].frame_restoration_type = RESTORE_WIENER;
 
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     rsi[plane].restoration_type[tile_idx] = RESTORE_NONE;
   }
 
-  // Compute best Wiener filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, 0, 0, &h_start, &h_end,
-                             &v_start, &v_end);
-    err = sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
-                               h_end - h_start, v_start, v_end - v_start,
-                               1 << plane);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_WIENER_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    // best_tile_cost[tile_idx] = DBL_MAX;
-
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, WIENER_HALFWIN,
-                             WIENER_HALFWIN, &h_start, &h_end, &v_start,
-                             &v_end);
-    if (plane == AOM_PLANE_U) {
+  // The tiles are restored on their own, so the borders of the plane are
+  // extended here rather than by av1_loop_restoration_frame().
+  if (!partial_frame) {
+    const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
+    uint8_t *const dgd_buffer =
+        plane == AOM_PLANE_U ? dgd->u_buffer : dgd->v_buffer;
 #if CONFIG_AOM_HIGHBITDEPTH
-      if (cm->use_highbitdepth)
-        compute_stats_highbd(dgd->u_buffer, src->u_buffer, h_start, h_end,
-                             v_start, v_end, dgd_stride, src_stride, M, H);
-      else
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-        compute_stats(dgd->u_buffer, src->u_buffer, h_start, h_end, v_start,
-                      v_end, dgd_stride, src_stride, M, H);
-    } else if (plane == AOM_PLANE_V) {
-#if CONFIG_AOM_HIGHBITDEPTH
-      if (cm->use_highbitdepth)
-        compute_stats_highbd(dgd->v_buffer, src->v_buffer, h_start, h_end,
-                             v_start, v_end, dgd_stride, src_stride, M, H);
-      else
+    if (cm->use_highbitdepth)
+      extend_frame_highbd(CONVERT_TO_SHORTPTR(dgd_buffer), ctxt.width,
+                          ctxt.height, dgd->uv_stride);
+    else
 #endif  // CONFIG_AOM_HIGHBITDEPTH
-        compute_stats(dgd->v_buffer, src->v_buffer, h_start, h_end, v_start,
-                      v_end, dgd_stride, src_stride, M, H);
-    } else {
-      assert(0);
-    }
-
-    type[tile_idx] = RESTORE_WIENER;
-
-    if (!wiener_decompose_sep_sym(M, H, vfilterd, hfilterd)) {
-      type[tile_idx] = RESTORE_NONE;
-      continue;
-    }
-    quantize_sym_filter(vfilterd, rsi[plane].wiener_info[tile_idx].vfilter);
-    quantize_sym_filter(hfilterd, rsi[plane].wiener_info[tile_idx].hfilter);
-
-    // Filter score computes the value of the function x'*A*x - x'*b for the
-    // learned filter and compares it against identity filer. If there is no
-    // reduction in the function, the filter is reverted back to identity
-    score = compute_score(M, H, rsi[plane].wiener_info[tile_idx].vfilter,
-                          rsi[plane].wiener_info[tile_idx].hfilter);
-    if (score > 0.0) {
-      type[tile_idx] = RESTORE_NONE;
-      continue;
-    }
-
-    rsi[plane].restoration_type[tile_idx] = RESTORE_WIENER;
-    err = try_restoration_tile(src, cpi, rsi, 1 << plane, partial_frame,
-                               tile_idx, 0, 0, dst_frame);
-    bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_WIENER_PROB, 1);
-    cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_wiener >= cost_norestore) {
-      type[tile_idx] = RESTORE_NONE;
-    } else {
-      type[tile_idx] = RESTORE_WIENER;
-      memcpy(&wiener_info[tile_idx], &rsi[plane].wiener_info[tile_idx],
-             sizeof(wiener_info[tile_idx]));
-    }
-    rsi[plane].restoration_type[tile_idx] = RESTORE_NONE;
+      extend_frame(dgd_buffer, ctxt.width, ctxt.height, dgd->uv_stride);
   }
+
+  // Compute best Wiener filters for each tile
+  search_tiles(&ctxt);
   // Cost for Wiener filtering
   bits = 0;
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     bits +=
         av1_cost_bit(RESTORE_NONE_WIENER_PROB, type[tile_idx] != RESTORE_NONE);
     memcpy(&rsi[plane].wiener_info[tile_idx], &wiener_info[tile_idx],
@@ -885,22 +1061,18 @@ static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
   RestorationInfo *rsi = cpi->rst_search;
   int64_t err;
   int bits;
-  double cost_wiener, cost_norestore;
+  double cost_wiener;
   MACROBLOCK *x = &cpi->td.mb;
-  double M[WIENER_WIN2];
-  double H[WIENER_WIN2 * WIENER_WIN2];
-  double vfilterd[WIENER_WIN], hfilterd[WIENER_WIN];
   const YV12_BUFFER_CONFIG *dgd = cm->frame_to_show;
   const int width = cm->width;
   const int height = cm->height;
-  const int src_stride = src->y_stride;
   const int dgd_stride = dgd->y_stride;
-  double score;
-  int tile_idx, tile_width, tile_height, nhtiles, nvtiles;
-  int h_start, h_end, v_start, v_end;
-  const int ntiles =
-      av1_get_rest_ntiles(width, height, cm->rst_info[0].restoration_tilesize,
-                          &tile_width, &tile_height, &nhtiles, &nvtiles);
+  RestSearchCtxt ctxt;
+  int tile_idx;
+
+  init_search_ctxt(&ctxt, src, cpi, AOM_PLANE_Y, partial_frame, info, type,
+                   best_tile_cost);
+  ctxt.search_tile = search_wiener_tile;
   assert(width == dgd->y_crop_width);
   assert(height == dgd->y_crop_height);
   assert(width == src->y_crop_width);
@@ -908,7 +1080,7 @@ static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
 
   rsi->frame_restoration_type = RESTORE_WIENER;
 
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     rsi->restoration_type[tile_idx] = RESTORE_NONE;
   }
 
@@ -922,71 +1094,11 @@ static double search_wiener(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
     extend_frame(dgd->y_buffer, width, height, dgd_stride);
 
   // Compute best Wiener filters for each tile
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, 0, 0, &h_start, &h_end,
-                             &v_start, &v_end);
-    err = sse_restoration_tile(src, cm->frame_to_show, cm, h_start,
-                               h_end - h_start, v_start, v_end - v_start, 1);
-    // #bits when a tile is not restored
-    bits = av1_cost_bit(RESTORE_NONE_WIENER_PROB, 0);
-    cost_norestore = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    best_tile_cost[tile_idx] = DBL_MAX;
-
-    av1_get_rest_tile_limits(tile_idx, 0, 0, nhtiles, nvtiles, tile_width,
-                             tile_height, width, height, 0, 0, &h_start, &h_end,
-                             &v_start, &v_end);
-#if CONFIG_AOM_HIGHBITDEPTH
-    if (cm->use_highbitdepth)
-      compute_stats_highbd(dgd->y_buffer, src->y_buffer, h_start, h_end,
-                           v_start, v_end, dgd_stride, src_stride, M, H);
-    else
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-      compute_stats(dgd->y_buffer, src->y_buffer, h_start, h_end, v_start,
-                    v_end, dgd_stride, src_stride, M, H);
-
-    type[tile_idx] = RESTORE_WIENER;
-
-    if (!wiener_decompose_sep_sym(M, H, vfilterd, hfilterd)) {
-      type[tile_idx] = RESTORE_NONE;
-      continue;
-    }
-    quantize_sym_filter(vfilterd, rsi->wiener_info[tile_idx].vfilter);
-    quantize_sym_filter(hfilterd, rsi->wiener_info[tile_idx].hfilter);
-
-    // Filter score computes the value of the function x'*A*x - x'*b for the
-    // learned filter and compares it against identity filer. If there is no
-    // reduction in the function, the filter is reverted back to identity
-    score = compute_score(M, H, rsi->wiener_info[tile_idx].vfilter,
-                          rsi->wiener_info[tile_idx].hfilter);
-    if (score > 0.0) {
-      type[tile_idx] = RESTORE_NONE;
-      continue;
-    }
-
-    rsi->restoration_type[tile_idx] = RESTORE_WIENER;
-    err = try_restoration_tile(src, cpi, rsi, 1, partial_frame, tile_idx, 0, 0,
-                               dst_frame);
-    bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
-    bits += av1_cost_bit(RESTORE_NONE_WIENER_PROB, 1);
-    cost_wiener = RDCOST_DBL(x->rdmult, x->rddiv, (bits >> 4), err);
-    if (cost_wiener >= cost_norestore) {
-      type[tile_idx] = RESTORE_NONE;
-    } else {
-      type[tile_idx] = RESTORE_WIENER;
-      memcpy(&wiener_info[tile_idx], &rsi->wiener_info[tile_idx],
-             sizeof(wiener_info[tile_idx]));
-      bits = WIENER_FILT_BITS << AV1_PROB_COST_SHIFT;
-      best_tile_cost[tile_idx] = RDCOST_DBL(
-          x->rdmult, x->rddiv,
-          (bits + cpi->switchable_restore_cost[RESTORE_WIENER]) >> 4, err);
-    }
-    rsi->restoration_type[tile_idx] = RESTORE_NONE;
-  }
+  search_tiles(&ctxt);
   // Cost for Wiener filtering
   bits = frame_level_restore_bits[rsi->frame_restoration_type]
          << AV1_PROB_COST_SHIFT;
-  for (tile_idx = 0; tile_idx < ntiles; ++tile_idx) {
+  for (tile_idx = 0; tile_idx < ctxt.ntiles; ++tile_idx) {
     bits +=
         av1_cost_bit(RESTORE_NONE_WIENER_PROB, type[tile_idx] != RESTORE_NONE);
     memcpy(&rsi->wiener_info[tile_idx], &wiener_info[tile_idx],
@@ -1073,6 +1185,50 @@ static double search_switchable_restoration(
   return cost_switchable;
 }
 
+void av1_free_restoration_search_buffers(AV1_COMP *cpi) {
+  int i;
+  for (i = 1; i < cpi->num_rst_search_threads; ++i) {
+    aom_free_frame_buffer(&cpi->rst_search_thr_data[i].frame_buf);
+    aom_free(cpi->rst_search_thr_data[i].tmpbuf);
+  }
+  aom_free(cpi->rst_search_thr_data);
+  cpi->rst_search_thr_data = NULL;
+  cpi->num_rst_search_threads = 0;
+}
+
+static void alloc_search_buffers(AV1_COMP *cpi, int num_threads) {
+  AV1_COMMON *const cm = &cpi->common;
+  RestSearchThreadData *thr;
+  int i;
+
+  if (num_threads != cpi->num_rst_search_threads) {
+    av1_free_restoration_search_buffers(cpi);
+    CHECK_MEM_ERROR(cm, cpi->rst_search_thr_data,
+                    aom_calloc(num_threads, sizeof(*cpi->rst_search_thr_data)));
+    cpi->num_rst_search_threads = num_threads;
+    for (i = 1; i < num_threads; ++i) {
+      CHECK_MEM_ERROR(cm, cpi->rst_search_thr_data[i].tmpbuf,
+                      (int32_t *)aom_memalign(16, RESTORATION_TMPBUF_SIZE));
+    }
+  }
+  thr = cpi->rst_search_thr_data;
+  thr[0].dst_frame = &cpi->trial_frame_rst;
+  thr[0].tmpbuf = cm->rst_internal.tmpbuf;
+  for (i = 1; i < num_threads; ++i) {
+    if (aom_realloc_frame_buffer(&thr[i].frame_buf, cm->width, cm->height,
+                                 cm->subsampling_x, cm->subsampling_y,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                 cm->use_highbitdepth,
+#endif
+                                 AOM_BORDER_IN_PIXELS, cm->byte_alignment,
+                                 NULL, NULL, NULL))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate restoration search buffer");
+    thr[i].dst_frame = &thr[i].frame_buf;
+  }
+  for (i = 0; i < num_threads; ++i) thr[i].start = i;
+}
+
 void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
                                  LPF_PICK_METHOD method) {
   static search_restore_type search_restore_fun[RESTORE_SWITCHABLE_TYPES] = {
@@ -1089,6 +1245,8 @@ void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi,
                                          cm->rst_info[0].restoration_tilesize,
                                          NULL, NULL, NULL, NULL);
 
+  alloc_search_buffers(cpi, AOMMAX(cpi->num_workers, 1));
+
   for (r = 0; r < RESTORE_SWITCHABLE_TYPES; r++) {
     tile_cost[r] = (double *)aom_malloc(sizeof(*tile_cost[0]) * ntiles);
     restore_types[r] =
@@ -23,6 +23,9 @@ struct AV1_COMP;
 void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi,
                                  LPF_PICK_METHOD method);
 
+// Free the buffers of the threads of the loop restoration search.
+void av1_free_restoration_search_buffers(AV1_COMP *cpi);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
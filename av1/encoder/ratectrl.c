@@ -42,6 +42,9 @@
 #define MIN_BPB_FACTOR 0.005
 #define MAX_BPB_FACTOR 50
 
+#define MIN_SIZE_ESTIMATE_FACTOR 0.25
+#define MAX_SIZE_ESTIMATE_FACTOR 4.0
+
 #define FRAME_OVERHEAD_BITS 200
 #if CONFIG_AOM_HIGHBITDEPTH
 #define ASSIGN_MINQ_TABLE(bit_depth, name)                   \
@@ -318,6 +321,8 @@ void av1_rc_init(const AV1EncoderConfig *oxcf, int pass, RATE_CONTROL *rc) {
   for (i = 0; i < RATE_FACTOR_LEVELS; ++i) {
     rc->rate_correction_factors[i] = 1.0;
   }
+  rc->size_estimate_factors[0] = 1.0;
+  rc->size_estimate_factors[1] = 1.0;
 
   rc->min_gf_interval = oxcf->min_gf_interval;
   rc->max_gf_interval = oxcf->max_gf_interval;
@@ -483,6 +488,32 @@ void av1_rc_update_rate_correction_factors(AV1_COMP *cpi) {
   set_rate_correction_factor(cpi, rate_correction_factor);
 }
 
+int av1_rc_estimate_frame_size(const AV1_COMP *cpi) {
+  const int intra_only = frame_is_intra_only(&cpi->common);
+  const double bits =
+      (double)cpi->td.rd_counts.sb_rate / (1 << AV1_PROB_COST_SHIFT);
+
+  aom_clear_system_state();
+  return (int)AOMMIN(bits * cpi->rc.size_estimate_factors[intra_only] +
+                         FRAME_OVERHEAD_BITS,
+                     INT_MAX);
+}
+
+void av1_rc_update_size_estimate_factor(AV1_COMP *cpi, int frame_size) {
+  const int intra_only = frame_is_intra_only(&cpi->common);
+  const double bits =
+      (double)cpi->td.rd_counts.sb_rate / (1 << AV1_PROB_COST_SHIFT);
+  double *const factor = &cpi->rc.size_estimate_factors[intra_only];
+
+  aom_clear_system_state();
+  if (bits < FRAME_OVERHEAD_BITS || frame_size < FRAME_OVERHEAD_BITS) return;
+
+  // Move half way towards the ratio just seen.
+  *factor =
+      fclamp(0.5 * *factor + 0.5 * (frame_size - FRAME_OVERHEAD_BITS) / bits,
+             MIN_SIZE_ESTIMATE_FACTOR, MAX_SIZE_ESTIMATE_FACTOR);
+}
+
 int av1_rc_regulate_q(const AV1_COMP *cpi, int target_bits_per_frame,
                       int active_best_quality, int active_worst_quality) {
   const AV1_COMMON *const cm = &cpi->common;
@@ -86,6 +86,9 @@ typedef struct {
   int kf_boost;
 
   double rate_correction_factors[RATE_FACTOR_LEVELS];
+  // Scale the rates of the RD search to frame sizes, for inter and for
+  // intra-only frames.
+  double size_estimate_factors[2];
 
   int frames_since_golden;
   int frames_till_gf_update_due;
@@ -224,6 +227,14 @@ void av1_rc_postencode_update_drop_frame(struct AV1_COMP *cpi);
 // Changes only the rate correction factors in the rate control structure.
 void av1_rc_update_rate_correction_factors(struct AV1_COMP *cpi);
 
+// Estimates the size in bits of the frame just encoded from the rates of the
+// RD search, without packing it.
+int av1_rc_estimate_frame_size(const struct AV1_COMP *cpi);
+
+// Updates the factor of the size estimates with the size in bits of the frame
+// just packed.
+void av1_rc_update_size_estimate_factor(struct AV1_COMP *cpi, int frame_size);
+
 // Decide if we should drop this frame: For 1-pass CBR.
 // Changes only the decimation count in the rate control structure
 int av1_rc_drop_frame(struct AV1_COMP *cpi);
@@ -131,6 +131,7 @@ static void set_good_speed_feature(AV1_COMP *cpi, AV1_COMMON *cm,
   if (speed >= 1) {
     sf->tx_type_search.fast_intra_tx_type_search = 1;
     sf->tx_type_search.fast_inter_tx_type_search = 1;
+    sf->recode_size = RECODE_SIZE_ESTIMATE_NEAR_LIMITS;
   }
 
   if (speed >= 2) {
@@ -164,6 +165,7 @@ static void set_good_speed_feature(AV1_COMP *cpi, AV1_COMMON *cm,
     sf->tx_size_search_breakout = 1;
     sf->partition_search_breakout_rate_thr = 80;
     sf->tx_type_search.prune_mode = PRUNE_ONE;
+    sf->cdef_prune_strengths = 1;
     // Use transform domain distortion.
     // Note var-tx expt always uses pixel domain distortion.
     sf->use_transform_domain_distortion = 1;
@@ -187,6 +189,7 @@ static void set_good_speed_feature(AV1_COMP *cpi, AV1_COMMON *cm,
     sf->allow_partition_search_skip = 1;
     sf->use_upsampled_references = 0;
     sf->adaptive_rd_thresh = 2;
+    sf->recode_size = RECODE_SIZE_ESTIMATE;
 #if CONFIG_EXT_TX
     sf->tx_type_search.prune_mode = PRUNE_TWO;
 #endif
@@ -297,6 +300,7 @@ static void set_rt_speed_feature(AV1_COMP *cpi, SPEED_FEATURES *sf, int speed,
   if (speed >= 1) {
     sf->use_square_partition_only = !frame_is_intra_only(cm);
     sf->less_rectangular_check = 1;
+    sf->cdef_prune_strengths = 1;
     sf->tx_size_search_method =
         frame_is_intra_only(cm) ? USE_FULL_RD : USE_LARGESTALL;
 
@@ -444,18 +448,9 @@ static void set_rt_speed_feature(AV1_COMP *cpi, SPEED_FEATURES *sf, int speed,
 void av1_set_speed_features_framesize_dependent(AV1_COMP *cpi) {
   SPEED_FEATURES *const sf = &cpi->sf;
   const AV1EncoderConfig *const oxcf = &cpi->oxcf;
-  AV1_COMMON *const cm = &cpi->common;
   RD_OPT *const rd = &cpi->rd;
   int i;
 
-  // Limit memory usage for high resolutions
-  if (AOMMIN(cm->width, cm->height) > 1080) {
-    sf->use_upsampled_references = 0;
-  }
-  if ((AOMMIN(cm->width, cm->height) > 720) && (oxcf->profile != PROFILE_0)) {
-    sf->use_upsampled_references = 0;
-  }
-
   if (oxcf->mode == REALTIME) {
     set_rt_speed_feature_framesize_dependent(cpi, sf, oxcf->speed);
   } else if (oxcf->mode == GOOD) {
@@ -485,6 +480,7 @@ void av1_set_speed_features_framesize_independent(AV1_COMP *cpi) {
   sf->frame_parameter_update = 1;
   sf->mv.search_method = NSTEP;
   sf->recode_loop = ALLOW_RECODE;
+  sf->recode_size = RECODE_SIZE_PACK;
   sf->mv.subpel_search_method = SUBPEL_TREE;
   sf->mv.subpel_iters_per_step = 2;
   sf->mv.subpel_force_stop = 0;
@@ -537,6 +533,7 @@ void av1_set_speed_features_framesize_independent(AV1_COMP *cpi) {
   }
   sf->use_rd_breakout = 0;
   sf->lpf_pick = LPF_PICK_FROM_FULL_IMAGE;
+  sf->cdef_prune_strengths = 0;
   sf->use_fast_coef_updates = TWO_LOOP;
   sf->use_fast_coef_costing = 0;
   sf->mode_skip_start = MAX_MODES;  // Mode index at which mode skip mask set
@@ -114,6 +114,16 @@ typedef enum {
   ALLOW_RECODE = 3,
 } RECODE_LOOP_TYPE;
 
+typedef enum {
+  // Pack the frame to find its size.
+  RECODE_SIZE_PACK = 0,
+  // Estimate the size from the rates of the RD search, and pack the frame
+  // only if the estimate is close to the limits that trigger a recode.
+  RECODE_SIZE_ESTIMATE_NEAR_LIMITS = 1,
+  // Always estimate the size from the rates of the RD search.
+  RECODE_SIZE_ESTIMATE = 2,
+} RECODE_SIZE_TYPE;
+
 typedef enum {
   SUBPEL_TREE = 0,
   SUBPEL_TREE_PRUNED = 1,           // Prunes 1/2-pel searches
@@ -261,6 +271,9 @@ typedef struct SPEED_FEATURES {
 
   RECODE_LOOP_TYPE recode_loop;
 
+  // How the recode loop finds the size of each encoding of the frame.
+  RECODE_SIZE_TYPE recode_size;
+
   // Trellis (dynamic programming) optimization of quantized values (+1, 0).
   int optimize_coefficients;
 
@@ -413,6 +426,10 @@ typedef struct SPEED_FEATURES {
   // This feature controls how the loop filter level is determined.
   LPF_PICK_METHOD lpf_pick;
 
+  // Only try the strong luma dering levels of CDEF on superblocks whose
+  // blocks have a strong direction.
+  int cdef_prune_strengths;
+
   // This feature limits the number of coefficients updates we actually do
   // by only looking at counts from 1/2 the bands.
   FAST_COEFF_UPDATE use_fast_coef_updates;
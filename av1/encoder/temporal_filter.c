@@ -13,6 +13,7 @@
 #include <limits.h>
 
 #include "./aom_config.h"
+#include "./av1_rtcd.h"
 #include "av1/common/alloccommon.h"
 #include "av1/common/onyxc_int.h"
 #include "av1/common/quant_common.h"
@@ -23,6 +24,7 @@
 #include "av1/encoder/firstpass.h"
 #include "av1/encoder/mcomp.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/ratectrl.h"
 #include "av1/encoder/segmentation.h"
 #include "av1/encoder/temporal_filter.h"
@@ -34,12 +36,12 @@
 
 static void temporal_filter_predictors_mb_c(
     MACROBLOCKD *xd, uint8_t *y_mb_ptr, uint8_t *u_mb_ptr, uint8_t *v_mb_ptr,
-    int stride, int uv_block_width, int uv_block_height, int mv_row, int mv_col,
-    uint8_t *pred, struct scale_factors *scale, int x, int y) {
+    int stride, int uv_stride, int uv_block_width, int uv_block_height,
+    int mv_row, int mv_col, uint8_t *pred, struct scale_factors *scale, int x,
+    int y) {
   const int which_mv = 0;
   const MV mv = { mv_row, mv_col };
   enum mv_precision mv_precision_uv;
-  int uv_stride;
   // TODO(angiebird): change plane setting accordingly
   ConvolveParams conv_params = get_conv_params(which_mv, 0);
 
@@ -58,10 +60,8 @@ static void temporal_filter_predictors_mb_c(
 #endif  // USE_TEMPORALFILTER_12TAP
 
   if (uv_block_width == 8) {
-    uv_stride = (stride + 1) >> 1;
     mv_precision_uv = MV_PRECISION_Q4;
   } else {
-    uv_stride = stride;
     mv_precision_uv = MV_PRECISION_Q3;
   }
 
@@ -241,11 +241,11 @@ void av1_highbd_temporal_filter_apply_c(
 }
 #endif  // CONFIG_AOM_HIGHBITDEPTH
 
-static int temporal_filter_find_matching_mb_c(AV1_COMP *cpi,
+static int temporal_filter_find_matching_mb_c(AV1_COMP *cpi, MACROBLOCK *x,
                                               uint8_t *arf_frame_buf,
+                                              int arf_stride,
                                               uint8_t *frame_ptr_buf,
                                               int stride) {
-  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   const MV_SPEED_FEATURES *const mv_sf = &cpi->sf.mv;
   int step_param;
@@ -267,7 +267,7 @@ static int temporal_filter_find_matching_mb_c(AV1_COMP *cpi,
 
   // Setup frame pointers
   x->plane[0].src.buf = arf_frame_buf;
-  x->plane[0].src.stride = stride;
+  x->plane[0].src.stride = arf_stride;
   xd->plane[0].pre[0].buf = frame_ptr_buf;
   xd->plane[0].pre[0].stride = stride;
 
@@ -293,8 +293,6 @@ static int temporal_filter_find_matching_mb_c(AV1_COMP *cpi,
       cond_cost_list(cpi, cost_list), NULL, NULL, &distortion, &sse, NULL, 0, 0,
       0);
 
-  x->e_mbd.mi[0]->bmi[0].as_mv[0] = x->best_mv;
-
   // Restore input state
   x->plane[0].src = src;
   xd->plane[0].pre[0] = pre;
@@ -302,23 +300,22 @@ static int temporal_filter_find_matching_mb_c(AV1_COMP *cpi,
   return bestsme;
 }
 
-static void temporal_filter_iterate_c(AV1_COMP *cpi,
-                                      YV12_BUFFER_CONFIG **frames,
-                                      int frame_count, int alt_ref_index,
-                                      int strength,
-                                      struct scale_factors *scale) {
+void av1_temporal_filter_row(AV1_COMP *cpi, ThreadData *td,
+                             const TemporalFilterData *tf, int mb_row) {
+  YV12_BUFFER_CONFIG **const frames = tf->frames;
+  const int alt_ref_index = tf->alt_ref_index;
+  const int strength = tf->strength;
+  const int mb_cols = tf->mb_cols;
+  const int mb_rows = tf->mb_rows;
+  MACROBLOCK *const x = &td->mb;
+  MACROBLOCKD *const mbd = &x->e_mbd;
+  YV12_BUFFER_CONFIG *f = frames[alt_ref_index];
   int byte;
   int frame;
-  int mb_col, mb_row;
+  int mb_col;
   unsigned int filter_weight;
-  int mb_cols = (frames[alt_ref_index]->y_crop_width + 15) >> 4;
-  int mb_rows = (frames[alt_ref_index]->y_crop_height + 15) >> 4;
-  int mb_y_offset = 0;
-  int mb_uv_offset = 0;
   DECLARE_ALIGNED(16, unsigned int, accumulator[16 * 16 * 3]);
   DECLARE_ALIGNED(16, uint16_t, count[16 * 16 * 3]);
-  MACROBLOCKD *mbd = &cpi->td.mb.e_mbd;
-  YV12_BUFFER_CONFIG *f = frames[alt_ref_index];
   uint8_t *dst1, *dst2;
 #if CONFIG_AOM_HIGHBITDEPTH
   DECLARE_ALIGNED(16, uint16_t, predictor16[16 * 16 * 3]);
@@ -329,6 +326,11 @@ static void temporal_filter_iterate_c(AV1_COMP *cpi,
 #endif
   const int mb_uv_height = 16 >> mbd->plane[1].subsampling_y;
   const int mb_uv_width = 16 >> mbd->plane[1].subsampling_x;
+  // The offsets of the macroblock in the alt ref buffer. The source frames
+  // may differ in stride, as input frames lent by the application are read in
+  // place, so their offsets are found for each frame.
+  int mb_y_offset = mb_row * 16 * cpi->alt_ref_buffer.y_stride;
+  int mb_uv_offset = mb_row * mb_uv_height * cpi->alt_ref_buffer.uv_stride;
 
   // Save input state
   uint8_t *input_buffer[MAX_MB_PLANE];
@@ -343,196 +345,163 @@ static void temporal_filter_iterate_c(AV1_COMP *cpi,
 
   for (i = 0; i < MAX_MB_PLANE; i++) input_buffer[i] = mbd->plane[i].pre[0].buf;
 
-  for (mb_row = 0; mb_row < mb_rows; mb_row++) {
-    // Source frames are extended to 16 pixels. This is different than
-    //  L/A/G reference frames that have a border of 32 (AV1ENCBORDERINPIXELS)
-    // A 6/8 tap filter is used for motion search.  This requires 2 pixels
-    //  before and 3 pixels after.  So the largest Y mv on a border would
-    //  then be 16 - AOM_INTERP_EXTEND. The UV blocks are half the size of the
-    //  Y and therefore only extended by 8.  The largest mv that a UV block
-    //  can support is 8 - AOM_INTERP_EXTEND.  A UV mv is half of a Y mv.
-    //  (16 - AOM_INTERP_EXTEND) >> 1 which is greater than
-    //  8 - AOM_INTERP_EXTEND.
-    // To keep the mv in play for both Y and UV planes the max that it
-    //  can be on a border is therefore 16 - (2*AOM_INTERP_EXTEND+1).
-    cpi->td.mb.mv_row_min = -((mb_row * 16) + (17 - 2 * AOM_INTERP_EXTEND));
-    cpi->td.mb.mv_row_max =
-        ((mb_rows - 1 - mb_row) * 16) + (17 - 2 * AOM_INTERP_EXTEND);
-
-    for (mb_col = 0; mb_col < mb_cols; mb_col++) {
-      int j, k;
-      int stride;
-
-      memset(accumulator, 0, 16 * 16 * 3 * sizeof(accumulator[0]));
-      memset(count, 0, 16 * 16 * 3 * sizeof(count[0]));
-
-      cpi->td.mb.mv_col_min = -((mb_col * 16) + (17 - 2 * AOM_INTERP_EXTEND));
-      cpi->td.mb.mv_col_max =
-          ((mb_cols - 1 - mb_col) * 16) + (17 - 2 * AOM_INTERP_EXTEND);
-
-      for (frame = 0; frame < frame_count; frame++) {
-        const int thresh_low = 10000;
-        const int thresh_high = 20000;
-
-        if (frames[frame] == NULL) continue;
-
-        mbd->mi[0]->bmi[0].as_mv[0].as_mv.row = 0;
-        mbd->mi[0]->bmi[0].as_mv[0].as_mv.col = 0;
-
-        if (frame == alt_ref_index) {
-          filter_weight = 2;
-        } else {
-          // Find best match in this frame by MC
-          int err = temporal_filter_find_matching_mb_c(
-              cpi, frames[alt_ref_index]->y_buffer + mb_y_offset,
-              frames[frame]->y_buffer + mb_y_offset, frames[frame]->y_stride);
-
-          // Assign higher weight to matching MB if it's error
-          // score is lower. If not applying MC default behavior
-          // is to weight all MBs equal.
-          filter_weight = err < thresh_low ? 2 : err < thresh_high ? 1 : 0;
-        }
+  // Source frames are extended to 16 pixels. This is different than
+  //  L/A/G reference frames that have a border of 32 (AV1ENCBORDERINPIXELS)
+  // A 6/8 tap filter is used for motion search.  This requires 2 pixels
+  //  before and 3 pixels after.  So the largest Y mv on a border would
+  //  then be 16 - AOM_INTERP_EXTEND. The UV blocks are half the size of the
+  //  Y and therefore only extended by 8.  The largest mv that a UV block
+  //  can support is 8 - AOM_INTERP_EXTEND.  A UV mv is half of a Y mv.
+  //  (16 - AOM_INTERP_EXTEND) >> 1 which is greater than
+  //  8 - AOM_INTERP_EXTEND.
+  // To keep the mv in play for both Y and UV planes the max that it
+  //  can be on a border is therefore 16 - (2*AOM_INTERP_EXTEND+1).
+  x->mv_row_min = -((mb_row * 16) + (17 - 2 * AOM_INTERP_EXTEND));
+  x->mv_row_max = ((mb_rows - 1 - mb_row) * 16) + (17 - 2 * AOM_INTERP_EXTEND);
+
+  for (mb_col = 0; mb_col < mb_cols; mb_col++) {
+    int j, k;
+    int stride;
+    int f_y_offset, f_uv_offset;
+
+    memset(accumulator, 0, 16 * 16 * 3 * sizeof(accumulator[0]));
+    memset(count, 0, 16 * 16 * 3 * sizeof(count[0]));
+
+    x->mv_col_min = -((mb_col * 16) + (17 - 2 * AOM_INTERP_EXTEND));
+    x->mv_col_max =
+        ((mb_cols - 1 - mb_col) * 16) + (17 - 2 * AOM_INTERP_EXTEND);
+
+    f_y_offset = mb_row * 16 * f->y_stride + mb_col * 16;
+    f_uv_offset = mb_row * mb_uv_height * f->uv_stride + mb_col * mb_uv_width;
+
+    for (frame = 0; frame < tf->frame_count; frame++) {
+      const int thresh_low = 10000;
+      const int thresh_high = 20000;
+      MV mv = { 0, 0 };
+      int y_offset, uv_offset;
+
+      if (frames[frame] == NULL) continue;
+
+      y_offset = mb_row * 16 * frames[frame]->y_stride + mb_col * 16;
+      uv_offset = mb_row * mb_uv_height * frames[frame]->uv_stride +
+                  mb_col * mb_uv_width;
+
+      if (frame == alt_ref_index) {
+        filter_weight = 2;
+      } else {
+        // Find best match in this frame by MC
+        int err = temporal_filter_find_matching_mb_c(
+            cpi, x, f->y_buffer + f_y_offset, f->y_stride,
+            frames[frame]->y_buffer + y_offset, frames[frame]->y_stride);
+        mv = x->best_mv.as_mv;
+
+        // Assign higher weight to matching MB if it's error
+        // score is lower. If not applying MC default behavior
+        // is to weight all MBs equal.
+        filter_weight = err < thresh_low ? 2 : err < thresh_high ? 1 : 0;
+      }
 
-        if (filter_weight != 0) {
-          // Construct the predictors
-          temporal_filter_predictors_mb_c(
-              mbd, frames[frame]->y_buffer + mb_y_offset,
-              frames[frame]->u_buffer + mb_uv_offset,
-              frames[frame]->v_buffer + mb_uv_offset, frames[frame]->y_stride,
-              mb_uv_width, mb_uv_height, mbd->mi[0]->bmi[0].as_mv[0].as_mv.row,
-              mbd->mi[0]->bmi[0].as_mv[0].as_mv.col, predictor, scale,
-              mb_col * 16, mb_row * 16);
+      if (filter_weight != 0) {
+        // Construct the predictors
+        temporal_filter_predictors_mb_c(
+            mbd, frames[frame]->y_buffer + y_offset,
+            frames[frame]->u_buffer + uv_offset,
+            frames[frame]->v_buffer + uv_offset, frames[frame]->y_stride,
+            frames[frame]->uv_stride, mb_uv_width, mb_uv_height, mv.row,
+            mv.col, predictor, tf->scale, mb_col * 16, mb_row * 16);
 
 #if CONFIG_AOM_HIGHBITDEPTH
-          if (mbd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
-            int adj_strength = strength + 2 * (mbd->bd - 8);
-            // Apply the filter (YUV)
-            av1_highbd_temporal_filter_apply(
-                f->y_buffer + mb_y_offset, f->y_stride, predictor, 16, 16,
-                adj_strength, filter_weight, accumulator, count);
-            av1_highbd_temporal_filter_apply(
-                f->u_buffer + mb_uv_offset, f->uv_stride, predictor + 256,
-                mb_uv_width, mb_uv_height, adj_strength, filter_weight,
-                accumulator + 256, count + 256);
-            av1_highbd_temporal_filter_apply(
-                f->v_buffer + mb_uv_offset, f->uv_stride, predictor + 512,
-                mb_uv_width, mb_uv_height, adj_strength, filter_weight,
-                accumulator + 512, count + 512);
-          } else {
-            // Apply the filter (YUV)
-            av1_temporal_filter_apply_c(f->y_buffer + mb_y_offset, f->y_stride,
-                                        predictor, 16, 16, strength,
-                                        filter_weight, accumulator, count);
-            av1_temporal_filter_apply_c(
-                f->u_buffer + mb_uv_offset, f->uv_stride, predictor + 256,
-                mb_uv_width, mb_uv_height, strength, filter_weight,
-                accumulator + 256, count + 256);
-            av1_temporal_filter_apply_c(
-                f->v_buffer + mb_uv_offset, f->uv_stride, predictor + 512,
-                mb_uv_width, mb_uv_height, strength, filter_weight,
-                accumulator + 512, count + 512);
-          }
-#else
+        if (mbd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+          int adj_strength = strength + 2 * (mbd->bd - 8);
           // Apply the filter (YUV)
-          av1_temporal_filter_apply_c(f->y_buffer + mb_y_offset, f->y_stride,
-                                      predictor, 16, 16, strength,
-                                      filter_weight, accumulator, count);
-          av1_temporal_filter_apply_c(f->u_buffer + mb_uv_offset, f->uv_stride,
-                                      predictor + 256, mb_uv_width,
-                                      mb_uv_height, strength, filter_weight,
-                                      accumulator + 256, count + 256);
-          av1_temporal_filter_apply_c(f->v_buffer + mb_uv_offset, f->uv_stride,
-                                      predictor + 512, mb_uv_width,
-                                      mb_uv_height, strength, filter_weight,
-                                      accumulator + 512, count + 512);
-#endif  // CONFIG_AOM_HIGHBITDEPTH
+          av1_highbd_temporal_filter_apply(
+              f->y_buffer + f_y_offset, f->y_stride, predictor, 16, 16,
+              adj_strength, filter_weight, accumulator, count);
+          av1_highbd_temporal_filter_apply(
+              f->u_buffer + f_uv_offset, f->uv_stride, predictor + 256,
+              mb_uv_width, mb_uv_height, adj_strength, filter_weight,
+              accumulator + 256, count + 256);
+          av1_highbd_temporal_filter_apply(
+              f->v_buffer + f_uv_offset, f->uv_stride, predictor + 512,
+              mb_uv_width, mb_uv_height, adj_strength, filter_weight,
+              accumulator + 512, count + 512);
+        } else {
+          // Apply the filter (YUV)
+          av1_temporal_filter_apply(f->y_buffer + f_y_offset, f->y_stride,
+                                    predictor, 16, 16, strength, filter_weight,
+                                    accumulator, count);
+          av1_temporal_filter_apply(f->u_buffer + f_uv_offset, f->uv_stride,
+                                    predictor + 256, mb_uv_width, mb_uv_height,
+                                    strength, filter_weight, accumulator + 256,
+                                    count + 256);
+          av1_temporal_filter_apply(f->v_buffer + f_uv_offset, f->uv_stride,
+                                    predictor + 512, mb_uv_width, mb_uv_height,
+                                    strength, filter_weight, accumulator + 512,
+                                    count + 512);
         }
+#else
+        // Apply the filter (YUV)
+        av1_temporal_filter_apply(f->y_buffer + f_y_offset, f->y_stride,
+                                  predictor, 16, 16, strength, filter_weight,
+                                  accumulator, count);
+        av1_temporal_filter_apply(f->u_buffer + f_uv_offset, f->uv_stride,
+                                  predictor + 256, mb_uv_width, mb_uv_height,
+                                  strength, filter_weight, accumulator + 256,
+                                  count + 256);
+        av1_temporal_filter_apply(f->v_buffer + f_uv_offset, f->uv_stride,
+                                  predictor + 512, mb_uv_width, mb_uv_height,
+                                  strength, filter_weight, accumulator + 512,
+                                  count + 512);
+#endif  // CONFIG_AOM_HIGHBITDEPTH
       }
+    }
 
 #if CONFIG_AOM_HIGHBITDEPTH
-      if (mbd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
-        uint16_t *dst1_16;
-        uint16_t *dst2_16;
-        // Normalize filter output to produce AltRef frame
-        dst1 = cpi->alt_ref_buffer.y_buffer;
-        dst1_16 = CONVERT_TO_SHORTPTR(dst1);
-        stride = cpi->alt_ref_buffer.y_stride;
-        byte = mb_y_offset;
-        for (i = 0, k = 0; i < 16; i++) {
-          for (j = 0; j < 16; j++, k++) {
-            dst1_16[byte] =
-                (uint16_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
-
-            // move to next pixel
-            byte++;
-          }
+    if (mbd->cur_buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+      uint16_t *dst1_16;
+      uint16_t *dst2_16;
+      // Normalize filter output to produce AltRef frame
+      dst1 = cpi->alt_ref_buffer.y_buffer;
+      dst1_16 = CONVERT_TO_SHORTPTR(dst1);
+      stride = cpi->alt_ref_buffer.y_stride;
+      byte = mb_y_offset;
+      for (i = 0, k = 0; i < 16; i++) {
+        for (j = 0; j < 16; j++, k++) {
+          dst1_16[byte] =
+              (uint16_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
 
-          byte += stride - 16;
+          // move to next pixel
+          byte++;
         }
 
-        dst1 = cpi->alt_ref_buffer.u_buffer;
-        dst2 = cpi->alt_ref_buffer.v_buffer;
-        dst1_16 = CONVERT_TO_SHORTPTR(dst1);
-        dst2_16 = CONVERT_TO_SHORTPTR(dst2);
-        stride = cpi->alt_ref_buffer.uv_stride;
-        byte = mb_uv_offset;
-        for (i = 0, k = 256; i < mb_uv_height; i++) {
-          for (j = 0; j < mb_uv_width; j++, k++) {
-            int m = k + 256;
-
-            // U
-            dst1_16[byte] =
-                (uint16_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
-
-            // V
-            dst2_16[byte] =
-                (uint16_t)OD_DIVU(accumulator[m] + (count[m] >> 1), count[m]);
-
-            // move to next pixel
-            byte++;
-          }
-
-          byte += stride - mb_uv_width;
-        }
-      } else {
-        // Normalize filter output to produce AltRef frame
-        dst1 = cpi->alt_ref_buffer.y_buffer;
-        stride = cpi->alt_ref_buffer.y_stride;
-        byte = mb_y_offset;
-        for (i = 0, k = 0; i < 16; i++) {
-          for (j = 0; j < 16; j++, k++) {
-            dst1[byte] =
-                (uint8_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
-
-            // move to next pixel
-            byte++;
-          }
-          byte += stride - 16;
-        }
+        byte += stride - 16;
+      }
 
-        dst1 = cpi->alt_ref_buffer.u_buffer;
-        dst2 = cpi->alt_ref_buffer.v_buffer;
-        stride = cpi->alt_ref_buffer.uv_stride;
-        byte = mb_uv_offset;
-        for (i = 0, k = 256; i < mb_uv_height; i++) {
-          for (j = 0; j < mb_uv_width; j++, k++) {
-            int m = k + 256;
+      dst1 = cpi->alt_ref_buffer.u_buffer;
+      dst2 = cpi->alt_ref_buffer.v_buffer;
+      dst1_16 = CONVERT_TO_SHORTPTR(dst1);
+      dst2_16 = CONVERT_TO_SHORTPTR(dst2);
+      stride = cpi->alt_ref_buffer.uv_stride;
+      byte = mb_uv_offset;
+      for (i = 0, k = 256; i < mb_uv_height; i++) {
+        for (j = 0; j < mb_uv_width; j++, k++) {
+          int m = k + 256;
 
-            // U
-            dst1[byte] =
-                (uint8_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
+          // U
+          dst1_16[byte] =
+              (uint16_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
 
-            // V
-            dst2[byte] =
-                (uint8_t)OD_DIVU(accumulator[m] + (count[m] >> 1), count[m]);
+          // V
+          dst2_16[byte] =
+              (uint16_t)OD_DIVU(accumulator[m] + (count[m] >> 1), count[m]);
 
-            // move to next pixel
-            byte++;
-          }
-          byte += stride - mb_uv_width;
+          // move to next pixel
+          byte++;
         }
+
+        byte += stride - mb_uv_width;
       }
-#else
+    } else {
       // Normalize filter output to produce AltRef frame
       dst1 = cpi->alt_ref_buffer.y_buffer;
       stride = cpi->alt_ref_buffer.y_stride;
@@ -569,18 +538,83 @@ static void temporal_filter_iterate_c(AV1_COMP *cpi,
         }
         byte += stride - mb_uv_width;
       }
-#endif  // CONFIG_AOM_HIGHBITDEPTH
-      mb_y_offset += 16;
-      mb_uv_offset += mb_uv_width;
     }
-    mb_y_offset += 16 * (f->y_stride - mb_cols);
-    mb_uv_offset += mb_uv_height * f->uv_stride - mb_uv_width * mb_cols;
+#else
+    // Normalize filter output to produce AltRef frame
+    dst1 = cpi->alt_ref_buffer.y_buffer;
+    stride = cpi->alt_ref_buffer.y_stride;
+    byte = mb_y_offset;
+    for (i = 0, k = 0; i < 16; i++) {
+      for (j = 0; j < 16; j++, k++) {
+        dst1[byte] =
+            (uint8_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
+
+        // move to next pixel
+        byte++;
+      }
+      byte += stride - 16;
+    }
+
+    dst1 = cpi->alt_ref_buffer.u_buffer;
+    dst2 = cpi->alt_ref_buffer.v_buffer;
+    stride = cpi->alt_ref_buffer.uv_stride;
+    byte = mb_uv_offset;
+    for (i = 0, k = 256; i < mb_uv_height; i++) {
+      for (j = 0; j < mb_uv_width; j++, k++) {
+        int m = k + 256;
+
+        // U
+        dst1[byte] =
+            (uint8_t)OD_DIVU(accumulator[k] + (count[k] >> 1), count[k]);
+
+        // V
+        dst2[byte] =
+            (uint8_t)OD_DIVU(accumulator[m] + (count[m] >> 1), count[m]);
+
+        // move to next pixel
+        byte++;
+      }
+      byte += stride - mb_uv_width;
+    }
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+    mb_y_offset += 16;
+    mb_uv_offset += mb_uv_width;
   }
 
   // Restore input state
   for (i = 0; i < MAX_MB_PLANE; i++) mbd->plane[i].pre[0].buf = input_buffer[i];
 }
 
+static int use_temporal_filter_row_mt(const AV1_COMP *cpi, int mb_rows) {
+  return cpi->oxcf.max_threads > 1 && mb_rows > 1;
+}
+
+static void temporal_filter_iterate_c(AV1_COMP *cpi,
+                                      YV12_BUFFER_CONFIG **frames,
+                                      int frame_count, int alt_ref_index,
+                                      int strength,
+                                      struct scale_factors *scale) {
+  TemporalFilterData tf;
+  int mb_row;
+
+  tf.frames = frames;
+  tf.frame_count = frame_count;
+  tf.alt_ref_index = alt_ref_index;
+  tf.strength = strength;
+  tf.scale = scale;
+  tf.mb_cols = (frames[alt_ref_index]->y_crop_width + 15) >> 4;
+  tf.mb_rows = (frames[alt_ref_index]->y_crop_height + 15) >> 4;
+
+  // The macroblocks are filtered independently, so the result does not depend
+  // on the number of threads.
+  if (use_temporal_filter_row_mt(cpi, tf.mb_rows)) {
+    av1_temporal_filter_row_mt(cpi, &tf);
+  } else {
+    for (mb_row = 0; mb_row < tf.mb_rows; mb_row++)
+      av1_temporal_filter_row(cpi, &cpi->td, &tf, mb_row);
+  }
+}
+
 // Apply buffer limits and context specific adjustments to arnr filter.
 static void adjust_arnr_filter(AV1_COMP *cpi, int distance, int group_boost,
                                int *arnr_frames, int *arnr_strength) {
@@ -684,6 +718,7 @@ void av1_temporal_filter(AV1_COMP *cpi, int distance) {
     const int which_buffer = start_frame - frame;
     struct lookahead_entry *buf =
         av1_lookahead_peek(cpi->lookahead, which_buffer);
+    av1_lookahead_prepare_search(buf);
     frames[frames_to_blur - 1 - frame] = &buf->img;
   }
 
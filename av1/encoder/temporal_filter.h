@@ -16,8 +16,25 @@
 extern "C" {
 #endif
 
+// Parameters of the filtering of an ARF, shared by the threads filtering its
+// macroblock rows.
+typedef struct TemporalFilterData {
+  YV12_BUFFER_CONFIG **frames;
+  int frame_count;
+  int alt_ref_index;
+  int strength;
+  struct scale_factors *scale;
+  int mb_rows;
+  int mb_cols;
+} TemporalFilterData;
+
 void av1_temporal_filter(AV1_COMP *cpi, int distance);
 
+// Filter one macroblock row of the ARF into cpi->alt_ref_buffer, using the
+// motion search state of td.
+void av1_temporal_filter_row(AV1_COMP *cpi, ThreadData *td,
+                             const TemporalFilterData *tf, int mb_row);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -315,18 +315,17 @@ static void set_entropy_context_b(int plane, int block, int blk_row,
 }
 
 #if CONFIG_NEW_TOKENSET
-static INLINE void add_token(TOKENEXTRA **t,
-                             aom_cdf_prob (*tail_cdf)[CDF_SIZE(ENTROPY_TOKENS)],
-                             aom_cdf_prob (*head_cdf)[CDF_SIZE(ENTROPY_TOKENS)],
-                             int eob_val, int first_val, int32_t extra,
-                             uint8_t token) {
+static INLINE void add_token(TOKENEXTRA **t, uint16_t ctx, int eob_val,
+                             int first_val, int32_t extra, uint8_t token) {
   (*t)->token = token;
-  (*t)->extra = extra;
-  (*t)->tail_cdf = tail_cdf;
-  (*t)->head_cdf = head_cdf;
-  (*t)->eob_val = eob_val;
-  (*t)->first_val = first_val;
+  (*t)->ctx = ctx;
+  (*t)->flags = eob_val | (first_val << TOKEN_FIRST_VAL_SHIFT) |
+                ((extra & 1) << TOKEN_SIGN_SHIFT);
   (*t)++;
+  if (av1_token_has_extra_bits(token)) {
+    av1_set_token_extra_bits(*t, extra >> 1);
+    (*t)++;
+  }
 }
 
 #else  // CONFIG_NEW_TOKENSET
@@ -363,10 +362,12 @@ void av1_tokenize_palette_sb(const AV1_COMP *cpi,
   int i, j;
   int this_rate = 0;
   uint8_t color_order[PALETTE_MAX_SIZE];
+#if !CONFIG_NEW_TOKENSET
   const aom_prob(
       *const probs)[PALETTE_COLOR_INDEX_CONTEXTS][PALETTE_COLORS - 1] =
       plane == 0 ? av1_default_palette_y_color_index_prob
                  : av1_default_palette_uv_color_index_prob;
+#endif  // !CONFIG_NEW_TOKENSET
   int plane_block_width, rows, cols;
   av1_get_block_dimensions(bsize, plane, xd, &plane_block_width, NULL, &rows,
                            &cols);
@@ -389,8 +390,13 @@ void av1_tokenize_palette_sb(const AV1_COMP *cpi,
         this_rate += cpi->palette_y_color_cost[n - PALETTE_MIN_SIZE][color_ctx]
                                               [color_new_idx];
       (*t)->token = color_new_idx;
+#if CONFIG_NEW_TOKENSET
+      (*t)->ctx = color_ctx;
+      (*t)->flags = 0;
+#else
       (*t)->context_tree = probs[n - PALETTE_MIN_SIZE][color_ctx];
       (*t)->skip_eob_node = 0;
+#endif  // CONFIG_NEW_TOKENSET
       ++(*t);
     }
   }
@@ -482,23 +488,18 @@ static void tokenize_b(int plane, int block, int blk_row, int blk_col,
       cpi->common.fc->coef_probs[txsize_sqr_map[tx_size]][type][ref];
 #endif  // CONFIG_SUBFRAME_PROB_UPDATE
 #endif  // !CONFIG_NEW_TOKENSET
-#if CONFIG_EC_ADAPT
-  FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
-#elif CONFIG_EC_MULTISYMBOL
-  FRAME_CONTEXT *ec_ctx = cpi->common.fc;
-#endif
 #if CONFIG_NEW_TOKENSET
-  aom_cdf_prob(
-      *const coef_head_cdfs)[COEFF_CONTEXTS][CDF_SIZE(ENTROPY_TOKENS)] =
-      ec_ctx->coef_head_cdfs[txsize_sqr_map[tx_size]][type][ref];
-  aom_cdf_prob(
-      *const coef_tail_cdfs)[COEFF_CONTEXTS][CDF_SIZE(ENTROPY_TOKENS)] =
-      ec_ctx->coef_tail_cdfs[txsize_sqr_map[tx_size]][type][ref];
   unsigned int(*const blockz_count)[2] =
       td->counts->blockz_count[txsize_sqr_map[tx_size]][type][ref];
+  const TX_SIZE tx_size_sqr = txsize_sqr_map[tx_size];
   int eob_val;
   int first_val = 1;
 #else
+#if CONFIG_EC_ADAPT
+  FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
+#elif CONFIG_EC_MULTISYMBOL
+  FRAME_CONTEXT *ec_ctx = cpi->common.fc;
+#endif
 #if CONFIG_EC_MULTISYMBOL
   aom_cdf_prob(*const coef_cdfs)[COEFF_CONTEXTS][CDF_SIZE(ENTROPY_TOKENS)] =
       ec_ctx->coef_cdfs[txsize_sqr_map[tx_size]][type][ref];
@@ -520,8 +521,8 @@ static void tokenize_b(int plane, int block, int blk_row, int blk_col,
 
 #if CONFIG_NEW_TOKENSET
   if (eob == 0)
-    add_token(&t, &coef_tail_cdfs[band[c]][pt], &coef_head_cdfs[band[c]][pt], 1,
-              1, 0, BLOCK_Z_TOKEN);
+    add_token(&t, av1_get_token_ctx(tx_size_sqr, type, ref, band[c], pt), 1, 1,
+              0, BLOCK_Z_TOKEN);
 
   ++blockz_count[pt][eob != 0];
 
@@ -530,8 +531,8 @@ static void tokenize_b(int plane, int block, int blk_row, int blk_col,
     first_val = (c == 0);
 
     if (!v) {
-      add_token(&t, &coef_tail_cdfs[band[c]][pt], &coef_head_cdfs[band[c]][pt],
-                0, first_val, 0, ZERO_TOKEN);
+      add_token(&t, av1_get_token_ctx(tx_size_sqr, type, ref, band[c], pt), 0,
+                first_val, 0, ZERO_TOKEN);
       ++counts[band[c]][pt][ZERO_TOKEN];
       token_cache[scan[c]] = 0;
     } else {
@@ -540,7 +541,7 @@ static void tokenize_b(int plane, int block, int blk_row, int blk_col,
 
       av1_get_token_extra(v, &token, &extra);
 
-      add_token(&t, &coef_tail_cdfs[band[c]][pt], &coef_head_cdfs[band[c]][pt],
+      add_token(&t, av1_get_token_ctx(tx_size_sqr, type, ref, band[c], pt),
                 eob_val, first_val, extra, (uint8_t)token);
 
       if (eob_val != LAST_EOB) {
@@ -34,13 +34,53 @@ typedef struct {
   EXTRABIT extra;
 } TOKENVALUE;
 
-typedef struct {
 #if CONFIG_NEW_TOKENSET
-  aom_cdf_prob (*tail_cdf)[CDF_SIZE(ENTROPY_TOKENS)];
-  aom_cdf_prob (*head_cdf)[CDF_SIZE(ENTROPY_TOKENS)];
-  int eob_val;
-  int first_val;
-#elif CONFIG_EC_MULTISYMBOL
+// A token takes 4 bytes. Its cdfs are given by their indices in the tables of
+// the frame context, and category tokens store their extra bits, less the
+// sign, in the entry that follows them.
+typedef struct {
+  // For coefficient tokens, the square transform size, plane type, reference
+  // type, band and coefficient context, packed as by av1_get_token_ctx().
+  // For palette tokens, the color index context.
+  uint16_t ctx;
+  uint8_t token;
+  // The eob_val (bits 0-1), first_val (bit 2) and sign (bit 3) of the token.
+  uint8_t flags;
+} TOKENEXTRA;
+
+#define TOKEN_EOB_VAL_MASK 0x03
+#define TOKEN_FIRST_VAL_SHIFT 2
+#define TOKEN_SIGN_SHIFT 3
+
+#if COEF_BANDS > 8 || COEFF_CONTEXTS > 8
+#error "Need to change av1_get_token_ctx() for the new number of contexts"
+#endif
+
+static INLINE uint16_t av1_get_token_ctx(TX_SIZE tx_size_sqr, PLANE_TYPE type,
+                                         int ref, int band, int pt) {
+  return (uint16_t)((tx_size_sqr << 8) | (type << 7) | (ref << 6) |
+                    (band << 3) | pt);
+}
+
+static INLINE int av1_token_has_extra_bits(int token) {
+  return token >= CATEGORY1_TOKEN && token <= CATEGORY6_TOKEN;
+}
+
+static INLINE void av1_set_token_extra_bits(TOKENEXTRA *t, int bits) {
+  t->ctx = (uint16_t)bits;
+  t->token = (uint8_t)(bits >> 16);
+  t->flags = (uint8_t)(bits >> 24);
+}
+
+static INLINE int av1_get_token_extra_bits(const TOKENEXTRA *t) {
+  return t->ctx | (t->token << 16) | (t->flags << 24);
+}
+
+// The number of token buffer entries a coefficient may take.
+#define TOKEN_ENTRIES_PER_COEFF 2
+#else
+typedef struct {
+#if CONFIG_EC_MULTISYMBOL
   aom_cdf_prob (*token_cdf)[CDF_SIZE(ENTROPY_TOKENS)];
 #endif
   const aom_prob *context_tree;
@@ -49,6 +89,9 @@ typedef struct {
   uint8_t skip_eob_node;
 } TOKENEXTRA;
 
+#define TOKEN_ENTRIES_PER_COEFF 1
+#endif  // CONFIG_NEW_TOKENSET
+
 extern const aom_tree_index av1_coef_tree[];
 extern const aom_tree_index av1_coef_con_tree[];
 #if !CONFIG_EC_MULTISYMBOL
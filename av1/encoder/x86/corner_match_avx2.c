@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <math.h>
+
+#include <immintrin.h>  // AVX2
+
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "av1/encoder/corner_match.h"
+
+DECLARE_ALIGNED(32, static const uint8_t, byte_mask[32]) = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0
+};
+#if MATCH_SZ != 13
+#error "Need to change byte_mask in corner_match_avx2.c if MATCH_SZ != 13"
+#endif
+
+// Loads two rows of a window, the second one only if it is inside the window.
+static INLINE __m256i load_rows(const unsigned char *p, int stride,
+                                int second_row, __m256i mask) {
+  const __m128i lo = _mm_loadu_si128((const __m128i *)p);
+  const __m128i hi = second_row
+                         ? _mm_loadu_si128((const __m128i *)(p + stride))
+                         : _mm_setzero_si128();
+  return _mm256_and_si256(
+      _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), mask);
+}
+
+static INLINE int hsum_epi32(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+  s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+  return _mm_cvtsi128_si32(s);
+}
+
+/* Compute corr(im1, im2) * MATCH_SZ * stddev(im1), where the
+   correlation/standard deviation are taken over MATCH_SZ by MATCH_SZ windows
+   of each image, centered at (x1, y1) and (x2, y2) respectively.
+   Each row of a window is read as 16 bytes, so the rows must be readable up
+   to 3 bytes past the right edge of the windows.
+*/
+double compute_cross_correlation_avx2(unsigned char *im1, int stride1, int x1,
+                                      int y1, unsigned char *im2, int stride2,
+                                      int x2, int y2) {
+  const __m256i mask = _mm256_load_si256((const __m256i *)byte_mask);
+  const __m256i zero = _mm256_setzero_si256();
+  // The sums of the pixels are in lanes 0, 2, 4 and 6, the others in all 8.
+  __m256i sum1_vec = zero;
+  __m256i sum2_vec = zero;
+  __m256i sumsq2_vec = zero;
+  __m256i cross_vec = zero;
+  int sum1, sum2, sumsq2, cross, var2, cov;
+  int i;
+
+  im1 += (y1 - MATCH_SZ_BY2) * stride1 + (x1 - MATCH_SZ_BY2);
+  im2 += (y2 - MATCH_SZ_BY2) * stride2 + (x2 - MATCH_SZ_BY2);
+
+  // Two rows at a time, one in each 128-bit lane.
+  for (i = 0; i < MATCH_SZ; i += 2) {
+    const __m256i v1 = load_rows(im1, stride1, i + 1 < MATCH_SZ, mask);
+    const __m256i v2 = load_rows(im2, stride2, i + 1 < MATCH_SZ, mask);
+    const __m256i v1_l = _mm256_unpacklo_epi8(v1, zero);
+    const __m256i v1_r = _mm256_unpackhi_epi8(v1, zero);
+    const __m256i v2_l = _mm256_unpacklo_epi8(v2, zero);
+    const __m256i v2_r = _mm256_unpackhi_epi8(v2, zero);
+
+    sum1_vec = _mm256_add_epi32(sum1_vec, _mm256_sad_epu8(v1, zero));
+    sum2_vec = _mm256_add_epi32(sum2_vec, _mm256_sad_epu8(v2, zero));
+    sumsq2_vec = _mm256_add_epi32(
+        sumsq2_vec, _mm256_add_epi32(_mm256_madd_epi16(v2_l, v2_l),
+                                     _mm256_madd_epi16(v2_r, v2_r)));
+    cross_vec = _mm256_add_epi32(
+        cross_vec, _mm256_add_epi32(_mm256_madd_epi16(v1_l, v2_l),
+                                    _mm256_madd_epi16(v1_r, v2_r)));
+
+    im1 += 2 * stride1;
+    im2 += 2 * stride2;
+  }
+
+  sum1 = hsum_epi32(sum1_vec);
+  sum2 = hsum_epi32(sum2_vec);
+  sumsq2 = hsum_epi32(sumsq2_vec);
+  cross = hsum_epi32(cross_vec);
+
+  var2 = sumsq2 * MATCH_SZ_SQ - sum2 * sum2;
+  cov = cross * MATCH_SZ_SQ - sum1 * sum2;
+  return cov / sqrt((double)var2);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <math.h>
+
+#include <smmintrin.h>
+
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "av1/encoder/corner_match.h"
+
+DECLARE_ALIGNED(16, static const uint8_t, byte_mask[16]) = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0
+};
+#if MATCH_SZ != 13
+#error "Need to change byte_mask in corner_match_sse4.c if MATCH_SZ != 13"
+#endif
+
+static INLINE int hsum_epi32(__m128i v) {
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+  v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+  return _mm_cvtsi128_si32(v);
+}
+
+/* Compute corr(im1, im2) * MATCH_SZ * stddev(im1), where the
+   correlation/standard deviation are taken over MATCH_SZ by MATCH_SZ windows
+   of each image, centered at (x1, y1) and (x2, y2) respectively.
+   Each row of a window is read as 16 bytes, so the rows must be readable up
+   to 3 bytes past the right edge of the windows.
+*/
+double compute_cross_correlation_sse4_1(unsigned char *im1, int stride1,
+                                        int x1, int y1, unsigned char *im2,
+                                        int stride2, int x2, int y2) {
+  const __m128i mask = _mm_load_si128((const __m128i *)byte_mask);
+  const __m128i zero = _mm_setzero_si128();
+  // The sums of the pixels are in lanes 0 and 2, the others in all 4 lanes.
+  __m128i sum1_vec = zero;
+  __m128i sum2_vec = zero;
+  __m128i sumsq2_vec = zero;
+  __m128i cross_vec = zero;
+  int sum1, sum2, sumsq2, cross, var2, cov;
+  int i;
+
+  im1 += (y1 - MATCH_SZ_BY2) * stride1 + (x1 - MATCH_SZ_BY2);
+  im2 += (y2 - MATCH_SZ_BY2) * stride2 + (x2 - MATCH_SZ_BY2);
+
+  for (i = 0; i < MATCH_SZ; ++i) {
+    const __m128i v1 =
+        _mm_and_si128(_mm_loadu_si128((const __m128i *)im1), mask);
+    const __m128i v2 =
+        _mm_and_si128(_mm_loadu_si128((const __m128i *)im2), mask);
+    const __m128i v1_l = _mm_cvtepu8_epi16(v1);
+    const __m128i v1_r = _mm_unpackhi_epi8(v1, zero);
+    const __m128i v2_l = _mm_cvtepu8_epi16(v2);
+    const __m128i v2_r = _mm_unpackhi_epi8(v2, zero);
+
+    sum1_vec = _mm_add_epi32(sum1_vec, _mm_sad_epu8(v1, zero));
+    sum2_vec = _mm_add_epi32(sum2_vec, _mm_sad_epu8(v2, zero));
+    sumsq2_vec = _mm_add_epi32(
+        sumsq2_vec,
+        _mm_add_epi32(_mm_madd_epi16(v2_l, v2_l), _mm_madd_epi16(v2_r, v2_r)));
+    cross_vec = _mm_add_epi32(
+        cross_vec,
+        _mm_add_epi32(_mm_madd_epi16(v1_l, v2_l), _mm_madd_epi16(v1_r, v2_r)));
+
+    im1 += stride1;
+    im2 += stride2;
+  }
+
+  sum1 = hsum_epi32(sum1_vec);
+  sum2 = hsum_epi32(sum2_vec);
+  sumsq2 = hsum_epi32(sumsq2_vec);
+  cross = hsum_epi32(cross_vec);
+
+  var2 = sumsq2 * MATCH_SZ_SQ - sum2 * sum2;
+  cov = cross * MATCH_SZ_SQ - sum1 * sum2;
+  return cov / sqrt((double)var2);
+}
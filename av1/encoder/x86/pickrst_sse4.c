@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>
+#include <string.h>
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_dsp/aom_dsp_common.h"
+#include "av1/common/restoration.h"
+
+// The sums are computed one row at a time, as dot products between the rows
+// of the window shifted by each offset. Blocks are split in columns of at
+// most WIENER_SUMS_COLS pixels, so that the products of two 12-bit pixels
+// can be accumulated in 32 bits along a row.
+#define WIENER_SUMS_COLS 256
+#define WIENER_SUMS_STRIDE (WIENER_SUMS_COLS + WIENER_WIN - 1)
+
+static INLINE int64_t hsum_epi32(__m128i sum) {
+  int64_t sum64[2];
+  _mm_storeu_si128((__m128i *)sum64,
+                   _mm_add_epi64(_mm_cvtepi32_epi64(sum),
+                                 _mm_cvtepi32_epi64(_mm_srli_si128(sum, 8))));
+  return sum64[0] + sum64[1];
+}
+
+static INLINE int64_t sum_16(const int16_t *a, int n) {
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i sum = _mm_setzero_si128();
+  int64_t tail = 0;
+  int j;
+  for (j = 0; j + 8 <= n; j += 8)
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + j)), one));
+  for (; j < n; ++j) tail += a[j];
+  return hsum_epi32(sum) + tail;
+}
+
+static INLINE int64_t dot_16(const int16_t *a, const int16_t *b, int n) {
+  __m128i sum = _mm_setzero_si128();
+  int64_t tail = 0;
+  int j;
+  for (j = 0; j + 8 <= n; j += 8)
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + j)),
+                            _mm_loadu_si128((const __m128i *)(b + j))));
+  for (; j < n; ++j) tail += a[j] * b[j];
+  return hsum_epi32(sum) + tail;
+}
+
+// Accumulates the sums of one row of n <= WIENER_SUMS_COLS pixels, given
+// the WIENER_WIN rows of dgd around it starting WIENER_HALFWIN pixels to the
+// left, and the row of src.
+static void accumulate_row(const int16_t *const *rows, const int16_t *x, int n,
+                           int64_t *sum_x, int64_t *sum_y, int64_t *sum_xy,
+                           int64_t *sum_yy) {
+  const int16_t *y[WIENER_WIN2];
+  int k, l;
+  // Same indexing as the C version: columns major, then rows.
+  for (k = 0; k < WIENER_WIN; ++k)
+    for (l = 0; l < WIENER_WIN; ++l) y[k * WIENER_WIN + l] = rows[l] + k;
+
+  *sum_x += sum_16(x, n);
+  for (k = 0; k < WIENER_WIN2; ++k) {
+    sum_y[k] += sum_16(y[k], n);
+    sum_xy[k] += dot_16(y[k], x, n);
+    for (l = k; l < WIENER_WIN2; ++l)
+      sum_yy[k * WIENER_WIN2 + l] += dot_16(y[k], y[l], n);
+  }
+}
+
+static void clear_sums(int64_t *sum_x, int64_t *sum_y, int64_t *sum_xy,
+                       int64_t *sum_yy) {
+  *sum_x = 0;
+  memset(sum_y, 0, sizeof(*sum_y) * WIENER_WIN2);
+  memset(sum_xy, 0, sizeof(*sum_xy) * WIENER_WIN2);
+  memset(sum_yy, 0, sizeof(*sum_yy) * WIENER_WIN2 * WIENER_WIN2);
+}
+
+static INLINE void convert_row(const uint8_t *src, int n, int16_t *dst) {
+  int j;
+  for (j = 0; j + 8 <= n; j += 8)
+    _mm_storeu_si128(
+        (__m128i *)(dst + j),
+        _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(src + j))));
+  for (; j < n; ++j) dst[j] = src[j];
+}
+
+void av1_compute_wiener_sums_sse4_1(const uint8_t *dgd, const uint8_t *src,
+                                    int width, int height, int dgd_stride,
+                                    int src_stride, int64_t *sum_x,
+                                    int64_t *sum_y, int64_t *sum_xy,
+                                    int64_t *sum_yy) {
+  // The dgd rows around the current one, in a circular buffer, and the src
+  // row, converted to 16 bits.
+  DECLARE_ALIGNED(16, int16_t, buf[WIENER_WIN + 1][WIENER_SUMS_STRIDE]);
+  const int16_t *rows[WIENER_WIN];
+  int16_t *const x = buf[WIENER_WIN];
+  int i, j, k;
+
+  clear_sums(sum_x, sum_y, sum_xy, sum_yy);
+  for (j = 0; j < width; j += WIENER_SUMS_COLS) {
+    const int n = AOMMIN(WIENER_SUMS_COLS, width - j);
+    const uint8_t *const d = dgd + j - WIENER_HALFWIN;
+    for (k = 0; k < WIENER_WIN - 1; ++k)
+      convert_row(d + (k - WIENER_HALFWIN) * dgd_stride, n + WIENER_WIN - 1,
+                  buf[k]);
+    for (i = 0; i < height; ++i) {
+      convert_row(d + (i + WIENER_HALFWIN) * dgd_stride, n + WIENER_WIN - 1,
+                  buf[(i + WIENER_WIN - 1) % WIENER_WIN]);
+      convert_row(src + i * src_stride + j, n, x);
+      for (k = 0; k < WIENER_WIN; ++k) rows[k] = buf[(i + k) % WIENER_WIN];
+      accumulate_row(rows, x, n, sum_x, sum_y, sum_xy, sum_yy);
+    }
+  }
+}
+
+#if CONFIG_AOM_HIGHBITDEPTH
+void av1_compute_wiener_sums_highbd_sse4_1(const uint16_t *dgd,
+                                           const uint16_t *src, int width,
+                                           int height, int dgd_stride,
+                                           int src_stride, int64_t *sum_x,
+                                           int64_t *sum_y, int64_t *sum_xy,
+                                           int64_t *sum_yy) {
+  // Pixels of up to 12 bits are used directly as signed 16-bit values.
+  const int16_t *rows[WIENER_WIN];
+  int i, j, k;
+
+  clear_sums(sum_x, sum_y, sum_xy, sum_yy);
+  for (j = 0; j < width; j += WIENER_SUMS_COLS) {
+    const int n = AOMMIN(WIENER_SUMS_COLS, width - j);
+    for (i = 0; i < height; ++i) {
+      for (k = 0; k < WIENER_WIN; ++k)
+        rows[k] = (const int16_t *)(dgd +
+                                    (i + k - WIENER_HALFWIN) * dgd_stride + j -
+                                    WIENER_HALFWIN);
+      accumulate_row(rows, (const int16_t *)(src + i * src_stride + j), n,
+                     sum_x, sum_y, sum_xy, sum_yy);
+    }
+  }
+}
+#endif  // CONFIG_AOM_HIGHBITDEPTH
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "./av1_rtcd.h"
+#include "aom/aom_integer.h"
+#include "aom_ports/mem.h"
+
+#define TF_MAX_SIZE 16
+// The squared differences are stored in rows with a border of zeros, so that
+// the sums over the 3x3 neighbourhood of the pixels need no special case at
+// the edges of the block.
+#define TF_BORDER 8
+#define TF_STRIDE (TF_MAX_SIZE + 2 * TF_BORDER)
+
+static INLINE __m256i load_block_row(const uint8_t *p, unsigned int width) {
+  const __m128i a = width == 16 ? _mm_loadu_si128((const __m128i *)p)
+                                : _mm_loadl_epi64((const __m128i *)p);
+  return _mm256_cvtepu8_epi16(a);
+}
+
+// Sums of the squared differences at columns -1, 0 and 1 of 8 pixels.
+static INLINE __m256i sum_row_3(const uint16_t *sq) {
+  const __m256i l =
+      _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(sq - 1)));
+  const __m256i c =
+      _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)sq));
+  const __m256i r =
+      _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(sq + 1)));
+  return _mm256_add_epi32(_mm256_add_epi32(l, c), r);
+}
+
+void av1_temporal_filter_apply_avx2(uint8_t *frame1, unsigned int stride,
+                                    uint8_t *frame2, unsigned int block_width,
+                                    unsigned int block_height, int strength,
+                                    int filter_weight,
+                                    unsigned int *accumulator,
+                                    uint16_t *count) {
+  DECLARE_ALIGNED(32, uint16_t, sq[(TF_MAX_SIZE + 2) * TF_STRIDE]);
+  DECLARE_ALIGNED(32, float, col_count[TF_MAX_SIZE]);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i rounding =
+      _mm256_set1_epi32(strength > 0 ? 1 << (strength - 1) : 0);
+  const __m128i shift = _mm_cvtsi32_si128(strength);
+  const __m256i sixteen = _mm256_set1_epi32(16);
+  const __m256i weight = _mm256_set1_epi32(filter_weight);
+  unsigned int i, j;
+
+  if ((block_width != 8 && block_width != 16) || block_height == 0 ||
+      block_height > TF_MAX_SIZE) {
+    av1_temporal_filter_apply_c(frame1, stride, frame2, block_width,
+                                block_height, strength, filter_weight,
+                                accumulator, count);
+    return;
+  }
+
+  // Squared differences, with a row of zeros above and below the block.
+  for (i = 0; i < block_height + 2; ++i) {
+    uint16_t *const row = sq + i * TF_STRIDE + TF_BORDER;
+    __m256i d = zero;
+    if (i > 0 && i <= block_height) {
+      d = _mm256_sub_epi16(
+          load_block_row(frame1 + (i - 1) * stride, block_width),
+          load_block_row(frame2 + (i - 1) * block_width, block_width));
+      // |d| <= 255, so its square fits in 16 bits.
+      d = _mm256_mullo_epi16(d, d);
+    }
+    _mm256_storeu_si256((__m256i *)row, d);
+    row[-1] = 0;
+    row[TF_MAX_SIZE] = 0;
+  }
+
+  // Number of pixels of the neighbourhood inside the block, horizontally.
+  for (j = 0; j < block_width; ++j)
+    col_count[j] = (float)(1 + (j > 0) + (j < block_width - 1));
+
+  for (j = 0; j < block_width; j += 8) {
+    const uint16_t *row = sq + TF_BORDER + j;
+    const __m256 cols = _mm256_load_ps(col_count + j);
+    __m256i above = sum_row_3(row);
+    __m256i cur = sum_row_3(row + TF_STRIDE);
+
+    for (i = 0; i < block_height; ++i) {
+      const unsigned int k = i * block_width + j;
+      const __m256i below = sum_row_3(row + (i + 2) * TF_STRIDE);
+      const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(above, cur), below);
+      const float rows = (float)(1 + (i > 0) + (i < block_height - 1));
+      // The sums are below 2^21, so they are exact as floats, and the
+      // truncated quotient of the division matches the integer division.
+      const __m256 num =
+          _mm256_cvtepi32_ps(_mm256_add_epi32(sum, _mm256_slli_epi32(sum, 1)));
+      const __m256 den = _mm256_mul_ps(cols, _mm256_set1_ps(rows));
+      __m256i modifier = _mm256_cvttps_epi32(_mm256_div_ps(num, den));
+      const __m256i pixel = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(frame2 + k)));
+      __m256i acc = _mm256_loadu_si256((const __m256i *)(accumulator + k));
+      __m128i cnt = _mm_loadu_si128((const __m128i *)(count + k));
+
+      modifier = _mm256_srl_epi32(_mm256_add_epi32(modifier, rounding), shift);
+      modifier = _mm256_min_epu32(modifier, sixteen);
+      modifier =
+          _mm256_mullo_epi32(_mm256_sub_epi32(sixteen, modifier), weight);
+
+      // Both factors fit in 16 bits, with zero upper halves.
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(modifier, pixel));
+      cnt = _mm_add_epi16(
+          cnt, _mm_packus_epi32(_mm256_castsi256_si128(modifier),
+                                _mm256_extracti128_si256(modifier, 1)));
+      _mm256_storeu_si256((__m256i *)(accumulator + k), acc);
+      _mm_storeu_si128((__m128i *)(count + k), cnt);
+
+      above = cur;
+      cur = below;
+    }
+  }
+}
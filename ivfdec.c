@@ -100,3 +100,27 @@ int ivf_read_frame(FILE *infile, uint8_t **buffer, size_t *bytes_read,
 
   return 1;
 }
+
+int ivf_read_mapped_frame(struct AvxInputContext *input_ctx,
+                          const uint8_t **buffer, size_t *bytes_read) {
+  const size_t left = input_ctx->map_size - input_ctx->map_pos;
+  const uint8_t *const raw_header = input_ctx->map + input_ctx->map_pos;
+  size_t frame_size;
+
+  if (left < IVF_FRAME_HDR_SZ) return 1;
+
+  frame_size = mem_get_le32(raw_header);
+  if (frame_size > 256 * 1024 * 1024) {
+    warn("Read invalid frame size (%u)\n", (unsigned int)frame_size);
+    frame_size = 0;
+  }
+  if (frame_size > left - IVF_FRAME_HDR_SZ) {
+    warn("Failed to read full frame\n");
+    return 1;
+  }
+
+  *buffer = raw_header + IVF_FRAME_HDR_SZ;
+  *bytes_read = frame_size;
+  input_ctx->map_pos += IVF_FRAME_HDR_SZ + frame_size;
+  return 0;
+}
@@ -22,6 +22,11 @@ int file_is_ivf(struct AvxInputContext *input);
 int ivf_read_frame(FILE *infile, uint8_t **buffer, size_t *bytes_read,
                    size_t *buffer_size);
 
+// Like ivf_read_frame(), but reads the frame at input_ctx->map_pos of the
+// mapped input file, and points *buffer at it instead of copying it.
+int ivf_read_mapped_frame(struct AvxInputContext *input_ctx,
+                          const uint8_t **buffer, size_t *bytes_read);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
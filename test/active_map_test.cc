@@ -10,12 +10,14 @@
 */
 
 #include <climits>
+#include <cstring>
 #include <vector>
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 #include "test/codec_factory.h"
 #include "test/encode_test_driver.h"
 #include "test/i420_video_source.h"
 #include "test/util.h"
+#include "test/video_source.h"
 
 namespace {
 
@@ -92,6 +94,174 @@ class ActiveMapTestLarge : public ActiveMapTest {};
 
 TEST_P(ActiveMapTestLarge, Test) { DoTest(); }
 
+// The luma plane is split in two halves at a macroblock boundary. The left
+// half changes every frame. The right half changes only at kCheckFrame.
+const unsigned int kMapFrame = 2;
+const unsigned int kResizeFrame = 4;
+const unsigned int kRestoreFrame = 6;
+const unsigned int kCheckFrame = 10;
+const int kRightBefore = 160;
+const int kRightAfter = 220;
+
+int LeftValue(unsigned int frame) { return 40 + 10 * (frame % 8); }
+
+int RightValue(unsigned int frame) {
+  return frame < kCheckFrame ? kRightBefore : kRightAfter;
+}
+
+int SplitCol(unsigned int width) { return (width / 2) & ~15; }
+
+enum LookaheadCase {
+  kKeepMap,
+  kDisableMap,
+  kResizeUp,
+  kResizeDown,
+  kResizeDownUp
+};
+
+class SplitVideoSource : public ::libaom_test::DummyVideoSource {
+ public:
+  // The size changes at kResizeFrame, and back at kRestoreFrame if restore.
+  SplitVideoSource(unsigned int width, unsigned int height,
+                   unsigned int resized_width, unsigned int resized_height,
+                   bool restore)
+      : initial_width_(width), initial_height_(height),
+        resized_width_(resized_width), resized_height_(resized_height),
+        restore_(restore) {
+    SetSize(width, height);
+    limit_ = kCheckFrame + 1;
+  }
+
+  virtual void Begin() {
+    SetSize(initial_width_, initial_height_);
+    DummyVideoSource::Begin();
+  }
+
+ protected:
+  virtual void Next() {
+    ++frame_;
+    if (frame_ >= kRestoreFrame && restore_)
+      SetSize(initial_width_, initial_height_);
+    else if (frame_ >= kResizeFrame)
+      SetSize(resized_width_, resized_height_);
+    FillFrame();
+  }
+
+  virtual void FillFrame() {
+    const int split = SplitCol(img_->d_w);
+    unsigned int r;
+    for (r = 0; r < img_->d_h; ++r) {
+      uint8_t *const row = img_->planes[AOM_PLANE_Y] + r * img_->stride[0];
+      memset(row, LeftValue(frame_), split);
+      memset(row + split, RightValue(frame_), img_->d_w - split);
+    }
+    for (r = 0; r < (img_->d_h + 1) / 2; ++r) {
+      memset(img_->planes[AOM_PLANE_U] + r * img_->stride[1], 128,
+             (img_->d_w + 1) / 2);
+      memset(img_->planes[AOM_PLANE_V] + r * img_->stride[2], 128,
+             (img_->d_w + 1) / 2);
+    }
+  }
+
+  unsigned int initial_width_;
+  unsigned int initial_height_;
+  unsigned int resized_width_;
+  unsigned int resized_height_;
+  bool restore_;
+};
+
+// Marks the left half active from kMapFrame on, and forces a key frame at
+// kCheckFrame, which encodes the whole frame as the lookahead holds it. The
+// left half must be read every frame. The right half, unchanged as far as the
+// map tells, must not be read again while the map stays set. Once the map is
+// disabled, or after a size change, the whole frame must be read.
+class ActiveMapLookaheadTest
+    : public ::libaom_test::EncoderTest,
+      public ::libaom_test::CodecTestWithParam<int> {
+ protected:
+  static const int kWidth = 160;
+  static const int kHeight = 96;
+
+  ActiveMapLookaheadTest()
+      : EncoderTest(GET_PARAM(0)), lookahead_case_(GET_PARAM(1)),
+        checked_(false) {}
+  virtual ~ActiveMapLookaheadTest() {}
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(::libaom_test::kRealTime);
+  }
+
+  virtual void PreEncodeFrameHook(::libaom_test::VideoSource *video,
+                                  ::libaom_test::Encoder *encoder) {
+    frame_flags_ = video->frame() == kCheckFrame ? AOM_EFLAG_FORCE_KF : 0;
+    if (video->frame() == 1) {
+      encoder->Control(AOME_SET_CPUUSED, 8);
+    } else if (video->frame() == kMapFrame ||
+               (video->frame() == kCheckFrame &&
+                lookahead_case_ == kDisableMap)) {
+      const aom_image_t *const img = video->img();
+      aom_active_map_t map = aom_active_map_t();
+      std::vector<uint8_t> active_map;
+      map.cols = (img->d_w + 15) / 16;
+      map.rows = (img->d_h + 15) / 16;
+      for (unsigned int r = 0; r < map.rows; ++r) {
+        for (unsigned int c = 0; c < map.cols; ++c)
+          active_map.push_back(c * 16 < (unsigned int)SplitCol(img->d_w));
+      }
+      map.active_map = video->frame() == kMapFrame ? &active_map[0] : NULL;
+      encoder->Control(AOME_SET_ACTIVEMAP, &map);
+    }
+  }
+
+  virtual void DecompressedFrameHook(const aom_image_t &img,
+                                     aom_codec_pts_t pts) {
+    if (pts != kCheckFrame) return;
+    const int split = SplitCol(img.d_w);
+    const int right =
+        lookahead_case_ == kKeepMap ? kRightBefore : RightValue(kCheckFrame);
+    // Leave out the pixels the loop filters may blend across the split.
+    for (int r = 0; r < static_cast<int>(img.d_h); ++r) {
+      const uint8_t *const row = img.planes[AOM_PLANE_Y] + r * img.stride[0];
+      for (int c = 0; c < static_cast<int>(img.d_w); ++c) {
+        if (c >= split - 8 && c < split + 8) continue;
+        const int expected = c < split ? LeftValue(kCheckFrame) : right;
+        ASSERT_NEAR(expected, row[c], 8) << "row " << r << " col " << c;
+      }
+    }
+    checked_ = true;
+  }
+
+  void DoTest() {
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_resize_allowed = 0;
+    cfg_.rc_end_usage = AOM_VBR;
+    cfg_.rc_min_quantizer = 8;
+    cfg_.rc_max_quantizer = 8;
+    cfg_.kf_max_dist = 90000;
+    unsigned int width = kWidth, height = kHeight;
+    unsigned int resized_width = kWidth, resized_height = kHeight;
+    if (lookahead_case_ == kResizeUp) {
+      resized_width = 2 * kWidth;
+      resized_height = 2 * kHeight;
+    } else if (lookahead_case_ == kResizeDown ||
+               lookahead_case_ == kResizeDownUp) {
+      width = 2 * kWidth;
+      height = 2 * kHeight;
+    }
+    SplitVideoSource video(width, height, resized_width, resized_height,
+                           lookahead_case_ == kResizeDownUp);
+
+    ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+    ASSERT_TRUE(checked_);
+  }
+
+  int lookahead_case_;
+  bool checked_;
+};
+
+TEST_P(ActiveMapLookaheadTest, Test) { DoTest(); }
+
 AV1_INSTANTIATE_TEST_CASE(ActiveMapTestLarge,
                           ::testing::Values(::libaom_test::kRealTime),
                           ::testing::Range(0, 5));
@@ -100,4 +270,8 @@ AV1_INSTANTIATE_TEST_CASE(ActiveMapTest,
                           ::testing::Values(::libaom_test::kRealTime),
                           ::testing::Range(5, 9));
 
+AV1_INSTANTIATE_TEST_CASE(ActiveMapLookaheadTest,
+                          ::testing::Values(kKeepMap, kDisableMap, kResizeUp,
+                                            kResizeDown, kResizeDownUp));
+
 }  // namespace
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "av1/common/od_dering.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+
+namespace {
+
+typedef uint64_t (*compute_dering_dist_func)(uint16_t *dst, int dstride,
+                                             uint16_t *src, dering_list *dlist,
+                                             int dering_count, BLOCK_SIZE bsize,
+                                             int coeff_shift, int pli);
+
+typedef std::tr1::tuple<compute_dering_dist_func, compute_dering_dist_func>
+    dering_dist_param_t;
+
+class CDEFDistTest : public ::testing::TestWithParam<dering_dist_param_t> {
+ public:
+  virtual ~CDEFDistTest() {}
+  virtual void SetUp() {
+    dist = GET_PARAM(0);
+    ref_dist = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  compute_dering_dist_func dist;
+  compute_dering_dist_func ref_dist;
+};
+
+// Compares the distortion of random filtered superblocks against a random
+// source, for all the chroma subsamplings and bit depths.
+TEST_P(CDEFDistTest, TestSIMDNoMismatch) {
+  const int stride = MAX_SB_SIZE + 8;
+  const BLOCK_SIZE bsizes[] = { BLOCK_8X8, BLOCK_4X8, BLOCK_8X4, BLOCK_4X4 };
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint16_t, dst[MAX_SB_SIZE * stride]);
+  DECLARE_ALIGNED(16, uint16_t, src[MAX_SB_SQUARE]);
+  dering_list dlist[OD_DERING_NBLOCKS * OD_DERING_NBLOCKS];
+
+  for (int depth = 8; depth <= 12; depth += 2) {
+    const int coeff_shift = depth - 8;
+    for (int b = 0; b < 4; b++) {
+      for (int pli = 0; pli < 2; pli++) {
+        // Luma is only coded in 8x8 blocks.
+        if (pli == 0 && bsizes[b] != BLOCK_8X8) continue;
+        for (int count = 0; count < 64; count++) {
+          // Small amplitudes around a random level, as well as the full range.
+          const int bits = 1 + rnd(depth);
+          const int level = rnd((1 << depth) - (1 << bits) + 1);
+          for (int i = 0; i < MAX_SB_SIZE * stride; i++)
+            dst[i] = level + (rnd.Rand16() & ((1 << bits) - 1));
+          for (int i = 0; i < MAX_SB_SQUARE; i++)
+            src[i] = count & 1 ? dst[i] ^ (rnd.Rand16() & 3)
+                               : level + (rnd.Rand16() & ((1 << bits) - 1));
+          int dering_count = 0;
+          for (int by = 0; by < OD_DERING_NBLOCKS; by++)
+            for (int bx = 0; bx < OD_DERING_NBLOCKS; bx++)
+              if (rnd(4)) {
+                dlist[dering_count].by = by;
+                dlist[dering_count].bx = bx;
+                dering_count++;
+              }
+          const uint64_t ref_res =
+              ref_dist(dst, stride, src, dlist, dering_count, bsizes[b],
+                       coeff_shift, pli);
+          uint64_t res;
+          ASM_REGISTER_STATE_CHECK(res = dist(dst, stride, src, dlist,
+                                              dering_count, bsizes[b],
+                                              coeff_shift, pli));
+          ASSERT_EQ(ref_res, res) << "depth: " << depth << ", bsize: " << b
+                                  << ", pli: " << pli;
+        }
+      }
+    }
+  }
+}
+
+using std::tr1::make_tuple;
+
+// VS compiling for 32 bit targets does not support vector types in
+// structs as arguments, which makes the v256 type of the intrinsics
+// hard to support, so optimizations for this target are disabled.
+#if defined(_WIN64) || !defined(_MSC_VER) || defined(__clang__)
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, CDEFDistTest,
+                        ::testing::Values(make_tuple(&compute_dering_dist_sse2,
+                                                     &compute_dering_dist_c)));
+#endif
+
+#if HAVE_SSSE3
+INSTANTIATE_TEST_CASE_P(SSSE3, CDEFDistTest,
+                        ::testing::Values(make_tuple(&compute_dering_dist_ssse3,
+                                                     &compute_dering_dist_c)));
+#endif
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, CDEFDistTest,
+    ::testing::Values(make_tuple(&compute_dering_dist_sse4_1,
+                                 &compute_dering_dist_c)));
+#endif
+
+#if HAVE_NEON
+INSTANTIATE_TEST_CASE_P(NEON, CDEFDistTest,
+                        ::testing::Values(make_tuple(&compute_dering_dist_neon,
+                                                     &compute_dering_dist_c)));
+#endif
+#endif  // defined(_WIN64) || !defined(_MSC_VER)
+}  // namespace
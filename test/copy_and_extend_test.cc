@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstring>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "aom_dsp/aom_dsp_common.h"
+#include "aom_scale/yv12config.h"
+#include "av1/encoder/extend.h"
+#include "test/acm_random.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+
+namespace {
+
+// Subsampling in x and y, and whether the frames are high bit depth.
+typedef std::tr1::tuple<int, int, int> CopyAndExtendParam;
+
+class CopyAndExtendTest : public ::testing::TestWithParam<CopyAndExtendParam> {
+ public:
+  CopyAndExtendTest() : rnd_(ACMRandom::DeterministicSeed()) {}
+  virtual ~CopyAndExtendTest() {}
+
+  virtual void SetUp() {
+    ss_x_ = GET_PARAM(0);
+    ss_y_ = GET_PARAM(1);
+    highbd_ = GET_PARAM(2);
+    memset(&src_, 0, sizeof(src_));
+    memset(&full_, 0, sizeof(full_));
+    memset(&rect_, 0, sizeof(rect_));
+  }
+
+  virtual void TearDown() {
+    aom_free_frame_buffer(&src_);
+    aom_free_frame_buffer(&full_);
+    aom_free_frame_buffer(&rect_);
+  }
+
+ protected:
+  void Alloc(YV12_BUFFER_CONFIG *ybf, int width, int height, int border) {
+    ASSERT_EQ(0, aom_alloc_frame_buffer(ybf, width, height, ss_x_, ss_y_,
+#if CONFIG_AOM_HIGHBITDEPTH
+                                        highbd_,
+#endif
+                                        border, 0));
+  }
+
+  void SetPixel(uint8_t *buf, int stride, int x, int y, int value) {
+#if CONFIG_AOM_HIGHBITDEPTH
+    if (highbd_) {
+      CONVERT_TO_SHORTPTR(buf)[y * stride + x] = value;
+      return;
+    }
+#endif
+    buf[y * stride + x] = value;
+  }
+
+  // Sets the pixels of the 16x16 block (mb_col, mb_row) in all planes.
+  void FillBlock(int mb_row, int mb_col) {
+    const int uv_h = 16 >> ss_y_;
+    const int uv_w = 16 >> ss_x_;
+    for (int y = mb_row * 16; y < AOMMIN(mb_row * 16 + 16, src_.y_crop_height);
+         ++y) {
+      for (int x = mb_col * 16;
+           x < AOMMIN(mb_col * 16 + 16, src_.y_crop_width); ++x) {
+        SetPixel(src_.y_buffer, src_.y_stride, x, y, rnd_.Rand8());
+      }
+    }
+    for (int y = mb_row * uv_h; y < AOMMIN(mb_row * uv_h + uv_h,
+                                           src_.uv_crop_height);
+         ++y) {
+      for (int x = mb_col * uv_w;
+           x < AOMMIN(mb_col * uv_w + uv_w, src_.uv_crop_width); ++x) {
+        SetPixel(src_.u_buffer, src_.uv_stride, x, y, rnd_.Rand8());
+        SetPixel(src_.v_buffer, src_.uv_stride, x, y, rnd_.Rand8());
+      }
+    }
+  }
+
+  void CheckSameBuffers() {
+    ASSERT_EQ(full_.frame_size, rect_.frame_size);
+    ASSERT_EQ(0, memcmp(full_.buffer_alloc, rect_.buffer_alloc,
+                        full_.frame_size));
+  }
+
+  ACMRandom rnd_;
+  int ss_x_;
+  int ss_y_;
+  int highbd_;
+  YV12_BUFFER_CONFIG src_;
+  YV12_BUFFER_CONFIG full_;
+  YV12_BUFFER_CONFIG rect_;
+};
+
+// Copies frames whose blocks change at random, either in full or only the
+// rows of changed blocks, and checks that the copies, borders included, match.
+TEST_P(CopyAndExtendTest, RectsMatchFullCopy) {
+  const int kSizes[][2] = { { 64, 64 }, { 70, 37 }, { 33, 80 }, { 8, 8 } };
+
+  for (int s = 0; s < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++s) {
+    const int width = kSizes[s][0];
+    const int height = kSizes[s][1];
+    const int mb_rows = (height + 15) >> 4;
+    const int mb_cols = (width + 15) >> 4;
+    TearDown();
+    Alloc(&src_, width, height, 32);
+    Alloc(&full_, width, height, AOM_BORDER_IN_PIXELS);
+    Alloc(&rect_, width, height, AOM_BORDER_IN_PIXELS);
+
+    for (int frame = 0; frame < 8; ++frame) {
+      bool changed[8][8];
+      for (int r = 0; r < mb_rows; ++r) {
+        for (int c = 0; c < mb_cols; ++c) {
+          changed[r][c] = frame == 0 || rnd_(3) == 0;
+          if (changed[r][c]) FillBlock(r, c);
+        }
+      }
+
+      av1_copy_and_extend_frame(&src_, &full_);
+      for (int r = 0; r < mb_rows; ++r) {
+        for (int c = 0; c < mb_cols;) {
+          int end = c;
+          while (end < mb_cols && changed[r][end]) ++end;
+          if (end > c) {
+            av1_copy_and_extend_frame_with_rect(&src_, &rect_, r * 16, c * 16,
+                                                16, (end - c) * 16);
+            c = end;
+          } else {
+            ++c;
+          }
+        }
+      }
+      SCOPED_TRACE(testing::Message() << width << "x" << height << " frame "
+                                      << frame);
+      CheckSameBuffers();
+    }
+  }
+}
+
+using std::tr1::make_tuple;
+
+INSTANTIATE_TEST_CASE_P(C, CopyAndExtendTest,
+                        ::testing::Values(make_tuple(1, 1, 0),
+                                          make_tuple(1, 0, 0),
+                                          make_tuple(0, 0, 0)));
+
+#if CONFIG_AOM_HIGHBITDEPTH
+INSTANTIATE_TEST_CASE_P(C_HighBD, CopyAndExtendTest,
+                        ::testing::Values(make_tuple(1, 1, 1),
+                                          make_tuple(0, 0, 1)));
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+}  // namespace
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "av1/encoder/corner_match.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+
+namespace {
+
+typedef double (*ComputeCrossCorrFunc)(unsigned char *im1, int stride1, int x1,
+                                       int y1, unsigned char *im2, int stride2,
+                                       int x2, int y2);
+
+typedef std::tr1::tuple<ComputeCrossCorrFunc, ComputeCrossCorrFunc>
+    CornerMatchParam;
+
+class CornerMatchTest : public ::testing::TestWithParam<CornerMatchParam> {
+ public:
+  virtual ~CornerMatchTest() {}
+  virtual void SetUp() {
+    corr_ = GET_PARAM(0);
+    ref_corr_ = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  ComputeCrossCorrFunc corr_;
+  ComputeCrossCorrFunc ref_corr_;
+};
+
+// Correlates random windows of two random images, and checks that the
+// results match exactly.
+TEST_P(CornerMatchTest, TestSIMDNoMismatch) {
+  const int w = 64;
+  const int h = 48;
+  // The SIMD versions read past the right edge of the windows.
+  const int stride1 = w + 8;
+  const int stride2 = w + 16;
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint8_t, im1[h * stride1]);
+  DECLARE_ALIGNED(16, uint8_t, im2[h * stride2]);
+
+  for (int iter = 0; iter < 1024; iter++) {
+    // Small differences as well as the full range. The windows of the
+    // second image are never flat, as the correlation is then undefined.
+    const int mask = iter & 1 ? 255 : (2 << rnd(8)) - 1;
+    for (int i = 0; i < h * stride1; i++) im1[i] = rnd.Rand8();
+    for (int i = 0; i < h; i++)
+      for (int j = 0; j < stride2; j++) {
+        const int base = iter & 2 ? im1[i * stride1 + j % stride1] : 0;
+        im2[i * stride2 + j] = base ^ (rnd.Rand8() & mask);
+      }
+    const int x1 = MATCH_SZ_BY2 + rnd(w - 2 * MATCH_SZ_BY2);
+    const int y1 = MATCH_SZ_BY2 + rnd(h - 2 * MATCH_SZ_BY2);
+    const int x2 = MATCH_SZ_BY2 + rnd(w - 2 * MATCH_SZ_BY2);
+    const int y2 = MATCH_SZ_BY2 + rnd(h - 2 * MATCH_SZ_BY2);
+    const double ref_res =
+        ref_corr_(im1, stride1, x1, y1, im2, stride2, x2, y2);
+    double res;
+    ASM_REGISTER_STATE_CHECK(
+        res = corr_(im1, stride1, x1, y1, im2, stride2, x2, y2));
+    ASSERT_EQ(ref_res, res) << "windows at (" << x1 << ", " << y1 << ") and ("
+                            << x2 << ", " << y2 << ")";
+  }
+}
+
+using std::tr1::make_tuple;
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, CornerMatchTest,
+    ::testing::Values(make_tuple(&compute_cross_correlation_sse4_1,
+                                 &compute_cross_correlation_c)));
+#endif
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, CornerMatchTest,
+    ::testing::Values(make_tuple(&compute_cross_correlation_avx2,
+                                 &compute_cross_correlation_c)));
+#endif
+}  // namespace
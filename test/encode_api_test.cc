@@ -9,6 +9,8 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
 */
 
+#include <vector>
+
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "./aom_config.h"
@@ -60,4 +62,122 @@ TEST(EncodeAPI, InvalidParams) {
   }
 }
 
+#if CONFIG_AV1_ENCODER
+const int kLentWidth = 96;
+const int kLentHeight = 64;
+const int kLentFrames = 16;
+const unsigned int kLentLag = 10;
+
+// An I420 frame whose planes are surrounded by a border of the given width.
+struct LentFrame {
+  LentFrame(int frame, unsigned int border)
+      : buf((kLentWidth + 2 * border) * (kLentHeight + 2 * border) * 3 / 2,
+            255),
+        released(0) {
+    const int stride[3] = { static_cast<int>(kLentWidth + 2 * border),
+                            static_cast<int>(kLentWidth / 2 + border),
+                            static_cast<int>(kLentWidth / 2 + border) };
+    const int rows[3] = { static_cast<int>(kLentHeight + 2 * border),
+                          static_cast<int>(kLentHeight / 2 + border),
+                          static_cast<int>(kLentHeight / 2 + border) };
+    uint8_t *plane = &buf[0];
+
+    EXPECT_EQ(&img, aom_img_wrap(&img, AOM_IMG_FMT_I420, kLentWidth,
+                                 kLentHeight, 1, &buf[0]));
+    for (int p = 0; p < 3; ++p) {
+      const int b = p ? border / 2 : border;
+      img.stride[p] = stride[p];
+      img.planes[p] = plane + b * stride[p] + b;
+      // A pattern moving across the frame, in the visible area only.
+      for (int r = 0; r < (p ? kLentHeight / 2 : kLentHeight); ++r) {
+        for (int c = 0; c < (p ? kLentWidth / 2 : kLentWidth); ++c) {
+          img.planes[p][r * stride[p] + c] =
+              static_cast<uint8_t>(((c - 2 * frame) ^ (r - frame + p)) * 3);
+        }
+      }
+      plane += stride[p] * rows[p];
+    }
+  }
+
+  std::vector<uint8_t> buf;
+  aom_image_t img;
+  int released;
+};
+
+void ReleaseLentFrame(void *cb_priv, aom_image_t *img) {
+  std::vector<LentFrame *> *frames =
+      static_cast<std::vector<LentFrame *> *>(cb_priv);
+  for (size_t i = 0; i < frames->size(); ++i)
+    if (&(*frames)[i]->img == img) ++(*frames)[i]->released;
+}
+
+// Encodes the frames, lent with the given border if it is not 0, and
+// returns the bitstream.
+std::vector<uint8_t> EncodeLentFrames(unsigned int border) {
+  std::vector<LentFrame *> frames;
+  std::vector<uint8_t> stream;
+  aom_codec_ctx_t enc;
+  aom_codec_enc_cfg_t cfg;
+
+  EXPECT_EQ(AOM_CODEC_OK,
+            aom_codec_enc_config_default(&aom_codec_av1_cx_algo, &cfg, 0));
+  cfg.g_w = kLentWidth;
+  cfg.g_h = kLentHeight;
+  cfg.g_lag_in_frames = kLentLag;
+  EXPECT_EQ(AOM_CODEC_OK,
+            aom_codec_enc_init(&enc, &aom_codec_av1_cx_algo, &cfg, 0));
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 8));
+  EXPECT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&enc, AOME_SET_ENABLEAUTOALTREF, 1));
+  if (border) {
+    aom_zero_copy_input_t zero_copy = { ReleaseLentFrame, &frames, border };
+    EXPECT_EQ(AOM_CODEC_OK,
+              aom_codec_control(&enc, AV1E_SET_ZERO_COPY_INPUT, &zero_copy));
+  }
+
+  for (int i = 0; i <= kLentFrames; ++i) {
+    const aom_codec_cx_pkt_t *pkt;
+    aom_codec_iter_t iter = NULL;
+    if (i < kLentFrames) {
+      frames.push_back(new LentFrame(i, border));
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_encode(&enc, &frames.back()->img, i, 1, 0, 0));
+    } else {
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, NULL, i, 1, 0, 0));
+    }
+    while ((pkt = aom_codec_get_cx_data(&enc, &iter)) != NULL) {
+      if (pkt->kind != AOM_CODEC_CX_FRAME_PKT) continue;
+      const uint8_t *data = static_cast<const uint8_t *>(pkt->data.frame.buf);
+      stream.insert(stream.end(), data, data + pkt->data.frame.sz);
+    }
+
+    // The encoder holds a bounded number of frames.
+    int held = 0;
+    for (size_t j = 0; j < frames.size(); ++j) held += !frames[j]->released;
+    if (border) {
+      EXPECT_LE(held, static_cast<int>(kLentLag + 2));
+    }
+  }
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+
+  // Every lent frame is returned, once.
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (border) {
+      EXPECT_EQ(1, frames[i]->released) << "frame " << i;
+    }
+    delete frames[i];
+  }
+  return stream;
+}
+
+// Lending the input frames does not change the bitstream, whether the frames
+// are read in place or copied because their border is too small.
+TEST(EncodeAPI, ZeroCopyInput) {
+  const std::vector<uint8_t> copied = EncodeLentFrames(0);
+  EXPECT_FALSE(copied.empty());
+  EXPECT_TRUE(copied == EncodeLentFrames(AOM_ENC_MIN_INPUT_BORDER));
+  EXPECT_TRUE(copied == EncodeLentFrames(AOM_ENC_MIN_INPUT_BORDER / 2));
+}
+#endif  // CONFIG_AV1_ENCODER
+
 }  // namespace
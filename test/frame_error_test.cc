@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+
+namespace {
+
+typedef int64_t (*FrameErrorFunc)(const uint8_t *const ref, int stride,
+                                  const uint8_t *const dst, int p_width,
+                                  int p_height, int p_stride);
+
+typedef std::tr1::tuple<FrameErrorFunc, FrameErrorFunc> FrameErrorParam;
+
+class FrameErrorTest : public ::testing::TestWithParam<FrameErrorParam> {
+ public:
+  virtual ~FrameErrorTest() {}
+  virtual void SetUp() {
+    error_ = GET_PARAM(0);
+    ref_error_ = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  FrameErrorFunc error_;
+  FrameErrorFunc ref_error_;
+};
+
+// Measures random regions of all widths, including the ones that are not
+// multiples of the vector width, and checks that the errors match.
+TEST_P(FrameErrorTest, TestSIMDNoMismatch) {
+  const int stride = 96;
+  const int p_stride = 88;
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint8_t, ref[64 * stride]);
+  DECLARE_ALIGNED(16, uint8_t, dst[64 * p_stride]);
+
+  for (int iter = 0; iter < 1024; iter++) {
+    const int width = 1 + rnd(80);
+    const int height = 1 + rnd(64);
+    // Small differences as well as the full range.
+    const int mask = iter & 1 ? 255 : (1 << rnd(8)) - 1;
+    for (int i = 0; i < 64 * stride; i++) ref[i] = rnd.Rand8();
+    for (int i = 0; i < 64; i++)
+      for (int j = 0; j < p_stride; j++)
+        dst[i * p_stride + j] = ref[i * stride + j] ^ (rnd.Rand8() & mask);
+    if (iter == 0) {
+      // The largest differences, of both signs.
+      for (int i = 0; i < 64 * stride; i++) ref[i] = i & 1 ? 255 : 0;
+      for (int i = 0; i < 64 * p_stride; i++) dst[i] = i & 2 ? 255 : 0;
+    }
+    const int64_t ref_res =
+        ref_error_(ref, stride, dst, width, height, p_stride);
+    int64_t res;
+    ASM_REGISTER_STATE_CHECK(
+        res = error_(ref, stride, dst, width, height, p_stride));
+    ASSERT_EQ(ref_res, res) << "size " << width << "x" << height;
+  }
+}
+
+using std::tr1::make_tuple;
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, FrameErrorTest,
+    ::testing::Values(make_tuple(&av1_calc_frame_error_avx2,
+                                 &av1_calc_frame_error_c)));
+#endif
+}  // namespace
@@ -9,12 +9,46 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "aom_mem/aom_mem.h"
+#include "aom_ports/aom_timer.h"
 #include "av1/common/common_data.h"
 #include "av1/common/scan.h"
-#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+#include "test/acm_random.h"
+
+using libaom_test::ACMRandom;
 
 namespace {
 
+int CompareAugmentedProb(const void *a, const void *b) {
+  return *(const uint32_t *)b > *(const uint32_t *)a ? 1 : -1;
+}
+
+// The sort order as obtained by sorting the augmented probabilities.
+void ReferenceSortOrder(TX_SIZE tx_size, TX_TYPE tx_type,
+                        const uint32_t *non_zero_prob, int16_t *sort_order) {
+  const SCAN_ORDER *sc = get_default_scan(tx_size, tx_type, 0);
+  const int tx2d_size = tx_size_2d[tx_size];
+  const uint32_t mask = (1 << 16) - 1;
+  uint32_t temp[4096];
+  memcpy(temp, non_zero_prob, tx2d_size * sizeof(*temp));
+  av1_augment_prob(tx_size, tx_type, temp);
+  qsort(temp, tx2d_size, sizeof(*temp), CompareAugmentedProb);
+  for (int i = 0; i < tx2d_size; ++i)
+    sort_order[i] = sc->scan[mask ^ (temp[i] & mask)];
+}
+
+void FillRandomProb(ACMRandom *rnd, int size, uint32_t *prob) {
+  // Few distinct values half of the time, to have many ties.
+  const int range = rnd->Rand8() & 1 ? 4 : 1 << 16;
+  for (int i = 0; i < size; ++i) prob[i] = rnd->Rand16() % range;
+}
+
 TEST(ScanTest, av1_augment_prob) {
   const TX_SIZE tx_size = TX_4X4;
   const TX_TYPE tx_type = DCT_DCT;
@@ -55,6 +89,29 @@ TEST(ScanTest, av1_update_sort_order) {
   for (int i = 0; i < 16; ++i) EXPECT_EQ(ref_sort_order[i], sort_order[i]);
 }
 
+TEST(ScanTest, av1_update_sort_order_matches_augmented_sort) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint32_t prob[4096];
+  int16_t sort_order[4096];
+  int16_t ref_sort_order[4096];
+  for (int tx_size = 0; tx_size < TX_SIZES; ++tx_size) {
+    const int tx2d_size = tx_size_2d[tx_size];
+    for (int tx_type = DCT_DCT; tx_type < TX_TYPES; ++tx_type) {
+      for (int iter = 0; iter < 8; ++iter) {
+        FillRandomProb(&rnd, tx2d_size, prob);
+        ReferenceSortOrder(static_cast<TX_SIZE>(tx_size),
+                           static_cast<TX_TYPE>(tx_type), prob,
+                           ref_sort_order);
+        av1_update_sort_order(static_cast<TX_SIZE>(tx_size),
+                              static_cast<TX_TYPE>(tx_type), prob, sort_order);
+        ASSERT_EQ(0, memcmp(ref_sort_order, sort_order,
+                            tx2d_size * sizeof(*sort_order)))
+            << "tx_size " << tx_size << " tx_type " << tx_type;
+      }
+    }
+  }
+}
+
 TEST(ScanTest, av1_update_scan_order) {
   TX_SIZE tx_size = TX_4X4;
   const TX_TYPE tx_type = DCT_DCT;
@@ -94,4 +151,57 @@ TEST(ScanTest, av1_update_neighbors) {
   }
 }
 
+// Times the sorts of the probabilities, and the adaptation of the scan orders
+// of a frame where only DCT_DCT, then all the transform types, were used.
+TEST(ScanTest, DISABLED_Speed) {
+  const int kIterations = 200;
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint32_t prob[4096];
+  int16_t sort_order[4096];
+  for (int tx_size = 0; tx_size < TX_SIZES; ++tx_size) {
+    const int tx2d_size = tx_size_2d[tx_size];
+    FillRandomProb(&rnd, tx2d_size, prob);
+    aom_usec_timer ref_timer, timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kIterations * TX_TYPES; ++i)
+      ReferenceSortOrder(static_cast<TX_SIZE>(tx_size), DCT_DCT, prob,
+                         sort_order);
+    aom_usec_timer_mark(&ref_timer);
+    aom_usec_timer_start(&timer);
+    for (int i = 0; i < kIterations * TX_TYPES; ++i)
+      av1_update_sort_order(static_cast<TX_SIZE>(tx_size), DCT_DCT, prob,
+                            sort_order);
+    aom_usec_timer_mark(&timer);
+    printf("%4d coeffs: qsort %6d us, av1_update_sort_order %6d us\n",
+           tx2d_size, static_cast<int>(aom_usec_timer_elapsed(&ref_timer)),
+           static_cast<int>(aom_usec_timer_elapsed(&timer)));
+  }
+
+  AV1_COMMON *const cm =
+      static_cast<AV1_COMMON *>(aom_calloc(1, sizeof(*cm)));
+  ASSERT_TRUE(cm != NULL);
+  cm->fc = static_cast<FRAME_CONTEXT *>(aom_calloc(1, sizeof(*cm->fc)));
+  cm->frame_contexts =
+      static_cast<FRAME_CONTEXT *>(aom_calloc(1, sizeof(*cm->frame_contexts)));
+  ASSERT_TRUE(cm->fc != NULL && cm->frame_contexts != NULL);
+  av1_init_scan_order(cm);
+  *cm->frame_contexts = *cm->fc;
+  for (int used_types = 1; used_types <= TX_TYPES; used_types *= TX_TYPES) {
+    for (int tx_size = 0; tx_size < TX_SIZES; ++tx_size) {
+      for (int tx_type = 0; tx_type < used_types; ++tx_type)
+        cm->counts.txb_count[tx_size][tx_type] = 100;
+    }
+    aom_usec_timer timer;
+    aom_usec_timer_start(&timer);
+    for (int i = 0; i < kIterations; ++i) av1_adapt_scan_order(cm);
+    aom_usec_timer_mark(&timer);
+    printf("av1_adapt_scan_order, %2d tx types used: %6d us per frame\n",
+           used_types,
+           static_cast<int>(aom_usec_timer_elapsed(&timer) / kIterations));
+  }
+  aom_free(cm->frame_contexts);
+  aom_free(cm->fc);
+  aom_free(cm);
+}
+
 }  // namespace
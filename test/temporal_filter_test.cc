@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_config.h"
+#include "./av1_rtcd.h"
+#include "aom_ports/mem.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+
+namespace {
+
+typedef void (*TemporalFilterFunc)(uint8_t *frame1, unsigned int stride,
+                                   uint8_t *frame2, unsigned int block_width,
+                                   unsigned int block_height, int strength,
+                                   int filter_weight, unsigned int *accumulator,
+                                   uint16_t *count);
+
+typedef std::tr1::tuple<TemporalFilterFunc, TemporalFilterFunc>
+    TemporalFilterParam;
+
+class TemporalFilterTest
+    : public ::testing::TestWithParam<TemporalFilterParam> {
+ public:
+  virtual ~TemporalFilterTest() {}
+  virtual void SetUp() {
+    filter_ = GET_PARAM(0);
+    ref_filter_ = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  TemporalFilterFunc filter_;
+  TemporalFilterFunc ref_filter_;
+};
+
+// Accumulates random predictors of the luma and chroma block sizes over
+// random sources, and checks that the sums and counts match.
+TEST_P(TemporalFilterTest, TestSIMDNoMismatch) {
+  const int stride = 48;
+  const unsigned int sizes[][2] = {
+    { 16, 16 }, { 8, 8 }, { 8, 16 }, { 16, 8 }
+  };
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint8_t, src[16 * stride]);
+  DECLARE_ALIGNED(16, uint8_t, pred[16 * 16]);
+  DECLARE_ALIGNED(16, unsigned int, acc[16 * 16]);
+  DECLARE_ALIGNED(16, unsigned int, ref_acc[16 * 16]);
+  DECLARE_ALIGNED(16, uint16_t, cnt[16 * 16]);
+  DECLARE_ALIGNED(16, uint16_t, ref_cnt[16 * 16]);
+
+  for (int s = 0; s < 4; s++) {
+    const unsigned int width = sizes[s][0];
+    const unsigned int height = sizes[s][1];
+    for (int iter = 0; iter < 256; iter++) {
+      memset(acc, 0, sizeof(acc));
+      memset(ref_acc, 0, sizeof(ref_acc));
+      memset(cnt, 0, sizeof(cnt));
+      memset(ref_cnt, 0, sizeof(ref_cnt));
+      // Accumulate several frames, as the encoder does.
+      for (int frame = 0; frame < 4; frame++) {
+        // Small differences as well as the full range.
+        const int mask = iter & 1 ? 255 : (1 << rnd(8)) - 1;
+        const int strength = rnd(7);
+        const int weight = rnd(3);
+        for (int i = 0; i < 16 * stride; i++) src[i] = rnd.Rand8();
+        for (unsigned int i = 0; i < height; i++)
+          for (unsigned int j = 0; j < width; j++)
+            pred[i * width + j] = src[i * stride + j] ^ (rnd.Rand8() & mask);
+        ref_filter_(src, stride, pred, width, height, strength, weight,
+                    ref_acc, ref_cnt);
+        ASM_REGISTER_STATE_CHECK(filter_(src, stride, pred, width, height,
+                                         strength, weight, acc, cnt));
+      }
+      for (unsigned int i = 0; i < width * height; i++) {
+        ASSERT_EQ(ref_acc[i], acc[i]) << "size " << width << "x" << height
+                                      << ", pixel " << i;
+        ASSERT_EQ(ref_cnt[i], cnt[i]) << "size " << width << "x" << height
+                                      << ", pixel " << i;
+      }
+    }
+  }
+}
+
+using std::tr1::make_tuple;
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, TemporalFilterTest,
+    ::testing::Values(make_tuple(&av1_temporal_filter_apply_avx2,
+                                 &av1_temporal_filter_apply_c)));
+#endif
+}  // namespace
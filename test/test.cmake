@@ -46,6 +46,11 @@ if (CONFIG_GLOBAL_MOTION OR CONFIG_WARPED_MOTION)
         "${AOM_ROOT}/test/warp_filter_test_util.cc"
         "${AOM_ROOT}/test/warp_filter_test_util.h")
   endif ()
+  if (HAVE_AVX2)
+    set(AOM_UNIT_TEST_COMMON_SOURCES
+        ${AOM_UNIT_TEST_COMMON_SOURCES}
+        "${AOM_ROOT}/test/frame_error_test.cc")
+  endif ()
 endif ()
 
 set(AOM_UNIT_TEST_DECODER_SOURCES
@@ -136,6 +141,7 @@ if (CONFIG_AV1_ENCODER)
       "${AOM_ROOT}/test/blend_a64_mask_1d_test.cc"
       "${AOM_ROOT}/test/blend_a64_mask_test.cc"
       "${AOM_ROOT}/test/borders_test.cc"
+      "${AOM_ROOT}/test/copy_and_extend_test.cc"
       "${AOM_ROOT}/test/cpu_speed_test.cc"
       "${AOM_ROOT}/test/end_to_end_test.cc"
       "${AOM_ROOT}/test/error_block_test.cc"
@@ -147,8 +153,15 @@ if (CONFIG_AV1_ENCODER)
       "${AOM_ROOT}/test/minmax_test.cc"
       "${AOM_ROOT}/test/subtract_test.cc"
       "${AOM_ROOT}/test/sum_squares_test.cc"
+      "${AOM_ROOT}/test/temporal_filter_test.cc"
       "${AOM_ROOT}/test/variance_test.cc")
 
+  if (CONFIG_CDEF)
+    set(AOM_UNIT_TEST_ENCODER_SOURCES
+        ${AOM_UNIT_TEST_ENCODER_SOURCES}
+        "${AOM_ROOT}/test/cdef_dist_test.cc")
+  endif ()
+
   if (CONFIG_EXT_INTER)
     set(AOM_UNIT_TEST_ENCODER_SOURCES
         ${AOM_UNIT_TEST_ENCODER_SOURCES}
@@ -181,6 +194,7 @@ endif ()
 if (CONFIG_AV1_DECODER AND CONFIG_AV1_ENCODER)
   set(AOM_UNIT_TEST_COMMON_SOURCES
       ${AOM_UNIT_TEST_COMMON_SOURCES}
+      "${AOM_ROOT}/test/decode_multithreaded_test.cc"
       "${AOM_ROOT}/test/divu_small_test.cc"
       "${AOM_ROOT}/test/ethread_test.cc"
       "${AOM_ROOT}/test/idct8x8_test.cc"
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2017, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <ctime>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "./aom_dsp_rtcd.h"
+#include "./av1_rtcd.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+#include "aom_dsp/aom_filter.h"
+#include "aom_mem/aom_mem.h"
+#include "aom_ports/mem.h"
+#include "av1/common/restoration.h"
+
+namespace {
+
+using std::tr1::tuple;
+using std::tr1::make_tuple;
+using libaom_test::ACMRandom;
+
+const int kStride = MAX_SB_SIZE + 32;
+const int kBufSize = kStride * (MAX_SB_SIZE + 16);
+const int kOffset = 8 * kStride + 8;
+
+// Random symmetric 7-tap filter in the form used by the Wiener filter.
+void RandomWienerFilter(ACMRandom *rnd, int16_t *filter) {
+  filter[0] = filter[6] =
+      WIENER_FILT_TAP0_MINV +
+      rnd->PseudoUniform(WIENER_FILT_TAP0_MAXV + 1 - WIENER_FILT_TAP0_MINV);
+  filter[1] = filter[5] =
+      WIENER_FILT_TAP1_MINV +
+      rnd->PseudoUniform(WIENER_FILT_TAP1_MAXV + 1 - WIENER_FILT_TAP1_MINV);
+  filter[2] = filter[4] =
+      WIENER_FILT_TAP2_MINV +
+      rnd->PseudoUniform(WIENER_FILT_TAP2_MAXV + 1 - WIENER_FILT_TAP2_MINV);
+  filter[3] = -2 * (filter[0] + filter[1] + filter[2]);
+  filter[7] = 0;
+}
+
+typedef void (*ConvolveFunc)(const uint8_t *src, ptrdiff_t src_stride,
+                             uint8_t *dst, ptrdiff_t dst_stride,
+                             const int16_t *filter_x, int x_step_q4,
+                             const int16_t *filter_y, int y_step_q4, int w,
+                             int h);
+typedef tuple<ConvolveFunc> ConvolveParam;
+
+class AV1WienerConvolveTest : public ::testing::TestWithParam<ConvolveParam> {
+ public:
+  virtual ~AV1WienerConvolveTest() {}
+  virtual void SetUp() { func_ = GET_PARAM(0); }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCorrectnessTest() {
+    const int NUM_ITERS = 1000;
+    DECLARE_ALIGNED(16, uint8_t, input[kBufSize]);
+    DECLARE_ALIGNED(16, uint8_t, output[kBufSize]);
+    DECLARE_ALIGNED(16, uint8_t, output2[kBufSize]);
+    DECLARE_ALIGNED(16, int16_t, filter_x[8]);
+    DECLARE_ALIGNED(16, int16_t, filter_y[8]);
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    int i, j;
+
+    for (i = 0; i < NUM_ITERS; ++i) {
+      // Noise, extremes and flat areas, to reach the clipping of both
+      // passes.
+      const int mode = i % 3;
+      for (j = 0; j < kBufSize; ++j) {
+        if (mode == 0)
+          input[j] = rnd.Rand8();
+        else if (mode == 1)
+          input[j] = rnd.Rand8() & 1 ? 255 : 0;
+        else
+          input[j] = 128 + rnd.PseudoUniform(4);
+      }
+      RandomWienerFilter(&rnd, filter_x);
+      RandomWienerFilter(&rnd, filter_y);
+      // restoration.c filters blocks whose width and height are multiples of
+      // 16, but the other widths must work too.
+      const int w = i % 4 ? 16 * (1 + rnd.PseudoUniform(MAX_SB_SIZE / 16))
+                          : 1 + rnd.PseudoUniform(MAX_SB_SIZE);
+      const int h = 16 * (1 + rnd.PseudoUniform(MAX_SB_SIZE / 16));
+      memset(output, 0, sizeof(output));
+      memset(output2, 0, sizeof(output2));
+
+      aom_convolve8_add_src_c(input + kOffset, kStride, output, kStride,
+                              filter_x, 16, filter_y, 16, w, h);
+      ASM_REGISTER_STATE_CHECK(func_(input + kOffset, kStride, output2,
+                                     kStride, filter_x, 16, filter_y, 16, w,
+                                     h));
+      for (j = 0; j < kBufSize; ++j) ASSERT_EQ(output[j], output2[j]);
+    }
+  }
+
+  void RunSpeedTest() {
+    const int NUM_ITERS = 100000;
+    DECLARE_ALIGNED(16, uint8_t, input[kBufSize]);
+    DECLARE_ALIGNED(16, uint8_t, output[kBufSize]);
+    DECLARE_ALIGNED(16, int16_t, filter[8]);
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    int i;
+
+    for (i = 0; i < kBufSize; ++i) input[i] = rnd.Rand8();
+    RandomWienerFilter(&rnd, filter);
+
+    std::clock_t start = std::clock();
+    for (i = 0; i < NUM_ITERS; ++i)
+      func_(input + kOffset, kStride, output, kStride, filter, 16, filter, 16,
+            MAX_SB_SIZE, MAX_SB_SIZE);
+    std::clock_t end = std::clock();
+    double elapsed = ((end - start) / (double)CLOCKS_PER_SEC);
+
+    printf("%5d %dx%d blocks in %7.3fs = %7.3fus/block\n", NUM_ITERS,
+           MAX_SB_SIZE, MAX_SB_SIZE, elapsed, elapsed * 1000000. / NUM_ITERS);
+  }
+
+  ConvolveFunc func_;
+};
+
+TEST_P(AV1WienerConvolveTest, CorrectnessTest) { RunCorrectnessTest(); }
+TEST_P(AV1WienerConvolveTest, DISABLED_SpeedTest) { RunSpeedTest(); }
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2, AV1WienerConvolveTest,
+                        ::testing::Values(make_tuple(
+                            &aom_convolve8_add_src_avx2)));
+#endif
+
+#if CONFIG_AOM_HIGHBITDEPTH
+typedef void (*HighbdConvolveFunc)(const uint8_t *src, ptrdiff_t src_stride,
+                                   uint8_t *dst, ptrdiff_t dst_stride,
+                                   const int16_t *filter_x, int x_step_q4,
+                                   const int16_t *filter_y, int y_step_q4,
+                                   int w, int h, int bd);
+typedef tuple<HighbdConvolveFunc, int> HighbdConvolveParam;
+
+class AV1HighbdWienerConvolveTest
+    : public ::testing::TestWithParam<HighbdConvolveParam> {
+ public:
+  virtual ~AV1HighbdWienerConvolveTest() {}
+  virtual void SetUp() {
+    func_ = GET_PARAM(0);
+    bit_depth_ = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCorrectnessTest() {
+    const int NUM_ITERS = 1000;
+    const int mask = (1 << bit_depth_) - 1;
+    DECLARE_ALIGNED(16, uint16_t, input[kBufSize]);
+    DECLARE_ALIGNED(16, uint16_t, output[kBufSize]);
+    DECLARE_ALIGNED(16, uint16_t, output2[kBufSize]);
+    DECLARE_ALIGNED(16, int16_t, filter_x[8]);
+    DECLARE_ALIGNED(16, int16_t, filter_y[8]);
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    int i, j;
+
+    for (i = 0; i < NUM_ITERS; ++i) {
+      const int mode = i % 3;
+      for (j = 0; j < kBufSize; ++j) {
+        if (mode == 0)
+          input[j] = rnd.Rand16() & mask;
+        else if (mode == 1)
+          input[j] = rnd.Rand8() & 1 ? mask : 0;
+        else
+          input[j] = (mask >> 1) + rnd.PseudoUniform(4);
+      }
+      RandomWienerFilter(&rnd, filter_x);
+      RandomWienerFilter(&rnd, filter_y);
+      const int w = i % 4 ? 16 * (1 + rnd.PseudoUniform(MAX_SB_SIZE / 16))
+                          : 1 + rnd.PseudoUniform(MAX_SB_SIZE);
+      const int h = 16 * (1 + rnd.PseudoUniform(MAX_SB_SIZE / 16));
+      memset(output, 0, sizeof(output));
+      memset(output2, 0, sizeof(output2));
+
+      aom_highbd_convolve8_add_src_c(
+          CONVERT_TO_BYTEPTR(input + kOffset), kStride,
+          CONVERT_TO_BYTEPTR(output), kStride, filter_x, 16, filter_y, 16, w,
+          h, bit_depth_);
+      ASM_REGISTER_STATE_CHECK(func_(CONVERT_TO_BYTEPTR(input + kOffset),
+                                     kStride, CONVERT_TO_BYTEPTR(output2),
+                                     kStride, filter_x, 16, filter_y, 16, w,
+                                     h, bit_depth_));
+      for (j = 0; j < kBufSize; ++j) ASSERT_EQ(output[j], output2[j]);
+    }
+  }
+
+  HighbdConvolveFunc func_;
+  int bit_depth_;
+};
+
+TEST_P(AV1HighbdWienerConvolveTest, CorrectnessTest) { RunCorrectnessTest(); }
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, AV1HighbdWienerConvolveTest,
+    ::testing::Values(make_tuple(&aom_highbd_convolve8_add_src_avx2, 8),
+                      make_tuple(&aom_highbd_convolve8_add_src_avx2, 10),
+                      make_tuple(&aom_highbd_convolve8_add_src_avx2, 12)));
+#endif
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+
+#if CONFIG_AV1_ENCODER
+const int kSumsStride = 320;
+const int kSumsBufSize = kSumsStride * 80;
+const int kSumsOffset = WIENER_HALFWIN * kSumsStride + WIENER_HALFWIN;
+
+typedef void (*WienerSumsFunc)(const uint8_t *dgd, const uint8_t *src,
+                               int width, int height, int dgd_stride,
+                               int src_stride, int64_t *sum_x, int64_t *sum_y,
+                               int64_t *sum_xy, int64_t *sum_yy);
+typedef tuple<WienerSumsFunc> WienerSumsParam;
+
+// Only the upper triangle of sum_yy is defined.
+void ExpectSameSums(int64_t sum_x, const int64_t *sum_y, const int64_t *sum_xy,
+                    const int64_t *sum_yy, int64_t sum_x2,
+                    const int64_t *sum_y2, const int64_t *sum_xy2,
+                    const int64_t *sum_yy2) {
+  int k, l;
+  ASSERT_EQ(sum_x, sum_x2);
+  for (k = 0; k < WIENER_WIN2; ++k) {
+    ASSERT_EQ(sum_y[k], sum_y2[k]);
+    ASSERT_EQ(sum_xy[k], sum_xy2[k]);
+    for (l = k; l < WIENER_WIN2; ++l)
+      ASSERT_EQ(sum_yy[k * WIENER_WIN2 + l], sum_yy2[k * WIENER_WIN2 + l]);
+  }
+}
+
+class AV1WienerSumsTest : public ::testing::TestWithParam<WienerSumsParam> {
+ public:
+  virtual ~AV1WienerSumsTest() {}
+  virtual void SetUp() { func_ = GET_PARAM(0); }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCorrectnessTest() {
+    const int NUM_ITERS = 50;
+    uint8_t *dgd = (uint8_t *)aom_memalign(16, kSumsBufSize);
+    uint8_t *src = (uint8_t *)aom_memalign(16, kSumsBufSize);
+    int64_t sum_x, sum_y[WIENER_WIN2], sum_xy[WIENER_WIN2];
+    int64_t sum_yy[WIENER_WIN2 * WIENER_WIN2];
+    int64_t sum_x2, sum_y2[WIENER_WIN2], sum_xy2[WIENER_WIN2];
+    int64_t sum_yy2[WIENER_WIN2 * WIENER_WIN2];
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    int i, j;
+
+    for (i = 0; i < NUM_ITERS; ++i) {
+      for (j = 0; j < kSumsBufSize; ++j) {
+        dgd[j] = i & 1 ? rnd.Rand8() : 255;
+        src[j] = i & 1 ? rnd.Rand8() : 255;
+      }
+      // Widths around the 256 pixel columns of the SIMD versions.
+      const int w = 1 + rnd.PseudoUniform(kSumsStride - WIENER_WIN);
+      const int h = 1 + rnd.PseudoUniform(64);
+
+      av1_compute_wiener_sums_c(dgd + kSumsOffset, src, w, h, kSumsStride,
+                                kSumsStride, &sum_x, sum_y, sum_xy, sum_yy);
+      ASM_REGISTER_STATE_CHECK(func_(dgd + kSumsOffset, src, w, h,
+                                     kSumsStride, kSumsStride, &sum_x2,
+                                     sum_y2, sum_xy2, sum_yy2));
+      ExpectSameSums(sum_x, sum_y, sum_xy, sum_yy, sum_x2, sum_y2, sum_xy2,
+                     sum_yy2);
+    }
+
+    aom_free(dgd);
+    aom_free(src);
+  }
+
+  WienerSumsFunc func_;
+};
+
+TEST_P(AV1WienerSumsTest, CorrectnessTest) { RunCorrectnessTest(); }
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(SSE4_1, AV1WienerSumsTest,
+                        ::testing::Values(make_tuple(
+                            &av1_compute_wiener_sums_sse4_1)));
+#endif
+
+#if CONFIG_AOM_HIGHBITDEPTH
+typedef void (*HighbdWienerSumsFunc)(const uint16_t *dgd, const uint16_t *src,
+                                     int width, int height, int dgd_stride,
+                                     int src_stride, int64_t *sum_x,
+                                     int64_t *sum_y, int64_t *sum_xy,
+                                     int64_t *sum_yy);
+typedef tuple<HighbdWienerSumsFunc, int> HighbdWienerSumsParam;
+
+class AV1HighbdWienerSumsTest
+    : public ::testing::TestWithParam<HighbdWienerSumsParam> {
+ public:
+  virtual ~AV1HighbdWienerSumsTest() {}
+  virtual void SetUp() {
+    func_ = GET_PARAM(0);
+    bit_depth_ = GET_PARAM(1);
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCorrectnessTest() {
+    const int NUM_ITERS = 50;
+    const int mask = (1 << bit_depth_) - 1;
+    uint16_t *dgd =
+        (uint16_t *)aom_memalign(16, kSumsBufSize * sizeof(uint16_t));
+    uint16_t *src =
+        (uint16_t *)aom_memalign(16, kSumsBufSize * sizeof(uint16_t));
+    int64_t sum_x, sum_y[WIENER_WIN2], sum_xy[WIENER_WIN2];
+    int64_t sum_yy[WIENER_WIN2 * WIENER_WIN2];
+    int64_t sum_x2, sum_y2[WIENER_WIN2], sum_xy2[WIENER_WIN2];
+    int64_t sum_yy2[WIENER_WIN2 * WIENER_WIN2];
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    int i, j;
+
+    for (i = 0; i < NUM_ITERS; ++i) {
+      for (j = 0; j < kSumsBufSize; ++j) {
+        dgd[j] = i & 1 ? rnd.Rand16() & mask : mask;
+        src[j] = i & 1 ? rnd.Rand16() & mask : mask;
+      }
+      const int w = 1 + rnd.PseudoUniform(kSumsStride - WIENER_WIN);
+      const int h = 1 + rnd.PseudoUniform(64);
+
+      av1_compute_wiener_sums_highbd_c(dgd + kSumsOffset, src, w, h,
+                                       kSumsStride, kSumsStride, &sum_x, sum_y,
+                                       sum_xy, sum_yy);
+      ASM_REGISTER_STATE_CHECK(func_(dgd + kSumsOffset, src, w, h,
+                                     kSumsStride, kSumsStride, &sum_x2,
+                                     sum_y2, sum_xy2, sum_yy2));
+      ExpectSameSums(sum_x, sum_y, sum_xy, sum_yy, sum_x2, sum_y2, sum_xy2,
+                     sum_yy2);
+    }
+
+    aom_free(dgd);
+    aom_free(src);
+  }
+
+  HighbdWienerSumsFunc func_;
+  int bit_depth_;
+};
+
+TEST_P(AV1HighbdWienerSumsTest, CorrectnessTest) { RunCorrectnessTest(); }
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(
+    SSE4_1, AV1HighbdWienerSumsTest,
+    ::testing::Values(make_tuple(&av1_compute_wiener_sums_highbd_sse4_1, 8),
+                      make_tuple(&av1_compute_wiener_sums_highbd_sse4_1, 10),
+                      make_tuple(&av1_compute_wiener_sums_highbd_sse4_1, 12)));
+#endif
+#endif  // CONFIG_AOM_HIGHBITDEPTH
+#endif  // CONFIG_AV1_ENCODER
+
+}  // namespace
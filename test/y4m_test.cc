@@ -9,12 +9,15 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
 */
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "./aom_config.h"
 #include "./y4menc.h"
+#include "test/acm_random.h"
 #include "test/md5_helper.h"
 #include "test/util.h"
 #include "test/y4m_video_source.h"
@@ -189,4 +192,72 @@ TEST_P(Y4mVideoWriteTest, WriteTest) {
 
 INSTANTIATE_TEST_CASE_P(C, Y4mVideoWriteTest,
                         ::testing::ValuesIn(kY4mTestVectors));
+
+struct Y4mMappedTestParam {
+  const char *chroma;
+  int only_420;
+};
+
+const Y4mMappedTestParam kY4mMappedTestParams[] = {
+  { "420jpeg", 0 }, { "420mpeg2", 0 }, { "422jpeg", 0 },
+  { "422jpeg", 1 }, { "444", 0 },      { "mono", 0 },
+};
+
+class Y4mMappedTest : public ::testing::TestWithParam<Y4mMappedTestParam> {};
+
+// Writes a y4m file of random frames, reads it both through stdio and from
+// memory, and checks that the frames match.
+TEST_P(Y4mMappedTest, MatchesFileRead) {
+  const Y4mMappedTestParam t = GetParam();
+  const int kMappedFrames = 4;
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  libaom_test::TempOutFile tmpfile;
+  FILE *const file = tmpfile.file();
+  ASSERT_TRUE(file != NULL);
+  fprintf(file, "YUV4MPEG2 W35 H19 F30:1 Ip A1:1 C%s\n", t.chroma);
+  rewind(file);
+
+  y4m_input y4m;
+  memset(&y4m, 0, sizeof(y4m));
+  ASSERT_EQ(0, y4m_input_open(&y4m, file, NULL, 0, t.only_420));
+  const long header_sz = ftell(file);
+  const size_t frame_sz = y4m.dst_buf_read_sz + y4m.aux_buf_read_sz;
+  ASSERT_EQ(0, fseek(file, 0, SEEK_END));
+  for (int i = 0; i < kMappedFrames; ++i) {
+    // Frame headers may have parameters, which are skipped.
+    fputs(i & 1 ? "FRAME Ip\n" : "FRAME\n", file);
+    for (size_t j = 0; j < frame_sz; ++j) fputc(rnd.Rand8(), file);
+  }
+  const long file_sz = ftell(file);
+  std::vector<unsigned char> data(file_sz);
+  rewind(file);
+  ASSERT_EQ(data.size(), fread(&data[0], 1, data.size(), file));
+  ASSERT_EQ(0, fseek(file, header_sz, SEEK_SET));
+
+  size_t pos = header_sz;
+  for (int i = 0; i < kMappedFrames; ++i) {
+    aom_image_t img;
+    ASSERT_EQ(1, y4m_input_fetch_frame(&y4m, file, &img));
+    libaom_test::MD5 md5;
+    md5.Add(&img);
+    const std::string expected_md5(md5.Get());
+
+    ASSERT_EQ(1, y4m_input_fetch_frame_mapped(&y4m, &data[0], data.size(),
+                                              &pos, &img));
+    libaom_test::MD5 mapped_md5;
+    mapped_md5.Add(&img);
+    EXPECT_EQ(expected_md5, std::string(mapped_md5.Get())) << "frame " << i;
+    const bool in_place = img.planes[0] >= &data[0] &&
+                          img.planes[0] < &data[0] + data.size();
+    EXPECT_EQ(y4m_input_frames_are_mapped(&y4m) != 0, in_place);
+  }
+  aom_image_t img;
+  EXPECT_EQ(0, y4m_input_fetch_frame_mapped(&y4m, &data[0], data.size(), &pos,
+                                            &img));
+  EXPECT_EQ(data.size(), pos);
+  y4m_input_close(&y4m);
+}
+
+INSTANTIATE_TEST_CASE_P(C, Y4mMappedTest,
+                        ::testing::ValuesIn(kY4mMappedTestParams));
 }  // namespace
@@ -9,6 +9,8 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#define _POSIX_C_SOURCE 200112L  // fileno()
+
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -25,6 +27,14 @@
 #include "aom/aomdx.h"
 #endif
 
+#if HAVE_UNISTD_H && !defined(_WIN32) && !defined(__OS2__)
+#define USE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define USE_MMAP 0
+#endif
+
 #if defined(_WIN32) || defined(__OS2__)
 #include <io.h>
 #include <fcntl.h>
@@ -128,6 +138,40 @@ int read_yuv_frame(struct AvxInputContext *input_ctx, aom_image_t *yuv_frame) {
   return shortread;
 }
 
+int aom_map_input_file(struct AvxInputContext *input_ctx) {
+#if USE_MMAP
+  struct stat st;
+  const FileOffset pos = ftello(input_ctx->file);
+  void *map;
+
+  if (fstat(fileno(input_ctx->file), &st) || !S_ISREG(st.st_mode) ||
+      pos < 0 || st.st_size <= pos ||
+      (off_t)(size_t)st.st_size != st.st_size)
+    return 0;
+
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+             fileno(input_ctx->file), 0);
+  if (map == MAP_FAILED) return 0;
+
+  input_ctx->map = (const uint8_t *)map;
+  input_ctx->map_size = (size_t)st.st_size;
+  input_ctx->map_pos = (size_t)pos;
+  return 1;
+#else
+  (void)input_ctx;
+  return 0;
+#endif
+}
+
+void aom_unmap_input_file(struct AvxInputContext *input_ctx) {
+#if USE_MMAP
+  if (input_ctx->map) munmap((void *)input_ctx->map, input_ctx->map_size);
+#endif
+  input_ctx->map = NULL;
+  input_ctx->map_size = 0;
+  input_ctx->map_pos = 0;
+}
+
 #if CONFIG_ENCODERS
 
 static const AvxInterface aom_encoders[] = {
@@ -103,6 +103,11 @@ struct AvxInputContext {
 #if CONFIG_ENCODERS
   y4m_input y4m;
 #endif
+  /* The whole input file, when aom_map_input_file() could map it. */
+  const uint8_t *map;
+  size_t map_size;
+  /* Offset of the next frame in the map. */
+  size_t map_pos;
 };
 
 #ifdef __cplusplus
@@ -131,6 +136,13 @@ void usage_exit(void) AOM_NO_RETURN;
 
 int read_yuv_frame(struct AvxInputContext *input_ctx, aom_image_t *yuv_frame);
 
+/* Maps the input file read-only into memory, with map_pos set to the current
+ * position of the file. Returns 0 if the file cannot be mapped, e.g. it is a
+ * pipe, and the stdio functions should be used instead.
+ */
+int aom_map_input_file(struct AvxInputContext *input_ctx);
+void aom_unmap_input_file(struct AvxInputContext *input_ctx);
+
 typedef struct AvxInterface {
   const char *const name;
   const uint32_t fourcc;
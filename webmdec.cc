@@ -117,13 +117,9 @@ int file_is_webm(struct WebmInputContext *webm_ctx,
   return 1;
 }
 
-int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
-                    size_t *buffer_size) {
-  // This check is needed for frame parallel decoding, in which case this
-  // function could be called even after it has reached end of input stream.
-  if (webm_ctx->reached_eos) {
-    return 1;
-  }
+// Advances to the next video frame, without reading its data. Returns 0 on
+// success, 1 at the end of the stream and -1 on error.
+static int next_frame(struct WebmInputContext *webm_ctx) {
   mkvparser::Segment *const segment =
       reinterpret_cast<mkvparser::Segment *>(webm_ctx->segment);
   const mkvparser::Cluster *cluster =
@@ -142,7 +138,6 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
     } else if (block_entry_eos || block_entry->EOS()) {
       cluster = segment->GetNext(cluster);
       if (cluster == NULL || cluster->EOS()) {
-        *buffer_size = 0;
         webm_ctx->reached_eos = 1;
         return 1;
       }
@@ -172,10 +167,29 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
   webm_ctx->cluster = cluster;
   webm_ctx->block_entry = block_entry;
   webm_ctx->block = block;
+  ++webm_ctx->block_frame_index;
+  webm_ctx->timestamp_ns = block->GetTime(cluster);
+  webm_ctx->is_key_frame = block->IsKey();
+  return 0;
+}
+
+int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
+                    size_t *buffer_size) {
+  // This check is needed for frame parallel decoding, in which case this
+  // function could be called even after it has reached end of input stream.
+  if (webm_ctx->reached_eos) {
+    return 1;
+  }
+  const int status = next_frame(webm_ctx);
+  if (status) {
+    if (webm_ctx->reached_eos) *buffer_size = 0;
+    return status;
+  }
 
+  const mkvparser::Block *const block =
+      reinterpret_cast<const mkvparser::Block *>(webm_ctx->block);
   const mkvparser::Block::Frame &frame =
-      block->GetFrame(webm_ctx->block_frame_index);
-  ++webm_ctx->block_frame_index;
+      block->GetFrame(webm_ctx->block_frame_index - 1);
   if (frame.len > static_cast<long>(*buffer_size)) {
     delete[] * buffer;
     *buffer = new uint8_t[frame.len];
@@ -185,8 +199,6 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
     webm_ctx->buffer = *buffer;
   }
   *buffer_size = frame.len;
-  webm_ctx->timestamp_ns = block->GetTime(cluster);
-  webm_ctx->is_key_frame = block->IsKey();
 
   mkvparser::MkvReader *const reader =
       reinterpret_cast<mkvparser::MkvReader *>(webm_ctx->reader);
@@ -209,14 +221,25 @@ int webm_guess_framerate(struct WebmInputContext *webm_ctx,
       static_cast<int>(webm_ctx->timestamp_ns / 1000);
   delete[] buffer;
 
+  webm_rewind(webm_ctx);
+
+  return 0;
+}
+
+int webm_skip_frame(struct WebmInputContext *webm_ctx) {
+  if (webm_ctx->reached_eos) {
+    return 1;
+  }
+  return next_frame(webm_ctx);
+}
+
+void webm_rewind(struct WebmInputContext *webm_ctx) {
   get_first_cluster(webm_ctx);
   webm_ctx->block = NULL;
   webm_ctx->block_entry = NULL;
   webm_ctx->block_frame_index = 0;
   webm_ctx->timestamp_ns = 0;
   webm_ctx->reached_eos = 0;
-
-  return 0;
 }
 
 void webm_free(struct WebmInputContext *webm_ctx) { reset(webm_ctx); }
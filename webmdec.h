@@ -60,6 +60,14 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
 int webm_guess_framerate(struct WebmInputContext *webm_ctx,
                          struct AvxInputContext *aom_ctx);
 
+// Advances to the next video frame like webm_read_frame(), but without reading
+// its data. |is_key_frame| and |timestamp_ns| are updated as usual.
+// Return values are the same as for webm_read_frame().
+int webm_skip_frame(struct WebmInputContext *webm_ctx);
+
+// Returns to the first frame of the file.
+void webm_rewind(struct WebmInputContext *webm_ctx);
+
 // Resets the WebMInputContext.
 void webm_free(struct WebmInputContext *webm_ctx);
 
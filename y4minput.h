@@ -61,6 +61,18 @@ int y4m_input_open(y4m_input *_y4m, FILE *_fin, char *_skip, int _nskip,
                    int only_420);
 void y4m_input_close(y4m_input *_y4m);
 int y4m_input_fetch_frame(y4m_input *_y4m, FILE *_fin, aom_image_t *img);
+/*Fetches the frame at offset *_pos of the _size bytes of _data, usually the
+   whole file mapped in memory, and moves *_pos past it.
+  The planes of _img point into _data if y4m_input_frames_are_mapped()
+   returns 1, and into internal buffers that the next fetch overwrites
+   otherwise.
+  Return: 1 on success, 0 at the end of the data, and -1 on error.*/
+int y4m_input_fetch_frame_mapped(y4m_input *_y4m, const unsigned char *_data,
+                                 size_t _size, size_t *_pos,
+                                 aom_image_t *img);
+/*Returns 1 if the frames need no chroma conversion, so that mapped frames can
+   be used in place.*/
+int y4m_input_frames_are_mapped(const y4m_input *_y4m);
 
 #ifdef __cplusplus
 }  // extern "C"